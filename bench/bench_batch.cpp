@@ -0,0 +1,61 @@
+#include <iostream>
+#include <sstream>
+
+#include "bench_utils.hpp"
+#include "filter_pipeline.hpp"
+
+// Throughput of FilterPipeline::applyBatch on a batch of 512x512 thumbnails for each
+// parallelization strategy, against calling apply() once per image.
+
+int main(int argc, char** argv) {
+    const int count = argc > 1 ? std::stoi(argv[1]) : 500;
+    const int side = 512;
+
+    std::vector<FlatImage> inputs;
+    for (int i = 0; i < count; ++i) {
+        inputs.push_back(randomImage(side, side, i));
+    }
+    auto pipeline = FilterPipeline().addGaussianBlur().addSobelOperator();
+
+    std::vector<FlatImage> outputs(count);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i) {
+        pipeline.apply(inputs[i], outputs[i]);
+    }
+    double loopSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<std::string> report;
+    std::ostringstream header;
+    header << count << " x " << side << "x" << side << "  apply() loop: " << count / loopSeconds << " images/s";
+    report.push_back(header.str());
+
+    const std::pair<const char*, BatchParallelism> modes[] = {
+        {"auto", BatchParallelism::Auto},
+        {"across images", BatchParallelism::AcrossImages},
+        {"across rows", BatchParallelism::AcrossRows},
+        {"both", BatchParallelism::Both},
+    };
+    for (const auto& [name, parallelism] : modes) {
+        std::vector<FlatImage> batchOutputs;
+        BatchReport result = pipeline.applyBatch(inputs, batchOutputs, {parallelism});
+
+        for (int i = 0; i < count; ++i) {
+            if (!std::equal(batchOutputs[i].begin(), batchOutputs[i].end(), outputs[i].begin())) {
+                std::cerr << "Batch output differs from apply() for image " << i << std::endl;
+                return 1;
+            }
+        }
+
+        std::ostringstream line;
+        line << "  " << name << ": " << result.imagesPerSecond << " images/s"
+             << "  speedup: " << result.imagesPerSecond * loopSeconds / count << "x";
+        report.push_back(line.str());
+    }
+
+    std::cout << std::endl;
+    for (const auto& line : report) {
+        std::cout << line << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include <iostream>
+#include <limits>
+
+#include "bench_utils.hpp"
+#include "filter_pipeline.hpp"
+
+// Calibrates ExecutionPolicy for this machine: finds the smallest square image on which
+// row-parallel execution beats serial execution, and the smallest frame on which tile-parallel
+// execution beats row-parallel execution, then prints the matching environment variables.
+
+static double medianWithPolicy(FilterPipeline& pipeline, const ExecutionPolicy& policy, const FlatImage& input, int iterations) {
+    FlatImage output;
+    pipeline.setExecutionPolicy(policy);
+    pipeline.apply(input, output); // warm up the scratch arenas
+    return medianMicroseconds([&] { pipeline.apply(input, output); }, iterations);
+}
+
+int main(int argc, char** argv) {
+    const int iterations = argc > 1 ? std::stoi(argv[1]) : 5;
+    auto pipeline = FilterPipeline().addGaussianBlur().addSobelOperator();
+
+    ExecutionPolicy serial = ExecutionPolicy::serial();
+    ExecutionPolicy chunked;
+    chunked.parallelMinPixels = 1;
+    chunked.tileMinPixels = std::numeric_limits<size_t>::max();
+    ExecutionPolicy tiled;
+    tiled.parallelMinPixels = 1;
+    tiled.tileMinPixels = 1;
+
+    size_t parallelMinPixels = std::numeric_limits<size_t>::max();
+    for (int side = 32; side <= 2048 && parallelMinPixels == std::numeric_limits<size_t>::max(); side *= 2) {
+        FlatImage input = randomImage(side, side);
+        double serialUs = medianWithPolicy(pipeline, serial, input, iterations);
+        double chunkedUs = medianWithPolicy(pipeline, chunked, input, iterations);
+        std::cerr << side << "x" << side << "  serial: " << serialUs << " us  chunked: " << chunkedUs << " us" << std::endl;
+        if (chunkedUs < serialUs) {
+            parallelMinPixels = static_cast<size_t>(side) * side;
+        }
+    }
+
+    size_t tileMinPixels = std::numeric_limits<size_t>::max();
+    for (int side = 2048; side <= 8192 && tileMinPixels == std::numeric_limits<size_t>::max(); side *= 2) {
+        FlatImage input = randomImage(side, side);
+        double chunkedUs = medianWithPolicy(pipeline, chunked, input, iterations);
+        double tiledUs = medianWithPolicy(pipeline, tiled, input, iterations);
+        std::cerr << side << "x" << side << "  chunked: " << chunkedUs << " us  tiled: " << tiledUs << " us" << std::endl;
+        if (tiledUs < chunkedUs) {
+            tileMinPixels = static_cast<size_t>(side) * side;
+        }
+    }
+
+    std::cout << std::endl
+              << "export IMAGE_FILTERS_PARALLEL_MIN_PIXELS=" << parallelMinPixels << std::endl
+              << "export IMAGE_FILTERS_TILE_MIN_PIXELS=" << tileMinPixels << std::endl;
+
+    return 0;
+}
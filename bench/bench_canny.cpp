@@ -0,0 +1,60 @@
+#include <iostream>
+
+#include "bench_utils.hpp"
+#include "blur.hpp"
+#include "canny.hpp"
+#include "sobel.hpp"
+
+// Times CannyEdgeDetector against cv::Canny (3x3 aperture) on blob images, whose smoothed noise
+// has edges of every orientation at a high density, with the time of every stage. Also reports
+// how many pixels agree with OpenCV's output.
+
+static FlatImage blobImage(int rows, int cols) {
+    FlatImage noise = randomImage(rows, cols), blobs;
+    Blur(7).apply(noise, blobs);
+    for (uchar& px : blobs) {
+        px = static_cast<uchar>(std::clamp((px - 128) * 8 + 128, 0, 255));
+    }
+    return blobs;
+}
+
+int main(int argc, char** argv) {
+    const int iterations = argc > 1 ? std::stoi(argv[1]) : 9;
+    const std::vector<std::pair<int, int>> sizes = {{1080, 1920}, {2160, 3840}};
+
+    for (GradientNorm norm : {GradientNorm::L1, GradientNorm::L2}) {
+        const CannyEdgeDetector canny(50, 150, norm);
+        for (auto [rows, cols] : sizes) {
+            const FlatImage input = blobImage(rows, cols);
+            FlatImage output;
+            cv::Mat inputMat = FlatImageFactory::toMat(input), outputMat;
+
+            const double cannyUs = medianMicroseconds([&] { canny.apply(input, output); }, iterations);
+            const double opencvUs = medianMicroseconds([&] { canny.applyBenchmark(inputMat, outputMat); }, iterations);
+
+            GradientField field;
+            field.norm = norm;
+            field.outputs = GradientMagnitude | GradientOrientation;
+            FlatImage candidates, traced;
+            const double fieldUs = medianMicroseconds([&] { SobelOperator().applyGradientField(input, field); }, iterations);
+            const double suppressUs = medianMicroseconds([&] { canny.suppressNonMaxima(field, candidates); }, iterations);
+            const double traceUs = medianMicroseconds([&] { CannyEdgeDetector::traceEdges(candidates, traced); }, iterations);
+
+            size_t agreeing = 0, edges = 0;
+            for (int i = 0; i < rows; ++i) {
+                for (int j = 0; j < cols; ++j) {
+                    agreeing += output(i, j) == outputMat.at<uchar>(i, j);
+                    edges += output(i, j) != 0;
+                }
+            }
+
+            std::cout << cols << "x" << rows << (norm == GradientNorm::L1 ? " L1" : " L2")
+                      << "  canny: " << cannyUs << " us"
+                      << " (gradient field " << fieldUs << ", suppression " << suppressUs << ", tracing " << traceUs << ")"
+                      << "  cv::Canny: " << opencvUs << " us (" << opencvUs / cannyUs << "x)"
+                      << "  edges: " << 100.0 * edges / input.size() << "%"
+                      << "  agreement: " << 100.0 * agreeing / input.size() << "%" << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <iostream>
+
+#include "bench_utils.hpp"
+#include "channel_image.hpp"
+#include "filter_pipeline.hpp"
+
+// Smoothing a 1080p RGB frame: splitting it into three planes and running the pipeline once
+// per plane, against one pass over the interleaved and planar images. Also times 16-bit and
+// float samples, which only the one-pass path accepts.
+
+template <typename T>
+static ChannelImage<T> randomChannels(int rows, int cols, int channels, ChannelLayout layout, double maxValue) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> dist(0, maxValue);
+    ChannelImage<T> image(rows, cols, channels, layout);
+    for (int i = 0; i < image.samples().rows(); ++i) {
+        for (int j = 0; j < image.samples().cols(); ++j) {
+            image.samples()(i, j) = static_cast<T>(dist(rng));
+        }
+    }
+    return image;
+}
+
+int main(int argc, char** argv) {
+    const int iterations = argc > 1 ? std::stoi(argv[1]) : 15;
+    const int rows = 1080, cols = 1920, channels = 3;
+    auto pipeline = FilterPipeline().addBlur(5).addGaussianBlur(5);
+
+    const auto input = randomChannels<uchar>(rows, cols, channels, ChannelLayout::Interleaved, 255);
+
+    // what callers had to do before: split, filter every plane, merge
+    ChannelImage<uchar> planes(rows, cols, channels, ChannelLayout::Planar), filteredPlanes(rows, cols, channels, ChannelLayout::Planar);
+    ChannelImage<uchar> merged;
+    const double splitUs = medianMicroseconds([&] {
+        ChannelImageFactory::convert(input, planes);
+        for (int c = 0; c < channels; ++c) {
+            FlatImage target = filteredPlanes.plane(c);
+            pipeline.apply(planes.plane(c), target);
+        }
+        ChannelImageFactory::convert(filteredPlanes, merged);
+    }, iterations);
+
+    ChannelImage<uchar> output;
+    pipeline.apply(input, output);
+    const double interleavedUs = medianMicroseconds([&] { pipeline.apply(input, output); }, iterations);
+
+    for (int i = 0; i < rows; ++i) {
+        if (!std::equal(output.samples().row(i), output.samples().row(i) + cols * channels, merged.samples().row(i))) {
+            std::cerr << "One-pass output differs from the per-plane runs in row " << i << std::endl;
+            return 1;
+        }
+    }
+
+    ChannelImage<uchar> planarOutput;
+    const double planarUs = medianMicroseconds([&] { pipeline.apply(planes, planarOutput); }, iterations);
+
+    const auto deep = randomChannels<uint16_t>(rows, cols, channels, ChannelLayout::Interleaved, 65535);
+    ChannelImage<uint16_t> deepOutput;
+    pipeline.apply(deep, deepOutput);
+    const double deepUs = medianMicroseconds([&] { pipeline.apply(deep, deepOutput); }, iterations);
+
+    const auto real = randomChannels<float>(rows, cols, channels, ChannelLayout::Interleaved, 1.0);
+    ChannelImage<float> realOutput;
+    pipeline.apply(real, realOutput);
+    const double realUs = medianMicroseconds([&] { pipeline.apply(real, realOutput); }, iterations);
+
+    std::cout << cols << "x" << rows << "x" << channels << ", Blur(5) + GaussianBlur(5), median of " << iterations << " runs" << std::endl;
+    std::cout << "  8-bit split + 3 runs + merge: " << splitUs << " us" << std::endl;
+    std::cout << "  8-bit interleaved, one pass:  " << interleavedUs << " us (" << splitUs / interleavedUs << "x)" << std::endl;
+    std::cout << "  8-bit planar, one pass:       " << planarUs << " us" << std::endl;
+    std::cout << "  16-bit interleaved:           " << deepUs << " us" << std::endl;
+    std::cout << "  float interleaved:            " << realUs << " us" << std::endl;
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <tbb/global_control.h>
+
+#include "bench_utils.hpp"
+#include "filter_pipeline.hpp"
+
+// Google Benchmark sweep of FilterPipeline::apply against the OpenCV path of applyBenchmark for
+// every filter and a few chains, over common resolutions and thread counts. Throughput is
+// reported as MPix/s; pass --benchmark_out=<file> --benchmark_out_format=json to keep results
+// (the bench_filters_json target does this).
+
+struct NamedPipeline
+{
+    std::string name;
+    std::function<FilterPipeline()> make;
+};
+
+struct Resolution
+{
+    int cols;
+    int rows;
+};
+
+static void setThroughput(benchmark::State& state, const Resolution& resolution) {
+    const double pixels = static_cast<double>(resolution.rows) * resolution.cols;
+    state.counters["MPix"] = benchmark::Counter(pixels / 1e6, benchmark::Counter::kIsIterationInvariantRate);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * pixels));
+}
+
+static void benchCustom(benchmark::State& state, FilterPipeline pipeline, Resolution resolution, int threads) {
+    tbb::global_control limit(tbb::global_control::max_allowed_parallelism, threads);
+    const FlatImage input = randomImage(resolution.rows, resolution.cols);
+    FlatImage output;
+    pipeline.apply(input, output); // warm up the scratch arenas
+    for (auto _ : state) {
+        pipeline.apply(input, output);
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+    }
+    setThroughput(state, resolution);
+}
+
+static void benchOpenCV(benchmark::State& state, FilterPipeline pipeline, Resolution resolution, int threads) {
+    const int previousThreads = cv::getNumThreads();
+    cv::setNumThreads(threads);
+    FlatImage source = randomImage(resolution.rows, resolution.cols);
+    const cv::Mat input = FlatImageFactory::toMat(source).clone();
+    cv::Mat output;
+    pipeline.applyBenchmark(input, output);
+    for (auto _ : state) {
+        pipeline.applyBenchmark(input, output);
+        benchmark::DoNotOptimize(output.data);
+        benchmark::ClobberMemory();
+    }
+    setThroughput(state, resolution);
+    cv::setNumThreads(previousThreads);
+}
+
+int main(int argc, char** argv) {
+    const std::vector<NamedPipeline> pipelines = {
+        {"Blur", [] { return FilterPipeline().addBlur(); }},
+        {"GaussianBlur", [] { return FilterPipeline().addGaussianBlur(); }},
+        {"Sobel", [] { return FilterPipeline().addSobelOperator(); }},
+        {"Scharr", [] { return FilterPipeline().addScharrOperator(); }},
+        {"LaplacianOfGaussian", [] { return FilterPipeline().addLaplacianOfGaussian(); }},
+        {"GaussianBlur+Sobel", [] { return FilterPipeline().addGaussianBlur().addSobelOperator(); }},
+        {"Blur+Blur+Scharr", [] { return FilterPipeline().addBlur().addBlur().addScharrOperator(); }},
+    };
+    const std::vector<Resolution> resolutions = {{640, 480}, {1280, 720}, {1920, 1080}, {3840, 2160}};
+
+    std::vector<int> threadCounts = {1};
+    const int cores = static_cast<int>(std::thread::hardware_concurrency());
+    for (int threads = 2; threads < cores; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    if (cores > 1) {
+        threadCounts.push_back(cores);
+    }
+
+    for (const auto& pipeline : pipelines) {
+        for (const auto& resolution : resolutions) {
+            for (int threads : threadCounts) {
+                const std::string suffix = "/" + std::to_string(resolution.cols) + "x" + std::to_string(resolution.rows) +
+                                           "/threads:" + std::to_string(threads);
+                benchmark::RegisterBenchmark((pipeline.name + "/custom" + suffix).c_str(), benchCustom, pipeline.make(), resolution, threads)
+                    ->Unit(benchmark::kMicrosecond)
+                    ->UseRealTime();
+                benchmark::RegisterBenchmark((pipeline.name + "/opencv" + suffix).c_str(), benchOpenCV, pipeline.make(), resolution, threads)
+                    ->Unit(benchmark::kMicrosecond)
+                    ->UseRealTime();
+            }
+        }
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
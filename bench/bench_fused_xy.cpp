@@ -0,0 +1,89 @@
+#include <iostream>
+#include <sstream>
+
+#include "bench_utils.hpp"
+#include "image_filter.hpp"
+#include "scharr.hpp"
+#include "simd_kernels.hpp"
+#include "sobel.hpp"
+
+// Compares the fused single-sweep XY gradient and the separable passes against the original
+// five-pass path (padBoundaries, 2x getGradient, combineGradients, removeBoundaries), and times
+// the full gradient field (int16 gx/gy, L2 magnitude, orientation) of the same sweep.
+
+class XYKernelBenchmark : public ImageFilter
+{
+public:
+    using ImageFilter::factorizeKernel;
+
+    void apply(const FlatImage&, FlatImage&) const override {}
+    void applyBenchmark(const cv::Mat&, cv::Mat&) const override {}
+
+    template <typename KType>
+    void runFused(const FlatImage& input, FlatImage& output, const KType kernelX[3][3], const KType kernelY[3][3]) const {
+        applyXYKernels(input, output, kernelX, kernelY, 50);
+    }
+
+    template <typename KType>
+    void runSeparable(const FlatImage& input, FlatImage& output, const SeparableKernel<KType>& kernelX, const SeparableKernel<KType>& kernelY) const {
+        separableXYGradient(input, output, kernelX, kernelY, 50);
+    }
+
+    template <typename KType>
+    void runMultiPass(const FlatImage& input, FlatImage& output, const KType kernelX[3][3], const KType kernelY[3][3]) const {
+        applyXYKernelsMultiPass(input, output, kernelX, kernelY, 50);
+    }
+};
+
+int main(int argc, char** argv) {
+    const int iterations = argc > 1 ? std::stoi(argv[1]) : 5;
+    const std::vector<std::pair<int, int>> sizes = {{2160, 3840}, {4320, 7680}};
+
+    XYKernelBenchmark bench;
+    std::vector<std::string> report;
+
+    for (auto [rows, cols] : sizes) {
+        FlatImage input = randomImage(rows, cols);
+        FlatImage fused, separable, multiPass;
+        SeparableKernel<int> sepX, sepY;
+        XYKernelBenchmark::factorizeKernel(SobelOperator::KERNELX, sepX);
+        XYKernelBenchmark::factorizeKernel(SobelOperator::KERNELY, sepY);
+        const double pixels = static_cast<double>(rows) * cols;
+
+        double fusedUs = medianMicroseconds([&] { bench.runFused(input, fused, SobelOperator::KERNELX, SobelOperator::KERNELY); }, iterations);
+        double separableUs = medianMicroseconds([&] { bench.runSeparable(input, separable, sepX, sepY); }, iterations);
+        double multiPassUs = medianMicroseconds([&] { bench.runMultiPass(input, multiPass, SobelOperator::KERNELX, SobelOperator::KERNELY); }, iterations);
+
+        // signed derivatives, L2 magnitude and orientation in the same single sweep
+        GradientField field;
+        double fieldUs = medianMicroseconds([&] { SobelOperator().applyGradientField(input, field); }, iterations);
+
+        if (!std::equal(fused.begin(), fused.end(), multiPass.begin()) || !std::equal(separable.begin(), separable.end(), multiPass.begin())) {
+            std::cerr << "Fused, separable and multi-pass outputs differ for " << cols << "x" << rows << std::endl;
+            return 1;
+        }
+
+        // Estimated DRAM traffic per frame in bytes per pixel:
+        //  multi-pass: pad (zero-fill + read + write = 3), 2x getGradient (zero-fill + read + write = 6),
+        //              combine (zero-fill + 2 reads + write = 4), remove (zero-fill + read + write = 3)
+        //  fused:      read + write = 2
+        const double multiPassBytes = 16 * pixels;
+        const double fusedBytes = 2 * pixels;
+
+        std::ostringstream line;
+        line << cols << "x" << rows
+             << "  multi-pass: " << multiPassUs << " us (" << multiPassBytes / multiPassUs / 1e3 << " GB/s, ~" << multiPassBytes / 1e6 << " MB)"
+             << "  fused: " << fusedUs << " us (" << fusedBytes / fusedUs / 1e3 << " GB/s, ~" << fusedBytes / 1e6 << " MB)"
+             << "  speedup: " << multiPassUs / fusedUs << "x"
+             << "  separable: " << separableUs << " us (speedup: " << multiPassUs / separableUs << "x)"
+             << "  gradient field: " << fieldUs << " us";
+        report.push_back(line.str());
+    }
+
+    std::cout << std::endl << "SIMD kernels: " << activeSimdKernels().name << std::endl;
+    for (const auto& line : report) {
+        std::cout << line << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include <iostream>
+#include <random>
+#include <sstream>
+
+#include "bench_utils.hpp"
+#include "dirty_regions.hpp"
+#include "filter_pipeline.hpp"
+
+// Compares filtering every frame in full against FilterPipeline::applyIncremental when only a
+// few rectangles change, such as an overlay or small moving objects, with the rectangles given
+// by the caller and detected by the frame diff.
+
+// Changes `count` random squares covering about `share` of the frame
+std::vector<PixelRect> changeRects(FlatImage& frame, double share, int count, unsigned int seed) {
+    std::mt19937 rng(seed);
+    const int side = std::max(1, static_cast<int>(std::sqrt(share * frame.size() / count)));
+    std::uniform_int_distribution<int> row(0, frame.rows() - side), col(0, frame.cols() - side);
+
+    std::vector<PixelRect> rects;
+    for (int k = 0; k < count; ++k) {
+        PixelRect rect{row(rng), col(rng), side, side};
+        for (int i = rect.row; i < rect.row + side; ++i) {
+            for (int j = rect.col; j < rect.col + side; ++j) {
+                frame(i, j) = static_cast<uchar>(255 - frame(i, j));
+            }
+        }
+        rects.push_back(rect);
+    }
+    return rects;
+}
+
+std::string compare(const std::string& name, FilterPipeline pipeline, const FlatImage& previous, double share, int count, int iterations) {
+    FlatImage current = previous;
+    const std::vector<PixelRect> dirty = changeRects(current, share, count, 7);
+
+    FlatImage before, expected;
+    pipeline.apply(previous, before);
+    const double fullUs = medianMicroseconds([&] { pipeline.apply(current, expected); }, iterations);
+
+    FlatImage given = before, detected = before;
+    const double copyUs = medianMicroseconds([&] { given = before; }, iterations);
+    IncrementalReport report;
+    const double givenUs = medianMicroseconds([&] {
+        given = before;
+        report = pipeline.applyIncremental(current, given, dirty);
+    }, iterations);
+    const double detectedUs = medianMicroseconds([&] {
+        detected = before;
+        pipeline.applyIncremental(previous, current, detected);
+    }, iterations);
+
+    if (!std::equal(given.begin(), given.end(), expected.begin()) || !std::equal(detected.begin(), detected.end(), expected.begin())) {
+        std::cerr << "Incremental and full outputs differ for " << name << std::endl;
+        std::exit(1);
+    }
+
+    // the copies restoring the earlier output are not part of an update
+    std::ostringstream line;
+    line << previous.cols() << "x" << previous.rows() << "  " << name << "  " << 100 * share << "% changed in " << count << " rects"
+         << "  recomputed: " << 100.0 * report.pixels / current.size() << "%" << (report.full ? " (full)" : "")
+         << "  full: " << fullUs << " us"
+         << "  incremental: " << givenUs - copyUs << " us"
+         << "  detected: " << detectedUs - copyUs << " us"
+         << "  speedup: " << fullUs / (givenUs - copyUs) << "x (detected: " << fullUs / (detectedUs - copyUs) << "x)";
+    return line.str();
+}
+
+int main(int argc, char** argv) {
+    const int iterations = argc > 1 ? std::stoi(argv[1]) : 5;
+    const std::vector<std::pair<int, int>> sizes = {{1080, 1920}, {2160, 3840}};
+
+    std::vector<std::string> report;
+    for (auto [rows, cols] : sizes) {
+        FlatImage frame = randomImage(rows, cols);
+        for (auto [share, count] : {std::pair{0.01, 1}, std::pair{0.01, 16}, std::pair{0.05, 4}, std::pair{0.2, 8}}) {
+            report.push_back(compare("GaussianBlur(5) + Sobel", FilterPipeline().addGaussianBlur().addSobelOperator(), frame, share, count, iterations));
+        }
+        report.push_back(compare("GaussianBlur(7) + Blur(5) + LoG", FilterPipeline().addGaussianBlur(7).addBlur(5).addLaplacianOfGaussian(),
+                                 frame, 0.05, 4, iterations));
+    }
+
+    std::cout << std::endl;
+    for (const auto& line : report) {
+        std::cout << line << std::endl;
+    }
+
+    return 0;
+}
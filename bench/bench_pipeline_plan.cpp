@@ -0,0 +1,63 @@
+#include <iostream>
+#include <sstream>
+
+#include "bench_utils.hpp"
+#include "filter_pipeline.hpp"
+
+// Times multi-stage preprocessing chains with the default plan, which runs every stage, against
+// the plan that folds adjacent smoothing stages, and prints the folded plans and how many of
+// their pixels differ from the stage-by-stage chain.
+
+int main(int argc, char** argv) {
+    const int iterations = argc > 1 ? std::stoi(argv[1]) : 5;
+    const std::vector<std::pair<int, int>> sizes = {{1080, 1920}, {2160, 3840}};
+
+    std::vector<std::pair<std::string, FilterPipeline>> chains = {
+        {"Blur(3) + GaussianBlur(5) + Sobel", FilterPipeline().addBlur(3).addGaussianBlur(5).addSobelOperator()},
+        {"GaussianBlur(5) x2 + Scharr", FilterPipeline().addGaussianBlur(5).addGaussianBlur(5).addScharrOperator()},
+        {"GaussianBlur(3) x3 + LoG", FilterPipeline().addGaussianBlur(3).addGaussianBlur(3).addGaussianBlur(3).addLaplacianOfGaussian()},
+        {"Blur(1) + GaussianBlur(7) + Blur(5) + Sobel", FilterPipeline().addBlur(1).addGaussianBlur(7).addBlur(5).addSobelOperator()},
+    };
+
+    std::vector<std::string> report;
+    for (auto [rows, cols] : sizes) {
+        FlatImage input = randomImage(rows, cols);
+
+        for (auto& [name, pipeline] : chains) {
+            FlatImage chained, folded;
+            pipeline.setPlanOptions(PlanOptions{});
+            double chainedUs = medianMicroseconds([&] { pipeline.apply(input, chained); }, iterations);
+
+            pipeline.setPlanOptions(PlanOptions{.foldSmoothing = true});
+            double foldedUs = medianMicroseconds([&] { pipeline.apply(input, folded); }, iterations);
+
+            // one grey level of smoothing can move a gradient across its threshold, so count
+            // the pixels that change rather than by how much
+            size_t differing = 0;
+            for (int i = 0; i < rows; ++i) {
+                for (int j = 0; j < cols; ++j) {
+                    differing += chained(i, j) != folded(i, j);
+                }
+            }
+
+            std::ostringstream line;
+            line << cols << "x" << rows << "  " << name
+                 << "  per stage: " << chainedUs << " us"
+                 << "  folded: " << foldedUs << " us"
+                 << "  speedup: " << chainedUs / foldedUs << "x"
+                 << "  differing pixels: " << 100.0 * differing / input.size() << "%";
+            report.push_back(line.str());
+        }
+    }
+
+    std::cout << std::endl;
+    for (auto& [name, pipeline] : chains) {
+        std::cout << name << ":" << std::endl << pipeline.plan().describe();
+    }
+    std::cout << std::endl;
+    for (const auto& line : report) {
+        std::cout << line << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <iostream>
+#include <sstream>
+
+#include "bench_utils.hpp"
+#include "filter_pipeline.hpp"
+#include "image_pyramid.hpp"
+#include "simd_kernels.hpp"
+
+// Compares ImagePyramid against cv::buildPyramid: building the levels, and building them and
+// filtering every level, where the OpenCV route copies each level through FlatImageFactory::from
+// and runs the pipeline on one level after another.
+
+std::string compare(const std::string& name, const FilterPipeline& pipeline, const FlatImage& base, int levels, int iterations) {
+    const cv::Mat mat = FlatImageFactory::toMat(base);
+
+    std::vector<cv::Mat> cvLevels;
+    const double cvBuildUs = medianMicroseconds([&] { cv::buildPyramid(mat, cvLevels, levels - 1); }, iterations);
+    std::vector<FlatImage> cvFiltered(levels);
+    const double cvFilterUs = medianMicroseconds([&] {
+        cv::buildPyramid(mat, cvLevels, levels - 1);
+        for (int i = 0; i < levels; ++i) {
+            FilterPipeline(pipeline).apply(FlatImageFactory::from(cvLevels[i]), cvFiltered[i]);
+        }
+    }, iterations);
+
+    ImagePyramid pyramid, filtered;
+    const double buildUs = medianMicroseconds([&] { pyramid.build(base, levels); }, iterations);
+    const double filterUs = medianMicroseconds([&] {
+        pyramid.build(base, levels);
+        pyramid.filter(pipeline, filtered);
+    }, iterations);
+
+    std::ostringstream line;
+    line << base.cols() << "x" << base.rows() << "  " << levels << " levels  " << name
+         << "  build: " << buildUs << " us (cv::buildPyramid: " << cvBuildUs << " us, " << cvBuildUs / buildUs << "x)"
+         << "  build + filter: " << filterUs << " us (OpenCV route: " << cvFilterUs << " us, " << cvFilterUs / filterUs << "x)"
+         << "  memory: " << static_cast<double>(pyramid.bytes()) / base.size() << " x base";
+    return line.str();
+}
+
+int main(int argc, char** argv) {
+    const int iterations = argc > 1 ? std::stoi(argv[1]) : 5;
+    const std::vector<std::pair<int, int>> sizes = {{1080, 1920}, {2160, 3840}};
+
+    std::vector<std::string> report;
+    for (auto [rows, cols] : sizes) {
+        FlatImage base = randomImage(rows, cols);
+        report.push_back(compare("Sobel", FilterPipeline().addSobelOperator(), base, 4, iterations));
+        report.push_back(compare("Blur + Sobel", FilterPipeline().addBlur().addSobelOperator(), base, 6, iterations));
+    }
+
+    std::cout << std::endl << "SIMD kernels: " << activeSimdKernels().name << std::endl;
+    for (const auto& line : report) {
+        std::cout << line << std::endl;
+    }
+
+    return 0;
+}
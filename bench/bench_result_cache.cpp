@@ -0,0 +1,67 @@
+#include <iostream>
+#include <sstream>
+
+#include "bench_utils.hpp"
+#include "content_hash.hpp"
+#include "filter_pipeline.hpp"
+#include "result_cache.hpp"
+#include "simd_kernels.hpp"
+
+// Prices the result cache: how fast frames hash compared with filtering them, what a hit costs,
+// and how much a miss adds to the uncached pipeline.
+
+std::string measure(const std::string& name, FilterPipeline pipeline, const FlatImage& frame, int iterations) {
+    FlatImage output;
+    volatile uint64_t sink = 0;
+    const double hashUs = medianMicroseconds([&] { sink = sink + contentHash(frame); }, iterations);
+    const double filterUs = medianMicroseconds([&] { pipeline.apply(frame, output); }, iterations);
+
+    // hits: the same frame again and again
+    auto cache = std::make_shared<ResultCache>(size_t(256) << 20);
+    pipeline.setResultCache(cache);
+    pipeline.apply(frame, output);
+    const double hitUs = medianMicroseconds([&] { pipeline.apply(frame, output); }, iterations);
+
+    // misses: four distinct frames cycling through a cache that holds two, so every frame is
+    // filtered and stored over the least recently used one
+    std::vector<FlatImage> frames(4, frame);
+    for (size_t k = 0; k < frames.size(); ++k) {
+        frames[k](0, 0) = static_cast<uchar>(frames[k](0, 0) + k);
+    }
+    pipeline.setResultCache(std::make_shared<ResultCache>(2 * frame.size()));
+    size_t next = 0;
+    const double missUs = medianMicroseconds([&] { pipeline.apply(frames[next++ % frames.size()], output); }, iterations);
+    if (cache->stats().hits == 0 || pipeline.resultCache()->stats().hits != 0) {
+        std::cerr << "Unexpected cache hits or misses for " << name << std::endl;
+        std::exit(1);
+    }
+
+    const double gigabytes = static_cast<double>(frame.size()) / 1e9;
+    std::ostringstream line;
+    line << frame.cols() << "x" << frame.rows() << "  " << name
+         << "  hash: " << hashUs << " us (" << gigabytes / (hashUs * 1e-6) << " GB/s)"
+         << "  filter: " << filterUs << " us"
+         << "  hit: " << hitUs << " us (" << filterUs / hitUs << "x)"
+         << "  miss: " << missUs << " us (" << std::showpos << 100.0 * (missUs - filterUs) / filterUs << std::noshowpos << "%)";
+    return line.str();
+}
+
+int main(int argc, char** argv) {
+    const int iterations = argc > 1 ? std::stoi(argv[1]) : 5;
+    const std::vector<std::pair<int, int>> sizes = {{1080, 1920}, {2160, 3840}};
+
+    std::vector<std::string> report;
+    for (auto [rows, cols] : sizes) {
+        FlatImage frame = randomImage(rows, cols);
+        report.push_back(measure("Blur", FilterPipeline().addBlur(), frame, iterations));
+        report.push_back(measure("GaussianBlur(5) + Sobel", FilterPipeline().addGaussianBlur().addSobelOperator(), frame, iterations));
+        report.push_back(measure("Canny", FilterPipeline().addGaussianBlur().addCannyEdgeDetector(), frame, iterations));
+    }
+
+    std::cout << std::endl << "SIMD kernels: " << activeSimdKernels().name << std::endl;
+    for (const auto& line : report) {
+        std::cout << line << std::endl;
+    }
+
+    return 0;
+}
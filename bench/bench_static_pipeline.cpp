@@ -0,0 +1,63 @@
+#include <iostream>
+#include <sstream>
+
+#include "bench_utils.hpp"
+#include "blur.hpp"
+#include "filter_pipeline.hpp"
+#include "gaussian_blur.hpp"
+#include "laplacian_of_gaussian.hpp"
+#include "scharr.hpp"
+#include "simd_kernels.hpp"
+#include "sobel.hpp"
+#include "static_pipeline.hpp"
+
+// Compares StaticPipeline, which streams rows between the stages of a chain fixed at compile
+// time, against the runtime FilterPipeline with the same filters, run whole-image stage by
+// stage and tiled.
+
+template <typename Pipeline>
+std::string compare(const std::string& name, const Pipeline& fused, FilterPipeline runtime, const FlatImage& input, int iterations) {
+    FlatImage expected, tiled, output;
+    double runtimeUs = medianMicroseconds([&] { runtime.apply(input, expected); }, iterations);
+    double tiledUs = medianMicroseconds([&] { runtime.applyTiled(input, tiled); }, iterations);
+    double fusedUs = medianMicroseconds([&] { fused.apply(input, output); }, iterations);
+
+    if (!std::equal(output.begin(), output.end(), expected.begin())) {
+        std::cerr << "StaticPipeline and FilterPipeline outputs differ for " << name << std::endl;
+        std::exit(1);
+    }
+
+    std::ostringstream line;
+    line << input.cols() << "x" << input.rows() << "  " << name
+         << "  FilterPipeline: " << runtimeUs << " us"
+         << "  tiled: " << tiledUs << " us"
+         << "  StaticPipeline: " << fusedUs << " us"
+         << "  speedup: " << runtimeUs / fusedUs << "x (tiled: " << tiledUs / fusedUs << "x)";
+    return line.str();
+}
+
+int main(int argc, char** argv) {
+    const int iterations = argc > 1 ? std::stoi(argv[1]) : 5;
+    const std::vector<std::pair<int, int>> sizes = {{1080, 1920}, {2160, 3840}};
+
+    std::vector<std::string> report;
+    for (auto [rows, cols] : sizes) {
+        FlatImage input = randomImage(rows, cols);
+
+        report.push_back(compare("Blur + Sobel", StaticPipeline<Blur, SobelOperator>(),
+                                 FilterPipeline().addBlur().addSobelOperator(), input, iterations));
+        report.push_back(compare("GaussianBlur(5) + Scharr", StaticPipeline<GaussianBlur, ScharrOperator>(),
+                                 FilterPipeline().addGaussianBlur().addScharrOperator(), input, iterations));
+        report.push_back(compare("GaussianBlur(7) + Blur(5) + Sobel(5) + LoG",
+                                 StaticPipeline(GaussianBlur(7), Blur(5), SobelOperator(5), LaplacianOfGaussian()),
+                                 FilterPipeline().addGaussianBlur(7).addBlur(5).addSobelOperator(5).addLaplacianOfGaussian(),
+                                 input, iterations));
+    }
+
+    std::cout << std::endl << "SIMD kernels: " << activeSimdKernels().name << std::endl;
+    for (const auto& line : report) {
+        std::cout << line << std::endl;
+    }
+
+    return 0;
+}
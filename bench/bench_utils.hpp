@@ -0,0 +1,29 @@
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "types.hpp"
+
+FlatImage randomImage(int rows, int cols, unsigned int seed = 42) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> dist(0, 255);
+    FlatImage image(rows, cols);
+    for (auto& px : image) {
+        px = static_cast<uchar>(dist(rng));
+    }
+    return image;
+}
+
+template <typename Fn>
+double medianMicroseconds(Fn&& fn, int iterations) {
+    std::vector<double> samples;
+    for (int it = 0; it < iterations; ++it) {
+        auto start = std::chrono::high_resolution_clock::now();
+        fn();
+        auto end = std::chrono::high_resolution_clock::now();
+        samples.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
@@ -0,0 +1,73 @@
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "bench_utils.hpp"
+#include "filter_pipeline.hpp"
+#include "video_pipeline.hpp"
+
+// Stands in for a decoder or encoder that blocks for a fixed time per frame (I/O, a hardware
+// codec), so the overlap between stages is visible even on a single core
+class ThrottledSource : public FrameSource {
+public:
+    ThrottledSource(int rows, int cols, int frames, std::chrono::microseconds delay) : source(rows, cols, frames), delay(delay) {}
+
+    bool read(FlatImage& frame) override {
+        std::this_thread::sleep_for(delay);
+        return source.read(frame);
+    }
+
+private:
+    SyntheticFrameSource source;
+    std::chrono::microseconds delay;
+};
+
+class ThrottledSink : public FrameSink {
+public:
+    explicit ThrottledSink(std::chrono::microseconds delay) : delay(delay) {}
+
+    void write(const FlatImage&) override {
+        std::this_thread::sleep_for(delay);
+    }
+
+private:
+    std::chrono::microseconds delay;
+};
+
+int main(int argc, char** argv) {
+    const int frames = argc > 1 ? std::stoi(argv[1]) : 120;
+    const int rows = 720, cols = 1280;
+    const auto ioDelay = std::chrono::microseconds(argc > 2 ? std::stoi(argv[2]) : 4000);
+    auto pipeline = FilterPipeline().addGaussianBlur().addSobelOperator();
+
+    // one frame after another: read, filter, write
+    double sequentialSeconds;
+    {
+        ThrottledSource source(rows, cols, frames, ioDelay);
+        ThrottledSink sink(ioDelay);
+        FlatImage input, output;
+        auto start = std::chrono::steady_clock::now();
+        while (source.read(input)) {
+            pipeline.apply(input, output);
+            sink.write(output);
+        }
+        sequentialSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::cerr << "Frames: " << frames << " of " << cols << "x" << rows << ", read/write delay "
+              << ioDelay.count() << " us" << std::endl;
+    std::cerr << "Sequential loop:      " << frames / sequentialSeconds << " frames/s" << std::endl;
+
+    for (size_t ringFrames : {1, 3, 6}) {
+        ThrottledSource source(rows, cols, frames, ioDelay);
+        ThrottledSink sink(ioDelay);
+        VideoReport report = VideoPipeline(pipeline, {ringFrames}).run(source, sink);
+        std::cerr << "VideoPipeline ring " << ringFrames << ": " << report.framesPerSecond << " frames/s ("
+                  << report.framesPerSecond * sequentialSeconds / frames << "x), latency mean "
+                  << report.meanLatencyMs << " ms, max " << report.maxLatencyMs << " ms; busy read "
+                  << report.readSeconds << " s, filter " << report.filterSeconds << " s, write "
+                  << report.writeSeconds << " s" << std::endl;
+    }
+
+    return 0;
+}
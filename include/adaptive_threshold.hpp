@@ -0,0 +1,25 @@
+# pragma once
+
+#include "image_filter.hpp"
+#include "types.hpp"
+
+#include <opencv2/opencv.hpp>
+
+class AdaptiveThreshold : public ImageFilter
+{
+public:
+    // maxValue where a pixel exceeds the mean of its ksize x ksize window minus offset, else 0.
+    // Matches cv::adaptiveThreshold with ADAPTIVE_THRESH_MEAN_C and THRESH_BINARY. Window sums
+    // come from an IntegralImage, so every size costs the same per pixel.
+    explicit AdaptiveThreshold(int ksize = 15, int offset = 5, uchar maxValue = 255);
+
+    void apply(const FlatImage& input, FlatImage& output) const override;
+    void applyBenchmark(const cv::Mat& input, cv::Mat& output) const override;
+    int radius() const override { return ksize / 2; }
+    std::string signature() const override;
+
+private:
+    int ksize;
+    int offset;
+    uchar maxValue;
+};
@@ -8,14 +8,21 @@
 class Blur : public ImageFilter
 {
 public:
-    static constexpr float KERNEL[3][3] = {
-        {.11, .11, .11},
-        {.11, .11, .11},
-        {.11, .11, .11}
-    };
-
-    Blur() {}
+    // Mean over a ksize x ksize box (any odd size), computed in fixed point with running sums so
+    // large boxes cost the same per pixel as 3x3. Matches cv::blur with replicated borders.
+    explicit Blur(int ksize = 3);
 
     void apply(const FlatImage& input, FlatImage& output) const override;
+    void applyChannels(const ChannelImage<uchar>& input, ChannelImage<uchar>& output) const override;
+    void applyChannels(const ChannelImage<uint16_t>& input, ChannelImage<uint16_t>& output) const override;
+    void applyChannels(const ChannelImage<float>& input, ChannelImage<float>& output) const override;
     void applyBenchmark(const cv::Mat& input, cv::Mat& output) const override;
+    // Row form used by StaticPipeline; see RowFilter
+    void applyRow(const uchar* const* window, uchar* out, int cols, RowScratch& scratch) const;
+    int radius() const override { return ksize / 2; }
+    std::string signature() const override { return "Blur(" + std::to_string(ksize) + ")"; }
+    std::vector<int> smoothingTaps() const override { return std::vector<int>(ksize, 1); }
+
+private:
+    int ksize;
 };
@@ -0,0 +1,43 @@
+# pragma once
+
+#include "gradient_field.hpp"
+#include "image_filter.hpp"
+#include "types.hpp"
+
+#include <opencv2/opencv.hpp>
+
+class CannyEdgeDetector : public ImageFilter
+{
+public:
+    // Thin edges (255) along the ridges of the 3x3 Sobel gradient magnitude: pixels above
+    // highThreshold start an edge, which extends through 8-connected pixels above lowThreshold.
+    // norm selects |gx| + |gy| or the Euclidean magnitude, like cv::Canny's L2gradient.
+    CannyEdgeDetector(double lowThreshold = 50, double highThreshold = 150, GradientNorm norm = GradientNorm::L1);
+
+    void apply(const FlatImage& input, FlatImage& output) const override;
+    void applyBenchmark(const cv::Mat& input, cv::Mat& output) const override;
+    // hysteresis follows an edge as far as it goes
+    int radius() const override { return UNBOUNDED_RADIUS; }
+    std::string signature() const override;
+
+    // Candidate states left by non-maximum suppression
+    static constexpr uchar WEAK = 1;
+    static constexpr uchar STRONG = 2;
+
+    // Keeps the pixels whose magnitude peaks across the edge direction, marking them WEAK above
+    // lowThreshold and STRONG above highThreshold; the others become 0. Neighbours outside the
+    // image count as zero, and ties on plateaus are broken as in cv::Canny.
+    void suppressNonMaxima(const GradientField& field, FlatImage& candidates) const;
+
+    // Hysteresis: writes 255 for every candidate 8-connected to a STRONG one and 0 elsewhere.
+    // Row chunks split their rows into horizontal runs of candidates and link the runs with
+    // union-find in parallel, the seams between chunks are joined, and a last parallel pass
+    // marks the sets that contain a strong pixel. Every pass scans rows in order, so no
+    // recursion or flood-fill stack is involved.
+    static void traceEdges(const FlatImage& candidates, FlatImage& output);
+
+private:
+    double lowThreshold;
+    double highThreshold;
+    GradientNorm norm;
+};
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+
+#include <opencv2/opencv.hpp>
+
+#include "types.hpp"
+
+enum class ChannelLayout
+{
+    Interleaved, // every row holds cols * channels samples, pixel by pixel (the cv::Mat layout)
+    Planar       // one rows x cols plane per channel, stacked in a single allocation
+};
+
+// Sample types the filters accept, with the matching OpenCV depth
+template <typename T>
+concept ChannelSample = std::is_same_v<T, uchar> || std::is_same_v<T, uint16_t> || std::is_same_v<T, float>;
+
+template <ChannelSample T>
+constexpr int sampleDepth() {
+    if constexpr (std::is_same_v<T, uchar>) {
+        return CV_8U;
+    } else if constexpr (std::is_same_v<T, uint16_t>) {
+        return CV_16U;
+    } else {
+        return CV_32F;
+    }
+}
+
+// Image with `channels` samples of type T per pixel, stored as one FlatArray of samples: rows x
+// (cols * channels) when interleaved, (channels * rows) x cols when planar. Ownership, views
+// and allocators follow the FlatArray underneath, so a ChannelImage can view a cv::Mat or a
+// caller's buffer without copying.
+template <ChannelSample T>
+class ChannelImage {
+public:
+    ChannelImage() = default;
+
+    explicit ChannelImage(PixelAllocator& allocator) : _samples(allocator) {}
+
+    ChannelImage(int rows, int cols, int channels, ChannelLayout layout = ChannelLayout::Interleaved,
+                 PixelAllocator& allocator = defaultPixelAllocator())
+        : _samples(allocator) {
+        resize(rows, cols, channels, layout);
+    }
+
+    // Adopts an existing sample array (typically a view) laid out as described above
+    ChannelImage(FlatArray<T> samples, int channels, ChannelLayout layout) : _samples(std::move(samples)) {
+        if (channels <= 0 || (layout == ChannelLayout::Interleaved ? _samples.cols() : _samples.rows()) % channels != 0) {
+            throw std::invalid_argument("Sample array does not divide into the channels.");
+        }
+        _channels = channels;
+        _layout = layout;
+        _rows = layout == ChannelLayout::Interleaved ? _samples.rows() : _samples.rows() / channels;
+        _cols = layout == ChannelLayout::Interleaved ? _samples.cols() / channels : _samples.cols();
+    }
+
+    // Resizing to the current shape keeps the pixels, so filters write straight into views
+    void resize(int rows, int cols, int channels, ChannelLayout layout) {
+        if (rows < 0 || cols < 0 || channels <= 0) {
+            throw std::invalid_argument("Invalid ChannelImage dimensions.");
+        }
+        _rows = rows;
+        _cols = cols;
+        _channels = channels;
+        _layout = layout;
+        if (layout == ChannelLayout::Interleaved) {
+            _samples.resize(rows, cols * channels);
+        } else {
+            _samples.resize(rows * channels, cols);
+        }
+    }
+
+    // Same shape and layout as `other`
+    template <ChannelSample U>
+    void resizeLike(const ChannelImage<U>& other) {
+        resize(other.rows(), other.cols(), other.channels(), other.layout());
+    }
+
+    // View of one channel's plane; planar images and single-channel images only
+    FlatArray<T> plane(int channel) {
+        checkPlane(channel);
+        return _samples.subView(channel * _rows, 0, _rows, _samples.cols());
+    }
+
+    const FlatArray<T> plane(int channel) const {
+        checkPlane(channel);
+        return _samples.subView(channel * _rows, 0, _rows, _samples.cols());
+    }
+
+    inline T& operator()(int i, int j, int channel) {
+        return _layout == ChannelLayout::Interleaved ? _samples(i, j * _channels + channel) : _samples(channel * _rows + i, j);
+    }
+
+    inline const T& operator()(int i, int j, int channel) const {
+        return const_cast<ChannelImage*>(this)->operator()(i, j, channel);
+    }
+
+    FlatArray<T>& samples() { return _samples; }
+    const FlatArray<T>& samples() const { return _samples; }
+
+    int rows() const { return _rows; }
+    int cols() const { return _cols; }
+    int channels() const { return _channels; }
+    ChannelLayout layout() const { return _layout; }
+
+    // Number of pixels, not samples
+    size_t size() const { return static_cast<size_t>(_rows) * _cols; }
+    bool empty() const { return size() == 0; }
+
+private:
+    void checkPlane(int channel) const {
+        if (channel < 0 || channel >= _channels || (_layout == ChannelLayout::Interleaved && _channels > 1)) {
+            throw std::invalid_argument("Only planar images have a plane per channel.");
+        }
+    }
+
+    FlatArray<T> _samples;
+    int _rows = 0;
+    int _cols = 0;
+    int _channels = 1;
+    ChannelLayout _layout = ChannelLayout::Interleaved;
+};
+
+class ChannelImageFactory {
+public:
+    // Zero-copy interleaved view of a Mat with 8-bit, 16-bit unsigned or float samples and any
+    // channel count, ROIs included. Like FlatImageFactory::wrap, the view keeps a refcounted
+    // Mat's buffer alive.
+    template <ChannelSample T>
+    static ChannelImage<T> wrap(const cv::Mat& mat) {
+        if (mat.depth() != sampleDepth<T>() || mat.dims != 2) {
+            throw std::invalid_argument("cv::Mat depth does not match the ChannelImage sample type.");
+        }
+        auto owner = std::make_shared<cv::Mat>(mat);
+        auto samples = FlatArray<T>::adopt(reinterpret_cast<T*>(owner->data), mat.rows, mat.cols * mat.channels(),
+                                           static_cast<int>(mat.step[0] / sizeof(T)), owner);
+        return ChannelImage<T>(std::move(samples), mat.channels(), ChannelLayout::Interleaved);
+    }
+
+    // Copies the pixels into a new owning image in the requested layout
+    template <ChannelSample T>
+    static ChannelImage<T> from(const cv::Mat& mat, ChannelLayout layout = ChannelLayout::Interleaved) {
+        const ChannelImage<T> view = wrap<T>(mat);
+        ChannelImage<T> image(view.rows(), view.cols(), view.channels(), layout);
+        convert(view, image);
+        return image;
+    }
+
+    // Non-owning Mat header over an interleaved image, valid while the image's pixels are
+    template <ChannelSample T>
+    static cv::Mat toMat(ChannelImage<T>& image) {
+        if (image.layout() != ChannelLayout::Interleaved && image.channels() > 1) {
+            throw std::invalid_argument("Only interleaved images map onto a cv::Mat.");
+        }
+        return cv::Mat(image.rows(), image.cols(), CV_MAKETYPE(sampleDepth<T>(), image.channels()),
+                       image.samples().data(), image.samples().stride() * sizeof(T));
+    }
+
+    // Copies `input` into `output`'s layout, interleaving or splitting the channels as needed.
+    // output keeps its layout and takes the input's dimensions.
+    template <ChannelSample T>
+    static void convert(const ChannelImage<T>& input, ChannelImage<T>& output) {
+        output.resize(input.rows(), input.cols(), input.channels(), output.layout());
+        if (input.layout() == output.layout() || input.channels() == 1) {
+            const FlatArray<T>& from = input.samples();
+            FlatArray<T>& to = output.samples();
+            for (int i = 0; i < from.rows(); ++i) {
+                std::copy(from.row(i), from.row(i) + from.cols(), to.row(i));
+            }
+            return;
+        }
+        const int channels = input.channels();
+        const bool split = input.layout() == ChannelLayout::Interleaved;
+        for (int c = 0; c < channels; ++c) {
+            for (int i = 0; i < input.rows(); ++i) {
+                const T* from = split ? input.samples().row(i) + c : &input(i, 0, c);
+                T* to = split ? &output(i, 0, c) : output.samples().row(i) + c;
+                const int fromStep = split ? channels : 1;
+                const int toStep = split ? 1 : channels;
+                for (int j = 0; j < input.cols(); ++j) {
+                    to[j * toStep] = from[j * fromStep];
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "types.hpp"
+
+// 64-bit hash of an image's dimensions and pixels, to recognise frames seen before. Rows are
+// hashed as one byte stream whatever the stride or guard band, so a view and a copy of the same
+// pixels hash alike. The stripes of the stream go through the active SIMD kernel set and run at
+// memory bandwidth, far below the cost of any filter. Not cryptographic: an adversary can build
+// collisions, and the value depends on the platform's byte order.
+uint64_t contentHash(const FlatImage& image);
+
+// The same hash over a plain byte range
+uint64_t contentHash(const void* data, size_t size);
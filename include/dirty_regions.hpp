@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "types.hpp"
+
+// Pixels in rows [row, row + rows) and columns [col, col + cols)
+struct PixelRect
+{
+    int row = 0;
+    int col = 0;
+    int rows = 0;
+    int cols = 0;
+
+    bool empty() const { return rows <= 0 || cols <= 0; }
+    size_t area() const { return empty() ? 0 : static_cast<size_t>(rows) * cols; }
+    bool operator==(const PixelRect&) const = default;
+};
+
+// Compares two frames in blockSize x blockSize cells and returns rectangles covering every
+// cell that differs: runs of changed cells in a cell row, stacked where consecutive rows have
+// the same run. Rows that match as a whole are skipped with a single memcmp. Frames of
+// different dimensions count as changed everywhere.
+std::vector<PixelRect> findChangedRects(const FlatImage& previous, const FlatImage& current, int blockSize = 32);
+
+// Disjoint rectangles covering `rects` grown by halo on every side and clipped to a rows x cols
+// image. Overlapping rectangles are merged into their bounding box, and so are rectangles whose
+// box, halo included, costs no more to recompute than both of them.
+std::vector<PixelRect> coverRects(const std::vector<PixelRect>& rects, int halo, int rows, int cols);
@@ -1,20 +1,162 @@
 # pragma once
 
+#include <optional>
+
 #include <opencv2/opencv.hpp>
+#include "dirty_regions.hpp"
 #include "image_filter.hpp"
+#include "pipeline_plan.hpp"
+#include "result_cache.hpp"
+#include "strip_io.hpp"
+
+// Tile geometry for FilterPipeline::applyTiled. Zero tile dimensions derive a square tile
+// whose working set fits in cacheBytes (the L2 size when it can be queried).
+struct TileOptions
+{
+    int tileRows = 0;
+    int tileCols = 0;
+    size_t cacheBytes = 0;
+};
+
+// How FilterPipeline::applyBatch spreads a batch over the cores
+enum class BatchParallelism
+{
+    Auto,         // chosen from the batch size, image size and core count
+    AcrossImages, // one image per task, rows processed serially
+    AcrossRows,   // one image after another, rows in parallel
+    Both          // images in parallel, and idle workers steal row tasks
+};
+
+struct BatchOptions
+{
+    BatchParallelism parallelism = BatchParallelism::Auto;
+    // Auto runs images with at most this many pixels serially, one per task, once the batch
+    // has at least one image per core
+    size_t smallImagePixels = 1 << 20;
+};
+
+struct BatchReport
+{
+    size_t images = 0;
+    double seconds = 0;
+    double imagesPerSecond = 0;
+    BatchParallelism parallelism = BatchParallelism::Auto; // what was actually used
+};
+
+struct IncrementalOptions
+{
+    // Cell size of the frame diff when the dirty rectangles are detected
+    int blockSize = 32;
+    // Filter the whole frame once the rectangles to recompute, halos included, cover more than
+    // this share of it
+    double maxRecomputeFraction = 0.5;
+};
+
+struct IncrementalReport
+{
+    std::vector<PixelRect> dirty;      // changed input rectangles, given or detected
+    std::vector<PixelRect> recomputed; // output rectangles recomputed; the whole frame on fallback
+    size_t pixels = 0;                 // output pixels recomputed
+    bool full = false;                 // the whole frame was filtered
+};
 
 class FilterPipeline
 {
 public:
     FilterPipeline& add(const std::shared_ptr<const ImageFilter>& filter);
-    FilterPipeline& addBlur();
+    FilterPipeline& addBlur(int ksize = 3);
+    FilterPipeline& addGaussianBlur(int ksize = 5);
+    FilterPipeline& addLaplacianOfGaussian();
     FilterPipeline& addScharrOperator();
-    FilterPipeline& addSobelOperator();
+    FilterPipeline& addSobelOperator(int ksize = 3);
+    FilterPipeline& addLocalVariance(int ksize = 15);
+    FilterPipeline& addAdaptiveThreshold(int ksize = 15, int offset = 5);
+    FilterPipeline& addCannyEdgeDetector(double lowThreshold = 50, double highThreshold = 150, GradientNorm norm = GradientNorm::L1);
 
+    // Runs the chain serially, row-parallel or tile-parallel as executionPolicy() decides for
+    // the input's size. output may be, or overlap, the input.
     void apply(const FlatImage& input, FlatImage& output);
     void applyBenchmark(const cv::Mat& input, cv::Mat& output);
 
+    // Runs the chain over every channel of an 8-bit, 16-bit or float image, keeping its layout.
+    // The smoothing and gradient filters run all channels in one pass; the other filters accept
+    // 8-bit images only and run plane by plane. Rows run in parallel as executionPolicy() decides;
+    // multi-channel images are not tiled.
+    template <ChannelSample T>
+    void apply(const ChannelImage<T>& input, ChannelImage<T>& output);
+
+    // Splits the image into cache-sized tiles and runs the whole chain on each tile, in
+    // parallel, before moving on. Every tile is extended by haloRadius() pixels (clipped to
+    // the image) so the result matches apply() bit for bit. Chains with an unbounded radius
+    // run on the whole image instead.
+    void applyTiled(const FlatImage& input, FlatImage& output, const TileOptions& options = {}) const;
+
+    // Computes output rows [row, row + rows) and columns [col, col + cols) of the full chain.
+    // output must already have the input's dimensions.
+    void applyRegion(const FlatImage& input, FlatImage& output, int row, int col, int rows, int cols) const;
+
+    // Updates output, this pipeline's result for an earlier frame, for input, which differs from
+    // that frame only inside `dirty`. Every rectangle is grown by haloRadius(), the reach of the
+    // whole chain, overlapping ones are merged, and only those output pixels are recomputed with
+    // applyRegion, so the result matches apply() bit for bit. Falls back to apply() when output
+    // does not match the input's dimensions, the chain has an unbounded radius, or the rectangles
+    // exceed options.maxRecomputeFraction of the frame.
+    IncrementalReport applyIncremental(const FlatImage& input, FlatImage& output, const std::vector<PixelRect>& dirty,
+                                       const IncrementalOptions& options = {});
+
+    // As above, with the dirty rectangles found by comparing input against previousInput, the
+    // frame output was computed from, in options.blockSize cells (see findChangedRects)
+    IncrementalReport applyIncremental(const FlatImage& previousInput, const FlatImage& input, FlatImage& output,
+                                       const IncrementalOptions& options = {});
+
+    // Pulls strips of stripRows rows from reader, runs the chain over each strip together with
+    // haloRadius() rows above and below it, and hands the finished rows to writer. Halo rows
+    // are carried over between strips instead of re-read. Memory scales with
+    // (stripRows + 2 * haloRadius()) x cols, and the result matches apply() bit for bit.
+    // Chains with an unbounded radius cannot be streamed and throw std::invalid_argument.
+    void applyStreaming(StripReader& reader, StripWriter& writer, int stripRows = 256) const;
+
+    // Filters every input into the matching output on TBB's work-stealing scheduler. outputs is
+    // resized to the number of inputs unless it already matches, so it may hold views.
+    BatchReport applyBatch(const std::vector<FlatImage>& inputs, std::vector<FlatImage>& outputs, const BatchOptions& options = {}) const;
+
+    // apply, applyTiled, applyRegion and applyStreaming run the plan built from the stages
+    // rather than the stages one by one; see PipelinePlan. Multi-channel images skip the
+    // dropped stages but run folded ones unfolded, and applyBenchmark runs every stage.
+    void setPlanOptions(const PlanOptions& options);
+    const PipelinePlan& plan() const;
+
+    // Optional cache in front of apply and applyBatch. A frame is hashed with contentHash() and
+    // looked up together with signature(); on a hit the stored result is copied out instead of
+    // running the chain. Pipelines with a stage of unknown signature never use the cache. One
+    // cache may be shared by several pipelines; pass nullptr to detach it.
+    void setResultCache(std::shared_ptr<ResultCache> cache);
+    const std::shared_ptr<ResultCache>& resultCache() const;
+
+    // Stage signatures and the plan options that change pixels, e.g. "Blur(3)|SobelOperator(3)";
+    // empty when the pipeline has no stages or a stage has no signature
+    const std::string& signature() const;
+
+    // Policy used by this pipeline's apply* calls; defaults to defaultExecutionPolicy() at the
+    // time of the call
+    void setExecutionPolicy(const ExecutionPolicy& executionPolicy);
+    ExecutionPolicy executionPolicy() const;
+
+    // Sum of the filter radii: how far the chain looks around each output pixel, or
+    // ImageFilter::UNBOUNDED_RADIUS when any filter looks at the whole image
+    int haloRadius() const;
+
 private:
+    void applyChain(const FlatImage& input, FlatImage& output) const;
+    void applyWithPolicy(const FlatImage& input, FlatImage& output) const;
+    void rebuildPlan();
+
     std::vector<std::shared_ptr<const ImageFilter>> filters;
+    std::optional<ExecutionPolicy> policy;
+    PlanOptions planOptions;
+    PipelinePlan executionPlan;
+    std::shared_ptr<ResultCache> cache;
+    std::string pipelineSignature;
+    uint64_t signatureHash = 0;
 
 };
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+
+// Rounded division of non-negative integers by a run-time constant as one multiply and shift:
+// (x + divisor / 2) / divisor, exact for every x up to maxDividend. The 32 x 32 -> 64-bit
+// multiply keeps loops over arrays of dividends vectorizable.
+struct FixedPointDivisor
+{
+    uint32_t bias;
+    uint32_t multiplier = 0;
+    int shift = 0;
+
+    FixedPointDivisor(uint32_t divisor, uint32_t maxDividend) : bias(divisor / 2) {
+        if (divisor == 0 || maxDividend > UINT32_MAX - bias) {
+            throw std::invalid_argument("Invalid fixed-point divisor range.");
+        }
+
+        // m = ceil(2^s / divisor) overshoots 1 / divisor by e / (divisor * 2^s), with
+        // e = m * divisor - 2^s; the quotient stays exact while limit * e < 2^s.
+        const uint64_t limit = static_cast<uint64_t>(maxDividend) + bias;
+        for (; shift < 64; ++shift) {
+            const uint64_t power = uint64_t(1) << shift;
+            const uint64_t candidate = (power + divisor - 1) / divisor;
+            if (candidate > UINT32_MAX) {
+                break;
+            }
+            if (limit * (candidate * divisor - power) < power) {
+                multiplier = static_cast<uint32_t>(candidate);
+                return;
+            }
+        }
+        throw std::invalid_argument("Divisor too large for an exact fixed-point reciprocal.");
+    }
+
+    uint32_t operator()(uint32_t x) const {
+        return static_cast<uint32_t>((static_cast<uint64_t>(x + bias) * multiplier) >> shift);
+    }
+};
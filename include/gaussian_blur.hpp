@@ -0,0 +1,29 @@
+# pragma once
+
+#include "image_filter.hpp"
+#include "types.hpp"
+
+#include <opencv2/opencv.hpp>
+
+class GaussianBlur : public ImageFilter
+{
+public:
+    // ksize selects kernels::GAUSSIAN_3, GAUSSIAN_5 or GAUSSIAN_7, applied separably in fixed point
+    explicit GaussianBlur(int ksize = 5);
+
+    void apply(const FlatImage& input, FlatImage& output) const override;
+    void applyChannels(const ChannelImage<uchar>& input, ChannelImage<uchar>& output) const override;
+    void applyChannels(const ChannelImage<uint16_t>& input, ChannelImage<uint16_t>& output) const override;
+    void applyChannels(const ChannelImage<float>& input, ChannelImage<float>& output) const override;
+    void applyBenchmark(const cv::Mat& input, cv::Mat& output) const override;
+    // Row form used by StaticPipeline; see RowFilter
+    void applyRow(const uchar* const* window, uchar* out, int cols, RowScratch& scratch) const;
+    int radius() const override { return ksize / 2; }
+    std::string signature() const override { return "GaussianBlur(" + std::to_string(ksize) + ")"; }
+    std::vector<int> smoothingTaps() const override;
+
+private:
+    std::span<const int> taps() const;
+
+    int ksize;
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "types.hpp"
+
+enum class GradientNorm
+{
+    L1, // |gx| + |gy|
+    L2  // sqrt(gx^2 + gy^2)
+};
+
+// Gradient direction quantized to the four sectors edge thinning needs. Diagonal and
+// AntiDiagonal are told apart by the signs of the raw kernel responses, so which image diagonal
+// they point along depends on the kernels' sign convention (the Sobel and Scharr KERNELY respond
+// positively to intensity increasing upwards).
+enum class GradientDirection : uchar
+{
+    Horizontal,  // |gy| <= tan(22.5 deg) * |gx|
+    Diagonal,    // neither, gx and gy have the same sign
+    Vertical,    // |gy| > tan(67.5 deg) * |gx|
+    AntiDiagonal // neither, gx and gy have opposite signs
+};
+
+// Which members of a GradientField a sweep writes; the others are left empty
+enum GradientOutputs : unsigned
+{
+    GradientDerivatives = 1, // gx and gy
+    GradientMagnitude = 2,
+    GradientOrientation = 4,
+    AllGradientOutputs = 7
+};
+
+// Signed gradient of an X/Y kernel pair, its magnitude and quantized orientation, all computed in
+// the same sweep over the image. Derivatives saturate to int16; for 3x3 kernels whose absolute
+// weights sum to at most 128 they never do. orientation holds GradientDirection values.
+struct GradientField
+{
+    GradientField() = default;
+    explicit GradientField(PixelAllocator& allocator) : gx(allocator), gy(allocator), magnitude(allocator), orientation(allocator) {}
+
+    GradientNorm norm = GradientNorm::L2;
+    unsigned outputs = AllGradientOutputs;
+
+    FlatArray<int16_t> gx, gy;
+    FlatArray<float> magnitude;
+    FlatImage orientation;
+
+    // Sizes the requested members and empties the rest
+    void resize(int rows, int cols) {
+        gx.resize((outputs & GradientDerivatives) ? rows : 0, (outputs & GradientDerivatives) ? cols : 0);
+        gy.resize((outputs & GradientDerivatives) ? rows : 0, (outputs & GradientDerivatives) ? cols : 0);
+        magnitude.resize((outputs & GradientMagnitude) ? rows : 0, (outputs & GradientMagnitude) ? cols : 0);
+        orientation.resize((outputs & GradientOrientation) ? rows : 0, (outputs & GradientOrientation) ? cols : 0);
+    }
+};
+
+// tan(22.5 deg) in 0.16 fixed point: (a * TAN_22_5_Q16) >> 16 is one 16-bit high multiply,
+// which the SIMD rows use as well
+constexpr int TAN_22_5_Q16 = 27146;
+
+// The sector boundaries are those of cv::Canny (tan(67.5 deg) = 2 + tan(22.5 deg)), so edge
+// thinning keeps the same pixels
+inline GradientDirection quantizeDirection(int gx, int gy) {
+    const int ax = std::abs(gx), ay = std::abs(gy);
+    const int tan22 = (ax * TAN_22_5_Q16) >> 16;
+    if (ay <= tan22) {
+        return GradientDirection::Horizontal;
+    }
+    if (ay > 2 * ax + tan22) {
+        return GradientDirection::Vertical;
+    }
+    return (gx ^ gy) < 0 ? GradientDirection::AntiDiagonal : GradientDirection::Diagonal;
+}
+
+// L2 takes the correctly rounded float square root of the exact integer sum, which is what
+// the vector sqrt instructions return as well
+inline float gradientMagnitude(int gx, int gy, GradientNorm norm) {
+    if (norm == GradientNorm::L1) {
+        return static_cast<float>(std::abs(gx) + std::abs(gy));
+    }
+    return std::sqrt(static_cast<float>(static_cast<int64_t>(gx) * gx + static_cast<int64_t>(gy) * gy));
+}
+
+// Row pointers into a GradientField; members that were not requested are null
+struct GradientRow
+{
+    int16_t* gx;
+    int16_t* gy;
+    float* magnitude;
+    uchar* orientation;
+
+    GradientRow(GradientField& field, int row)
+        : gx(field.gx.empty() ? nullptr : field.gx.row(row)),
+          gy(field.gy.empty() ? nullptr : field.gy.row(row)),
+          magnitude(field.magnitude.empty() ? nullptr : field.magnitude.row(row)),
+          orientation(field.orientation.empty() ? nullptr : field.orientation.row(row)) {}
+
+    // The same row starting `columns` pixels further right
+    GradientRow shifted(int columns) const {
+        GradientRow row = *this;
+        if (gx) {
+            row.gx += columns;
+            row.gy += columns;
+        }
+        if (magnitude) {
+            row.magnitude += columns;
+        }
+        if (orientation) {
+            row.orientation += columns;
+        }
+        return row;
+    }
+
+    // Saturates the raw kernel responses and writes pixel j of every requested output
+    void store(int j, int rawX, int rawY, GradientNorm norm) const {
+        const int x = std::clamp(rawX, static_cast<int>(std::numeric_limits<int16_t>::min()), static_cast<int>(std::numeric_limits<int16_t>::max()));
+        const int y = std::clamp(rawY, static_cast<int>(std::numeric_limits<int16_t>::min()), static_cast<int>(std::numeric_limits<int16_t>::max()));
+        if (gx) {
+            gx[j] = static_cast<int16_t>(x);
+            gy[j] = static_cast<int16_t>(y);
+        }
+        if (magnitude) {
+            magnitude[j] = gradientMagnitude(x, y, norm);
+        }
+        if (orientation) {
+            orientation[j] = static_cast<uchar>(quantizeDirection(x, y));
+        }
+    }
+};
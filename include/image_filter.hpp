@@ -1,25 +1,327 @@
 # pragma once
 
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
 #include <opencv2/opencv.hpp>
+
+#include "channel_image.hpp"
+#include "fixed_point.hpp"
+#include "gradient_field.hpp"
+#include "kernel.hpp"
+#include "parallel_utils.hpp"
+#include "prof_utils.hpp"
 #include "types.hpp"
 
+template <typename T>
+concept ConvolutionKernel = requires(const T& kernel) {
+    kernel.taps;
+    kernel.divisor;
+    kernelRadiusY(kernel);
+    kernelRadiusX(kernel);
+};
+
+// What one StaticPipeline stage carries from one output row to the next. The stage produces
+// consecutive rows, so the row forms can keep running sums in `sums` (rowScratchSize(cols,
+// radius) of them) and their divisor in `divide`. `leaving` is the source row that dropped out
+// of the window since the previous row, and nullptr on the first row of a stream.
+struct RowScratch
+{
+    uint32_t* sums = nullptr;
+    const uchar* leaving = nullptr;
+    std::optional<FixedPointDivisor> divide;
+};
+
+// Rank-1 3x3 kernel: kernel[r][c] == column[r] * row[c].
+template <typename KType>
+struct SeparableKernel
+{
+    KType column[3];
+    KType row[3];
+};
+
 class ImageFilter
 {
 public:
     virtual void apply(const FlatImage& input, FlatImage& output) const = 0;
     virtual void applyBenchmark(const cv::Mat& input, cv::Mat& output) const = 0;
 
+    // Number of neighbouring pixels on each side an output pixel depends on. Tiled and
+    // strip-based execution use it to size the halo around each region. Filters whose output
+    // can depend on any pixel of the image return UNBOUNDED_RADIUS and always see it whole.
+    virtual int radius() const { return 1; }
+    static constexpr int UNBOUNDED_RADIUS = std::numeric_limits<int>::max();
+
+    // Filters every channel of a multi-channel image into an output of the same shape and
+    // layout. By default 8-bit images run apply() once per channel plane (interleaved inputs
+    // are split into planes first) and other sample types are rejected; filters with a native
+    // path (the smoothing and gradient filters) convolve all channels in one pass.
+    virtual void applyChannels(const ChannelImage<uchar>& input, ChannelImage<uchar>& output) const;
+    virtual void applyChannels(const ChannelImage<uint16_t>& input, ChannelImage<uint16_t>& output) const;
+    virtual void applyChannels(const ChannelImage<float>& input, ChannelImage<float>& output) const;
+
+    // Signed X/Y derivatives with their magnitude and orientation, for filters built on an X/Y
+    // kernel pair; see GradientField. Other filters throw std::invalid_argument.
+    virtual void applyGradientField(const FlatImage& input, GradientField& field) const;
+
+    // Integer taps t when the filter is a symmetric smoothing by the outer product t x t divided
+    // by sum(t)^2, with replicated borders and one rounding; empty for every other filter.
+    // Pipeline plans fold consecutive smoothing stages through it.
+    virtual std::vector<int> smoothingTaps() const { return {}; }
+
+    // Name and parameters of what the filter computes, e.g. "Blur(5)": filters with equal
+    // signatures give equal outputs for every input. Empty when unknown, which keeps pipelines
+    // containing the filter out of result caches.
+    virtual std::string signature() const { return {}; }
+
     virtual ~ImageFilter() = default;
 
 protected:
+    // The apply* helpers, boxMean, smoothSeparable and the channel sweeps accept an output that
+    // is, or overlaps, the input; they then filter into arena scratch and copy the result back.
     template <typename KType>
     void applyXYKernels(const FlatImage& input, FlatImage& output, const KType kernelX[3][3], const KType kernelY[3][3], uchar threshold = 0) const;
     template <typename KType>
+    void applyXYKernelsMultiPass(const FlatImage& input, FlatImage& output, const KType kernelX[3][3], const KType kernelY[3][3], uchar threshold = 0) const;
+    template <typename KType>
     void applySingleKernel(const FlatImage& input, FlatImage& output, const KType kernel[3][3], uchar threshold = 0) const;
+    // Fills the requested members of `field` in one sweep instead of the combined 8-bit gradient
+    template <typename KType>
+    void applyXYKernels(const FlatImage& input, GradientField& field, const KType kernelX[3][3], const KType kernelY[3][3]) const;
 
-    static std::pair<int, int> padBoundaries(const FlatImage& input, FlatImage& output);
-    static void removeBoundaries(const FlatImage& input, FlatImage& output);
+    // Kernels declared (or detected) as separable run through the separable passes when they save
+    // enough taps over the dense SIMD rows, and through the fused dense sweep otherwise.
+    template <typename KType>
+    void applySeparableXYKernels(const FlatImage& input, FlatImage& output, const SeparableKernel<KType>& kernelX, const SeparableKernel<KType>& kernelY, uchar threshold = 0) const;
+    template <typename KType>
+    void applySeparableKernel(const FlatImage& input, FlatImage& output, const SeparableKernel<KType>& kernel, uchar threshold = 0) const;
+
+    // Arbitrary-size kernels (Kernel<KType, Rows, Cols> or DynamicKernel<KType>); the border is
+    // padded by the kernel radius.
+    template <ConvolutionKernel KernelType>
+    void applySingleKernel(const FlatImage& input, FlatImage& output, const KernelType& kernel, uchar threshold = 0) const;
+    template <ConvolutionKernel KernelType>
+    void applyXYKernels(const FlatImage& input, FlatImage& output, const KernelType& kernelX, const KernelType& kernelY, uchar threshold = 0) const;
+    template <ConvolutionKernel KernelType>
+    void applyXYKernels(const FlatImage& input, GradientField& field, const KernelType& kernelX, const KernelType& kernelY) const;
+
+    static std::pair<int, int> padBoundaries(const FlatImage& input, FlatImage& output, int radius = 1);
+    static void removeBoundaries(const FlatImage& input, FlatImage& output, int radius = 1);
     template <typename KType> static void getGradient(const FlatImage& input, FlatImage& output, int padded_rows, int padded_cols, const KType kernel[3][3], uchar threshold = 0);
     static void combineGradients(const FlatImage& gx, const FlatImage& gy, FlatImage& combinedGradient, uchar threshold = 0);
 
+    // Single row sweep computing gx, gy, their combination and the threshold with clamped borders.
+    // Produces the same pixels as applyXYKernelsMultiPass without the padded intermediate images.
+    // fusedSingleGradient does the same for padBoundaries + getGradient + removeBoundaries.
+    // Integer kernels run through the SIMD rows selected by activeSimdKernels().
+    template <typename KType> static void fusedXYGradient(const FlatImage& input, FlatImage& output, const KType kernelX[3][3], const KType kernelY[3][3], uchar threshold = 0);
+    // Gradient field counterpart of fusedXYGradient; integer kernels run through the SIMD
+    // gradientFieldRow.
+    template <typename KType> static void fusedGradientField(const FlatImage& input, GradientField& field, const KType kernelX[3][3], const KType kernelY[3][3]);
+    template <typename KType> static void fusedSingleGradient(const FlatImage& input, FlatImage& output, const KType kernel[3][3], uchar threshold = 0);
+
+    // Horizontal 3-tap pass into a rolling row buffer followed by a vertical 3-tap pass: 6 instead
+    // of 9 multiply-adds per pixel. Integer kernels accumulate in int16 when the weights allow it,
+    // and produce the same pixels as the dense paths.
+    template <typename KType> static void separableXYGradient(const FlatImage& input, FlatImage& output, const SeparableKernel<KType>& kernelX, const SeparableKernel<KType>& kernelY, uchar threshold = 0);
+    template <typename KType> static void separableSingleGradient(const FlatImage& input, FlatImage& output, const SeparableKernel<KType>& kernel, uchar threshold = 0);
+    // Finds integer factors of a rank-1 kernel; always fails for floating point kernels.
+    template <typename KType> static bool factorizeKernel(const KType kernel[3][3], SeparableKernel<KType>& separable);
+
+    // Mean of the (2 * radiusY + 1) x (2 * radiusX + 1) window around every pixel, rounded to
+    // nearest in integer arithmetic; matches cv::blur with BORDER_REPLICATE bit for bit. Sliding
+    // column and row sums keep the cost per pixel the same for every radius.
+    static void boxMean(const FlatImage& input, FlatImage& output, int radiusY, int radiusX);
+    // Smooths with the odd-length, non-negative integer taps down the columns and then along the
+    // rows, dividing by the squared tap sum with round-to-nearest (one multiply-shift per pixel).
+    static void smoothSeparable(const FlatImage& input, FlatImage& output, std::span<const int> taps);
+    // The same for every channel at once. Interleaved rows are swept as runs of cols * channels
+    // samples with horizontal taps one pixel (channels samples) apart, so the channels share
+    // every vector instruction. 16-bit samples use the same fixed-point rounding; float samples
+    // accumulate in double and are not rounded.
+    template <ChannelSample T> static void boxMean(const ChannelImage<T>& input, ChannelImage<T>& output, int radiusY, int radiusX);
+    template <ChannelSample T> static void smoothSeparable(const ChannelImage<T>& input, ChannelImage<T>& output, std::span<const int> taps);
+
+    // Integer-kernel convolution of every channel at once, with the response rules of
+    // convolveBordered and convolveXYBordered; 8-bit samples give the same pixels as apply() on
+    // each channel. Rows are swept like the smoothing above, one vector sweep per tap. The
+    // threshold is in 8-bit units and, like the saturation, scales to the sample's full-scale
+    // value: 65535 for 16-bit samples and 1 for float samples, which accumulate in double.
+    template <ChannelSample T> static void convolveChannels(const ChannelImage<T>& input, ChannelImage<T>& output, const DynamicKernel<int>& kernel, uchar threshold = 0);
+    template <ChannelSample T> static void convolveXYChannels(const ChannelImage<T>& input, ChannelImage<T>& output, const DynamicKernel<int>& kernelX, const DynamicKernel<int>& kernelY, uchar threshold = 0);
+
+    // Row forms of the sweeps above, which StaticPipeline streams between fused stages. `window`
+    // holds the 2 * radius + 1 source rows centred on the output row, with rows beyond the image
+    // already clamped; columns are clamped here. The pixels match the whole-image paths. The
+    // smoothing rows take 2 * (cols + 2 * radius) sums of scratch; the box mean slides its
+    // column sums from the previous row when scratch.leaving is set.
+    template <typename KType> static void xyGradientRow(const uchar* const* window, uchar* out, int cols, const KType kernelX[3][3], const KType kernelY[3][3], uchar threshold = 0);
+    template <ConvolutionKernel KernelType> static void convolveRow(const uchar* const* window, uchar* out, int cols, const KernelType& kernel, uchar threshold = 0);
+    template <ConvolutionKernel KernelType> static void convolveXYRow(const uchar* const* window, uchar* out, int cols, const KernelType& kernelX, const KernelType& kernelY, uchar threshold = 0);
+    static void boxMeanRow(const uchar* const* window, uchar* out, int cols, int radius, RowScratch& scratch);
+    static void smoothSeparableRow(const uchar* const* window, uchar* out, int cols, std::span<const int> taps, RowScratch& scratch);
+
+    // Returns `input` itself when its filled border already covers `radius`. Otherwise copies it
+    // into `scratch` with a guard band of `radius` pixels and fills the border there.
+    static const FlatImage& borderedSource(const FlatImage& input, FlatImage& scratch, int radius);
+
+    // Convolves an image whose border() covers the kernel radius, reading the neighbours in place.
+    template <ConvolutionKernel KernelType> static void convolveBordered(const FlatImage& source, FlatImage& output, const KernelType& kernel, uchar threshold = 0);
+    template <ConvolutionKernel KernelType> static void convolveXYBordered(const FlatImage& source, FlatImage& output, const KernelType& kernelX, const KernelType& kernelY, uchar threshold = 0);
+
+private:
+    template <typename RowFn> static void forEachOutputRow(const FlatImage& source, FlatImage& output, RowFn&& rowFn);
+    template <typename ColumnFn> static void forEachWindowColumn(int cols, int radiusX, ColumnFn&& columnFn);
+
 };
+
+
+// Templates over arbitrary kernel sizes are defined here so every size gets its own unrolled instantiation.
+
+// Calls columnFn(idxj, clamped) for every column, where `clamped` is a std::bool_constant that
+// is true for the columns within radiusX of either edge
+template <typename ColumnFn>
+void ImageFilter::forEachWindowColumn(int cols, int radiusX, ColumnFn&& columnFn) {
+    const int interiorBegin = std::min(radiusX, cols);
+    const int interiorEnd = std::max(cols - radiusX, interiorBegin);
+    for (int idxj = 0; idxj < interiorBegin; ++idxj) {
+        columnFn(idxj, std::true_type{});
+    }
+    for (int idxj = interiorBegin; idxj < interiorEnd; ++idxj) {
+        columnFn(idxj, std::false_type{});
+    }
+    for (int idxj = interiorEnd; idxj < cols; ++idxj) {
+        columnFn(idxj, std::true_type{});
+    }
+}
+
+template <typename RowFn>
+void ImageFilter::forEachOutputRow(const FlatImage& source, FlatImage& output, RowFn&& rowFn) {
+    const int rows = source.rows();
+    const int cols = source.cols();
+
+    output.resize(rows, cols);
+
+    forEachIndex(rows, source.size(), [&](int idxi) {
+        rowFn(idxi, &output(idxi, 0), cols);
+    });
+}
+
+template <ConvolutionKernel KernelType>
+void ImageFilter::convolveBordered(const FlatImage& source, FlatImage& output, const KernelType& kernel, uchar threshold) {
+    PROF_EXEC_TIME;
+
+    const int radiusY = kernelRadiusY(kernel);
+    const int radiusX = kernelRadiusX(kernel);
+    const int stride = source.stride();
+
+    forEachOutputRow(source, output, [&](int idxi, uchar* out, int cols) {
+        const uchar* window = &source(idxi - radiusY, -radiusX);
+        for (int idxj = 0; idxj < cols; ++idxj) {
+            int gradient = std::abs(convolveAt(window, stride, idxj, kernel));
+            out[idxj] = gradient < threshold ? 0 : std::min(gradient, 255);
+        }
+    });
+}
+
+template <ConvolutionKernel KernelType>
+void ImageFilter::convolveXYBordered(const FlatImage& source, FlatImage& output, const KernelType& kernelX, const KernelType& kernelY, uchar threshold) {
+    PROF_EXEC_TIME;
+
+    const int radiusY = kernelRadiusY(kernelX);
+    const int radiusX = kernelRadiusX(kernelX);
+    const int stride = source.stride();
+
+    forEachOutputRow(source, output, [&](int idxi, uchar* out, int cols) {
+        const uchar* window = &source(idxi - radiusY, -radiusX);
+        for (int idxj = 0; idxj < cols; ++idxj) {
+            int gx = std::min(std::abs(convolveAt(window, stride, idxj, kernelX)), 255);
+            int gy = std::min(std::abs(convolveAt(window, stride, idxj, kernelY)), 255);
+            int gradient = (gx + gy) >> 1;
+            out[idxj] = gradient < threshold ? 0 : gradient;
+        }
+    });
+}
+
+template <ConvolutionKernel KernelType>
+void ImageFilter::convolveRow(const uchar* const* window, uchar* out, int cols, const KernelType& kernel, uchar threshold) {
+    forEachWindowColumn(cols, kernelRadiusX(kernel), [&](int idxj, auto clamped) {
+        int gradient = std::abs(convolveRowsAt<decltype(clamped)::value>(window, idxj, cols, kernel));
+        out[idxj] = gradient < threshold ? 0 : std::min(gradient, 255);
+    });
+}
+
+template <ConvolutionKernel KernelType>
+void ImageFilter::convolveXYRow(const uchar* const* window, uchar* out, int cols, const KernelType& kernelX, const KernelType& kernelY, uchar threshold) {
+    forEachWindowColumn(cols, kernelRadiusX(kernelX), [&](int idxj, auto clamped) {
+        int gx = std::min(std::abs(convolveRowsAt<decltype(clamped)::value>(window, idxj, cols, kernelX)), 255);
+        int gy = std::min(std::abs(convolveRowsAt<decltype(clamped)::value>(window, idxj, cols, kernelY)), 255);
+        int gradient = (gx + gy) >> 1;
+        out[idxj] = gradient < threshold ? 0 : gradient;
+    });
+}
+
+template <ConvolutionKernel KernelType>
+void ImageFilter::applySingleKernel(const FlatImage& input, FlatImage& output, const KernelType& kernel, uchar threshold) const {
+    PROF_EXEC_TIME;
+
+    if (output.overlaps(input)) {
+        applyThroughScratch(input, output, [&](const FlatImage& from, FlatImage& to) { applySingleKernel(from, to, kernel, threshold); });
+        return;
+    }
+
+    const int padding = std::max(kernelRadiusY(kernel), kernelRadiusX(kernel));
+
+    FlatImage scratch(ScratchArena::local());
+    convolveBordered(borderedSource(input, scratch, padding), output, kernel, threshold);
+}
+
+template <ConvolutionKernel KernelType>
+void ImageFilter::applyXYKernels(const FlatImage& input, FlatImage& output, const KernelType& kernelX, const KernelType& kernelY, uchar threshold) const {
+    PROF_EXEC_TIME;
+
+    if (kernelRadiusY(kernelX) != kernelRadiusY(kernelY) || kernelRadiusX(kernelX) != kernelRadiusX(kernelY)) {
+        throw std::invalid_argument("X and Y kernels must have the same dimensions.");
+    }
+    if (output.overlaps(input)) {
+        applyThroughScratch(input, output, [&](const FlatImage& from, FlatImage& to) { applyXYKernels(from, to, kernelX, kernelY, threshold); });
+        return;
+    }
+
+    const int padding = std::max(kernelRadiusY(kernelX), kernelRadiusX(kernelX));
+
+    FlatImage scratch(ScratchArena::local());
+    convolveXYBordered(borderedSource(input, scratch, padding), output, kernelX, kernelY, threshold);
+}
+
+template <ConvolutionKernel KernelType>
+void ImageFilter::applyXYKernels(const FlatImage& input, GradientField& field, const KernelType& kernelX, const KernelType& kernelY) const {
+    PROF_EXEC_TIME;
+
+    if (kernelRadiusY(kernelX) != kernelRadiusY(kernelY) || kernelRadiusX(kernelX) != kernelRadiusX(kernelY)) {
+        throw std::invalid_argument("X and Y kernels must have the same dimensions.");
+    }
+
+    const int radiusY = kernelRadiusY(kernelX);
+    const int radiusX = kernelRadiusX(kernelX);
+
+    field.resize(input.rows(), input.cols());
+    if (input.empty()) {
+        return;
+    }
+
+    FlatImage scratch(ScratchArena::local());
+    const FlatImage& source = borderedSource(input, scratch, std::max(radiusY, radiusX));
+    const int stride = source.stride();
+
+    forEachIndex(source.rows(), source.size(), [&](int idxi) {
+        const uchar* window = &source(idxi - radiusY, -radiusX);
+        const GradientRow out(field, idxi);
+        for (int idxj = 0; idxj < source.cols(); ++idxj) {
+            out.store(idxj, convolveAt(window, stride, idxj, kernelX), convolveAt(window, stride, idxj, kernelY), field.norm);
+        }
+    });
+}
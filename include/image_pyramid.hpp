@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+#include "filter_pipeline.hpp"
+#include "types.hpp"
+
+// Halves an image like cv::pyrDown: a 5x5 Gaussian ([1 4 6 4 1] / 16 both ways, reflecting at the
+// edges) evaluated only at the even rows and columns it keeps, so blur and decimation are one
+// pass over the source. output becomes (rows + 1) / 2 x (cols + 1) / 2 and matches cv::pyrDown
+// bit for bit.
+void gaussianDownsample(const FlatImage& input, FlatImage& output);
+
+// Gaussian pyramid whose levels live in one contiguous allocation: level 0 is a copy of the base
+// image and every further level is gaussianDownsample of the one before, matching
+// cv::buildPyramid. Levels are views into the shared buffer, each starting on a 64-byte
+// boundary, so the whole pyramid takes about 4/3 of the base image.
+class ImagePyramid
+{
+public:
+    ImagePyramid() = default;
+
+    // Builds up to `levels` levels, the base included; stops early at a 1x1 level
+    ImagePyramid(const FlatImage& base, int levels);
+
+    ImagePyramid(const ImagePyramid& other);
+    ImagePyramid(ImagePyramid&& other) noexcept = default;
+    ImagePyramid& operator=(const ImagePyramid& other);
+    ImagePyramid& operator=(ImagePyramid&& other) noexcept = default;
+
+    // Rebuilds in place, reusing the buffer when the shape is unchanged
+    void build(const FlatImage& base, int levels);
+
+    // Filters every level into the matching level of output, which takes this pyramid's shape.
+    // The levels run as one FilterPipeline::applyBatch, so they are filtered in parallel and
+    // idle workers help with the rows of the large levels.
+    void filter(const FilterPipeline& pipeline, ImagePyramid& output, const BatchOptions& options = {}) const;
+
+    int levels() const { return static_cast<int>(_levels.size()); }
+    FlatImage& level(int i) { return _levels.at(i); }
+    const FlatImage& level(int i) const { return _levels.at(i); }
+
+    // Pixels in all levels, and bytes of the shared buffer including alignment
+    size_t size() const;
+    size_t bytes() const { return storage.size(); }
+
+private:
+    // Lays out the levels of a rows x cols base in the buffer
+    void reshape(int rows, int cols, int levels);
+
+    FlatImage storage;
+    std::vector<FlatImage> _levels;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+
+#include "types.hpp"
+
+// Summed-area tables of an 8-bit image: sums(y, x) holds the sum of all pixels above and left
+// of (y, x), so the sum over any rectangle is four lookups. squaredSums() does the same for the
+// squared pixels.
+//
+// The tables cover the image extended by `border` replicated pixels on every side, so windows
+// centred on edge pixels see the same values as filters with BORDER_REPLICATE. Entry (y, x)
+// covers padded rows [0, y) and columns [0, x); image pixel (i, j) is padded pixel
+// (i + border, j + border).
+//
+// Sums are kept modulo 2^32 and squared sums modulo 2^64. Rectangle sums are differences of
+// table entries, so they stay exact whenever the true rectangle sum fits: any window of up to
+// 2^24 pixels, whatever the image size.
+class IntegralImage {
+public:
+    IntegralImage() = default;
+    explicit IntegralImage(PixelAllocator& allocator) : _sums(allocator), _squaredSums(allocator) {}
+
+    // Builds both tables (or only the sums) in one parallel pass over the rows. Tables of
+    // the same shape are reused.
+    void build(const FlatImage& input, int border = 0, bool squares = true);
+
+    // Sum and squared sum of rows [top, top + rows) and columns [left, left + cols), in image
+    // coordinates. The rectangle may reach `border` pixels beyond the image.
+    uint32_t sum(int top, int left, int rows, int cols) const {
+        return boxDifference(sumsRow(top), sumsRow(top + rows), left, cols);
+    }
+
+    uint64_t squaredSum(int top, int left, int rows, int cols) const {
+        return boxDifference(squaredSumsRow(top), squaredSumsRow(top + rows), left, cols);
+    }
+
+    // Window of (2 * radiusY + 1) x (2 * radiusX + 1) pixels centred on (row, col)
+    uint32_t boxSum(int row, int col, int radiusY, int radiusX) const {
+        return sum(row - radiusY, col - radiusX, 2 * radiusY + 1, 2 * radiusX + 1);
+    }
+
+    double boxMean(int row, int col, int radiusY, int radiusX) const;
+
+    // Population variance of the window: (n * squared sum - sum^2) / n^2, exact up to the final
+    // division
+    double boxVariance(int row, int col, int radiusY, int radiusX) const;
+
+    // Table rows in image coordinates: sumsRow(i)[j] is the sum over image rows [-border, i)
+    // and columns [-border, j), for -border <= i <= rows() + border and likewise for j.
+    // Row loops over many windows read these directly.
+    const uint32_t* sumsRow(int row) const { return _sums.row(row + _border) + _border; }
+    const uint64_t* squaredSumsRow(int row) const { return _squaredSums.row(row + _border) + _border; }
+
+    const FlatArray<uint32_t>& sums() const { return _sums; }
+    const FlatArray<uint64_t>& squaredSums() const { return _squaredSums; }
+
+    int rows() const { return _rows; }
+    int cols() const { return _cols; }
+    int border() const { return _border; }
+    bool hasSquares() const { return !_squaredSums.empty(); }
+
+private:
+    template <typename Sum>
+    static Sum boxDifference(const Sum* above, const Sum* below, int left, int cols) {
+        return below[left + cols] - below[left] - above[left + cols] + above[left];
+    }
+
+    FlatArray<uint32_t> _sums;
+    FlatArray<uint64_t> _squaredSums;
+    int _rows = 0;
+    int _cols = 0;
+    int _border = 0;
+};
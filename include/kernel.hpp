@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Dense convolution kernel with compile-time dimensions. Rows and Cols must be odd; the
+// convolution for each size is fully unrolled. The response is sum / divisor, rounded to
+// nearest for integer kernels.
+template <typename KType, int Rows, int Cols>
+struct Kernel
+{
+    static_assert(Rows % 2 == 1 && Cols % 2 == 1, "Kernel dimensions must be odd");
+
+    static constexpr int ROWS = Rows;
+    static constexpr int COLS = Cols;
+    static constexpr int RADIUS_Y = Rows / 2;
+    static constexpr int RADIUS_X = Cols / 2;
+
+    std::array<KType, Rows * Cols> taps;
+    KType divisor = 1;
+
+    constexpr KType operator()(int r, int c) const {
+        return taps[r * Cols + c];
+    }
+};
+
+// Runtime-size fallback for kernels whose dimensions are only known at run time.
+template <typename KType>
+struct DynamicKernel
+{
+    int rows = 0;
+    int cols = 0;
+    std::vector<KType> taps;
+    KType divisor = 1;
+
+    DynamicKernel() = default;
+
+    DynamicKernel(int rows, int cols, std::vector<KType> taps, KType divisor = 1)
+        : rows(rows), cols(cols), taps(std::move(taps)), divisor(divisor) {
+        if (rows % 2 == 0 || cols % 2 == 0 || this->taps.size() != static_cast<size_t>(rows * cols)) {
+            throw std::invalid_argument("DynamicKernel needs odd dimensions and rows * cols taps.");
+        }
+    }
+
+    template <int Rows, int Cols>
+    DynamicKernel(const Kernel<KType, Rows, Cols>& kernel)
+        : rows(Rows), cols(Cols), taps(kernel.taps.begin(), kernel.taps.end()), divisor(kernel.divisor) {}
+
+    int radiusY() const { return rows / 2; }
+    int radiusX() const { return cols / 2; }
+
+    KType operator()(int r, int c) const {
+        return taps[r * cols + c];
+    }
+};
+
+// kernel(r, c) = column[r] * row[c]
+template <typename KType, int Rows, int Cols>
+constexpr Kernel<KType, Rows, Cols> outerProduct(const std::array<KType, Rows>& column, const std::array<KType, Cols>& row, KType divisor = 1) {
+    Kernel<KType, Rows, Cols> kernel{};
+    for (int r = 0; r < Rows; ++r) {
+        for (int c = 0; c < Cols; ++c) {
+            kernel.taps[r * Cols + c] = column[r] * row[c];
+        }
+    }
+    kernel.divisor = divisor;
+    return kernel;
+}
+
+// Kernel response before abs/threshold: integer kernels divide with round-to-nearest.
+template <typename Acc, typename KType>
+constexpr int normalizeResponse(Acc sum, KType divisor) {
+    if constexpr (std::is_integral_v<KType>) {
+        if (divisor == 1) {
+            return sum;
+        }
+        return (sum >= 0 ? sum + divisor / 2 : sum - divisor / 2) / divisor;
+    } else {
+        return static_cast<int>(sum / divisor);
+    }
+}
+
+// Accumulates window[r * stride + j + c] * kernel(r, c) with one statement per tap, where
+// window points at the top-left pixel under the kernel for column 0.
+template <typename KType, int Rows, int Cols, size_t... Taps>
+inline auto convolveUnrolled(const unsigned char* window, int stride, int j, const Kernel<KType, Rows, Cols>& kernel, std::index_sequence<Taps...>) {
+    using Acc = std::conditional_t<std::is_integral_v<KType>, int, KType>;
+    Acc sum = 0;
+    ((sum += window[(Taps / Cols) * stride + j + Taps % Cols] * kernel.taps[Taps]), ...);
+    return sum;
+}
+
+template <typename KType, int Rows, int Cols>
+inline int convolveAt(const unsigned char* window, int stride, int j, const Kernel<KType, Rows, Cols>& kernel) {
+    return normalizeResponse(convolveUnrolled(window, stride, j, kernel, std::make_index_sequence<Rows * Cols>{}), kernel.divisor);
+}
+
+template <typename KType>
+inline int convolveAt(const unsigned char* window, int stride, int j, const DynamicKernel<KType>& kernel) {
+    using Acc = std::conditional_t<std::is_integral_v<KType>, int, KType>;
+    Acc sum = 0;
+    for (int r = 0; r < kernel.rows; ++r) {
+        const KType* taps = &kernel.taps[r * kernel.cols];
+        const unsigned char* src = window + r * stride + j;
+        for (int c = 0; c < kernel.cols; ++c) {
+            sum += src[c] * taps[c];
+        }
+    }
+    return normalizeResponse(sum, kernel.divisor);
+}
+
+template <typename KType, int Rows, int Cols>
+constexpr int kernelRadiusY(const Kernel<KType, Rows, Cols>&) { return Rows / 2; }
+template <typename KType, int Rows, int Cols>
+constexpr int kernelRadiusX(const Kernel<KType, Rows, Cols>&) { return Cols / 2; }
+template <typename KType>
+inline int kernelRadiusY(const DynamicKernel<KType>& kernel) { return kernel.radiusY(); }
+template <typename KType>
+inline int kernelRadiusX(const DynamicKernel<KType>& kernel) { return kernel.radiusX(); }
+
+// Convolution over separate row pointers (rows[r] is the source row under kernel row r), for
+// row-streaming code whose rows are not evenly spaced. Clamped reads replicate the edge columns.
+template <bool Clamped, typename KType, int Rows, int Cols, size_t... Taps>
+inline auto convolveRowsUnrolled(const unsigned char* const* rows, int j, int cols, const Kernel<KType, Rows, Cols>& kernel, std::index_sequence<Taps...>) {
+    using Acc = std::conditional_t<std::is_integral_v<KType>, int, KType>;
+    auto column = [&](int c) { return Clamped ? std::clamp(j + c - Cols / 2, 0, cols - 1) : j + c - Cols / 2; };
+    Acc sum = 0;
+    ((sum += rows[Taps / Cols][column(Taps % Cols)] * kernel.taps[Taps]), ...);
+    return sum;
+}
+
+template <bool Clamped, typename KType, int Rows, int Cols>
+inline int convolveRowsAt(const unsigned char* const* rows, int j, int cols, const Kernel<KType, Rows, Cols>& kernel) {
+    return normalizeResponse(convolveRowsUnrolled<Clamped>(rows, j, cols, kernel, std::make_index_sequence<Rows * Cols>{}), kernel.divisor);
+}
+
+template <bool Clamped, typename KType>
+inline int convolveRowsAt(const unsigned char* const* rows, int j, int cols, const DynamicKernel<KType>& kernel) {
+    using Acc = std::conditional_t<std::is_integral_v<KType>, int, KType>;
+    Acc sum = 0;
+    for (int r = 0; r < kernel.rows; ++r) {
+        const KType* taps = &kernel.taps[r * kernel.cols];
+        for (int c = 0; c < kernel.cols; ++c) {
+            const int column = Clamped ? std::clamp(j + c - kernel.radiusX(), 0, cols - 1) : j + c - kernel.radiusX();
+            sum += rows[r][column] * taps[c];
+        }
+    }
+    return normalizeResponse(sum, kernel.divisor);
+}
+
+namespace kernels {
+
+// 1D Gaussian factors: binomial for 3 and 5 taps, and the fixed 7-tap table of
+// cv::getGaussianKernel, so the smoothing matches cv::GaussianBlur(ksize, sigma = 0)
+inline constexpr std::array<int, 3> GAUSSIAN_3 = {1, 2, 1};
+inline constexpr std::array<int, 5> GAUSSIAN_5 = {1, 4, 6, 4, 1};
+inline constexpr std::array<int, 7> GAUSSIAN_7 = {2, 7, 14, 18, 14, 7, 2};
+
+// Dense Gaussians, normalized by their sums
+inline constexpr auto GAUSSIAN_3X3 = outerProduct<int, 3, 3>(GAUSSIAN_3, GAUSSIAN_3, 16);
+inline constexpr auto GAUSSIAN_5X5 = outerProduct<int, 5, 5>(GAUSSIAN_5, GAUSSIAN_5, 256);
+inline constexpr auto GAUSSIAN_7X7 = outerProduct<int, 7, 7>(GAUSSIAN_7, GAUSSIAN_7, 4096);
+
+inline constexpr Kernel<int, 5, 5> LAPLACIAN_OF_GAUSSIAN_5X5 = {{
+     0,  0, -1,  0,  0,
+     0, -1, -2, -1,  0,
+    -1, -2, 16, -2, -1,
+     0, -1, -2, -1,  0,
+     0,  0, -1,  0,  0
+}};
+
+// SobelOperator's and ScharrOperator's 3x3 kernels as Kernel values
+inline constexpr auto SOBEL_3X3_X = outerProduct<int, 3, 3>({1, 2, 1}, {-1, 0, 1});
+inline constexpr auto SOBEL_3X3_Y = outerProduct<int, 3, 3>({1, 0, -1}, {1, 2, 1});
+inline constexpr auto SCHARR_3X3_X = outerProduct<int, 3, 3>({3, 10, 3}, {-1, 0, 1});
+inline constexpr auto SCHARR_3X3_Y = outerProduct<int, 3, 3>({1, 0, -1}, {3, 10, 3});
+
+// Same smoothing/derivative factors as cv::getDerivKernels
+inline constexpr auto SOBEL_5X5_X = outerProduct<int, 5, 5>({1, 4, 6, 4, 1}, {-1, -2, 0, 2, 1});
+inline constexpr auto SOBEL_5X5_Y = outerProduct<int, 5, 5>({-1, -2, 0, 2, 1}, {1, 4, 6, 4, 1});
+inline constexpr auto SOBEL_7X7_X = outerProduct<int, 7, 7>({1, 6, 15, 20, 15, 6, 1}, {-1, -4, -5, 0, 5, 4, 1});
+inline constexpr auto SOBEL_7X7_Y = outerProduct<int, 7, 7>({-1, -4, -5, 0, 5, 4, 1}, {1, 6, 15, 20, 15, 6, 1});
+
+} // namespace kernels
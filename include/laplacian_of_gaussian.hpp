@@ -0,0 +1,22 @@
+# pragma once
+
+#include "image_filter.hpp"
+#include "types.hpp"
+
+#include <opencv2/opencv.hpp>
+
+class LaplacianOfGaussian : public ImageFilter
+{
+public:
+    LaplacianOfGaussian() {}
+
+    void apply(const FlatImage& input, FlatImage& output) const override;
+    void applyChannels(const ChannelImage<uchar>& input, ChannelImage<uchar>& output) const override;
+    void applyChannels(const ChannelImage<uint16_t>& input, ChannelImage<uint16_t>& output) const override;
+    void applyChannels(const ChannelImage<float>& input, ChannelImage<float>& output) const override;
+    void applyBenchmark(const cv::Mat& input, cv::Mat& output) const override;
+    // Row form used by StaticPipeline; see RowFilter
+    void applyRow(const uchar* const* window, uchar* out, int cols, RowScratch& scratch) const;
+    int radius() const override { return kernels::LAPLACIAN_OF_GAUSSIAN_5X5.RADIUS_Y; }
+    std::string signature() const override { return "LaplacianOfGaussian"; }
+};
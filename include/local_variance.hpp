@@ -0,0 +1,23 @@
+# pragma once
+
+#include "image_filter.hpp"
+#include "types.hpp"
+
+#include <opencv2/opencv.hpp>
+
+class LocalVariance : public ImageFilter
+{
+public:
+    // Standard deviation of the ksize x ksize window around every pixel (any odd size), rounded
+    // to nearest. The variance itself would overflow 8 bits; the deviation stays below 128.
+    // Window sums come from an IntegralImage, so every size costs the same per pixel.
+    explicit LocalVariance(int ksize = 15);
+
+    void apply(const FlatImage& input, FlatImage& output) const override;
+    void applyBenchmark(const cv::Mat& input, cv::Mat& output) const override;
+    int radius() const override { return ksize / 2; }
+    std::string signature() const override { return "LocalVariance(" + std::to_string(ksize) + ")"; }
+
+private:
+    int ksize;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+enum class ExecutionMode
+{
+    Serial,          // one loop on the calling thread
+    ChunkedParallel, // rows split into a few chunks per worker
+    TileParallel     // FilterPipeline runs the whole chain per cache-sized tile
+};
+
+// Size-based choice between serial and parallel execution. Small images finish faster than the
+// scheduler can hand out tasks, and frames whose per-stage working set overflows the last-level
+// cache are better processed tile by tile.
+struct ExecutionPolicy
+{
+    size_t parallelMinPixels = 256 * 256; // smaller images run serially
+    size_t tileMinPixels = 0;             // larger frames run tile-parallel; 0 derives it from the LLC size
+    int chunksPerWorker = 4;              // load-balancing slack for chunked loops
+
+    ExecutionMode modeFor(size_t pixels) const;
+
+    // Number of chunks a loop over `count` items totalling `pixels` pixels is split into; 1 means serial
+    int chunksFor(int count, size_t pixels) const;
+
+    static ExecutionPolicy serial();
+};
+
+// Process-wide policy used when no ExecutionPolicyScope is active. It starts from the
+// IMAGE_FILTERS_PARALLEL_MIN_PIXELS and IMAGE_FILTERS_TILE_MIN_PIXELS environment variables
+// (see bench_calibrate_policy). setDefaultExecutionPolicy publishes a new immutable snapshot
+// atomically, so it may be called while other threads are filtering; loops already running
+// keep the snapshot they started with.
+ExecutionPolicy defaultExecutionPolicy();
+void setDefaultExecutionPolicy(const ExecutionPolicy& policy);
+
+// Policy of the innermost ExecutionPolicyScope on this thread, else the default one
+ExecutionPolicy currentExecutionPolicy();
+
+// Overrides the policy for loops started on the calling thread while the scope is alive
+class ExecutionPolicyScope {
+public:
+    explicit ExecutionPolicyScope(const ExecutionPolicy& policy);
+    ~ExecutionPolicyScope();
+
+    ExecutionPolicyScope(const ExecutionPolicyScope&) = delete;
+    ExecutionPolicyScope& operator=(const ExecutionPolicyScope&) = delete;
+
+private:
+    ExecutionPolicy policy;
+    const ExecutionPolicy* previous;
+};
+
+// Used while the calling thread runs work that is already spread across the cores one task per
+// core, e.g. one image of a batch or one tile, so its row loops do not fork competing tasks.
+class SerialRowsScope : public ExecutionPolicyScope {
+public:
+    SerialRowsScope() : ExecutionPolicyScope(ExecutionPolicy::serial()) {}
+};
+
+// Calls fn(index) for every index in [0, count), where the loop covers `pixels` pixels in total.
+// Runs serially or as chunked blocked ranges on TBB according to currentExecutionPolicy().
+template <typename Fn>
+void forEachIndex(int count, size_t pixels, Fn&& fn) {
+    const int chunks = currentExecutionPolicy().chunksFor(count, pixels);
+    if (chunks <= 1) {
+        for (int index = 0; index < count; ++index) {
+            fn(index);
+        }
+        return;
+    }
+
+    const int grain = (count + chunks - 1) / chunks;
+    tbb::parallel_for(tbb::blocked_range<int>(0, count, grain), [&](const tbb::blocked_range<int>& range) {
+        for (int index = range.begin(); index < range.end(); ++index) {
+            fn(index);
+        }
+    }, tbb::simple_partitioner());
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "image_filter.hpp"
+#include "separable_smoothing.hpp"
+
+// Run of smoothing stages folded into one SeparableSmoothing pass by the product of their taps.
+// Away from the edges that pass equals the chain up to its single rounding. Within the later
+// stages' radii of an edge the chain replicates intermediate pixels rather than source pixels,
+// so those bands run the original stages instead.
+class FoldedSmoothing : public ImageFilter
+{
+public:
+    explicit FoldedSmoothing(std::vector<std::shared_ptr<const ImageFilter>> stages);
+
+    void apply(const FlatImage& input, FlatImage& output) const override;
+    void applyBenchmark(const cv::Mat& input, cv::Mat& output) const override;
+    int radius() const override { return folded.radius(); }
+    std::string signature() const override;
+
+    // The folded taps; the edge bands are no plain smoothing, so smoothingTaps() stays empty
+    std::vector<int> taps() const { return folded.smoothingTaps(); }
+    const std::vector<std::shared_ptr<const ImageFilter>>& stages() const { return _stages; }
+
+private:
+    void applyStages(const FlatImage& input, FlatImage& output) const;
+    void applyBand(const FlatImage& input, FlatImage& output, int row, int col, int rows, int cols) const;
+
+    std::vector<std::shared_ptr<const ImageFilter>> _stages;
+    SeparableSmoothing folded;
+    int edgeBand; // sum of the radii after the first stage
+};
+
+struct PlanOptions
+{
+    // Drop stages that return their input unchanged, such as Blur(1)
+    bool dropNoOps = true;
+    // Fold runs of smoothing stages (Blur, GaussianBlur, SeparableSmoothing) into one separable
+    // kernel where the cost model expects a single pass to be cheaper; see FoldedSmoothing.
+    // Smoothing is linear up to its final rounding: the folded kernel rounds once instead of
+    // after every stage, so interior pixels may differ by one grey level from the stage-by-stage
+    // chain. Off by default so apply() stays bit exact.
+    bool foldSmoothing = false;
+};
+
+// One filter the plan runs, and the pipeline stages it stands for
+struct PlanStep
+{
+    std::shared_ptr<const ImageFilter> filter;
+    std::vector<size_t> stages;
+    std::vector<int> smoothingTaps; // the filter's smoothingTaps()
+    bool folded = false;            // filter was built by the plan from several stages
+};
+
+// What FilterPipeline actually runs for its stages: the filters left after dropping no-ops and
+// folding smoothing runs, and the intermediate buffers they need. Plans are rebuilt whenever
+// the pipeline changes and can be inspected through FilterPipeline::plan().
+class PipelinePlan
+{
+public:
+    PipelinePlan() = default;
+
+    static PipelinePlan build(const std::vector<std::shared_ptr<const ImageFilter>>& filters, const PlanOptions& options = {});
+
+    const std::vector<PlanStep>& steps() const { return _steps; }
+    const std::vector<size_t>& droppedStages() const { return _dropped; }
+
+    // Intermediate images between the steps: none for a single step, one for two, and two
+    // ping-pong buffers beyond that
+    int bufferCount() const { return std::clamp(static_cast<int>(_steps.size()) - 1, 0, 2); }
+
+    // Guard band the intermediates carry: the largest bounded radius of the steps reading them
+    int guard() const { return _guard; }
+
+    // One line per step, e.g. "stages 0+1: folded smoothing, taps 1 5 11 14 11 5 1 / 48^2"
+    std::string describe() const;
+
+private:
+    std::vector<PlanStep> _steps;
+    std::vector<size_t> _dropped;
+    int _guard = 0;
+};
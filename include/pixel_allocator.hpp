@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Source of FlatArray pixel storage. Every buffer is aligned to ALIGNMENT bytes.
+class PixelAllocator {
+public:
+    static constexpr size_t ALIGNMENT = 64;
+
+    virtual ~PixelAllocator() = default;
+
+    virtual void* allocate(size_t bytes) = 0;
+    virtual void deallocate(void* ptr, size_t bytes) = 0;
+
+    // Reference that keeps this allocator alive; FlatArray holds one for as long as it owns a
+    // buffer from it. Null for allocators whose lifetime the caller manages.
+    virtual std::shared_ptr<void> share() { return nullptr; }
+};
+
+// Aligned heap allocator used by default; its buffers are zero-filled.
+PixelAllocator& defaultPixelAllocator();
+
+// Number of buffers the default allocator has handed out so far, across all threads.
+// Comparing it before and after a frame shows whether steady-state processing allocates.
+size_t pixelAllocationCount();
+
+// Recycles released buffers by size instead of returning them to the heap, so intermediate
+// images of a repeated workload stop allocating after the first run. Recycled buffers keep
+// their previous contents. Buffers come from `upstream` on a miss and go back to it when the
+// arena is destroyed, or on release once more than maxPooledBytes would be pooled. An arena
+// owned by a std::shared_ptr is kept alive by the arrays allocated from it; otherwise those
+// arrays must not outlive it.
+class ScratchArena : public PixelAllocator, public std::enable_shared_from_this<ScratchArena> {
+public:
+    static constexpr size_t DEFAULT_MAX_POOLED_BYTES = size_t(256) << 20;
+
+    explicit ScratchArena(PixelAllocator& upstream = defaultPixelAllocator(), size_t maxPooledBytes = DEFAULT_MAX_POOLED_BYTES)
+        : upstream(upstream), maxPooled(maxPooledBytes) {}
+    ~ScratchArena() override;
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    void* allocate(size_t bytes) override;
+    void deallocate(void* ptr, size_t bytes) override;
+    std::shared_ptr<void> share() override;
+
+    // Returns every pooled buffer to the upstream allocator
+    void release();
+
+    // Returns pooled buffers, largest first, until at most `bytes` remain pooled
+    void trim(size_t bytes);
+
+    // Bytes currently pooled and waiting to be reused
+    size_t pooledBytes() const;
+
+    // Cap on pooledBytes(); lowering it trims the pool right away
+    size_t maxPooledBytes() const;
+    void setMaxPooledBytes(size_t bytes);
+
+    // Arena of the calling thread, used by filters for their intermediate images. Arrays that
+    // leave the thread keep the arena alive after the thread exits, and go back to its pool.
+    static ScratchArena& local();
+
+private:
+    void trimLocked(size_t bytes);
+
+    PixelAllocator& upstream;
+    mutable std::mutex mutex;
+    std::map<size_t, std::vector<void*>> pool;
+    size_t pooled = 0;
+    size_t maxPooled;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "types.hpp"
+
+// Uncompressed on-disk image format that maps straight into a FlatImage.
+//
+// Layout: a RawImageHeader, zero padding up to dataOffset (4096 bytes), then `rows` rows of
+// `pitch` bytes each. The pitch is a multiple of 64 bytes and the pixel data starts 4096-byte
+// aligned in the mapping, so mapped rows keep the alignment of FlatArray's own storage. Values
+// are stored in host byte order.
+struct RawImageHeader
+{
+    char magic[8];       // RAW_IMAGE_MAGIC
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t pitch;      // bytes between consecutive rows
+    int32_t type;        // OpenCV type code; only CV_8UC1 for now
+    uint64_t dataOffset; // bytes from the start of the file to row 0
+};
+
+inline constexpr char RAW_IMAGE_MAGIC[8] = {'I', 'F', 'R', 'A', 'W', '1', '\0', '\0'};
+
+// Maps an existing raw image. The returned FlatImage is a view over the mapping and keeps it
+// alive; pixels are paged in from the page cache on first access, with no decode or copy.
+// mapRawImage maps the pages copy-on-write, so writes through the view (or a copy of it) stay
+// private to the process and never reach the file; mapRawImageWritable writes them back.
+// Headers whose dimensions do not fit the file are rejected with std::runtime_error.
+FlatImage mapRawImage(const std::string& path);
+FlatImage mapRawImageWritable(const std::string& path);
+
+// Creates (or truncates) a raw image file of the given size and maps it read-write. Filtering
+// into the returned view writes the pixels straight into the file's pages; they reach disk when
+// the kernel writes them back or once the last view is gone.
+FlatImage createRawImage(const std::string& path, int rows, int cols);
+
+// Writes `image` to a new raw image file
+void writeRawImage(const std::string& path, const FlatImage& image);
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "types.hpp"
+
+// One filtered frame: the content hash and dimensions of the input, and the hash of the
+// signature of the pipeline that filtered it
+struct ResultKey
+{
+    uint64_t content = 0;
+    uint64_t pipeline = 0;
+    int rows = 0;
+    int cols = 0;
+
+    bool operator==(const ResultKey&) const = default;
+};
+
+struct ResultCacheStats
+{
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t insertions = 0;
+    size_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0; // pixels held by the entries
+
+    double hitRate() const { return hits + misses > 0 ? static_cast<double>(hits) / (hits + misses) : 0.0; }
+};
+
+// Least-recently-used cache of filtered frames, bounded by the bytes of pixels it holds. Safe to
+// share between threads and between pipelines, since keys carry the pipeline signature. Results
+// are copied in and out, so callers never alias cached pixels.
+class ResultCache
+{
+public:
+    explicit ResultCache(size_t capacityBytes);
+
+    // Copies the result stored under key into output and makes it the most recently used entry
+    bool lookup(const ResultKey& key, FlatImage& output);
+
+    // Stores a copy of result under key, evicting the least recently used entries until it
+    // fits. The copy reuses the pixels of an evicted entry when nobody is reading them, so a
+    // full cache of equally sized frames stops allocating. Results larger than the whole
+    // capacity are not stored.
+    void insert(const ResultKey& key, const FlatImage& result);
+
+    void clear();
+
+    ResultCacheStats stats() const;
+    size_t capacity() const { return capacityBytes; }
+
+private:
+    struct Entry
+    {
+        ResultKey key;
+        std::shared_ptr<FlatImage> pixels;
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const ResultKey& key) const;
+    };
+
+    // Evicts least recently used entries until at most `bytes` are held, returning the pixels of
+    // an evicted entry nobody else holds, if any. The caller holds the lock.
+    std::shared_ptr<FlatImage> evictUntil(size_t bytes);
+    void eraseLocked(std::unordered_map<ResultKey, std::list<Entry>::iterator, KeyHash>::iterator found);
+
+    const size_t capacityBytes;
+    mutable std::mutex mutex;
+    std::list<Entry> entries; // most recently used first
+    std::unordered_map<ResultKey, std::list<Entry>::iterator, KeyHash> index;
+    ResultCacheStats counters;
+};
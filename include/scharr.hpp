@@ -20,8 +20,19 @@ public:
         {-3, -10, -3}
     };
 
+    // KERNELX and KERNELY as column x row factors
+    static constexpr SeparableKernel<int> SEPARABLE_KERNELX = {{3, 10, 3}, {-1, 0, 1}};
+    static constexpr SeparableKernel<int> SEPARABLE_KERNELY = {{1, 0, -1}, {3, 10, 3}};
+
     ScharrOperator() {}
 
     void apply(const FlatImage& input, FlatImage& output) const override;
+    void applyChannels(const ChannelImage<uchar>& input, ChannelImage<uchar>& output) const override;
+    void applyChannels(const ChannelImage<uint16_t>& input, ChannelImage<uint16_t>& output) const override;
+    void applyChannels(const ChannelImage<float>& input, ChannelImage<float>& output) const override;
     void applyBenchmark(const cv::Mat& input, cv::Mat& output) const override;
+    void applyGradientField(const FlatImage& input, GradientField& field) const override;
+    // Row form used by StaticPipeline; see RowFilter
+    void applyRow(const uchar* const* window, uchar* out, int cols, RowScratch& scratch) const;
+    std::string signature() const override { return "ScharrOperator"; }
 };
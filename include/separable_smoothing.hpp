@@ -0,0 +1,34 @@
+# pragma once
+
+#include <vector>
+
+#include "image_filter.hpp"
+#include "types.hpp"
+
+#include <opencv2/opencv.hpp>
+
+class SeparableSmoothing : public ImageFilter
+{
+public:
+    // Smoothing by the outer product of an odd number of non-negative integer taps, applied down
+    // the columns and then along the rows in fixed point and divided by sum(taps)^2 with one
+    // rounding. Pipeline plans fold runs of Blur and GaussianBlur stages into one of these.
+    explicit SeparableSmoothing(std::vector<int> taps);
+
+    // Whether 8-bit images can be smoothed by these taps without overflowing the uint32 sums
+    static bool supports(const std::vector<int>& taps);
+
+    void apply(const FlatImage& input, FlatImage& output) const override;
+    void applyChannels(const ChannelImage<uchar>& input, ChannelImage<uchar>& output) const override;
+    void applyChannels(const ChannelImage<uint16_t>& input, ChannelImage<uint16_t>& output) const override;
+    void applyChannels(const ChannelImage<float>& input, ChannelImage<float>& output) const override;
+    void applyBenchmark(const cv::Mat& input, cv::Mat& output) const override;
+    // Row form used by StaticPipeline; see RowFilter
+    void applyRow(const uchar* const* window, uchar* out, int cols, RowScratch& scratch) const;
+    int radius() const override { return static_cast<int>(taps.size() / 2); }
+    std::vector<int> smoothingTaps() const override { return taps; }
+    std::string signature() const override;
+
+private:
+    std::vector<int> taps;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "fixed_point.hpp"
+#include "gradient_field.hpp"
+#include "types.hpp"
+
+// Hand-vectorized 3x3 convolution rows over uchar pixels, widened to int16.
+//
+// Every row function takes pointers to column 0 of the rows above, at and below the output
+// row, processes whole vector blocks of interior columns starting at column 1, and returns
+// the first column it did not write. The caller finishes the remaining columns (and the two
+// clamped border columns) with scalar code. Kernels are 9 row-major int16 taps whose absolute
+// values sum to at most MAX_INT16_KERNEL_WEIGHT, so no intermediate sum can overflow int16.
+struct SimdKernelSet
+{
+    const char* name;
+    int (*xyGradientRow)(const uchar* above, const uchar* center, const uchar* below, uchar* out, int cols,
+                         const int16_t* kernelX, const int16_t* kernelY, uchar threshold);
+    int (*singleGradientRow)(const uchar* above, const uchar* center, const uchar* below, uchar* out, int cols,
+                             const int16_t* kernel, uchar threshold);
+    // Signed int16 gx and gy with their magnitude and quantized orientation; GradientRow members
+    // left null are not written. L2 magnitudes use the vector square root instructions.
+    int (*gradientFieldRow)(const uchar* above, const uchar* center, const uchar* below, const GradientRow& out, int cols,
+                            const int16_t* kernelX, const int16_t* kernelY, GradientNorm norm);
+    // Canny non-maximum suppression over rows of float magnitudes and GradientDirection codes,
+    // with the same column contract: writes 0 for suppressed pixels, 1 for weak candidates
+    // (above `low`) and 2 for strong ones (above `high`).
+    int (*suppressNonMaximaRow)(const float* above, const float* center, const float* below, const uchar* direction, uchar* out,
+                                int cols, float low, float high);
+
+    // Separable passes. horizontalRow follows the same contract as above over a single source row.
+    // The vertical rows combine three int16 rows of a rolling buffer, start at column 0 and
+    // return the first column they did not write.
+    int (*horizontalRow)(const uchar* src, int16_t* dst, int cols, const int16_t* taps);
+    int (*verticalXYRow)(const int16_t* const windowX[3], const int16_t* const windowY[3], uchar* out, int cols,
+                         const int16_t* columnX, const int16_t* columnY, uchar threshold);
+    int (*verticalSingleRow)(const int16_t* const window[3], uchar* out, int cols, const int16_t* column, uchar threshold);
+
+    // Fixed-point rows for box and separable smoothing, each covering all `count` columns. They are
+    // plain loops left to the compiler: baseline vector code for scalar, SSE2 and NEON, and the
+    // same source built for AVX2 in the avx2 set.
+    void (*accumulateRow)(uint32_t* sums, const uchar* src, uint32_t tap, int count);         // sums += tap * src
+    void (*accumulateSumsRow)(uint32_t* sums, const uint32_t* src, uint32_t tap, int count);  // sums += tap * src
+    void (*slideRow)(uint32_t* sums, const uchar* entering, const uchar* leaving, int count); // sums += entering - leaving
+    void (*divideRow)(const uint32_t* sums, uchar* out, int count, const FixedPointDivisor& divide);
+
+    // Content hashing: folds `stripes` consecutive 64-byte stripes of data into eight 64-bit
+    // lanes, keying stripe s with the 64 bytes at secret + 8 * s. For every 8-byte word v of a
+    // stripe with key k = v ^ secret word: lanes[i] += lo32(k) * hi32(k), lanes[i ^ 1] += v.
+    // Unlike the rows above, every set computes all stripes and all sets agree exactly.
+    void (*hashStripes)(uint64_t* lanes, const uchar* data, int stripes, const uchar* secret);
+
+    // Gaussian pyramid step: one output row of cv::pyrDown from the five source rows centred on
+    // it, already reflected at the image edges. Filters with [1 4 6 4 1] / 16 in both directions,
+    // reflecting at the column edges, and keeps the even columns: (srcCols + 1) / 2 outputs.
+    // sums is scratch for srcCols + 4 values. A plain loop like the fixed-point rows.
+    void (*pyramidDownRow)(const uchar* const window[5], uchar* out, int srcCols, uint16_t* sums);
+};
+
+constexpr int MAX_INT16_KERNEL_WEIGHT = 128; // 128 * 255 < 32767
+
+// Best kernel set the running CPU supports, chosen once on first use.
+// Setting IMAGE_FILTERS_SIMD=scalar|sse2|avx2|neon overrides the choice when supported.
+const SimdKernelSet& activeSimdKernels();
+
+// All kernel sets the running CPU supports, best first; the scalar set is always last.
+std::vector<const SimdKernelSet*> supportedSimdKernels();
@@ -20,8 +20,26 @@ public:
         {-1, -2, -1}
     };
 
-    SobelOperator() {}
+    // KERNELX and KERNELY as column x row factors
+    static constexpr SeparableKernel<int> SEPARABLE_KERNELX = {{1, 2, 1}, {-1, 0, 1}};
+    static constexpr SeparableKernel<int> SEPARABLE_KERNELY = {{1, 0, -1}, {1, 2, 1}};
+
+    // ksize selects the 3x3 kernels above or the 5x5/7x7 variants in kernels::
+    explicit SobelOperator(int ksize = 3);
 
     void apply(const FlatImage& input, FlatImage& output) const override;
+    void applyChannels(const ChannelImage<uchar>& input, ChannelImage<uchar>& output) const override;
+    void applyChannels(const ChannelImage<uint16_t>& input, ChannelImage<uint16_t>& output) const override;
+    void applyChannels(const ChannelImage<float>& input, ChannelImage<float>& output) const override;
     void applyBenchmark(const cv::Mat& input, cv::Mat& output) const override;
+    void applyGradientField(const FlatImage& input, GradientField& field) const override;
+    // Row form used by StaticPipeline; see RowFilter
+    void applyRow(const uchar* const* window, uchar* out, int cols, RowScratch& scratch) const;
+    int radius() const override { return ksize / 2; }
+    std::string signature() const override { return "SobelOperator(" + std::to_string(ksize) + ")"; }
+
+private:
+    template <ChannelSample T> void convolveAllChannels(const ChannelImage<T>& input, ChannelImage<T>& output) const;
+
+    int ksize;
 };
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread. The capacity
+// is rounded up to a power of two; head and tail live on separate cache lines so the two sides
+// do not false-share.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) : slots(roundUpToPowerOfTwo(capacity)), mask(slots.size() - 1) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    size_t capacity() const { return slots.size(); }
+
+    // Producer side; false when the queue is full
+    bool tryPush(const T& value) {
+        const size_t tail = tailIndex.load(std::memory_order_relaxed);
+        if (tail - headIndex.load(std::memory_order_acquire) == slots.size()) {
+            return false;
+        }
+        slots[tail & mask] = value;
+        tailIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; false when the queue is empty
+    bool tryPop(T& value) {
+        const size_t head = headIndex.load(std::memory_order_relaxed);
+        if (head == tailIndex.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = slots[head & mask];
+        headIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static size_t roundUpToPowerOfTwo(size_t value) {
+        size_t rounded = 1;
+        while (rounded < value) {
+            rounded <<= 1;
+        }
+        return rounded;
+    }
+
+    std::vector<T> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> headIndex{0};
+    alignas(64) std::atomic<size_t> tailIndex{0};
+};
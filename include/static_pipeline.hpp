@@ -0,0 +1,228 @@
+# pragma once
+
+#include <array>
+#include <concepts>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+#include "image_filter.hpp"
+#include "types.hpp"
+
+// Filters StaticPipeline can fuse. Besides apply(), they compute one output row from the
+// 2 * radius() + 1 source rows centred on it (rows beyond the image already clamped) through a
+// non-virtual applyRow, given the stage's RowScratch with rowScratchSize(cols, radius()) sums.
+template <typename Filter>
+concept RowFilter = std::derived_from<Filter, ImageFilter> && std::copy_constructible<Filter> &&
+    requires(const Filter& filter, const uchar* const* window, uchar* out, int cols, RowScratch& scratch) {
+        filter.applyRow(window, out, cols, scratch);
+    };
+
+constexpr size_t rowScratchSize(int cols, int radius) {
+    return 2 * (static_cast<size_t>(cols) + 2 * radius);
+}
+
+// Filter chain fixed at compile time, e.g. StaticPipeline<Blur, SobelOperator> or
+// StaticPipeline(GaussianBlur(7), SobelOperator()). Instead of running every stage over the
+// whole image, rows stream through the chain: each stage keeps only the 2 * radius + 1 most
+// recent rows of the stage before it in a ring (plus the row that just left the window, so
+// running sums can slide), and produces a row as soon as the rows under its window exist.
+// Intermediates stay in cache, and every applyRow call goes to the concrete filter type
+// without virtual dispatch. The pixels match FilterPipeline with the same filters.
+//
+// Row chunks run in parallel as the current ExecutionPolicy decides; every chunk recomputes the
+// haloRadius() rows of intermediates it shares with its neighbours. An output that is, or
+// overlaps, the input is filled through scratch. A StaticPipeline is itself an ImageFilter, so
+// it can also serve as one fused stage of a FilterPipeline.
+template <RowFilter... Filters>
+class StaticPipeline : public ImageFilter
+{
+    static_assert(sizeof...(Filters) > 0, "StaticPipeline needs at least one filter");
+
+public:
+    static constexpr size_t STAGES = sizeof...(Filters);
+
+    StaticPipeline() = default;
+    explicit StaticPipeline(Filters... filters) : stages(std::move(filters)...) {}
+
+    void apply(const FlatImage& input, FlatImage& output) const override;
+    void applyBenchmark(const cv::Mat& input, cv::Mat& output) const override;
+    int radius() const override { return haloRadius(); }
+    std::string signature() const override;
+
+    // Sum of the stage radii
+    int haloRadius() const;
+
+    template <size_t Stage>
+    const auto& stage() const { return std::get<Stage>(stages); }
+
+private:
+    // Rows in flight for one chunk. Level 0 is the input and level STAGES the output; stage s
+    // reads level s and writes level s + 1. Every level in between is a ring holding the
+    // 2 * radius + 1 most recent rows its consumer reads and the one before them.
+    struct Stream
+    {
+        Stream(const FlatImage& input, FlatImage& output, const std::array<int, STAGES>& radii, int begin);
+
+        const uchar* source(size_t level, int row) const {
+            return level == 0 ? input.row(row) : rings.row(ringBase[level] + row % capacity[level]);
+        }
+
+        uchar* target(size_t level, int row) {
+            return level == STAGES ? output.row(row) : rings.row(ringBase[level] + row % capacity[level]);
+        }
+
+        const FlatImage& input;
+        FlatImage& output;
+        int rows;
+        int cols;
+        std::array<int, STAGES> radii;
+        std::array<int, STAGES + 1> first{};    // first row every level produces
+        std::array<int, STAGES + 1> next{};     // next row every level produces
+        std::array<int, STAGES + 1> capacity{}; // ring rows per intermediate level
+        std::array<int, STAGES + 1> ringBase{};
+        FlatImage rings;
+        FlatArray<uint32_t> sums;
+        std::array<RowScratch, STAGES> scratch{};
+        std::vector<const uchar*> windows;
+        std::array<int, STAGES> windowBase{};
+    };
+
+    // Produces the rows of `Level` up to `target`, pulling the rows of the level below first
+    template <size_t Level>
+    void advance(Stream& stream, int target) const;
+
+    std::array<int, STAGES> stageRadii() const {
+        return std::apply([](const Filters&... filter) { return std::array<int, STAGES>{filter.radius()...}; }, stages);
+    }
+
+    std::tuple<Filters...> stages;
+};
+
+
+template <RowFilter... Filters>
+StaticPipeline<Filters...>::Stream::Stream(const FlatImage& input, FlatImage& output, const std::array<int, STAGES>& radii, int begin)
+    : input(input), output(output), rows(input.rows()), cols(input.cols()), radii(radii),
+      rings(ScratchArena::local()), sums(ScratchArena::local())
+{
+    // level s must start haloRadius() of the stages above it before the chunk
+    int halo = 0;
+    next[STAGES] = begin;
+    for (size_t level = STAGES; level-- > 0;) {
+        halo += radii[level];
+        next[level] = std::max(begin - halo, 0);
+    }
+    first = next;
+
+    int ringRows = 0;
+    int windowRows = 0;
+    std::array<size_t, STAGES> sumBase{};
+    size_t sumCount = 0;
+    for (size_t stage = 0; stage < STAGES; ++stage) {
+        if (stage > 0) {
+            capacity[stage] = 2 * radii[stage] + 2;
+            ringBase[stage] = ringRows;
+            ringRows += capacity[stage];
+        }
+        windowBase[stage] = windowRows;
+        windowRows += 2 * radii[stage] + 1;
+        sumBase[stage] = sumCount;
+        sumCount += rowScratchSize(cols, radii[stage]);
+    }
+    rings.resize(ringRows, cols);
+    sums.resize(1, static_cast<int>(sumCount));
+    for (size_t stage = 0; stage < STAGES; ++stage) {
+        scratch[stage].sums = sums.data() + sumBase[stage];
+    }
+    windows.resize(windowRows);
+}
+
+template <RowFilter... Filters>
+template <size_t Level>
+void StaticPipeline<Filters...>::advance(Stream& stream, int target) const {
+    if constexpr (Level > 0) {
+        const auto& filter = std::get<Level - 1>(stages);
+        const int radius = stream.radii[Level - 1];
+        const uchar** window = stream.windows.data() + stream.windowBase[Level - 1];
+        RowScratch& scratch = stream.scratch[Level - 1];
+
+        for (; stream.next[Level] <= target; ++stream.next[Level]) {
+            const int row = stream.next[Level];
+            advance<Level - 1>(stream, std::min(row + radius, stream.rows - 1));
+            for (int k = 0; k <= 2 * radius; ++k) {
+                window[k] = stream.source(Level - 1, std::clamp(row - radius + k, 0, stream.rows - 1));
+            }
+            scratch.leaving = row == stream.first[Level] ? nullptr
+                                                         : stream.source(Level - 1, std::clamp(row - radius - 1, 0, stream.rows - 1));
+            filter.applyRow(window, stream.target(Level, row), stream.cols, scratch);
+        }
+    }
+}
+
+template <RowFilter... Filters>
+void StaticPipeline<Filters...>::apply(const FlatImage& input, FlatImage& output) const {
+    PROF_EXEC_TIME;
+
+    // rows of output are written while later rows and neighbouring chunks still read the input
+    if (output.overlaps(input)) {
+        applyThroughScratch(input, output, [this](const FlatImage& from, FlatImage& to) { apply(from, to); });
+        return;
+    }
+
+    const int rows = input.rows();
+    output.resize(rows, input.cols());
+    if (input.empty()) {
+        return;
+    }
+
+    const std::array<int, STAGES> radii = stageRadii();
+    const int chunkCount = currentExecutionPolicy().chunksFor(rows, input.size());
+    const int chunkRows = (rows + chunkCount - 1) / chunkCount;
+
+    forEachIndex(chunkCount, input.size(), [&](int chunk) {
+        const int begin = chunk * chunkRows;
+        const int end = std::min(begin + chunkRows, rows);
+        if (begin < end) {
+            Stream stream(input, output, radii, begin);
+            advance<STAGES>(stream, end - 1);
+        }
+    });
+}
+
+template <RowFilter... Filters>
+void StaticPipeline<Filters...>::applyBenchmark(const cv::Mat& input, cv::Mat& output) const {
+    PROF_EXEC_TIME;
+
+    cv::Mat temp = input;
+    std::apply([&](const Filters&... filter) {
+        ((filter.applyBenchmark(temp, output), temp = std::move(output)), ...);
+    }, stages);
+    output = std::move(temp);
+}
+
+template <RowFilter... Filters>
+std::string StaticPipeline<Filters...>::signature() const {
+    const std::array<std::string, STAGES> signatures = std::apply([](const Filters&... filter) {
+        return std::array<std::string, STAGES>{filter.signature()...};
+    }, stages);
+
+    std::string text = "StaticPipeline(";
+    for (size_t stage = 0; stage < STAGES; ++stage) {
+        if (signatures[stage].empty()) {
+            return {};
+        }
+        text += (stage ? "," : "") + signatures[stage];
+    }
+    return text + ")";
+}
+
+template <RowFilter... Filters>
+int StaticPipeline<Filters...>::haloRadius() const {
+    const std::array<int, STAGES> radii = stageRadii();
+    int halo = 0;
+    for (int radius : radii) {
+        halo += radius;
+    }
+    return halo;
+}
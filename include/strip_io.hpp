@@ -0,0 +1,88 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+
+#include <opencv2/opencv.hpp>
+#include "types.hpp"
+
+// Sequential source of image rows for FilterPipeline::applyStreaming. Each read() fills
+// `strip` with the next strip.rows() rows of the image, top to bottom.
+class StripReader
+{
+public:
+    virtual ~StripReader() = default;
+
+    virtual int rows() const = 0;
+    virtual int cols() const = 0;
+    virtual void read(FlatImage& strip) = 0;
+};
+
+// Sequential sink for image rows; each write() appends strip.rows() rows.
+class StripWriter
+{
+public:
+    virtual ~StripWriter() = default;
+
+    virtual void write(const FlatImage& strip) = 0;
+};
+
+// Reads strips out of an in-memory CV_8UC1 image
+class MatStripReader : public StripReader
+{
+public:
+    explicit MatStripReader(const cv::Mat& image);
+
+    int rows() const override { return image.rows; }
+    int cols() const override { return image.cols; }
+    void read(FlatImage& strip) override;
+
+private:
+    cv::Mat image;
+    int nextRow = 0;
+};
+
+// Writes strips into a CV_8UC1 image allocated up front
+class MatStripWriter : public StripWriter
+{
+public:
+    MatStripWriter(cv::Mat& image, int rows, int cols);
+
+    void write(const FlatImage& strip) override;
+
+private:
+    cv::Mat& image;
+    int nextRow = 0;
+};
+
+// Streams an 8-bit binary PGM (P5) file from disk; only the current strip is held in memory.
+class PgmStripReader : public StripReader
+{
+public:
+    explicit PgmStripReader(const std::string& path);
+
+    int rows() const override { return imageRows; }
+    int cols() const override { return imageCols; }
+    void read(FlatImage& strip) override;
+
+private:
+    std::ifstream file;
+    int imageRows = 0;
+    int imageCols = 0;
+    int nextRow = 0;
+};
+
+// Streams an 8-bit binary PGM (P5) file to disk
+class PgmStripWriter : public StripWriter
+{
+public:
+    PgmStripWriter(const std::string& path, int rows, int cols);
+
+    void write(const FlatImage& strip) override;
+
+private:
+    std::ofstream file;
+    int imageRows;
+    int imageCols;
+    int nextRow = 0;
+};
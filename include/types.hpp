@@ -1,52 +1,238 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
 #include <opencv2/opencv.hpp>
 
+#include "pixel_allocator.hpp"
+
 using uchar = unsigned char;
-using vec3 = std::array<uchar, 3>;
 
+// Row-major 2D array with a row stride (in elements) that may exceed its width.
+//
+// Ownership: by default a FlatArray owns its pixels, and copying it copies them. Owned pixels
+// are 64-byte aligned and come from a PixelAllocator: the zero-filling heap allocator unless
+// another one (e.g. a ScratchArena) is passed in, and a shared allocator is kept alive while
+// the array holds its buffer. borrow() and adopt() instead create views
+// over external memory. Copying a view copies the view, not the pixels. A borrowed view never
+// outlives the memory it points to; that is the caller's responsibility. An adopted view shares
+// ownership of the memory through `owner`. resize() to the current shape is a no-op, so filters
+// write straight into a view of the right size. Resizing a view to a different shape detaches
+// it into a new owning array.
+//
+// Guard bands: an owning array can reserve `guard` extra pixels around every side, so that
+// (i, j) is addressable for -guard <= i < rows + guard and likewise for j. Guarded rows start
+// on 64-byte boundaries and the stride is rounded up to a multiple of 64 bytes. fillBorder()
+// replicates the edge pixels into the guard band, after which border() reports how far the
+// image may be read out of bounds. Any resize() marks the border stale again, since the caller
+// is about to rewrite the pixels.
 template <typename T>
 class FlatArray {
+    static_assert(std::is_trivially_copyable_v<T>, "FlatArray holds plain pixel values");
+
     public:
-        FlatArray() : _rows(0), _cols(0) {} // Default constructor
+        FlatArray() : FlatArray(defaultPixelAllocator()) {} // Default constructor
+
+        explicit FlatArray(PixelAllocator& allocator)
+            : _rows(0), _cols(0), _stride(0), _guard(0), _border(0), _ptr(nullptr), _base(nullptr), _bytes(0),
+              _allocator(&allocator), _owning(true) {}
+
+        FlatArray(int rows, int cols, PixelAllocator& allocator = defaultPixelAllocator()) : FlatArray(allocator) {
+            resize(rows, cols);
+        }
+
+        FlatArray(int rows, int cols, int guard, PixelAllocator& allocator = defaultPixelAllocator()) : FlatArray(allocator) {
+            resize(rows, cols, guard);
+        }
+
+        FlatArray(const FlatArray& other) : FlatArray() {
+            *this = other;
+        }
+
+        FlatArray(FlatArray&& other) noexcept : FlatArray() {
+            swap(other);
+        }
+
+        ~FlatArray() {
+            release();
+        }
+
+        // Copies of owning arrays reuse this array's storage when the shape matches and
+        // otherwise allocate from this array's allocator
+        FlatArray& operator=(const FlatArray& other) {
+            if (this == &other) {
+                return *this;
+            }
+            if (!other._owning) {
+                release();
+                _rows = other._rows;
+                _cols = other._cols;
+                _stride = other._stride;
+                _ptr = other._ptr;
+                _owner = other._owner;
+                _owning = false;
+                return *this;
+            }
+            if (!_owning || _rows != other._rows || _cols != other._cols) {
+                release();
+                allocate(other._rows, other._cols, 0);
+            }
+            _border = 0;
+            for (int i = 0; i < _rows; ++i) {
+                std::copy(other.row(i), other.row(i) + _cols, row(i));
+            }
+            return *this;
+        }
+
+        FlatArray& operator=(FlatArray&& other) noexcept {
+            if (this != &other) {
+                FlatArray moved(std::move(other));
+                swap(moved);
+            }
+            return *this;
+        }
 
-        FlatArray(int rows, int cols) : _rows(rows), _cols(cols), _data(rows * cols, 0) {}
+        void swap(FlatArray& other) noexcept {
+            std::swap(_rows, other._rows);
+            std::swap(_cols, other._cols);
+            std::swap(_stride, other._stride);
+            std::swap(_guard, other._guard);
+            std::swap(_border, other._border);
+            std::swap(_ptr, other._ptr);
+            std::swap(_base, other._base);
+            std::swap(_bytes, other._bytes);
+            std::swap(_allocator, other._allocator);
+            std::swap(_owner, other._owner);
+            std::swap(_owning, other._owning);
+        }
+
+        // Non-owning view over external memory; `data` must outlive the view.
+        static FlatArray borrow(T* data, int rows, int cols, int stride = 0) {
+            return adopt(data, rows, cols, stride, nullptr);
+        }
+
+        // Non-owning view that keeps `owner` alive until the last view referencing it is gone.
+        static FlatArray adopt(T* data, int rows, int cols, int stride, std::shared_ptr<void> owner) {
+            if (rows < 0 || cols < 0 || (stride != 0 && stride < cols)) {
+                throw std::invalid_argument("Invalid FlatArray view dimensions.");
+            }
+            FlatArray view;
+            view._rows = rows;
+            view._cols = cols;
+            view._stride = stride ? stride : cols;
+            view._ptr = data;
+            view._owner = std::move(owner);
+            view._owning = false;
+            return view;
+        }
 
-        const std::vector<T>& data() const {
-            return _data;
+        // View of a rectangle of this array, sharing its pixels. Views of owning arrays are only
+        // valid while the array keeps its storage.
+        FlatArray subView(int row, int col, int rows, int cols) {
+            if (row < 0 || col < 0 || rows < 0 || cols < 0 || row + rows > _rows || col + cols > _cols) {
+                throw std::invalid_argument("Sub-view exceeds the array bounds.");
+            }
+            return adopt(&(*this)(row, col), rows, cols, _stride, _owner);
+        }
+
+        const FlatArray subView(int row, int col, int rows, int cols) const {
+            return const_cast<FlatArray*>(this)->subView(row, col, rows, cols);
+        }
+
+        T* data() {
+            return _ptr;
+        }
+
+        const T* data() const {
+            return _ptr;
+        }
+
+        inline T* row(int i) {
+            return _ptr + static_cast<ptrdiff_t>(i) * _stride;
+        }
+
+        inline const T* row(int i) const {
+            return _ptr + static_cast<ptrdiff_t>(i) * _stride;
         }
 
         inline T& operator()(int i, int j) {
-            return _data[i * _cols + j];
+            return _ptr[static_cast<ptrdiff_t>(i) * _stride + j];
         }
 
         inline const T& operator()(int i, int j) const {
-            return _data[i * _cols + j];
+            return _ptr[static_cast<ptrdiff_t>(i) * _stride + j];
         }
 
+        // Keeps the current guard band
         void resize(int rows, int cols) {
-            _rows = rows;
-            _cols = cols;
-            _data.resize(rows * cols, 0);
+            resize(rows, cols, _guard);
+        }
+
+        void resize(int rows, int cols, int guard) {
+            _border = 0;
+            if (rows == _rows && cols == _cols && guard <= _guard) {
+                return;
+            }
+            if (!_owning || !isContinuous() || guard > 0) {
+                release();
+                allocate(rows, cols, guard);
+                return;
+            }
+            // keep the existing pixels in flat order, like std::vector::resize
+            T* previous = _base;
+            const size_t previousSize = size();
+            const size_t previousBytes = _bytes;
+            allocate(rows, cols, 0);
+            if (previous) {
+                std::copy(previous, previous + std::min(previousSize, size()), _ptr);
+                _allocator->deallocate(previous, previousBytes);
+            }
+        }
+
+        // Replicates the edge pixels `radius` pixels into the guard band, corners included.
+        // Touches O(perimeter * radius) pixels.
+        void fillBorder(int radius) {
+            if (radius > _guard) {
+                throw std::invalid_argument("Border radius exceeds the guard band.");
+            }
+            if (empty()) {
+                return;
+            }
+            for (int i = 0; i < _rows; ++i) {
+                T* r = row(i);
+                std::fill(r - radius, r, r[0]);
+                std::fill(r + _cols, r + _cols + radius, r[_cols - 1]);
+            }
+            for (int i = 1; i <= radius; ++i) {
+                std::copy(row(0) - radius, row(0) + _cols + radius, row(-i) - radius);
+                std::copy(row(_rows - 1) - radius, row(_rows - 1) + _cols + radius, row(_rows - 1 + i) - radius);
+            }
+            _border = radius;
         }
 
         size_t size() const {
-            return _data.size();
+            return static_cast<size_t>(_rows) * _cols;
         }
 
+        // Flat indexing and iteration assume a continuous array (stride() == cols()).
         inline T& operator[](size_t idx) {
-            return _data[idx];
+            return _ptr[idx];
         }
 
         inline const T& operator[](size_t idx) const {
-            return _data[idx];
+            return _ptr[idx];
         }
 
         // Iteration support
-        auto begin() { return _data.begin(); }
-        auto end() { return _data.end(); }
-        auto begin() const { return _data.begin(); }
-        auto end() const { return _data.end(); }
+        T* begin() { return _ptr; }
+        T* end() { return _ptr + size(); }
+        const T* begin() const { return _ptr; }
+        const T* end() const { return _ptr + size(); }
 
         int rows() const {
             return _rows;
@@ -56,30 +242,134 @@ class FlatArray {
             return _cols;
         }
 
+        // Distance between the starts of consecutive rows, in elements
+        int stride() const {
+            return _stride;
+        }
+
+        // Addressable pixels beyond each edge
+        int guard() const {
+            return _guard;
+        }
+
+        // Pixels beyond each edge that currently hold the replicated border
+        int border() const {
+            return _border;
+        }
+
+        bool isContinuous() const {
+            return _stride == _cols;
+        }
+
+        bool isView() const {
+            return !_owning;
+        }
+
+        // Whether the two arrays' pixel spans share memory, e.g. the same array or
+        // overlapping views of one buffer
+        bool overlaps(const FlatArray& other) const {
+            if (empty() || other.empty()) {
+                return false;
+            }
+            const T* end = row(_rows - 1) + _cols;
+            const T* otherEnd = other.row(other._rows - 1) + other._cols;
+            return std::less<const T*>()(_ptr, otherEnd) && std::less<const T*>()(other._ptr, end);
+        }
+
         bool empty() const {
-            return _data.empty();
+            return size() == 0;
         }
 
     private:
         friend class FlatImageFactory;
 
-        int _rows, _cols;
-        std::vector<T> _data;
+        // New owned storage; the allocator decides whether it is zero-filled
+        void allocate(int rows, int cols, int guard) {
+            constexpr int alignment = std::max<int>(PixelAllocator::ALIGNMENT / sizeof(T), 1);
+            auto alignUp = [&](int n) { return (n + alignment - 1) / alignment * alignment; };
+
+            const int left = guard ? alignUp(guard) : 0;
+            _rows = rows;
+            _cols = cols;
+            _guard = guard;
+            _border = 0;
+            _stride = guard ? alignUp(left + cols + guard) : cols;
+            _bytes = size() ? static_cast<size_t>(rows + 2 * guard) * _stride * sizeof(T) : 0;
+            _base = _bytes ? static_cast<T*>(_allocator->allocate(_bytes)) : nullptr;
+            _ptr = _base ? _base + static_cast<ptrdiff_t>(guard) * _stride + left : nullptr;
+            // owning arrays use _owner to keep their allocator alive while they hold its buffer
+            _owner = _base ? _allocator->share() : nullptr;
+            _owning = true;
+        }
+
+        void release() {
+            if (_owning && _base) {
+                _allocator->deallocate(_base, _bytes);
+            }
+            _owner.reset();
+            _rows = _cols = _stride = _guard = _border = 0;
+            _ptr = _base = nullptr;
+            _bytes = 0;
+            _owning = true;
+        }
+
+        int _rows, _cols, _stride, _guard, _border;
+        T* _ptr;
+        T* _base;
+        size_t _bytes;
+        PixelAllocator* _allocator;
+        std::shared_ptr<void> _owner;
+        bool _owning;
 };
 
 typedef FlatArray<uchar> FlatImage;
 
+// Runs run(input, result) into a scratch image from the calling thread's arena and copies the
+// result into output. For outputs that share pixels with the input, which a row sweep would
+// overwrite before reading them.
+template <typename Run>
+void applyThroughScratch(const FlatImage& input, FlatImage& output, Run&& run) {
+    FlatImage result(ScratchArena::local());
+    run(input, result);
+    output.resize(result.rows(), result.cols());
+    for (int i = 0; i < result.rows(); ++i) {
+        std::copy(result.row(i), result.row(i) + result.cols(), output.row(i));
+    }
+}
+
 class FlatImageFactory {
 public:
+    // Copies the pixels into a new owning FlatImage. Accepts non-continuous ROIs.
     static FlatImage from(const cv::Mat& mat) {
-        if (mat.type() != CV_8UC1) {
-            throw std::invalid_argument("Only single-channel 8-bit images are supported when converting from cv::Mat.");
-        }
+        checkType(mat);
         FlatImage flatImage(mat.rows, mat.cols);
-        std::copy(mat.data, mat.data + mat.total(), flatImage._data.begin());
+        for (int i = 0; i < mat.rows; ++i) {
+            std::copy(mat.ptr<uchar>(i), mat.ptr<uchar>(i) + mat.cols, flatImage.row(i));
+        }
         return flatImage;
     }
 
+    // Zero-copy view of the Mat's pixels, including strided ROIs. The view holds a reference
+    // to the Mat's buffer, so refcounted Mats stay alive for as long as the view does. Mats
+    // built over user-supplied memory carry no refcount; that memory must outlive the view.
+    static FlatImage wrap(const cv::Mat& mat) {
+        checkType(mat);
+        auto owner = std::make_shared<cv::Mat>(mat);
+        return FlatImage::adopt(owner->data, mat.rows, mat.cols, static_cast<int>(mat.step[0]), owner);
+    }
+
+    // Non-owning cv::Mat header over the FlatImage's pixels, with the same stride. The Mat does
+    // not keep the pixels alive: it is valid while the FlatImage (or the memory it views) is,
+    // and until the FlatImage is resized to a different shape.
+    static cv::Mat toMat(FlatImage& image) {
+        return cv::Mat(image.rows(), image.cols(), CV_8UC1, image.data(), image.stride() * sizeof(uchar));
+    }
+
+    // Read-only variant of toMat; the returned header must not be written through.
+    static const cv::Mat toMat(const FlatImage& image) {
+        return cv::Mat(image.rows(), image.cols(), CV_8UC1, const_cast<uchar*>(image.data()), image.stride() * sizeof(uchar));
+    }
+
     template <typename T>
     static FlatImage from(const std::vector<std::vector<T>>& array2d) {
         if (array2d.empty() || array2d[0].empty()) {
@@ -98,4 +388,11 @@ public:
         }
         return flatImage;
     }
+
+private:
+    static void checkType(const cv::Mat& mat) {
+        if (mat.type() != CV_8UC1) {
+            throw std::invalid_argument("Only single-channel 8-bit images are supported when converting from cv::Mat.");
+        }
+    }
 };
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+#include "filter_pipeline.hpp"
+
+// Sequential source of grayscale frames for VideoPipeline. read() fills `frame` (resizing it as
+// needed) and returns false once the stream is exhausted.
+class FrameSource
+{
+public:
+    virtual ~FrameSource() = default;
+
+    virtual bool read(FlatImage& frame) = 0;
+};
+
+// Sequential sink for filtered frames
+class FrameSink
+{
+public:
+    virtual ~FrameSink() = default;
+
+    virtual void write(const FlatImage& frame) = 0;
+};
+
+// Decodes a video file (or anything else cv::VideoCapture opens) and converts it to grayscale
+// straight into the frame buffer
+class VideoCaptureSource : public FrameSource
+{
+public:
+    explicit VideoCaptureSource(const std::string& path);
+
+    bool read(FlatImage& frame) override;
+
+    int rows() const { return frameRows; }
+    int cols() const { return frameCols; }
+    double fps() const { return framesPerSecond; }
+
+private:
+    cv::VideoCapture capture;
+    cv::Mat decoded;
+    int frameRows = 0;
+    int frameCols = 0;
+    double framesPerSecond = 0;
+};
+
+// Generates `frames` frames of a moving gradient with a bright square sweeping across it;
+// frame k is the same on every run.
+class SyntheticFrameSource : public FrameSource
+{
+public:
+    SyntheticFrameSource(int rows, int cols, int frames);
+
+    bool read(FlatImage& frame) override;
+
+private:
+    int frameRows;
+    int frameCols;
+    int frames;
+    int nextFrame = 0;
+};
+
+// Encodes single-channel frames with cv::VideoWriter
+class VideoWriterSink : public FrameSink
+{
+public:
+    VideoWriterSink(const std::string& path, double fps, int rows, int cols, int fourcc = cv::VideoWriter::fourcc('m', 'p', '4', 'v'));
+
+    void write(const FlatImage& frame) override;
+
+private:
+    cv::VideoWriter writer;
+};
+
+struct VideoOptions
+{
+    // Frame buffers in flight. Reading, filtering and writing each hold at most one, so 3 keeps
+    // every stage busy and the rest absorb jitter; latency is bounded by ringFrames frames.
+    size_t ringFrames = 4;
+};
+
+struct VideoReport
+{
+    size_t frames = 0;
+    double seconds = 0;
+    double framesPerSecond = 0;
+    double meanLatencyMs = 0; // from the start of a frame's read to the end of its write
+    double maxLatencyMs = 0;
+    // time each stage spent working rather than waiting; the largest one bounds throughput
+    double readSeconds = 0;
+    double filterSeconds = 0;
+    double writeSeconds = 0;
+};
+
+// Runs FrameSource reading, FilterPipeline::apply and FrameSink writing as three concurrent
+// stages. Frames travel between them as indices into a fixed ring of reused input/output
+// buffers, passed through bounded lock-free single-producer single-consumer queues, so steady
+// state makes no allocations and throughput approaches that of the slowest stage.
+class VideoPipeline
+{
+public:
+    explicit VideoPipeline(const FilterPipeline& pipeline, const VideoOptions& options = {});
+
+    // Reads and writes on two helper threads and filters on the calling thread until the source
+    // is exhausted. The first exception thrown by any stage stops the others and is rethrown.
+    VideoReport run(FrameSource& source, FrameSink& sink);
+
+private:
+    struct FrameSlot
+    {
+        FlatImage input;
+        FlatImage output;
+        double readStart = 0; // seconds since the start of run()
+    };
+
+    FilterPipeline pipeline;
+    std::vector<FrameSlot> ring;
+};
@@ -0,0 +1,56 @@
+#include "adaptive_threshold.hpp"
+#include "fixed_point.hpp"
+#include "integral_image.hpp"
+#include "prof_utils.hpp"
+
+
+AdaptiveThreshold::AdaptiveThreshold(int ksize, int offset, uchar maxValue) : ksize(ksize), offset(offset), maxValue(maxValue)
+{
+    if (ksize < 3 || ksize % 2 == 0 || ksize > 4095) {
+        throw std::invalid_argument("AdaptiveThreshold needs an odd kernel size from 3 to 4095.");
+    }
+}
+
+std::string AdaptiveThreshold::signature() const
+{
+    return "AdaptiveThreshold(" + std::to_string(ksize) + "," + std::to_string(offset) + "," + std::to_string(maxValue) + ")";
+}
+
+void AdaptiveThreshold::applyBenchmark(const cv::Mat& input, cv::Mat& output) const {
+    PROF_EXEC_TIME;
+
+    cv::adaptiveThreshold(input, output, maxValue, cv::ADAPTIVE_THRESH_MEAN_C, cv::THRESH_BINARY, ksize, offset);
+}
+
+void AdaptiveThreshold::apply(const FlatImage& input, FlatImage& output) const {
+    PROF_EXEC_TIME;
+
+    // every output pixel only reads its own source pixel after the integral image is built, so
+    // only outputs that are not the input itself need the scratch
+    if (output.overlaps(input) && (output.data() != input.data() || output.stride() != input.stride())) {
+        applyThroughScratch(input, output, [this](const FlatImage& from, FlatImage& to) { apply(from, to); });
+        return;
+    }
+
+    const int r = radius();
+    const uint32_t area = static_cast<uint32_t>(ksize) * ksize;
+    // the window mean is rounded to 8 bits before the comparison, as cv::adaptiveThreshold does
+    const FixedPointDivisor divide(area, 255 * area);
+
+    IntegralImage integral(ScratchArena::local());
+    integral.build(input, r, false);
+
+    output.resize(input.rows(), input.cols());
+    forEachIndex(input.rows(), input.size(), [&](int idxi) {
+        const uint32_t* above = integral.sumsRow(idxi - r);
+        const uint32_t* below = integral.sumsRow(idxi + r + 1);
+        const uchar* src = input.row(idxi);
+        uchar* out = output.row(idxi);
+
+        for (int idxj = 0; idxj < input.cols(); ++idxj) {
+            const uint32_t sum = below[idxj + r + 1] - below[idxj - r] - above[idxj + r + 1] + above[idxj - r];
+            const int mean = static_cast<int>(divide(sum));
+            out[idxj] = src[idxj] - mean > -offset ? maxValue : 0;
+        }
+    });
+}
@@ -1,16 +1,40 @@
-#include <execution>
-
 #include "prof_utils.hpp"
 #include "blur.hpp"
 
 
+Blur::Blur(int ksize) : ksize(ksize)
+{
+    if (ksize < 1 || ksize % 2 == 0) {
+        throw std::invalid_argument("Blur needs a positive odd kernel size.");
+    }
+}
+
 void Blur::applyBenchmark(const cv::Mat& input, cv::Mat& output) const {
     PROF_EXEC_TIME;
 
-    cv::blur(input, output, cv::Size(3, 3));
+    cv::blur(input, output, cv::Size(ksize, ksize), cv::Point(-1, -1), cv::BORDER_REPLICATE);
 }
 
 void Blur::apply(const FlatImage& input, FlatImage& output) const {
     PROF_EXEC_TIME;
-    applySingleKernel(input, output, KERNEL, 0);
+    boxMean(input, output, radius(), radius());
+}
+
+void Blur::applyChannels(const ChannelImage<uchar>& input, ChannelImage<uchar>& output) const {
+    PROF_EXEC_TIME;
+    boxMean(input, output, radius(), radius());
+}
+
+void Blur::applyChannels(const ChannelImage<uint16_t>& input, ChannelImage<uint16_t>& output) const {
+    PROF_EXEC_TIME;
+    boxMean(input, output, radius(), radius());
+}
+
+void Blur::applyChannels(const ChannelImage<float>& input, ChannelImage<float>& output) const {
+    PROF_EXEC_TIME;
+    boxMean(input, output, radius(), radius());
+}
+
+void Blur::applyRow(const uchar* const* window, uchar* out, int cols, RowScratch& scratch) const {
+    boxMeanRow(window, out, cols, radius(), scratch);
 }
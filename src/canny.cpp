@@ -0,0 +1,338 @@
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+#include "canny.hpp"
+#include "prof_utils.hpp"
+#include "simd_kernels.hpp"
+#include "sobel.hpp"
+
+
+CannyEdgeDetector::CannyEdgeDetector(double lowThreshold, double highThreshold, GradientNorm norm)
+    : lowThreshold(lowThreshold), highThreshold(highThreshold), norm(norm)
+{
+    if (lowThreshold < 0 || highThreshold < lowThreshold) {
+        throw std::invalid_argument("Canny thresholds must satisfy 0 <= low <= high.");
+    }
+}
+
+std::string CannyEdgeDetector::signature() const
+{
+    // thresholds at full precision, so any two that differ give different signatures
+    std::ostringstream text;
+    text << std::setprecision(17) << "CannyEdgeDetector(" << lowThreshold << "," << highThreshold << ","
+         << (norm == GradientNorm::L1 ? "L1" : "L2") << ")";
+    return text.str();
+}
+
+void CannyEdgeDetector::applyBenchmark(const cv::Mat& input, cv::Mat& output) const {
+    PROF_EXEC_TIME;
+
+    cv::Canny(input, output, lowThreshold, highThreshold, 3, norm == GradientNorm::L2);
+}
+
+void CannyEdgeDetector::apply(const FlatImage& input, FlatImage& output) const {
+    PROF_EXEC_TIME;
+
+    ScratchArena& arena = ScratchArena::local();
+
+    // the fused Sobel sweep, keeping only what thinning needs
+    GradientField field(arena);
+    field.norm = norm;
+    field.outputs = GradientMagnitude | GradientOrientation;
+    SobelOperator().applyGradientField(input, field);
+
+    FlatImage candidates(arena);
+    suppressNonMaxima(field, candidates);
+    traceEdges(candidates, output);
+}
+
+static inline float magnitudeAt(const float* row, int j, int cols) {
+    return j >= 0 && j < cols ? row[j] : 0.0f;
+}
+
+void CannyEdgeDetector::suppressNonMaxima(const GradientField& field, FlatImage& candidates) const {
+    PROF_EXEC_TIME;
+
+    const int rows = field.magnitude.rows();
+    const int cols = field.magnitude.cols();
+    const float low = static_cast<float>(lowThreshold);
+    const float high = static_cast<float>(highThreshold);
+
+    candidates.resize(rows, cols);
+    if (field.magnitude.empty()) {
+        return;
+    }
+
+    // neighbours outside the image have zero magnitude, so the rows above the first and below
+    // the last read a zero row
+    ScratchArena& arena = ScratchArena::local();
+    FlatArray<float> zeros(1, cols, arena);
+    std::fill(zeros.begin(), zeros.end(), 0.0f);
+    const SimdKernelSet& simd = activeSimdKernels();
+
+    forEachIndex(rows, field.magnitude.size(), [&](int idxi) {
+        const float* above = idxi > 0 ? field.magnitude.row(idxi - 1) : zeros.data();
+        const float* center = field.magnitude.row(idxi);
+        const float* below = idxi + 1 < rows ? field.magnitude.row(idxi + 1) : zeros.data();
+        const uchar* direction = field.orientation.row(idxi);
+        uchar* out = candidates.row(idxi);
+
+        // The first neighbour along the gradient must be strictly smaller and the second no
+        // larger, so a plateau keeps exactly one pixel; Sobel's gy points up, so Diagonal
+        // gradients run from the lower left to the upper right
+        auto suppressPixel = [&](int idxj) {
+            const float m = center[idxj];
+            bool peak;
+            switch (static_cast<GradientDirection>(direction[idxj])) {
+            case GradientDirection::Horizontal:
+                peak = m > magnitudeAt(center, idxj - 1, cols) && m >= magnitudeAt(center, idxj + 1, cols);
+                break;
+            case GradientDirection::Vertical:
+                peak = m > above[idxj] && m >= below[idxj];
+                break;
+            case GradientDirection::Diagonal:
+                peak = m > magnitudeAt(above, idxj + 1, cols) && m > magnitudeAt(below, idxj - 1, cols);
+                break;
+            default:
+                peak = m > magnitudeAt(above, idxj - 1, cols) && m > magnitudeAt(below, idxj + 1, cols);
+                break;
+            }
+            out[idxj] = !(peak && m > low) ? 0 : (m > high ? STRONG : WEAK);
+        };
+
+        const int firstScalar = simd.suppressNonMaximaRow(above, center, below, direction, out, cols, low, high);
+        suppressPixel(0);
+        for (int idxj = std::max(firstScalar, 1); idxj < cols; ++idxj) {
+            suppressPixel(idxj);
+        }
+    });
+}
+
+namespace {
+
+// Horizontal run of candidates [begin, end) in one row, the unit the edge tracing links.
+// `strong` starts as "the run holds a strong pixel" and, once the run is the root of its set,
+// means "the set holds one".
+struct CandidateRun
+{
+    int32_t begin;
+    int32_t end;
+    uchar strong;
+};
+
+}
+
+// Gathers the lowest bit of each of the eight bytes of a little-endian word into one byte
+static inline uint64_t byteFlags(uint64_t word) {
+    return ((word & 0x0101010101010101ull) * 0x0102040810204080ull) >> 56;
+}
+
+// Bits [from, to) of a 64-bit block, for 0 <= from < 64 and from <= to <= 64
+static inline uint64_t bitRange(int from, int to) {
+    const uint64_t below = to == 64 ? ~uint64_t(0) : (uint64_t(1) << to) - 1;
+    return below & ~((uint64_t(1) << from) - 1);
+}
+
+// Candidate bits of `width` <= 64 pixels, and their strong bits
+static inline uint64_t candidateBits(const uchar* pixels, int width, uint64_t& strong) {
+    static_assert(CannyEdgeDetector::WEAK == 1 && CannyEdgeDetector::STRONG == 2, "candidate bits");
+
+    uint64_t candidate = 0;
+    strong = 0;
+    for (int k = 0; k < width; k += 8) {
+        uint64_t word = 0;
+        std::memcpy(&word, pixels + k, std::min(8, width - k));
+        candidate |= byteFlags(word | (word >> 1)) << k;
+        strong |= byteFlags(word >> 1) << k;
+    }
+    return candidate;
+}
+
+// Number of runs findRuns splits a candidate row into: the bits where the candidate mask
+// switches on
+static int countRuns(const uchar* row, int cols) {
+    int count = 0;
+    uint64_t carry = 0; // the last pixel of the previous block was a candidate
+    for (int base = 0; base < cols; base += 64) {
+        const int width = std::min(64, cols - base);
+        uint64_t strong;
+        const uint64_t candidate = candidateBits(row + base, width, strong);
+        count += std::popcount(candidate & ~((candidate << 1) | carry));
+        carry = (candidate >> (width - 1)) & 1;
+    }
+    return count;
+}
+
+// Splits a candidate row into runs; returns the number of runs. The row is read 64 pixels at a
+// time as bit masks of candidates and strong pixels, and runs are found from the bits where
+// the candidate mask switches on and off, so the cost follows the number of runs rather than
+// the number of pixels.
+static int findRuns(const uchar* row, int cols, CandidateRun* runs) {
+    int count = 0;
+    bool open = false; // the last run continues into the current block
+    int from = 0;      // first bit of the open run in the current block
+    for (int base = 0; base < cols; base += 64) {
+        const int width = std::min(64, cols - base);
+        uint64_t strong;
+        const uint64_t candidate = candidateBits(row + base, width, strong);
+
+        const uint64_t previous = (candidate << 1) | (open ? 1 : 0);
+        uint64_t starts = candidate & ~previous;
+        uint64_t ends = ~candidate & previous;
+        while (open ? ends != 0 : starts != 0) {
+            if (open) {
+                const int j = std::countr_zero(ends);
+                ends &= ends - 1;
+                runs[count - 1].end = base + j;
+                runs[count - 1].strong |= (strong & bitRange(from, j)) != 0;
+                open = false;
+            } else {
+                const int j = std::countr_zero(starts);
+                starts &= starts - 1;
+                runs[count++] = {base + j, 0, 0};
+                from = j;
+                open = true;
+            }
+        }
+        if (open) {
+            runs[count - 1].strong |= (strong & bitRange(from, 64)) != 0;
+            from = 0;
+        }
+    }
+    if (open) {
+        runs[count - 1].end = cols;
+    }
+    return count;
+}
+
+// Union-find over run slots, where every set's root is its smallest slot. Within a chunk a
+// single thread owns all entries, so plain accesses with path halving are fine.
+static int32_t findRoot(int32_t* parents, int32_t index) {
+    while (parents[index] != index) {
+        parents[index] = parents[parents[index]];
+        index = parents[index];
+    }
+    return index;
+}
+
+static void unite(int32_t* parents, int32_t a, int32_t b) {
+    a = findRoot(parents, a);
+    b = findRoot(parents, b);
+    if (a < b) {
+        parents[b] = a;
+    } else if (b < a) {
+        parents[a] = b;
+    }
+}
+
+// Unites every run of a row with the runs of the row above that touch it, diagonals included,
+// walking both sorted run lists once. Rows are given by their first slot and run count.
+static void linkRows(const CandidateRun* runs, int32_t* parents, int32_t upper, int upperCount, int32_t lower, int lowerCount) {
+    const int32_t upperEnd = upper + upperCount;
+    const int32_t lowerEnd = lower + lowerCount;
+    while (upper < upperEnd && lower < lowerEnd) {
+        if (runs[upper].end < runs[lower].begin) {
+            ++upper;
+        } else if (runs[lower].end < runs[upper].begin) {
+            ++lower;
+        } else {
+            unite(parents, upper, lower);
+            // advance whichever run ends first; the other may touch the next one too
+            if (runs[upper].end < runs[lower].end) {
+                ++upper;
+            } else {
+                ++lower;
+            }
+        }
+    }
+}
+
+void CannyEdgeDetector::traceEdges(const FlatImage& candidates, FlatImage& output) {
+    PROF_EXEC_TIME;
+
+    const int rows = candidates.rows();
+    const int cols = candidates.cols();
+    output.resize(rows, cols);
+    if (candidates.empty()) {
+        return;
+    }
+
+    const int chunkCount = currentExecutionPolicy().chunksFor(rows, candidates.size());
+    const int chunkRows = (rows + chunkCount - 1) / chunkCount;
+
+    // Candidates are thin lines, so linking runs instead of pixels cuts the union-find work
+    // several times over. The runs are counted first and packed row after row, so the run
+    // tables hold exactly the runs found, every chunk's slots stay contiguous and slot order
+    // follows pixel order.
+    ScratchArena& arena = ScratchArena::local();
+    FlatArray<int32_t> rowStartArray(1, rows, arena);
+    FlatArray<int> runCountArray(1, rows, arena);
+    int32_t* rowStarts = rowStartArray.data();
+    int* runCounts = runCountArray.data();
+
+    // 1. count the runs of every row and place the rows
+    forEachIndex(rows, candidates.size(), [&](int idxi) { runCounts[idxi] = countRuns(candidates.row(idxi), cols); });
+    std::exclusive_scan(runCounts, runCounts + rows, rowStarts, int32_t(0));
+    const int32_t totalRuns = rowStarts[rows - 1] + runCounts[rows - 1];
+
+    FlatArray<CandidateRun> runArray(1, std::max(totalRuns, 1), arena);
+    FlatArray<int32_t> parentArray(1, std::max(totalRuns, 1), arena);
+    CandidateRun* runs = runArray.data();
+    int32_t* parents = parentArray.data();
+
+    // 2. every chunk finds and links the runs of its own rows
+    forEachIndex(chunkCount, candidates.size(), [&](int chunk) {
+        const int begin = chunk * chunkRows;
+        const int end = std::min(begin + chunkRows, rows);
+        for (int idxi = begin; idxi < end; ++idxi) {
+            const int32_t slot = rowStarts[idxi];
+            findRuns(candidates.row(idxi), cols, runs + slot);
+            std::iota(parents + slot, parents + slot + runCounts[idxi], slot);
+            if (idxi > begin) {
+                linkRows(runs, parents, rowStarts[idxi - 1], runCounts[idxi - 1], slot, runCounts[idxi]);
+            }
+        }
+    });
+
+    // 3. join the sets across the seams between chunks
+    for (int begin = chunkRows; begin < rows; begin += chunkRows) {
+        linkRows(runs, parents, rowStarts[begin - 1], runCounts[begin - 1], rowStarts[begin], runCounts[begin]);
+    }
+
+    // 4. point every run straight at its root and flag the roots of strong runs. Chunks now
+    // share roots, so the parent reads and root flags are atomic; every parent read is an
+    // ancestor or the root itself, so all paths still end at the root. A root only ever has
+    // its flag raised for its own set, so reading it as the run's own flag stays correct.
+    forEachIndex(chunkCount, candidates.size(), [&](int chunk) {
+        const int begin = chunk * chunkRows;
+        const int end = std::min(begin + chunkRows, rows);
+        if (begin >= end) {
+            return;
+        }
+        for (int32_t slot = rowStarts[begin]; slot < rowStarts[end - 1] + runCounts[end - 1]; ++slot) {
+            int32_t root = slot;
+            for (int32_t parent; (parent = std::atomic_ref(parents[root]).load(std::memory_order_relaxed)) != root;) {
+                root = parent;
+            }
+            std::atomic_ref(parents[slot]).store(root, std::memory_order_relaxed);
+            if (std::atomic_ref(runs[slot].strong).load(std::memory_order_relaxed)) {
+                std::atomic_ref(runs[root].strong).store(1, std::memory_order_relaxed);
+            }
+        }
+    });
+
+    // 5. draw the runs whose set holds a strong pixel
+    forEachIndex(rows, candidates.size(), [&](int idxi) {
+        uchar* out = output.row(idxi);
+        std::fill(out, out + cols, 0);
+        for (int32_t slot = rowStarts[idxi]; slot < rowStarts[idxi] + runCounts[idxi]; ++slot) {
+            if (runs[parents[slot]].strong) {
+                std::fill(out + runs[slot].begin, out + runs[slot].end, 255);
+            }
+        }
+    });
+}
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "content_hash.hpp"
+#include "prof_utils.hpp"
+#include "simd_kernels.hpp"
+
+
+namespace {
+
+constexpr int STRIPE_BYTES = 64;
+constexpr int STRIPES_PER_BLOCK = 16;
+constexpr size_t SECRET_BYTES = 8 * STRIPES_PER_BLOCK + STRIPE_BYTES; // keys of every stripe in a block, and of the scramble
+
+constexpr uint64_t PRIME32_1 = 0x9E3779B1U;
+constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+
+constexpr uint64_t splitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr std::array<uchar, SECRET_BYTES> makeSecret() {
+    std::array<uchar, SECRET_BYTES> secret{};
+    uint64_t state = PRIME64_3;
+    for (size_t i = 0; i < SECRET_BYTES; i += 8) {
+        const uint64_t word = splitMix64(state);
+        for (size_t b = 0; b < 8; ++b) {
+            secret[i + b] = static_cast<uchar>(word >> (8 * b));
+        }
+    }
+    return secret;
+}
+
+constexpr std::array<uchar, SECRET_BYTES> SECRET = makeSecret();
+
+uint64_t secretWord(size_t offset) {
+    uint64_t word;
+    std::memcpy(&word, SECRET.data() + offset, sizeof(word));
+    return word;
+}
+
+uint64_t foldedMultiply(uint64_t a, uint64_t b) {
+    const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+}
+
+uint64_t avalanche(uint64_t h) {
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9ULL;
+    return h ^ (h >> 32);
+}
+
+// Streams bytes through 64-byte stripes. Every block of STRIPES_PER_BLOCK stripes ends with a
+// scramble of the lanes, so a lane's sums cannot cancel across blocks.
+class StripeHasher
+{
+public:
+    void update(const uchar* data, size_t size) {
+        total += size;
+        if (buffered > 0) {
+            const size_t take = std::min(size, STRIPE_BYTES - buffered);
+            std::memcpy(buffer + buffered, data, take);
+            buffered += take;
+            data += take;
+            size -= take;
+            if (buffered < STRIPE_BYTES) {
+                return;
+            }
+            consume(buffer, 1);
+            buffered = 0;
+        }
+        while (size >= STRIPE_BYTES) {
+            const int stripes = static_cast<int>(std::min<size_t>(size / STRIPE_BYTES, STRIPES_PER_BLOCK - stripe));
+            consume(data, stripes);
+            data += static_cast<size_t>(STRIPE_BYTES) * stripes;
+            size -= static_cast<size_t>(STRIPE_BYTES) * stripes;
+        }
+        std::memcpy(buffer, data, size);
+        buffered = size;
+    }
+
+    uint64_t finish(uint64_t seed) {
+        if (buffered > 0) {
+            std::memset(buffer + buffered, 0, STRIPE_BYTES - buffered);
+            consume(buffer, 1);
+        }
+        uint64_t result = total * PRIME64_1 ^ seed * PRIME64_2;
+        for (int i = 0; i < 4; ++i) {
+            result += foldedMultiply(lanes[2 * i] ^ secretWord(16 * i), lanes[2 * i + 1] ^ secretWord(16 * i + 8));
+        }
+        return avalanche(result);
+    }
+
+private:
+    void consume(const uchar* data, int stripes) {
+        activeSimdKernels().hashStripes(lanes, data, stripes, SECRET.data() + 8 * stripe);
+        stripe += stripes;
+        if (stripe == STRIPES_PER_BLOCK) {
+            for (int lane = 0; lane < 8; ++lane) {
+                lanes[lane] = ((lanes[lane] ^ (lanes[lane] >> 47)) ^ secretWord(8 * STRIPES_PER_BLOCK + 8 * lane)) * PRIME32_1;
+            }
+            stripe = 0;
+        }
+    }
+
+    uint64_t lanes[8] = {PRIME32_1, PRIME64_1, PRIME64_2, PRIME64_3, PRIME64_1 ^ PRIME64_2, PRIME64_2 ^ PRIME64_3, PRIME32_1 ^ PRIME64_3, PRIME64_1 + PRIME32_1};
+    uchar buffer[STRIPE_BYTES];
+    size_t buffered = 0;
+    size_t total = 0;
+    int stripe = 0;
+};
+
+} // namespace
+
+
+uint64_t contentHash(const FlatImage& image) {
+    PROF_EXEC_TIME;
+
+    StripeHasher hasher;
+    for (int i = 0; i < image.rows(); ++i) {
+        hasher.update(image.row(i), image.cols());
+    }
+    return hasher.finish(static_cast<uint64_t>(image.rows()) << 32 | static_cast<uint32_t>(image.cols()));
+}
+
+uint64_t contentHash(const void* data, size_t size) {
+    StripeHasher hasher;
+    hasher.update(static_cast<const uchar*>(data), size);
+    return hasher.finish(0);
+}
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "dirty_regions.hpp"
+#include "parallel_utils.hpp"
+#include "prof_utils.hpp"
+
+
+namespace {
+
+PixelRect boundingBox(const PixelRect& a, const PixelRect& b) {
+    const int top = std::min(a.row, b.row);
+    const int left = std::min(a.col, b.col);
+    return {top, left, std::max(a.row + a.rows, b.row + b.rows) - top, std::max(a.col + a.cols, b.col + b.cols) - left};
+}
+
+bool overlaps(const PixelRect& a, const PixelRect& b) {
+    return a.row < b.row + b.rows && b.row < a.row + a.rows && a.col < b.col + b.cols && b.col < a.col + a.cols;
+}
+
+// Pixels applyRegion filters for a rectangle: the rectangle and its halo
+size_t recomputeCost(const PixelRect& rect, int halo) {
+    return static_cast<size_t>(rect.rows + 2 * halo) * (rect.cols + 2 * halo);
+}
+
+} // namespace
+
+
+std::vector<PixelRect> findChangedRects(const FlatImage& previous, const FlatImage& current, int blockSize) {
+    PROF_EXEC_TIME;
+
+    if (blockSize <= 0) {
+        throw std::invalid_argument("Block size must be positive.");
+    }
+    const int rows = current.rows();
+    const int cols = current.cols();
+    if (previous.rows() != rows || previous.cols() != cols) {
+        return current.empty() ? std::vector<PixelRect>{} : std::vector<PixelRect>{{0, 0, rows, cols}};
+    }
+
+    const int blockRows = (rows + blockSize - 1) / blockSize;
+    const int blockCols = (cols + blockSize - 1) / blockSize;
+    std::vector<uchar> changed(static_cast<size_t>(blockRows) * blockCols, 0);
+
+    forEachIndex(blockRows, current.size(), [&](int blockRow) {
+        uchar* flags = changed.data() + static_cast<size_t>(blockRow) * blockCols;
+        const int end = std::min((blockRow + 1) * blockSize, rows);
+        for (int i = blockRow * blockSize; i < end; ++i) {
+            const uchar* before = previous.row(i);
+            const uchar* after = current.row(i);
+            if (std::memcmp(before, after, cols) == 0) {
+                continue;
+            }
+            for (int block = 0; block < blockCols; ++block) {
+                const int col = block * blockSize;
+                if (!flags[block] && std::memcmp(before + col, after + col, std::min(blockSize, cols - col)) != 0) {
+                    flags[block] = 1;
+                }
+            }
+        }
+    });
+
+    // runs of changed cells per cell row; a run continues the rectangle above with the same span
+    std::vector<PixelRect> rects;
+    std::vector<PixelRect> open; // rectangles ending at the previous cell row
+    for (int blockRow = 0; blockRow < blockRows; ++blockRow) {
+        const uchar* flags = changed.data() + static_cast<size_t>(blockRow) * blockCols;
+        const int row = blockRow * blockSize;
+        const int height = std::min(blockSize, rows - row);
+
+        std::vector<PixelRect> runs;
+        for (int block = 0; block < blockCols;) {
+            if (!flags[block]) {
+                ++block;
+                continue;
+            }
+            const int first = block;
+            while (block < blockCols && flags[block]) {
+                ++block;
+            }
+            const int col = first * blockSize;
+            const int width = std::min(block * blockSize, cols) - col;
+
+            auto above = std::find_if(open.begin(), open.end(), [&](const PixelRect& rect) {
+                return rect.col == col && rect.cols == width;
+            });
+            if (above != open.end()) {
+                runs.push_back({above->row, col, above->rows + height, width});
+                open.erase(above);
+            } else {
+                runs.push_back({row, col, height, width});
+            }
+        }
+        rects.insert(rects.end(), open.begin(), open.end());
+        open = std::move(runs);
+    }
+    rects.insert(rects.end(), open.begin(), open.end());
+    return rects;
+}
+
+std::vector<PixelRect> coverRects(const std::vector<PixelRect>& rects, int halo, int rows, int cols) {
+    std::vector<PixelRect> cover;
+    for (const PixelRect& rect : rects) {
+        const int top = std::max(rect.row - halo, 0);
+        const int left = std::max(rect.col - halo, 0);
+        const PixelRect grown{top, left, std::min(rect.row + rect.rows + halo, rows) - top, std::min(rect.col + rect.cols + halo, cols) - left};
+        if (!rect.empty() && !grown.empty()) {
+            cover.push_back(grown);
+        }
+    }
+
+    // merge overlapping pairs, and pairs cheaper as one box, until none is left; a grown box is
+    // checked against all others again
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (size_t a = 0; a < cover.size(); ++a) {
+            for (size_t b = a + 1; b < cover.size(); ++b) {
+                const PixelRect box = boundingBox(cover[a], cover[b]);
+                if (overlaps(cover[a], cover[b])
+                        || recomputeCost(box, halo) <= recomputeCost(cover[a], halo) + recomputeCost(cover[b], halo)) {
+                    cover[a] = box;
+                    cover.erase(cover.begin() + b);
+                    b = a;
+                    merged = true;
+                }
+            }
+        }
+    }
+    return cover;
+}
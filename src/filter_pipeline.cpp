@@ -1,40 +1,475 @@
+#include <chrono>
+#include <cstring>
+#include <unistd.h>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
 #include "filter_pipeline.hpp"
+#include "adaptive_threshold.hpp"
 #include "blur.hpp"
+#include "canny.hpp"
+#include "content_hash.hpp"
+#include "gaussian_blur.hpp"
+#include "laplacian_of_gaussian.hpp"
+#include "local_variance.hpp"
 #include "scharr.hpp"
 #include "sobel.hpp"
+#include "prof_utils.hpp"
 
 FilterPipeline& FilterPipeline::add(const std::shared_ptr<const ImageFilter>& filter)
 {
     filters.push_back(filter);
+    rebuildPlan();
     return *this;
 }
 
-FilterPipeline& FilterPipeline::addBlur()
+FilterPipeline& FilterPipeline::addBlur(int ksize)
 {
-    filters.push_back(std::make_shared<Blur>());
-    return *this;
+    return add(std::make_shared<Blur>(ksize));
+}
+
+FilterPipeline& FilterPipeline::addGaussianBlur(int ksize)
+{
+    return add(std::make_shared<GaussianBlur>(ksize));
+}
+
+FilterPipeline& FilterPipeline::addLaplacianOfGaussian()
+{
+    return add(std::make_shared<LaplacianOfGaussian>());
 }
 
 FilterPipeline& FilterPipeline::addScharrOperator()
 {
-    filters.push_back(std::make_shared<ScharrOperator>());
-    return *this;
+    return add(std::make_shared<ScharrOperator>());
 }
 
-FilterPipeline& FilterPipeline::addSobelOperator()
+FilterPipeline& FilterPipeline::addSobelOperator(int ksize)
 {
-    filters.push_back(std::make_shared<SobelOperator>());
-    return *this;
+    return add(std::make_shared<SobelOperator>(ksize));
+}
+
+FilterPipeline& FilterPipeline::addLocalVariance(int ksize)
+{
+    return add(std::make_shared<LocalVariance>(ksize));
+}
+
+FilterPipeline& FilterPipeline::addAdaptiveThreshold(int ksize, int offset)
+{
+    return add(std::make_shared<AdaptiveThreshold>(ksize, offset));
+}
+
+FilterPipeline& FilterPipeline::addCannyEdgeDetector(double lowThreshold, double highThreshold, GradientNorm norm)
+{
+    return add(std::make_shared<CannyEdgeDetector>(lowThreshold, highThreshold, norm));
 }
 
 void FilterPipeline::apply(const FlatImage& input, FlatImage& output)
 {
-    FlatImage temp = input;
+    ExecutionPolicyScope scope(executionPolicy());
+    applyWithPolicy(input, output);
+}
+
+template <ChannelSample T>
+void FilterPipeline::apply(const ChannelImage<T>& input, ChannelImage<T>& output)
+{
+    PROF_EXEC_TIME;
+
+    // an output sharing pixels with the input is filled from a scratch copy of the result
+    if (output.samples().overlaps(input.samples())) {
+        ChannelImage<T> result(ScratchArena::local());
+        apply(input, result);
+        ChannelImageFactory::convert(result, output);
+        return;
+    }
+
+    ExecutionPolicyScope scope(executionPolicy());
+
+    // the stages the plan keeps, unfolded: folded kernels are sized for 8-bit sums and their
+    // edge bands for single-channel images
+    std::vector<const ImageFilter*> stages;
+    for (const PlanStep& step : executionPlan.steps()) {
+        for (size_t stage : step.stages) {
+            stages.push_back(filters[stage].get());
+        }
+    }
+
+    if (stages.empty()) {
+        output.resizeLike(input);
+        ChannelImageFactory::convert(input, output);
+        return;
+    }
+
+    ScratchArena& arena = ScratchArena::local();
+    ChannelImage<T> buffers[2] = {ChannelImage<T>(arena), ChannelImage<T>(arena)};
+
+    const ChannelImage<T>* source = &input;
+    for (size_t stage = 0; stage < stages.size(); ++stage) {
+        ChannelImage<T>& target = stage + 1 == stages.size() ? output : buffers[stage % 2];
+        stages[stage]->applyChannels(*source, target);
+        source = &target;
+    }
+}
+
+template void FilterPipeline::apply(const ChannelImage<uchar>& input, ChannelImage<uchar>& output);
+template void FilterPipeline::apply(const ChannelImage<uint16_t>& input, ChannelImage<uint16_t>& output);
+template void FilterPipeline::apply(const ChannelImage<float>& input, ChannelImage<float>& output);
+
+void FilterPipeline::setPlanOptions(const PlanOptions& options)
+{
+    planOptions = options;
+    rebuildPlan();
+}
+
+const PipelinePlan& FilterPipeline::plan() const
+{
+    return executionPlan;
+}
+
+void FilterPipeline::rebuildPlan()
+{
+    executionPlan = PipelinePlan::build(filters, planOptions);
+
+    pipelineSignature.clear();
     for (const auto& filter : filters) {
-        filter->apply(temp, output);
-        temp = std::move(output);
+        const std::string stage = filter->signature();
+        if (stage.empty()) {
+            pipelineSignature.clear();
+            break;
+        }
+        pipelineSignature += (pipelineSignature.empty() ? "" : "|") + stage;
     }
-    output = std::move(temp);
+    // folding rounds differently from the stage-by-stage chain; dropping no-ops does not
+    if (!pipelineSignature.empty() && planOptions.foldSmoothing) {
+        pipelineSignature += "|fold";
+    }
+    signatureHash = contentHash(pipelineSignature.data(), pipelineSignature.size());
+}
+
+void FilterPipeline::setResultCache(std::shared_ptr<ResultCache> resultCache)
+{
+    cache = std::move(resultCache);
+}
+
+const std::shared_ptr<ResultCache>& FilterPipeline::resultCache() const
+{
+    return cache;
+}
+
+const std::string& FilterPipeline::signature() const
+{
+    return pipelineSignature;
+}
+
+void FilterPipeline::setExecutionPolicy(const ExecutionPolicy& executionPolicy)
+{
+    policy = executionPolicy;
+}
+
+ExecutionPolicy FilterPipeline::executionPolicy() const
+{
+    return policy ? *policy : defaultExecutionPolicy();
+}
+
+void FilterPipeline::applyWithPolicy(const FlatImage& input, FlatImage& output) const
+{
+    std::optional<ResultKey> key;
+    if (cache && !pipelineSignature.empty()) {
+        key = ResultKey{contentHash(input), signatureHash, input.rows(), input.cols()};
+        if (cache->lookup(*key, output)) {
+            return;
+        }
+    }
+
+    if (!filters.empty() && haloRadius() != ImageFilter::UNBOUNDED_RADIUS
+            && currentExecutionPolicy().modeFor(input.size()) == ExecutionMode::TileParallel) {
+        applyTiled(input, output);
+    } else {
+        applyChain(input, output);
+    }
+
+    if (key) {
+        cache->insert(*key, output);
+    }
+}
+
+void FilterPipeline::applyChain(const FlatImage& input, FlatImage& output) const
+{
+    if (output.overlaps(input)) {
+        applyThroughScratch(input, output, [this](const FlatImage& from, FlatImage& to) { applyChain(from, to); });
+        return;
+    }
+
+    const std::vector<PlanStep>& steps = executionPlan.steps();
+    if (steps.empty()) {
+        output.resize(input.rows(), input.cols());
+        for (int i = 0; i < input.rows(); ++i) {
+            std::memcpy(output.row(i), input.row(i), input.cols() * sizeof(uchar));
+        }
+        return;
+    }
+
+    // intermediates ping-pong between the plan's buffers; the last step writes straight into
+    // output, so a view of a caller-owned cv::Mat is filled in place. The intermediates carry a
+    // guard band holding the replicated border, so the next step reads its neighbours in place
+    // instead of padding a copy.
+    const int guard = executionPlan.guard();
+    ScratchArena& arena = ScratchArena::local();
+    FlatImage buffers[2] = {FlatImage(arena), FlatImage(arena)};
+    for (int buffer = 0; buffer < executionPlan.bufferCount(); ++buffer) {
+        buffers[buffer].resize(input.rows(), input.cols(), guard);
+    }
+
+    const FlatImage* source = &input;
+    for (size_t step = 0; step < steps.size(); ++step) {
+        const bool last = step + 1 == steps.size();
+        FlatImage& target = last ? output : buffers[step % 2];
+        steps[step].filter->apply(*source, target);
+        if (!last) {
+            target.fillBorder(std::min(guard, target.guard()));
+        }
+        source = &target;
+    }
+}
+
+int FilterPipeline::haloRadius() const
+{
+    int halo = 0;
+    for (const auto& filter : filters) {
+        if (filter->radius() == ImageFilter::UNBOUNDED_RADIUS) {
+            return ImageFilter::UNBOUNDED_RADIUS;
+        }
+        halo += filter->radius();
+    }
+    return halo;
+}
+
+void FilterPipeline::applyRegion(const FlatImage& input, FlatImage& output, int row, int col, int rows, int cols) const
+{
+    // an unbounded halo covers the whole image
+    const int halo = std::min(haloRadius(), std::max(input.rows(), input.cols()));
+
+    // extend the region by the halo; at the image border the filters' own clamping takes over
+    const int top = std::max(row - halo, 0);
+    const int left = std::max(col - halo, 0);
+    const int bottom = std::min(row + rows + halo, input.rows());
+    const int right = std::min(col + cols + halo, input.cols());
+
+    ScratchArena& arena = ScratchArena::local();
+    FlatImage region(bottom - top, right - left, arena);
+    for (int i = top; i < bottom; ++i) {
+        std::memcpy(&region(i - top, 0), &input(i, left), (right - left) * sizeof(uchar));
+    }
+
+    FlatImage filtered(arena);
+    applyChain(region, filtered);
+
+    for (int i = 0; i < rows; ++i) {
+        std::memcpy(&output(row + i, col), &filtered(row - top + i, col - left), cols * sizeof(uchar));
+    }
+}
+
+IncrementalReport FilterPipeline::applyIncremental(const FlatImage& input, FlatImage& output, const std::vector<PixelRect>& dirty,
+                                                   const IncrementalOptions& options)
+{
+    PROF_EXEC_TIME;
+
+    IncrementalReport report;
+    report.dirty = dirty;
+
+    const int halo = haloRadius();
+    const size_t frame = input.size();
+    bool full = output.rows() != input.rows() || output.cols() != input.cols() || halo == ImageFilter::UNBOUNDED_RADIUS;
+    if (!full) {
+        report.recomputed = coverRects(dirty, halo, input.rows(), input.cols());
+        for (const PixelRect& rect : report.recomputed) {
+            report.pixels += rect.area();
+        }
+        full = report.pixels > options.maxRecomputeFraction * frame;
+    }
+    if (full) {
+        apply(input, output);
+        report.recomputed = {PixelRect{0, 0, input.rows(), input.cols()}};
+        report.pixels = frame;
+        report.full = true;
+        return report;
+    }
+
+    // the rectangles are disjoint in output, so they fill it in parallel. Scopes only reach the
+    // thread that opens them, so every task re-enters the pipeline's policy for its rows.
+    const ExecutionPolicy policy = executionPolicy();
+    ExecutionPolicyScope scope(policy);
+    const std::vector<PixelRect>& rects = report.recomputed;
+    forEachIndex(static_cast<int>(rects.size()), report.pixels, [&](int r) {
+        ExecutionPolicyScope taskScope(policy);
+        applyRegion(input, output, rects[r].row, rects[r].col, rects[r].rows, rects[r].cols);
+    });
+    return report;
+}
+
+IncrementalReport FilterPipeline::applyIncremental(const FlatImage& previousInput, const FlatImage& input, FlatImage& output,
+                                                   const IncrementalOptions& options)
+{
+    return applyIncremental(input, output, findChangedRects(previousInput, input, options.blockSize), options);
+}
+
+void FilterPipeline::applyStreaming(StripReader& reader, StripWriter& writer, int stripRows) const
+{
+    PROF_EXEC_TIME;
+
+    if (stripRows <= 0) {
+        throw std::invalid_argument("Strip height must be positive.");
+    }
+    if (haloRadius() == ImageFilter::UNBOUNDED_RADIUS) {
+        throw std::invalid_argument("Filters that see the whole image cannot be streamed in strips.");
+    }
+
+    ExecutionPolicyScope scope(executionPolicy());
+
+    const int rows = reader.rows();
+    const int cols = reader.cols();
+    const int halo = haloRadius();
+
+    // input rows [top, top + loaded) of the image
+    ScratchArena& arena = ScratchArena::local();
+    FlatImage window(std::min(stripRows + 2 * halo, rows), cols, arena);
+    FlatImage filtered(arena);
+    int top = 0;
+    int loaded = 0;
+
+    for (int row = 0; row < rows; row += stripRows) {
+        const int end = std::min(row + stripRows, rows);
+
+        // drop the rows the strip no longer needs and move the carried halo rows up
+        const int newTop = std::max(row - halo, 0);
+        // strips shorter than the halo drop nothing until they pass it
+        const int dropped = newTop - top;
+        if (dropped > 0) {
+            for (int i = dropped; i < loaded; ++i) {
+                std::memcpy(window.row(i - dropped), window.row(i), cols * sizeof(uchar));
+            }
+        }
+        loaded -= dropped;
+        top = newTop;
+
+        const int needed = std::min(end + halo, rows) - (top + loaded);
+        FlatImage incoming = window.subView(loaded, 0, needed, cols);
+        reader.read(incoming);
+        loaded += needed;
+
+        applyChain(window.subView(0, 0, loaded, cols), filtered);
+        writer.write(filtered.subView(row - top, 0, end - row, cols));
+    }
+}
+
+static BatchParallelism chooseBatchParallelism(const std::vector<FlatImage>& inputs, const BatchOptions& options)
+{
+    if (options.parallelism != BatchParallelism::Auto) {
+        return options.parallelism;
+    }
+
+    const size_t workers = tbb::this_task_arena::max_concurrency();
+    size_t pixels = 0;
+    for (const auto& input : inputs) {
+        pixels += input.size();
+    }
+    const size_t averagePixels = inputs.empty() ? 0 : pixels / inputs.size();
+
+    // per-row tasks only pay off on large images; with enough small images every core
+    // already has whole images to work on
+    if (inputs.size() >= workers && averagePixels <= options.smallImagePixels) {
+        return BatchParallelism::AcrossImages;
+    }
+    // a few large images keep every core busy on their rows alone
+    if (inputs.size() == 1 || (inputs.size() < workers && averagePixels > options.smallImagePixels)) {
+        return BatchParallelism::AcrossRows;
+    }
+    return BatchParallelism::Both;
+}
+
+BatchReport FilterPipeline::applyBatch(const std::vector<FlatImage>& inputs, std::vector<FlatImage>& outputs, const BatchOptions& options) const
+{
+    if (outputs.size() != inputs.size()) {
+        outputs.resize(inputs.size());
+    }
+
+    BatchReport report;
+    report.images = inputs.size();
+    report.parallelism = chooseBatchParallelism(inputs, options);
+
+    auto start = std::chrono::steady_clock::now();
+
+    if (report.parallelism == BatchParallelism::AcrossRows) {
+        ExecutionPolicyScope scope(executionPolicy());
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            applyWithPolicy(inputs[i], outputs[i]);
+        }
+    } else {
+        const ExecutionPolicy imagePolicy = report.parallelism == BatchParallelism::AcrossImages ? ExecutionPolicy::serial() : executionPolicy();
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, inputs.size(), 1), [&](const tbb::blocked_range<size_t>& range) {
+            ExecutionPolicyScope scope(imagePolicy);
+            for (size_t i = range.begin(); i < range.end(); ++i) {
+                applyWithPolicy(inputs[i], outputs[i]);
+            }
+        });
+    }
+
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report.imagesPerSecond = report.seconds > 0 ? report.images / report.seconds : 0;
+    return report;
+}
+
+static size_t l2CacheBytes()
+{
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    long size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (size > 0) {
+        return static_cast<size_t>(size);
+    }
+#endif
+    return 1 << 20;
+}
+
+void FilterPipeline::applyTiled(const FlatImage& input, FlatImage& output, const TileOptions& options) const
+{
+    PROF_EXEC_TIME;
+
+    // later tiles read halo rows that earlier tiles would already have overwritten
+    if (output.overlaps(input)) {
+        applyThroughScratch(input, output, [&](const FlatImage& from, FlatImage& to) { applyTiled(from, to, options); });
+        return;
+    }
+
+    const int halo = haloRadius();
+    if (halo == ImageFilter::UNBOUNDED_RADIUS) {
+        applyChain(input, output);
+        return;
+    }
+
+    int tileRows = options.tileRows;
+    int tileCols = options.tileCols;
+    if (tileRows <= 0 || tileCols <= 0) {
+        // each stage holds an input and an output copy of the haloed tile
+        const size_t cacheBytes = options.cacheBytes ? options.cacheBytes : l2CacheBytes();
+        const int side = static_cast<int>(std::sqrt(cacheBytes / (2 * sizeof(uchar))));
+        tileRows = tileCols = std::max(side - 2 * halo, 32);
+    }
+
+    output.resize(input.rows(), input.cols());
+
+    const int tilesPerRow = (input.cols() + tileCols - 1) / tileCols;
+    const int tileCount = tilesPerRow * ((input.rows() + tileRows - 1) / tileRows);
+
+    // the tiles already spread over the cores, so each one runs its rows serially
+    tbb::parallel_for(tbb::blocked_range<int>(0, tileCount, 1), [&](const tbb::blocked_range<int>& range) {
+        SerialRowsScope serial;
+        for (int tile = range.begin(); tile < range.end(); ++tile) {
+            const int row = tile / tilesPerRow * tileRows;
+            const int col = tile % tilesPerRow * tileCols;
+            applyRegion(input, output, row, col, std::min(tileRows, input.rows() - row), std::min(tileCols, input.cols() - col));
+        }
+    });
 }
 
 void FilterPipeline::applyBenchmark(const cv::Mat& input, cv::Mat& output)
@@ -0,0 +1,58 @@
+#include "prof_utils.hpp"
+#include "gaussian_blur.hpp"
+
+
+GaussianBlur::GaussianBlur(int ksize) : ksize(ksize)
+{
+    if (ksize != 3 && ksize != 5 && ksize != 7) {
+        throw std::invalid_argument("GaussianBlur supports kernel sizes 3, 5 and 7.");
+    }
+}
+
+void GaussianBlur::applyBenchmark(const cv::Mat& input, cv::Mat& output) const {
+    PROF_EXEC_TIME;
+
+    cv::GaussianBlur(input, output, cv::Size(ksize, ksize), 0, 0, cv::BORDER_REPLICATE);
+}
+
+std::span<const int> GaussianBlur::taps() const {
+    switch (ksize) {
+    case 3:
+        return kernels::GAUSSIAN_3;
+    case 5:
+        return kernels::GAUSSIAN_5;
+    default:
+        return kernels::GAUSSIAN_7;
+    }
+}
+
+std::vector<int> GaussianBlur::smoothingTaps() const {
+    const std::span<const int> kernel = taps();
+    return std::vector<int>(kernel.begin(), kernel.end());
+}
+
+void GaussianBlur::apply(const FlatImage& input, FlatImage& output) const {
+    PROF_EXEC_TIME;
+
+    // same pixels as the dense GAUSSIAN_NxN kernels, with 2 * ksize instead of ksize^2 taps
+    smoothSeparable(input, output, taps());
+}
+
+void GaussianBlur::applyChannels(const ChannelImage<uchar>& input, ChannelImage<uchar>& output) const {
+    PROF_EXEC_TIME;
+    smoothSeparable(input, output, taps());
+}
+
+void GaussianBlur::applyChannels(const ChannelImage<uint16_t>& input, ChannelImage<uint16_t>& output) const {
+    PROF_EXEC_TIME;
+    smoothSeparable(input, output, taps());
+}
+
+void GaussianBlur::applyChannels(const ChannelImage<float>& input, ChannelImage<float>& output) const {
+    PROF_EXEC_TIME;
+    smoothSeparable(input, output, taps());
+}
+
+void GaussianBlur::applyRow(const uchar* const* window, uchar* out, int cols, RowScratch& scratch) const {
+    smoothSeparableRow(window, out, cols, taps(), scratch);
+}
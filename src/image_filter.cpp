@@ -1,7 +1,13 @@
+#include <cstring>
+#include <limits>
 #include <execution>
+#include <numeric>
 
+#include "fixed_point.hpp"
 #include "image_filter.hpp"
+#include "parallel_utils.hpp"
 #include "prof_utils.hpp"
+#include "simd_kernels.hpp"
 #include "types.hpp"
 #include <opencv2/opencv.hpp>
 
@@ -9,55 +15,69 @@
 constexpr float NORMALIZATION_FACTOR = 0.5;
 
 
-std::pair<int, int> ImageFilter::padBoundaries(const FlatImage& input, FlatImage& output) {
+std::pair<int, int> ImageFilter::padBoundaries(const FlatImage& input, FlatImage& output, int radius) {
     PROF_EXEC_TIME;
 
     const int rows = input.rows();
     const int cols = input.cols();
 
-    int padded_rows = rows + 2;
-    int padded_cols = cols + 2;
+    int padded_rows = rows + 2 * radius;
+    int padded_cols = cols + 2 * radius;
 
     output.resize(padded_rows, padded_cols);
 
-    // copy the inner content
-    for (int i = 0; i < rows; ++i) {
-        std::memcpy(&output(i + 1, 1), &input(i, 0), cols * sizeof(uchar));
+    // an empty image has no edge pixels to replicate, so its padding is left black
+    if (rows == 0 || cols == 0) {
+        for (int i = 0; i < padded_rows && !output.empty(); ++i) {
+            std::memset(output.row(i), 0, padded_cols * sizeof(uchar));
+        }
+        return {padded_rows, padded_cols};
     }
 
-    // top and bottom edge rows (without corners)
-    std::memcpy(&output(0, 1), &input(0, 0), cols * sizeof(uchar));
-    std::memcpy(&output(padded_rows - 1, 1), &input(rows - 1, 0), cols * sizeof(uchar));
+    // every padded row copies its clamped source row and replicates the edge pixels
+    // into the left and right border, which also fills the corners
+    for (int i = 0; i < padded_rows; ++i) {
+        const uchar* src = &input(std::clamp(i - radius, 0, rows - 1), 0);
+        uchar* dst = &output(i, 0);
 
-    // left and right edge columns
-    for (int i = 0; i < rows; ++i) {
-        output(i + 1, 0) = input(i, 0);
-        output(i + 1, padded_cols - 1) = input(i, cols - 1);
+        std::memset(dst, src[0], radius);
+        std::memcpy(dst + radius, src, cols * sizeof(uchar));
+        std::memset(dst + radius + cols, src[cols - 1], radius);
     }
 
-    // four corners
-    output(0, 0) = input(0, 0);                             // Top-left
-    output(0, padded_cols - 1) = input(0, cols - 1);        // Top-right
-    output(padded_rows - 1, 0) = input(rows - 1, 0);        // Bottom-left
-    output(padded_rows - 1, padded_cols - 1) = input(rows - 1, cols - 1); // Bottom-right
-
     return {padded_rows, padded_cols};
 }
 
 
-void ImageFilter::removeBoundaries(const FlatImage& input, FlatImage& output) {
+void ImageFilter::removeBoundaries(const FlatImage& input, FlatImage& output, int radius) {
     PROF_EXEC_TIME;
 
     const int padded_rows = input.rows();
     const int padded_cols = input.cols();
-    const int rows = padded_rows - 2;
-    const int cols = padded_cols - 2;
+    const int rows = padded_rows - 2 * radius;
+    const int cols = padded_cols - 2 * radius;
 
     output.resize(rows, cols);
 
     for (int i = 0; i < rows; ++i) {
-        std::memcpy(&output(i, 0), &input(i + 1, 1), cols * sizeof(uchar));
+        std::memcpy(&output(i, 0), &input(i + radius, radius), cols * sizeof(uchar));
+    }
+}
+
+const FlatImage& ImageFilter::borderedSource(const FlatImage& input, FlatImage& scratch, int radius) {
+    if (input.border() >= radius) {
+        return input;
+    }
+
+    PROF_EXEC_TIME;
+
+    // copies the pixels once; only the guard band around them is filled on top
+    scratch.resize(input.rows(), input.cols(), radius);
+    for (int i = 0; i < input.rows(); ++i) {
+        std::memcpy(scratch.row(i), input.row(i), input.cols() * sizeof(uchar));
     }
+    scratch.fillBorder(radius);
+    return scratch;
 }
 
 template <typename KType>
@@ -66,10 +86,8 @@ void ImageFilter::getGradient(const FlatImage& input, FlatImage& output, int pad
 
     output.resize(padded_rows, padded_cols);
 
-    std::vector<int> row_indices(padded_rows - 2);
-    std::iota(row_indices.begin(), row_indices.end(), 1); // [1, 2, ..., padded_rows-2]
-
-    std::for_each(std::execution::par_unseq, row_indices.begin(), row_indices.end(), [&](int idxi) {
+    forEachIndex(padded_rows - 2, static_cast<size_t>(padded_rows) * padded_cols, [&](int index) {
+        const int idxi = index + 1; // [1, 2, ..., padded_rows-2]
         for (int idxj = 1; idxj < padded_cols - 1; ++idxj) {
             int gradient = 0;
 
@@ -100,10 +118,7 @@ void ImageFilter::combineGradients(const FlatImage& gx, const FlatImage& gy, Fla
 
     combinedGradient.resize(rows, cols);
 
-    std::vector<int> row_indices(rows);
-    std::iota(row_indices.begin(), row_indices.end(), 0); // [0, 1, 2, ..., rows - 1]
-
-    std::for_each(std::execution::par_unseq, row_indices.begin(), row_indices.end(), [&](int idxi) {
+    forEachIndex(rows, gx.size(), [&](int idxi) {
         for (int idxj = 0; idxj < cols; ++idxj) {
             int gradient = static_cast<int>((gx(idxi, idxj) + gy(idxi, idxj)) * NORMALIZATION_FACTOR);
             combinedGradient(idxi, idxj) = gradient < threshold ? 0 : std::clamp(gradient, 0, 255);
@@ -111,18 +126,993 @@ void ImageFilter::combineGradients(const FlatImage& gx, const FlatImage& gy, Fla
     });
 }
 
+// Same accumulation order as getGradient, so float kernels truncate identically
+template <typename KType>
+static inline int convolvePixel(const uchar* above, const uchar* center, const uchar* below, int jm, int j, int jp, const KType kernel[3][3]) {
+    int gradient = 0;
+
+    gradient += above[jm] * kernel[0][0];
+    gradient += above[j ] * kernel[0][1];
+    gradient += above[jp] * kernel[0][2];
+
+    gradient += center[jm] * kernel[1][0];
+    gradient += center[j ] * kernel[1][1];
+    gradient += center[jp] * kernel[1][2];
+
+    gradient += below[jm] * kernel[2][0];
+    gradient += below[j ] * kernel[2][1];
+    gradient += below[jp] * kernel[2][2];
+
+    return gradient;
+}
+
+// Narrows an integer kernel to int16 taps for the SIMD rows; fails for float kernels and
+// for weights large enough to overflow int16 accumulation.
+template <typename KType>
+static bool toInt16Kernel(const KType kernel[3][3], int16_t taps[9]) {
+    if constexpr (!std::is_integral_v<KType>) {
+        return false;
+    } else {
+        int weight = 0;
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                weight += std::abs(static_cast<int>(kernel[r][c]));
+                taps[r * 3 + c] = static_cast<int16_t>(kernel[r][c]);
+            }
+        }
+        return weight <= MAX_INT16_KERNEL_WEIGHT;
+    }
+}
+
+// Runs rowFn(idxi, above, center, below, out) over every row, with neighbour rows clamped to the image.
+template <typename RowFn>
+static void forEachClampedRow(const FlatImage& input, FlatImage& output, RowFn&& rowFn) {
+    const int rows = input.rows();
+
+    forEachIndex(rows, input.size(), [&](int idxi) {
+        // clamped neighbour rows replace the padded border of the multi-pass path
+        const uchar* above = &input(std::max(idxi - 1, 0), 0);
+        const uchar* center = &input(idxi, 0);
+        const uchar* below = &input(std::min(idxi + 1, rows - 1), 0);
+        rowFn(above, center, below, &output(idxi, 0));
+    });
+}
+
+// Calls pixelFn(jm, j, jp) for the columns the SIMD row left over, including both clamped borders.
+template <typename PixelFn>
+static inline void finishRow(int cols, int firstScalar, PixelFn&& pixelFn) {
+    pixelFn(0, 0, std::min(1, cols - 1));
+    for (int idxj = std::max(firstScalar, 1); idxj < cols - 1; ++idxj) {
+        pixelFn(idxj - 1, idxj, idxj + 1);
+    }
+    if (cols > 1) {
+        pixelFn(cols - 2, cols - 1, cols - 1);
+    }
+}
+
+// One output row of fusedXYGradient; tapsX is null when the kernels have no int16 form
+template <typename KType>
+static void fusedXYGradientRow(const uchar* above, const uchar* center, const uchar* below, uchar* out, int cols,
+                               const KType kernelX[3][3], const KType kernelY[3][3], uchar threshold,
+                               const int16_t* tapsX, const int16_t* tapsY, const SimdKernelSet& simd) {
+    int firstScalar = tapsX ? simd.xyGradientRow(above, center, below, out, cols, tapsX, tapsY, threshold) : 1;
+
+    finishRow(cols, firstScalar, [&](int jm, int j, int jp) {
+        int gx = std::clamp(std::abs(convolvePixel(above, center, below, jm, j, jp, kernelX)), 0, 255);
+        int gy = std::clamp(std::abs(convolvePixel(above, center, below, jm, j, jp, kernelY)), 0, 255);
+        int gradient = static_cast<int>((gx + gy) * NORMALIZATION_FACTOR);
+        out[j] = gradient < threshold ? 0 : std::clamp(gradient, 0, 255);
+    });
+}
+
+template <typename KType>
+void ImageFilter::fusedXYGradient(const FlatImage& input, FlatImage& output, const KType kernelX[3][3], const KType kernelY[3][3], uchar threshold) {
+    PROF_EXEC_TIME;
+
+    const int cols = input.cols();
+    output.resize(input.rows(), cols);
+
+    int16_t tapsX[9], tapsY[9];
+    const bool vectorize = toInt16Kernel(kernelX, tapsX) && toInt16Kernel(kernelY, tapsY);
+    const SimdKernelSet& simd = activeSimdKernels();
+
+    forEachClampedRow(input, output, [&](const uchar* above, const uchar* center, const uchar* below, uchar* out) {
+        fusedXYGradientRow(above, center, below, out, cols, kernelX, kernelY, threshold, vectorize ? tapsX : nullptr, tapsY, simd);
+    });
+}
+
+template <typename KType>
+void ImageFilter::xyGradientRow(const uchar* const* window, uchar* out, int cols, const KType kernelX[3][3], const KType kernelY[3][3], uchar threshold) {
+    int16_t tapsX[9], tapsY[9];
+    const bool vectorize = toInt16Kernel(kernelX, tapsX) && toInt16Kernel(kernelY, tapsY);
+    fusedXYGradientRow(window[0], window[1], window[2], out, cols, kernelX, kernelY, threshold, vectorize ? tapsX : nullptr, tapsY, activeSimdKernels());
+}
+
+template <typename KType>
+void ImageFilter::fusedGradientField(const FlatImage& input, GradientField& field, const KType kernelX[3][3], const KType kernelY[3][3]) {
+    PROF_EXEC_TIME;
+
+    const int rows = input.rows();
+    const int cols = input.cols();
+    field.resize(rows, cols);
+    if (input.empty()) {
+        return;
+    }
+
+    int16_t tapsX[9], tapsY[9];
+    const bool vectorize = toInt16Kernel(kernelX, tapsX) && toInt16Kernel(kernelY, tapsY);
+    const SimdKernelSet& simd = activeSimdKernels();
+
+    forEachIndex(rows, input.size(), [&](int idxi) {
+        const uchar* above = &input(std::max(idxi - 1, 0), 0);
+        const uchar* center = &input(idxi, 0);
+        const uchar* below = &input(std::min(idxi + 1, rows - 1), 0);
+        const GradientRow out(field, idxi);
+
+        int firstScalar = vectorize ? simd.gradientFieldRow(above, center, below, out, cols, tapsX, tapsY, field.norm) : 1;
+
+        finishRow(cols, firstScalar, [&](int jm, int j, int jp) {
+            out.store(j, convolvePixel(above, center, below, jm, j, jp, kernelX), convolvePixel(above, center, below, jm, j, jp, kernelY), field.norm);
+        });
+    });
+}
+
+template <typename KType>
+void ImageFilter::fusedSingleGradient(const FlatImage& input, FlatImage& output, const KType kernel[3][3], uchar threshold) {
+    PROF_EXEC_TIME;
+
+    const int cols = input.cols();
+    output.resize(input.rows(), cols);
+
+    int16_t taps[9];
+    const bool vectorize = toInt16Kernel(kernel, taps);
+    const SimdKernelSet& simd = activeSimdKernels();
+
+    forEachClampedRow(input, output, [&](const uchar* above, const uchar* center, const uchar* below, uchar* out) {
+        int firstScalar = vectorize ? simd.singleGradientRow(above, center, below, out, cols, taps, threshold) : 1;
+
+        finishRow(cols, firstScalar, [&](int jm, int j, int jp) {
+            int gradient = std::abs(convolvePixel(above, center, below, jm, j, jp, kernel));
+            out[j] = gradient < threshold ? 0 : std::clamp(gradient, 0, 255);
+        });
+    });
+}
+
+template <typename KType>
+bool ImageFilter::factorizeKernel(const KType kernel[3][3], SeparableKernel<KType>& separable) {
+    if constexpr (!std::is_integral_v<KType>) {
+        return false;
+    } else {
+        // the first non-zero row, reduced by its gcd, is the row factor
+        int pivot = -1;
+        for (int r = 0; r < 3 && pivot < 0; ++r) {
+            if (kernel[r][0] != 0 || kernel[r][1] != 0 || kernel[r][2] != 0) {
+                pivot = r;
+            }
+        }
+        if (pivot < 0) {
+            return false;
+        }
+
+        KType divisor = std::gcd(std::gcd(kernel[pivot][0], kernel[pivot][1]), kernel[pivot][2]);
+        const int pivotCol = kernel[pivot][0] != 0 ? 0 : (kernel[pivot][1] != 0 ? 1 : 2);
+        for (int c = 0; c < 3; ++c) {
+            separable.row[c] = kernel[pivot][c] / divisor;
+        }
+
+        for (int r = 0; r < 3; ++r) {
+            if (kernel[r][pivotCol] % separable.row[pivotCol] != 0) {
+                return false;
+            }
+            separable.column[r] = kernel[r][pivotCol] / separable.row[pivotCol];
+            for (int c = 0; c < 3; ++c) {
+                if (separable.column[r] * separable.row[c] != kernel[r][c]) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+// int16 accumulation is exact when no horizontal or vertical sum can leave its range.
+template <typename KType>
+static bool fitsInt16(const SeparableKernel<KType>& kernel) {
+    if constexpr (!std::is_integral_v<KType>) {
+        return false;
+    } else {
+        int rowWeight = std::abs(kernel.row[0]) + std::abs(kernel.row[1]) + std::abs(kernel.row[2]);
+        int columnWeight = std::abs(kernel.column[0]) + std::abs(kernel.column[1]) + std::abs(kernel.column[2]);
+        return rowWeight * columnWeight * 255 <= std::numeric_limits<int16_t>::max();
+    }
+}
+
+// 3-tap horizontal pass over one source row with clamped border columns.
+// int16 rows start with the SIMD pass and finish the remaining columns here.
+template <typename Acc, typename KType>
+static void horizontalPass(const uchar* src, Acc* dst, int cols, const KType row[3]) {
+    const Acc k0 = row[0], k1 = row[1], k2 = row[2];
+
+    int firstScalar = 1;
+    if constexpr (std::is_same_v<Acc, int16_t>) {
+        const int16_t taps[3] = {k0, k1, k2};
+        firstScalar = activeSimdKernels().horizontalRow(src, dst, cols, taps);
+    }
+
+    dst[0] = src[0] * k0 + src[0] * k1 + src[std::min(1, cols - 1)] * k2;
+    for (int idxj = firstScalar; idxj < cols - 1; ++idxj) {
+        dst[idxj] = src[idxj - 1] * k0 + src[idxj] * k1 + src[idxj + 1] * k2;
+    }
+    if (cols > 1) {
+        dst[cols - 1] = src[cols - 2] * k0 + src[cols - 1] * k1 + src[cols - 1] * k2;
+    }
+}
+
+// 3-tap vertical pass at one column of the rolling window.
+template <typename Acc, typename KType>
+static inline int verticalTap(const Acc* const window[3], int idxj, const KType column[3]) {
+    return static_cast<int>(window[0][idxj] * column[0] + window[1][idxj] * column[1] + window[2][idxj] * column[2]);
+}
+
+// Splits the rows into chunks; each chunk keeps a rolling buffer of the N horizontal passes for
+// rows i-1, i and i+1 and calls rowFn(i, windows) where windows[n] holds those three rows.
+template <typename Acc, int N, typename KType, typename RowFn>
+static void forEachSeparableRow(const FlatImage& input, const KType* const rowTaps[N], RowFn&& rowFn) {
+    const int rows = input.rows();
+    const int cols = input.cols();
+
+    // serial execution sweeps the image as one chunk and primes the rings only once
+    const int chunkCount = currentExecutionPolicy().chunksFor(rows, input.size());
+    const int chunkRows = (rows + chunkCount - 1) / chunkCount;
+
+    // one block of rings for all chunks, taken from the calling thread's arena
+    FlatArray<Acc> rings(chunkCount * N * 3, cols, ScratchArena::local());
+
+    forEachIndex(chunkCount, input.size(), [&](int chunk) {
+        const int begin = chunk * chunkRows;
+        const int end = std::min(begin + chunkRows, rows);
+        if (begin >= end) {
+            return;
+        }
+
+        auto slot = [&](int n, int idxi) { return rings.row((chunk * N + n) * 3 + (idxi + 3) % 3); };
+        auto fill = [&](int idxi) {
+            const uchar* src = &input(std::clamp(idxi, 0, rows - 1), 0);
+            for (int n = 0; n < N; ++n) {
+                horizontalPass(src, slot(n, idxi), cols, rowTaps[n]);
+            }
+        };
+
+        fill(begin - 1);
+        fill(begin);
+        for (int idxi = begin; idxi < end; ++idxi) {
+            fill(idxi + 1);
+
+            const Acc* windows[N][3];
+            for (int n = 0; n < N; ++n) {
+                windows[n][0] = slot(n, idxi - 1);
+                windows[n][1] = slot(n, idxi);
+                windows[n][2] = slot(n, idxi + 1);
+            }
+            rowFn(idxi, windows);
+        }
+    });
+}
+
+template <typename Acc, typename KType>
+static void separableXYGradientRows(const FlatImage& input, FlatImage& output, const SeparableKernel<KType>& kernelX, const SeparableKernel<KType>& kernelY, uchar threshold) {
+    const int cols = input.cols();
+    const KType* const rowTaps[2] = {kernelX.row, kernelY.row};
+
+    int16_t columnX[3] = {}, columnY[3] = {};
+    if constexpr (std::is_same_v<Acc, int16_t>) {
+        std::copy(kernelX.column, kernelX.column + 3, columnX);
+        std::copy(kernelY.column, kernelY.column + 3, columnY);
+    }
+
+    forEachSeparableRow<Acc, 2>(input, rowTaps, [&](int idxi, const Acc* const windows[2][3]) {
+        uchar* out = &output(idxi, 0);
+
+        int firstScalar = 0;
+        if constexpr (std::is_same_v<Acc, int16_t>) {
+            firstScalar = activeSimdKernels().verticalXYRow(windows[0], windows[1], out, cols, columnX, columnY, threshold);
+        }
+
+        for (int idxj = firstScalar; idxj < cols; ++idxj) {
+            int gx = std::min(std::abs(verticalTap(windows[0], idxj, kernelX.column)), 255);
+            int gy = std::min(std::abs(verticalTap(windows[1], idxj, kernelY.column)), 255);
+            int gradient = (gx + gy) >> 1; // (gx + gy) * NORMALIZATION_FACTOR for non-negative values
+            out[idxj] = gradient < threshold ? 0 : gradient;
+        }
+    });
+}
+
+template <typename Acc, typename KType>
+static void separableSingleGradientRows(const FlatImage& input, FlatImage& output, const SeparableKernel<KType>& kernel, uchar threshold) {
+    const int cols = input.cols();
+    const KType* const rowTaps[1] = {kernel.row};
+
+    int16_t column[3] = {};
+    if constexpr (std::is_same_v<Acc, int16_t>) {
+        std::copy(kernel.column, kernel.column + 3, column);
+    }
+
+    forEachSeparableRow<Acc, 1>(input, rowTaps, [&](int idxi, const Acc* const windows[1][3]) {
+        uchar* out = &output(idxi, 0);
+
+        int firstScalar = 0;
+        if constexpr (std::is_same_v<Acc, int16_t>) {
+            firstScalar = activeSimdKernels().verticalSingleRow(windows[0], out, cols, column, threshold);
+        }
+
+        for (int idxj = firstScalar; idxj < cols; ++idxj) {
+            int gradient = std::abs(verticalTap(windows[0], idxj, kernel.column));
+            out[idxj] = gradient < threshold ? 0 : std::min(gradient, 255);
+        }
+    });
+}
+
+template <typename KType>
+void ImageFilter::separableXYGradient(const FlatImage& input, FlatImage& output, const SeparableKernel<KType>& kernelX, const SeparableKernel<KType>& kernelY, uchar threshold) {
+    PROF_EXEC_TIME;
+
+    output.resize(input.rows(), input.cols());
+
+    if constexpr (std::is_integral_v<KType>) {
+        if (fitsInt16(kernelX) && fitsInt16(kernelY)) {
+            separableXYGradientRows<int16_t>(input, output, kernelX, kernelY, threshold);
+        } else {
+            separableXYGradientRows<int>(input, output, kernelX, kernelY, threshold);
+        }
+    } else {
+        separableXYGradientRows<KType>(input, output, kernelX, kernelY, threshold);
+    }
+}
+
+template <typename KType>
+void ImageFilter::separableSingleGradient(const FlatImage& input, FlatImage& output, const SeparableKernel<KType>& kernel, uchar threshold) {
+    PROF_EXEC_TIME;
+
+    output.resize(input.rows(), input.cols());
+
+    if constexpr (std::is_integral_v<KType>) {
+        if (fitsInt16(kernel)) {
+            separableSingleGradientRows<int16_t>(input, output, kernel, threshold);
+        } else {
+            separableSingleGradientRows<int>(input, output, kernel, threshold);
+        }
+    } else {
+        separableSingleGradientRows<KType>(input, output, kernel, threshold);
+    }
+}
+
+// Splits the rows into chunks with `buffers` scratch rows of `width` sums each, taken as one
+// block from the calling thread's arena, and calls chunkFn(begin, end, buffers) per chunk.
+template <typename Sum, typename ChunkFn>
+static void forEachRowChunk(int rows, size_t samples, int buffers, int width, ChunkFn&& chunkFn) {
+    const int chunkCount = currentExecutionPolicy().chunksFor(rows, samples);
+    const int chunkRows = (rows + chunkCount - 1) / chunkCount;
+
+    FlatArray<Sum> scratch(chunkCount * buffers, width, ScratchArena::local());
+
+    forEachIndex(chunkCount, samples, [&](int chunk) {
+        const int begin = chunk * chunkRows;
+        const int end = std::min(begin + chunkRows, rows);
+        if (begin < end) {
+            chunkFn(begin, end, [&](int buffer) { return scratch.row(chunk * buffers + buffer); });
+        }
+    });
+}
+
+template <typename Sum, typename Src>
+static void accumulateSamples(Sum* sums, const Src* src, Sum tap, int count) {
+    for (int j = 0; j < count; ++j) {
+        sums[j] += tap * static_cast<Sum>(src[j]);
+    }
+}
+
+template <typename Sum, typename Src>
+static void slideSamples(Sum* sums, const Src* entering, const Src* leaving, int count) {
+    for (int j = 0; j < count; ++j) {
+        sums[j] += static_cast<Sum>(entering[j]) - static_cast<Sum>(leaving[j]);
+    }
+}
+
+// Row arithmetic of the smoothing passes for one sample type. Integer samples sum in uint32 and
+// round the final division with a fixed-point reciprocal, 8-bit rows through the SIMD kernel
+// set; float samples sum in double and are scaled by the reciprocal.
+template <ChannelSample T>
+class SmoothingRows
+{
+public:
+    using Sum = std::conditional_t<std::is_same_v<T, float>, double, uint32_t>;
+
+    // Throws unless every window sum of up to `divisor` weighted samples fits in Sum
+    explicit SmoothingRows(uint64_t divisor) : divide(fixedPointDivisor(divisor)), scale(1.0 / divisor), simd(activeSimdKernels()) {}
+
+    // Integer samples only, with a divisor fixedPointDivisor() already checked
+    explicit SmoothingRows(const FixedPointDivisor& divide) : divide(divide), scale(0), simd(activeSimdKernels()) {}
+
+    void accumulate(Sum* sums, const T* src, uint32_t tap, int count) const {
+        if constexpr (std::is_same_v<T, uchar>) {
+            simd.accumulateRow(sums, src, tap, count);
+        } else {
+            accumulateSamples(sums, src, static_cast<Sum>(tap), count);
+        }
+    }
+
+    void accumulateSums(Sum* sums, const Sum* src, uint32_t tap, int count) const {
+        if constexpr (std::is_same_v<Sum, uint32_t>) {
+            simd.accumulateSumsRow(sums, src, tap, count);
+        } else {
+            accumulateSamples(sums, src, static_cast<Sum>(tap), count);
+        }
+    }
+
+    void slide(Sum* sums, const T* entering, const T* leaving, int count) const {
+        if constexpr (std::is_same_v<T, uchar>) {
+            simd.slideRow(sums, entering, leaving, count);
+        } else {
+            slideSamples(sums, entering, leaving, count);
+        }
+    }
+
+    void store(const Sum* sums, T* out, int count) const {
+        if constexpr (std::is_same_v<T, uchar>) {
+            simd.divideRow(sums, out, count, divide);
+        } else if constexpr (std::is_same_v<T, uint16_t>) {
+            const FixedPointDivisor rowDivide = divide;
+            for (int j = 0; j < count; ++j) {
+                out[j] = static_cast<uint16_t>(rowDivide(sums[j]));
+            }
+        } else {
+            for (int j = 0; j < count; ++j) {
+                out[j] = static_cast<float>(sums[j] * scale);
+            }
+        }
+    }
+
+    // Rounded division by the window weight, throwing unless every window sum fits in Sum
+    static FixedPointDivisor fixedPointDivisor(uint64_t divisor) {
+        if constexpr (std::is_same_v<T, float>) {
+            if (divisor == 0 || divisor > UINT32_MAX) {
+                throw std::invalid_argument("Unsupported smoothing window.");
+            }
+            return FixedPointDivisor(1, 0);
+        } else {
+            const uint64_t maxSum = divisor * std::numeric_limits<T>::max();
+            if (divisor == 0 || maxSum > UINT32_MAX - divisor / 2) {
+                throw std::invalid_argument("Smoothing window too large for the sample type.");
+            }
+            return FixedPointDivisor(static_cast<uint32_t>(divisor), static_cast<uint32_t>(maxSum));
+        }
+    }
+
+private:
+    FixedPointDivisor divide;
+    double scale;
+    const SimdKernelSet& simd;
+};
+
+// Column sums are kept `pad` samples wider on both sides. The replicated border columns have
+// the same column sums as the edge pixels, so the border is copied in per row instead of
+// padding the source.
+template <typename Sum>
+static void replicateEdgeSums(Sum* columnSums, int width, int channels, int pad) {
+    const Sum* first = columnSums + pad;
+    const Sum* last = columnSums + pad + width - channels;
+    for (int offset = 0; offset < pad; offset += channels) {
+        std::copy(first, first + channels, columnSums + offset);
+        std::copy(last, last + channels, columnSums + pad + width + offset);
+    }
+}
+
+// Window sums of `count` pixels of one channel, `step` samples apart
+template <typename Sum>
+[[gnu::always_inline]] static inline void runningSums(const Sum* columnSums, Sum* rowSums, int count, int step, int windowCols) {
+    Sum sum = 0;
+    for (int k = 0; k < windowCols; ++k) {
+        sum += columnSums[k * step];
+    }
+    rowSums[0] = sum;
+    const Sum* entering = columnSums + windowCols * step;
+    for (int idxj = 1; idxj < count; ++idxj) {
+        sum += entering[(idxj - 1) * step] - columnSums[(idxj - 1) * step];
+        rowSums[idxj * step] = sum;
+    }
+}
+
+// Horizontal half of the box mean: fills the border of the column sums, adds up windowCols of
+// them per pixel and stores the rounded means
+template <ChannelSample T>
+static void storeBoxRow(const SmoothingRows<T>& arithmetic, typename SmoothingRows<T>::Sum* columnSums,
+                        typename SmoothingRows<T>::Sum* rowSums, T* out, int width, int channels, int windowCols) {
+    using Sum = typename SmoothingRows<T>::Sum;
+    replicateEdgeSums(columnSums, width, channels, windowCols / 2 * channels);
+
+    // narrow windows add their columns in vector sweeps; wider ones slide a running sum per
+    // channel, whose serial dependency costs about as much as eight sweeps
+    if (windowCols <= 8) {
+        std::fill(rowSums, rowSums + width, Sum(0));
+        for (int k = 0; k < windowCols; ++k) {
+            arithmetic.accumulateSums(rowSums, columnSums + k * channels, 1, width);
+        }
+    } else {
+        if (channels == 1) {
+            runningSums(columnSums, rowSums, width, 1, windowCols);
+        } else {
+            for (int c = 0; c < channels; ++c) {
+                runningSums(columnSums + c, rowSums + c, width / channels, channels, windowCols);
+            }
+        }
+    }
+
+    arithmetic.store(rowSums, out, width);
+}
+
+// Horizontal half of the separable smoothing, with the same layout of column sums
+template <ChannelSample T>
+static void storeSmoothedRow(const SmoothingRows<T>& arithmetic, typename SmoothingRows<T>::Sum* columnSums,
+                             typename SmoothingRows<T>::Sum* rowSums, T* out, int width, int channels, std::span<const int> taps) {
+    using Sum = typename SmoothingRows<T>::Sum;
+    replicateEdgeSums(columnSums, width, channels, static_cast<int>(taps.size() / 2) * channels);
+
+    std::fill(rowSums, rowSums + width, Sum(0));
+    for (size_t k = 0; k < taps.size(); ++k) {
+        arithmetic.accumulateSums(rowSums, columnSums + k * channels, taps[k], width);
+    }
+
+    arithmetic.store(rowSums, out, width);
+}
+
+// Box mean over rows of interleaved samples, `channels` per pixel. Source rows beyond the top
+// and bottom edge are clamped.
+template <ChannelSample T>
+static void boxMeanSamples(const FlatArray<T>& input, FlatArray<T>& output, int channels, int radiusY, int radiusX) {
+    if (radiusY < 0 || radiusX < 0) {
+        throw std::invalid_argument("Unsupported box filter radius.");
+    }
+    const int windowRows = 2 * radiusY + 1;
+    const int windowCols = 2 * radiusX + 1;
+    const SmoothingRows<T> arithmetic(static_cast<uint64_t>(windowRows) * windowCols);
+    using Sum = typename SmoothingRows<T>::Sum;
+
+    const int rows = input.rows();
+    const int width = input.cols();
+    if (input.empty()) {
+        return;
+    }
+
+    // column sums cover the radiusX border pixels on either side of the row
+    const int pad = radiusX * channels;
+    const int sumCols = width + 2 * pad;
+    auto sourceRow = [&](int idxi) { return input.row(std::clamp(idxi, 0, rows - 1)); };
+
+    forEachRowChunk<Sum>(rows, input.size(), 2, sumCols, [&](int begin, int end, auto buffer) {
+        Sum* columnSums = buffer(0);
+        Sum* rowSums = buffer(1);
+        Sum* interior = columnSums + pad;
+
+        std::fill(interior, interior + width, Sum(0));
+        for (int idxi = begin - radiusY; idxi <= begin + radiusY; ++idxi) {
+            arithmetic.accumulate(interior, sourceRow(idxi), 1, width);
+        }
+
+        for (int idxi = begin; idxi < end; ++idxi) {
+            // slide the column sums down one row: O(1) per column whatever the radius
+            if (idxi > begin) {
+                arithmetic.slide(interior, sourceRow(idxi + radiusY), sourceRow(idxi - radiusY - 1), width);
+            }
+            storeBoxRow(arithmetic, columnSums, rowSums, output.row(idxi), width, channels, windowCols);
+        }
+    });
+}
+
+template <ChannelSample T>
+static void smoothSeparableSamples(const FlatArray<T>& input, FlatArray<T>& output, int channels, std::span<const int> taps) {
+    const int64_t weight = std::accumulate(taps.begin(), taps.end(), int64_t(0));
+    if (taps.size() % 2 == 0 || std::any_of(taps.begin(), taps.end(), [](int tap) { return tap < 0; }) ||
+        weight == 0 || weight > UINT16_MAX) {
+        throw std::invalid_argument("Smoothing taps must be an odd number of non-negative weights.");
+    }
+    const SmoothingRows<T> arithmetic(static_cast<uint64_t>(weight * weight));
+    using Sum = typename SmoothingRows<T>::Sum;
+
+    const int rows = input.rows();
+    const int width = input.cols();
+    if (input.empty()) {
+        return;
+    }
+
+    const int radius = static_cast<int>(taps.size() / 2);
+    const int size = static_cast<int>(taps.size());
+    const int pad = radius * channels;
+    const int sumCols = width + 2 * pad;
+
+    forEachRowChunk<Sum>(rows, input.size(), 2, sumCols, [&](int begin, int end, auto buffer) {
+        Sum* columnSums = buffer(0);
+        Sum* rowSums = buffer(1);
+        Sum* interior = columnSums + pad;
+
+        for (int idxi = begin; idxi < end; ++idxi) {
+            // one tap at a time over whole rows, so every inner loop is a plain vectorizable sweep
+            std::fill(interior, interior + width, Sum(0));
+            for (int k = 0; k < size; ++k) {
+                arithmetic.accumulate(interior, input.row(std::clamp(idxi - radius + k, 0, rows - 1)), taps[k], width);
+            }
+            storeSmoothedRow(arithmetic, columnSums, rowSums, output.row(idxi), width, channels, taps);
+        }
+    });
+}
+
+void ImageFilter::boxMean(const FlatImage& input, FlatImage& output, int radiusY, int radiusX) {
+    PROF_EXEC_TIME;
+
+    if (output.overlaps(input)) {
+        applyThroughScratch(input, output, [&](const FlatImage& from, FlatImage& to) { boxMean(from, to, radiusY, radiusX); });
+        return;
+    }
+
+    output.resize(input.rows(), input.cols());
+    boxMeanSamples(input, output, 1, radiusY, radiusX);
+}
+
+void ImageFilter::smoothSeparable(const FlatImage& input, FlatImage& output, std::span<const int> taps) {
+    PROF_EXEC_TIME;
+
+    if (output.overlaps(input)) {
+        applyThroughScratch(input, output, [&](const FlatImage& from, FlatImage& to) { smoothSeparable(from, to, taps); });
+        return;
+    }
+
+    output.resize(input.rows(), input.cols());
+    smoothSeparableSamples(input, output, 1, taps);
+}
+
+void ImageFilter::boxMeanRow(const uchar* const* window, uchar* out, int cols, int radius, RowScratch& scratch) {
+    const int windowSize = 2 * radius + 1;
+    if (!scratch.divide) {
+        scratch.divide = SmoothingRows<uchar>::fixedPointDivisor(static_cast<uint64_t>(windowSize) * windowSize);
+    }
+    const SmoothingRows<uchar> arithmetic(*scratch.divide);
+
+    uint32_t* columnSums = scratch.sums;
+    uint32_t* interior = columnSums + radius;
+    if (scratch.leaving) {
+        // the column sums of the previous row, slid down by one
+        arithmetic.slide(interior, window[windowSize - 1], scratch.leaving, cols);
+    } else {
+        std::fill(interior, interior + cols, 0u);
+        for (int k = 0; k < windowSize; ++k) {
+            arithmetic.accumulate(interior, window[k], 1, cols);
+        }
+    }
+    storeBoxRow(arithmetic, columnSums, scratch.sums + cols + 2 * radius, out, cols, 1, windowSize);
+}
+
+void ImageFilter::smoothSeparableRow(const uchar* const* window, uchar* out, int cols, std::span<const int> taps, RowScratch& scratch) {
+    if (!scratch.divide) {
+        const int64_t weight = std::accumulate(taps.begin(), taps.end(), int64_t(0));
+        scratch.divide = SmoothingRows<uchar>::fixedPointDivisor(static_cast<uint64_t>(weight * weight));
+    }
+    const SmoothingRows<uchar> arithmetic(*scratch.divide);
+    const int radius = static_cast<int>(taps.size() / 2);
+
+    // weighted column sums cannot slide, so every row sums its window again
+    uint32_t* columnSums = scratch.sums;
+    uint32_t* interior = columnSums + radius;
+    std::fill(interior, interior + cols, 0u);
+    for (size_t k = 0; k < taps.size(); ++k) {
+        arithmetic.accumulate(interior, window[k], taps[k], cols);
+    }
+    storeSmoothedRow(arithmetic, columnSums, scratch.sums + cols + 2 * radius, out, cols, 1, taps);
+}
+
+// Interleaved images run as one sample array; planar images one plane after another
+template <ChannelSample T, typename PlaneFn>
+static void forEachSamplePlane(const ChannelImage<T>& input, ChannelImage<T>& output, PlaneFn&& planeFn) {
+    // rows written in place would still be read as input
+    if (output.samples().overlaps(input.samples())) {
+        ChannelImage<T> result(ScratchArena::local());
+        forEachSamplePlane(input, result, planeFn);
+        ChannelImageFactory::convert(result, output);
+        return;
+    }
+    output.resizeLike(input);
+    if (input.layout() == ChannelLayout::Interleaved) {
+        planeFn(input.samples(), output.samples(), input.channels());
+        return;
+    }
+    for (int c = 0; c < input.channels(); ++c) {
+        FlatArray<T> plane = output.plane(c);
+        planeFn(input.plane(c), plane, 1);
+    }
+}
+
+template <ChannelSample T>
+void ImageFilter::boxMean(const ChannelImage<T>& input, ChannelImage<T>& output, int radiusY, int radiusX) {
+    PROF_EXEC_TIME;
+
+    forEachSamplePlane(input, output, [&](const FlatArray<T>& from, FlatArray<T>& to, int channels) {
+        boxMeanSamples(from, to, channels, radiusY, radiusX);
+    });
+}
+
+template <ChannelSample T>
+void ImageFilter::smoothSeparable(const ChannelImage<T>& input, ChannelImage<T>& output, std::span<const int> taps) {
+    PROF_EXEC_TIME;
+
+    forEachSamplePlane(input, output, [&](const FlatArray<T>& from, FlatArray<T>& to, int channels) {
+        smoothSeparableSamples(from, to, channels, taps);
+    });
+}
+
+// Value the 8-bit thresholds and saturation of the gradient filters scale to
+template <ChannelSample T>
+constexpr double sampleFullScale() {
+    return std::is_same_v<T, float> ? 1.0 : static_cast<double>(std::numeric_limits<T>::max());
+}
+
+// Convolution of rows of interleaved samples, `channels` per pixel, with one kernel or an X/Y
+// pair. Every chunk keeps a ring of the rows under the kernel, each converted to the sum type
+// once and padded with the replicated edge pixels, so every tap is one sweep over the row.
+template <ChannelSample T>
+static void convolveSamples(const FlatArray<T>& input, FlatArray<T>& output, int channels, const DynamicKernel<int>& kernelX,
+                            const DynamicKernel<int>* kernelY, uchar threshold) {
+    using Sum = std::conditional_t<std::is_same_v<T, float>, double, int32_t>;
+
+    if (kernelY && (kernelY->rows != kernelX.rows || kernelY->cols != kernelX.cols)) {
+        throw std::invalid_argument("X and Y kernels must have the same dimensions.");
+    }
+    if constexpr (std::is_integral_v<T>) {
+        for (const DynamicKernel<int>* kernel : {&kernelX, kernelY}) {
+            int64_t weight = 0;
+            for (int tap : kernel ? kernel->taps : std::vector<int>()) {
+                weight += std::abs(tap);
+            }
+            if (weight * std::numeric_limits<T>::max() > std::numeric_limits<Sum>::max()) {
+                throw std::invalid_argument("Kernel too large for the sample type.");
+            }
+        }
+    }
+
+    const int rows = input.rows();
+    const int width = input.cols();
+    if (input.empty()) {
+        return;
+    }
+
+    const int radiusY = kernelX.radiusY();
+    const int windowRows = kernelX.rows;
+    const int pad = kernelX.radiusX() * channels;
+    const int sumCols = width + 2 * pad;
+
+    const Sum fullScale = static_cast<Sum>(sampleFullScale<T>());
+    const Sum minimum = static_cast<Sum>(threshold * sampleFullScale<T>() / 255);
+    auto response = [](Sum sum, const DynamicKernel<int>& kernel) -> Sum {
+        if constexpr (std::is_same_v<Sum, double>) {
+            return std::abs(sum / kernel.divisor);
+        } else {
+            return std::abs(normalizeResponse(sum, kernel.divisor));
+        }
+    };
+
+    forEachRowChunk<Sum>(rows, input.size(), windowRows + 2, sumCols, [&](int begin, int end, auto buffer) {
+        auto ringRow = [&](int idxi) { return buffer((idxi % windowRows + windowRows) % windowRows); };
+        auto load = [&](int idxi) {
+            const T* src = input.row(std::clamp(idxi, 0, rows - 1));
+            Sum* padded = ringRow(idxi);
+            std::copy(src, src + width, padded + pad);
+            replicateEdgeSums(padded, width, channels, pad);
+        };
+        auto convolveRow = [&](Sum* sums, const DynamicKernel<int>& kernel, int idxi) {
+            std::fill(sums, sums + width, Sum(0));
+            for (int r = 0; r < kernel.rows; ++r) {
+                const Sum* row = ringRow(idxi - radiusY + r);
+                for (int c = 0; c < kernel.cols; ++c) {
+                    if (const Sum tap = kernel(r, c)) {
+                        const Sum* src = row + c * channels;
+                        for (int j = 0; j < width; ++j) {
+                            sums[j] += tap * src[j];
+                        }
+                    }
+                }
+            }
+        };
+
+        Sum* sumsX = buffer(windowRows);
+        Sum* sumsY = buffer(windowRows + 1);
+        for (int idxi = begin - radiusY; idxi < begin + radiusY; ++idxi) {
+            load(idxi);
+        }
+
+        for (int idxi = begin; idxi < end; ++idxi) {
+            load(idxi + radiusY);
+            T* out = output.row(idxi);
+            convolveRow(sumsX, kernelX, idxi);
+            if (!kernelY) {
+                for (int j = 0; j < width; ++j) {
+                    const Sum gradient = response(sumsX[j], kernelX);
+                    out[j] = static_cast<T>(gradient < minimum ? 0 : std::min(gradient, fullScale));
+                }
+                continue;
+            }
+            convolveRow(sumsY, *kernelY, idxi);
+            for (int j = 0; j < width; ++j) {
+                const Sum gx = std::min(response(sumsX[j], kernelX), fullScale);
+                const Sum gy = std::min(response(sumsY[j], *kernelY), fullScale);
+                Sum gradient;
+                if constexpr (std::is_same_v<Sum, double>) {
+                    gradient = (gx + gy) * 0.5;
+                } else {
+                    gradient = (gx + gy) >> 1;
+                }
+                out[j] = static_cast<T>(gradient < minimum ? 0 : gradient);
+            }
+        }
+    });
+}
+
+template <ChannelSample T>
+void ImageFilter::convolveChannels(const ChannelImage<T>& input, ChannelImage<T>& output, const DynamicKernel<int>& kernel, uchar threshold) {
+    PROF_EXEC_TIME;
+
+    forEachSamplePlane(input, output, [&](const FlatArray<T>& from, FlatArray<T>& to, int channels) {
+        convolveSamples(from, to, channels, kernel, nullptr, threshold);
+    });
+}
+
+template <ChannelSample T>
+void ImageFilter::convolveXYChannels(const ChannelImage<T>& input, ChannelImage<T>& output, const DynamicKernel<int>& kernelX,
+                                     const DynamicKernel<int>& kernelY, uchar threshold) {
+    PROF_EXEC_TIME;
+
+    forEachSamplePlane(input, output, [&](const FlatArray<T>& from, FlatArray<T>& to, int channels) {
+        convolveSamples(from, to, channels, kernelX, &kernelY, threshold);
+    });
+}
+
+void ImageFilter::applyChannels(const ChannelImage<uchar>& input, ChannelImage<uchar>& output) const {
+    PROF_EXEC_TIME;
+
+    output.resizeLike(input);
+    if (input.layout() == ChannelLayout::Planar || input.channels() == 1) {
+        for (int c = 0; c < input.channels(); ++c) {
+            FlatImage plane = output.plane(c);
+            apply(input.plane(c), plane);
+        }
+        return;
+    }
+
+    // apply() works on single-channel images, so interleaved pixels are split into planes first
+    ScratchArena& arena = ScratchArena::local();
+    ChannelImage<uchar> planes(arena), filtered(arena);
+    planes.resize(input.rows(), input.cols(), input.channels(), ChannelLayout::Planar);
+    ChannelImageFactory::convert(input, planes);
+    applyChannels(planes, filtered);
+    ChannelImageFactory::convert(filtered, output);
+}
+
+void ImageFilter::applyChannels(const ChannelImage<uint16_t>&, ChannelImage<uint16_t>&) const {
+    throw std::invalid_argument("This filter only supports 8-bit samples.");
+}
+
+void ImageFilter::applyChannels(const ChannelImage<float>&, ChannelImage<float>&) const {
+    throw std::invalid_argument("This filter only supports 8-bit samples.");
+}
+
+void ImageFilter::applyGradientField(const FlatImage&, GradientField&) const {
+    throw std::invalid_argument("This filter does not produce a gradient field.");
+}
+
+template <typename KType>
+static void expandKernel(const SeparableKernel<KType>& separable, KType kernel[3][3]) {
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            kernel[r][c] = separable.column[r] * separable.row[c];
+        }
+    }
+}
+
+// The separable passes round-trip through the row buffer, so against the SIMD dense rows
+// they only pay off when they save at least two taps: 9 -> 6 for a Gaussian, but not 6 -> 5
+// for Sobel. Float kernels have no dense SIMD path and always go separable.
+template <typename KType>
+static bool preferSeparable(const SeparableKernel<KType>& separable) {
+    if constexpr (!std::is_integral_v<KType>) {
+        return true;
+    } else {
+        KType kernel[3][3];
+        int16_t taps[9];
+        expandKernel(separable, kernel);
+        if (!toInt16Kernel(kernel, taps)) {
+            return true;
+        }
+
+        auto nonZero = [](const KType v[3]) { return (v[0] != 0) + (v[1] != 0) + (v[2] != 0); };
+        const int rowTaps = nonZero(separable.row);
+        const int columnTaps = nonZero(separable.column);
+        return rowTaps + columnTaps + 2 <= rowTaps * columnTaps;
+    }
+}
+
+template <typename KType>
+void ImageFilter::applySeparableXYKernels(const FlatImage& input, FlatImage& output, const SeparableKernel<KType>& kernelX, const SeparableKernel<KType>& kernelY, uchar threshold) const {
+    PROF_EXEC_TIME;
+
+    if (output.overlaps(input)) {
+        applyThroughScratch(input, output, [&](const FlatImage& from, FlatImage& to) { applySeparableXYKernels(from, to, kernelX, kernelY, threshold); });
+        return;
+    }
+
+    if (preferSeparable(kernelX) && preferSeparable(kernelY)) {
+        separableXYGradient(input, output, kernelX, kernelY, threshold);
+    } else {
+        KType denseX[3][3], denseY[3][3];
+        expandKernel(kernelX, denseX);
+        expandKernel(kernelY, denseY);
+        fusedXYGradient(input, output, denseX, denseY, threshold);
+    }
+}
+
+template <typename KType>
+void ImageFilter::applySeparableKernel(const FlatImage& input, FlatImage& output, const SeparableKernel<KType>& kernel, uchar threshold) const {
+    PROF_EXEC_TIME;
+
+    if (output.overlaps(input)) {
+        applyThroughScratch(input, output, [&](const FlatImage& from, FlatImage& to) { applySeparableKernel(from, to, kernel, threshold); });
+        return;
+    }
+
+    if (preferSeparable(kernel)) {
+        separableSingleGradient(input, output, kernel, threshold);
+    } else {
+        KType dense[3][3];
+        expandKernel(kernel, dense);
+        fusedSingleGradient(input, output, dense, threshold);
+    }
+}
+
 template <typename KType>
 void ImageFilter::applyXYKernels(const FlatImage& input, FlatImage& output, const KType kernelX[3][3], const KType kernelY[3][3], uchar threshold) const {
     PROF_EXEC_TIME;
 
-    FlatImage paddedImage;
+    if (output.overlaps(input)) {
+        applyThroughScratch(input, output, [&](const FlatImage& from, FlatImage& to) { applyXYKernels(from, to, kernelX, kernelY, threshold); });
+        return;
+    }
+
+    SeparableKernel<KType> separableX, separableY;
+    if (factorizeKernel(kernelX, separableX) && factorizeKernel(kernelY, separableY)
+            && preferSeparable(separableX) && preferSeparable(separableY)) {
+        separableXYGradient(input, output, separableX, separableY, threshold);
+    } else {
+        fusedXYGradient(input, output, kernelX, kernelY, threshold);
+    }
+}
+
+template <typename KType>
+void ImageFilter::applyXYKernels(const FlatImage& input, GradientField& field, const KType kernelX[3][3], const KType kernelY[3][3]) const {
+    PROF_EXEC_TIME;
+
+    fusedGradientField(input, field, kernelX, kernelY);
+}
+
+template <typename KType>
+void ImageFilter::applyXYKernelsMultiPass(const FlatImage& input, FlatImage& output, const KType kernelX[3][3], const KType kernelY[3][3], uchar threshold) const {
+    PROF_EXEC_TIME;
+
+    // intermediates are recycled through the thread's arena instead of reallocated per call
+    ScratchArena& arena = ScratchArena::local();
+
+    FlatImage paddedImage(arena);
     auto [padded_rows, padded_cols] = padBoundaries(input, paddedImage);
 
-    FlatImage gx, gy;
+    FlatImage gx(arena), gy(arena);
     getGradient(paddedImage, gx, padded_rows, padded_cols, kernelX);
     getGradient(paddedImage, gy, padded_rows, padded_cols, kernelY);
 
-    FlatImage combinedGradient;
+    FlatImage combinedGradient(arena);
     combineGradients(gx, gy, combinedGradient, threshold);
 
     removeBoundaries(combinedGradient, output);
@@ -132,19 +1122,57 @@ template <typename KType>
 void ImageFilter::applySingleKernel(const FlatImage& input, FlatImage& output, const KType kernel[3][3], uchar threshold) const {
     PROF_EXEC_TIME;
 
-    FlatImage paddedImage;
-    auto [padded_rows, padded_cols] = padBoundaries(input, paddedImage);
-
-    FlatImage gradient;
-    getGradient(paddedImage, gradient, padded_rows, padded_cols, kernel, threshold);
+    if (output.overlaps(input)) {
+        applyThroughScratch(input, output, [&](const FlatImage& from, FlatImage& to) { applySingleKernel(from, to, kernel, threshold); });
+        return;
+    }
 
-    removeBoundaries(gradient, output);
+    SeparableKernel<KType> separable;
+    if (factorizeKernel(kernel, separable) && preferSeparable(separable)) {
+        separableSingleGradient(input, output, separable, threshold);
+    } else {
+        fusedSingleGradient(input, output, kernel, threshold);
+    }
 }
 
 // Explicit template instantiation
 template void ImageFilter::applyXYKernels(const FlatImage& input, FlatImage& output, const int kernelX[3][3], const int kernelY[3][3], uchar threshold) const;
 template void ImageFilter::applyXYKernels(const FlatImage& input, FlatImage& output, const float kernelX[3][3], const float kernelY[3][3], uchar threshold) const;
+template void ImageFilter::applyXYKernels(const FlatImage& input, GradientField& field, const int kernelX[3][3], const int kernelY[3][3]) const;
+template void ImageFilter::applyXYKernels(const FlatImage& input, GradientField& field, const float kernelX[3][3], const float kernelY[3][3]) const;
+template void ImageFilter::applyXYKernelsMultiPass(const FlatImage& input, FlatImage& output, const int kernelX[3][3], const int kernelY[3][3], uchar threshold) const;
+template void ImageFilter::applyXYKernelsMultiPass(const FlatImage& input, FlatImage& output, const float kernelX[3][3], const float kernelY[3][3], uchar threshold) const;
 template void ImageFilter::applySingleKernel(const FlatImage& input, FlatImage& output, const int kernel[3][3], uchar threshold) const;
 template void ImageFilter::applySingleKernel(const FlatImage& input, FlatImage& output, const float kernel[3][3], uchar threshold) const;
 template void ImageFilter::getGradient(const FlatImage& input, FlatImage& output, int padded_rows, int padded_cols, const int kernel[3][3], uchar threshold);
 template void ImageFilter::getGradient(const FlatImage& input, FlatImage& output, int padded_rows, int padded_cols, const float kernel[3][3], uchar threshold);
+template void ImageFilter::xyGradientRow(const uchar* const* window, uchar* out, int cols, const int kernelX[3][3], const int kernelY[3][3], uchar threshold);
+template void ImageFilter::xyGradientRow(const uchar* const* window, uchar* out, int cols, const float kernelX[3][3], const float kernelY[3][3], uchar threshold);
+template void ImageFilter::fusedXYGradient(const FlatImage& input, FlatImage& output, const int kernelX[3][3], const int kernelY[3][3], uchar threshold);
+template void ImageFilter::fusedXYGradient(const FlatImage& input, FlatImage& output, const float kernelX[3][3], const float kernelY[3][3], uchar threshold);
+template void ImageFilter::fusedGradientField(const FlatImage& input, GradientField& field, const int kernelX[3][3], const int kernelY[3][3]);
+template void ImageFilter::fusedGradientField(const FlatImage& input, GradientField& field, const float kernelX[3][3], const float kernelY[3][3]);
+template void ImageFilter::fusedSingleGradient(const FlatImage& input, FlatImage& output, const int kernel[3][3], uchar threshold);
+template void ImageFilter::fusedSingleGradient(const FlatImage& input, FlatImage& output, const float kernel[3][3], uchar threshold);
+template void ImageFilter::applySeparableXYKernels(const FlatImage& input, FlatImage& output, const SeparableKernel<int>& kernelX, const SeparableKernel<int>& kernelY, uchar threshold) const;
+template void ImageFilter::applySeparableXYKernels(const FlatImage& input, FlatImage& output, const SeparableKernel<float>& kernelX, const SeparableKernel<float>& kernelY, uchar threshold) const;
+template void ImageFilter::applySeparableKernel(const FlatImage& input, FlatImage& output, const SeparableKernel<int>& kernel, uchar threshold) const;
+template void ImageFilter::applySeparableKernel(const FlatImage& input, FlatImage& output, const SeparableKernel<float>& kernel, uchar threshold) const;
+template void ImageFilter::separableXYGradient(const FlatImage& input, FlatImage& output, const SeparableKernel<int>& kernelX, const SeparableKernel<int>& kernelY, uchar threshold);
+template void ImageFilter::separableXYGradient(const FlatImage& input, FlatImage& output, const SeparableKernel<float>& kernelX, const SeparableKernel<float>& kernelY, uchar threshold);
+template void ImageFilter::separableSingleGradient(const FlatImage& input, FlatImage& output, const SeparableKernel<int>& kernel, uchar threshold);
+template void ImageFilter::separableSingleGradient(const FlatImage& input, FlatImage& output, const SeparableKernel<float>& kernel, uchar threshold);
+template bool ImageFilter::factorizeKernel(const int kernel[3][3], SeparableKernel<int>& separable);
+template bool ImageFilter::factorizeKernel(const float kernel[3][3], SeparableKernel<float>& separable);
+template void ImageFilter::boxMean(const ChannelImage<uchar>& input, ChannelImage<uchar>& output, int radiusY, int radiusX);
+template void ImageFilter::boxMean(const ChannelImage<uint16_t>& input, ChannelImage<uint16_t>& output, int radiusY, int radiusX);
+template void ImageFilter::boxMean(const ChannelImage<float>& input, ChannelImage<float>& output, int radiusY, int radiusX);
+template void ImageFilter::smoothSeparable(const ChannelImage<uchar>& input, ChannelImage<uchar>& output, std::span<const int> taps);
+template void ImageFilter::smoothSeparable(const ChannelImage<uint16_t>& input, ChannelImage<uint16_t>& output, std::span<const int> taps);
+template void ImageFilter::smoothSeparable(const ChannelImage<float>& input, ChannelImage<float>& output, std::span<const int> taps);
+template void ImageFilter::convolveChannels(const ChannelImage<uchar>& input, ChannelImage<uchar>& output, const DynamicKernel<int>& kernel, uchar threshold);
+template void ImageFilter::convolveChannels(const ChannelImage<uint16_t>& input, ChannelImage<uint16_t>& output, const DynamicKernel<int>& kernel, uchar threshold);
+template void ImageFilter::convolveChannels(const ChannelImage<float>& input, ChannelImage<float>& output, const DynamicKernel<int>& kernel, uchar threshold);
+template void ImageFilter::convolveXYChannels(const ChannelImage<uchar>& input, ChannelImage<uchar>& output, const DynamicKernel<int>& kernelX, const DynamicKernel<int>& kernelY, uchar threshold);
+template void ImageFilter::convolveXYChannels(const ChannelImage<uint16_t>& input, ChannelImage<uint16_t>& output, const DynamicKernel<int>& kernelX, const DynamicKernel<int>& kernelY, uchar threshold);
+template void ImageFilter::convolveXYChannels(const ChannelImage<float>& input, ChannelImage<float>& output, const DynamicKernel<int>& kernelX, const DynamicKernel<int>& kernelY, uchar threshold);
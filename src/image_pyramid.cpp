@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "image_pyramid.hpp"
+#include "parallel_utils.hpp"
+#include "pixel_allocator.hpp"
+#include "prof_utils.hpp"
+#include "simd_kernels.hpp"
+
+
+namespace {
+
+constexpr size_t LEVEL_ALIGNMENT = 64;
+
+// cv::BORDER_REFLECT_101 index of row i in an image of `count` rows
+int reflect101(int i, int count) {
+    if (count == 1) {
+        return 0;
+    }
+    while (i < 0 || i >= count) {
+        i = i < 0 ? -i : 2 * count - 2 - i;
+    }
+    return i;
+}
+
+void copyPixels(const FlatImage& src, FlatImage& dst) {
+    for (int i = 0; i < src.rows(); ++i) {
+        std::memcpy(dst.row(i), src.row(i), src.cols() * sizeof(uchar));
+    }
+}
+
+} // namespace
+
+
+void gaussianDownsample(const FlatImage& input, FlatImage& output) {
+    PROF_EXEC_TIME;
+
+    const int rows = input.rows();
+    const int cols = input.cols();
+    output.resize((rows + 1) / 2, (cols + 1) / 2);
+    if (input.empty()) {
+        return;
+    }
+
+    const SimdKernelSet& simd = activeSimdKernels();
+    const int chunkCount = currentExecutionPolicy().chunksFor(output.rows(), input.size());
+    const int chunkRows = (output.rows() + chunkCount - 1) / chunkCount;
+
+    forEachIndex(chunkCount, input.size(), [&](int chunk) {
+        FlatArray<uint16_t> sums(1, cols + 4, ScratchArena::local());
+        const int end = std::min((chunk + 1) * chunkRows, output.rows());
+        for (int i = chunk * chunkRows; i < end; ++i) {
+            const uchar* window[5];
+            for (int k = 0; k < 5; ++k) {
+                window[k] = input.row(reflect101(2 * i - 2 + k, rows));
+            }
+            simd.pyramidDownRow(window, output.row(i), cols, sums.data());
+        }
+    });
+}
+
+ImagePyramid::ImagePyramid(const FlatImage& base, int levels) {
+    build(base, levels);
+}
+
+ImagePyramid::ImagePyramid(const ImagePyramid& other) {
+    *this = other;
+}
+
+ImagePyramid& ImagePyramid::operator=(const ImagePyramid& other) {
+    if (this != &other) {
+        reshape(other.levels() ? other.level(0).rows() : 0, other.levels() ? other.level(0).cols() : 0, other.levels());
+        for (int i = 0; i < levels(); ++i) {
+            copyPixels(other.level(i), level(i));
+        }
+    }
+    return *this;
+}
+
+void ImagePyramid::reshape(int rows, int cols, int levels) {
+    // level sizes and offsets, each level starting on an aligned boundary of the buffer
+    std::vector<std::pair<int, int>> shapes;
+    std::vector<size_t> offsets;
+    size_t total = 0;
+    for (int i = 0; i < levels && rows > 0 && cols > 0; ++i) {
+        shapes.emplace_back(rows, cols);
+        offsets.push_back(total);
+        total += (static_cast<size_t>(rows) * cols + LEVEL_ALIGNMENT - 1) / LEVEL_ALIGNMENT * LEVEL_ALIGNMENT;
+        if (rows == 1 && cols == 1) {
+            break;
+        }
+        rows = (rows + 1) / 2;
+        cols = (cols + 1) / 2;
+    }
+
+    const bool same = shapes.size() == _levels.size() && std::equal(shapes.begin(), shapes.end(), _levels.begin(),
+        [](const std::pair<int, int>& shape, const FlatImage& level) { return shape.first == level.rows() && shape.second == level.cols(); });
+    if (same) {
+        return;
+    }
+
+    // rows of LEVEL_ALIGNMENT bytes keep the buffer continuous and its size beyond int range
+    storage.resize(static_cast<int>(total / LEVEL_ALIGNMENT), static_cast<int>(LEVEL_ALIGNMENT));
+    _levels.clear();
+    for (size_t i = 0; i < shapes.size(); ++i) {
+        _levels.push_back(FlatImage::borrow(storage.data() + offsets[i], shapes[i].first, shapes[i].second));
+    }
+}
+
+void ImagePyramid::build(const FlatImage& base, int levels) {
+    PROF_EXEC_TIME;
+
+    if (levels < 1) {
+        throw std::invalid_argument("A pyramid needs at least one level.");
+    }
+    reshape(base.rows(), base.cols(), levels);
+    if (_levels.empty()) {
+        return;
+    }
+
+    copyPixels(base, _levels[0]);
+    for (size_t i = 1; i < _levels.size(); ++i) {
+        gaussianDownsample(_levels[i - 1], _levels[i]);
+    }
+}
+
+void ImagePyramid::filter(const FilterPipeline& pipeline, ImagePyramid& output, const BatchOptions& options) const {
+    PROF_EXEC_TIME;
+
+    output.reshape(levels() ? level(0).rows() : 0, levels() ? level(0).cols() : 0, levels());
+    // views share the buffers, so applyBatch writes straight into the output levels
+    std::vector<FlatImage> outputs = output._levels;
+    pipeline.applyBatch(_levels, outputs, options);
+}
+
+size_t ImagePyramid::size() const {
+    size_t pixels = 0;
+    for (const FlatImage& level : _levels) {
+        pixels += level.size();
+    }
+    return pixels;
+}
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "integral_image.hpp"
+#include "parallel_utils.hpp"
+#include "prof_utils.hpp"
+
+// Adds one source row (and its squares) to the running column sums
+static void accumulateColumns(uint32_t* columnSums, uint64_t* squaredColumnSums, const uchar* src, int cols) {
+    for (int j = 0; j < cols; ++j) {
+        columnSums[j] += src[j];
+    }
+    if (squaredColumnSums) {
+        for (int j = 0; j < cols; ++j) {
+            squaredColumnSums[j] += static_cast<uint32_t>(src[j]) * src[j];
+        }
+    }
+}
+
+// Table row from the column sums of the padded columns above it: a running sum along the row,
+// with the edge columns repeated `border` times on either side
+template <typename Sum>
+static void prefixRow(const Sum* columnSums, Sum* out, int cols, int border) {
+    Sum running = 0;
+    *out++ = 0;
+    for (int x = 0; x < border; ++x) {
+        running += columnSums[0];
+        *out++ = running;
+    }
+    for (int j = 0; j < cols; ++j) {
+        running += columnSums[j];
+        *out++ = running;
+    }
+    for (int x = 0; x < border; ++x) {
+        running += columnSums[cols - 1];
+        *out++ = running;
+    }
+}
+
+void IntegralImage::build(const FlatImage& input, int border, bool squares) {
+    PROF_EXEC_TIME;
+
+    if (border < 0) {
+        throw std::invalid_argument("Integral image border must not be negative.");
+    }
+
+    _rows = input.rows();
+    _cols = input.cols();
+    _border = input.empty() ? 0 : border;
+
+    const int paddedRows = input.empty() ? 0 : _rows + 2 * _border;
+    const int paddedCols = input.empty() ? 0 : _cols + 2 * _border;
+    _sums.resize(paddedRows + 1, paddedCols + 1);
+    _squaredSums.resize(squares ? paddedRows + 1 : 0, squares ? paddedCols + 1 : 0);
+
+    std::fill(_sums.row(0), _sums.row(0) + paddedCols + 1, 0u);
+    if (squares) {
+        std::fill(_squaredSums.row(0), _squaredSums.row(0) + paddedCols + 1, uint64_t(0));
+    }
+    if (input.empty()) {
+        return;
+    }
+
+    auto sourceRow = [&](int paddedRow) { return input.row(std::clamp(paddedRow - _border, 0, _rows - 1)); };
+
+    // Rows are split into chunks. Each chunk first totals its columns (reading only the 8-bit
+    // source), the totals are carried down across the chunks, and then every chunk writes its
+    // table rows starting from the carried column sums, so the tables are written in one pass.
+    const size_t pixels = static_cast<size_t>(paddedRows) * paddedCols;
+    const int chunkCount = currentExecutionPolicy().chunksFor(paddedRows, pixels);
+    const int chunkRows = (paddedRows + chunkCount - 1) / chunkCount;
+
+    ScratchArena& arena = ScratchArena::local();
+    FlatArray<uint32_t> columnSums(chunkCount, _cols, arena);
+    FlatArray<uint64_t> squaredColumnSums(squares ? chunkCount : 0, _cols, arena);
+    auto squaredRow = [&](int chunk) { return squares ? squaredColumnSums.row(chunk) : nullptr; };
+
+    forEachIndex(chunkCount, pixels, [&](int chunk) {
+        std::fill(columnSums.row(chunk), columnSums.row(chunk) + _cols, 0u);
+        if (squares) {
+            std::fill(squaredColumnSums.row(chunk), squaredColumnSums.row(chunk) + _cols, uint64_t(0));
+        }
+        for (int row = chunk * chunkRows; row < std::min((chunk + 1) * chunkRows, paddedRows); ++row) {
+            accumulateColumns(columnSums.row(chunk), squaredRow(chunk), sourceRow(row), _cols);
+        }
+    });
+
+    // exclusive prefix over the chunks: each chunk starts from the columns of all chunks above
+    for (int j = 0; j < _cols; ++j) {
+        uint32_t carry = 0;
+        uint64_t squaredCarry = 0;
+        for (int chunk = 0; chunk < chunkCount; ++chunk) {
+            const uint32_t total = columnSums(chunk, j);
+            columnSums(chunk, j) = carry;
+            carry += total;
+            if (squares) {
+                const uint64_t squaredTotal = squaredColumnSums(chunk, j);
+                squaredColumnSums(chunk, j) = squaredCarry;
+                squaredCarry += squaredTotal;
+            }
+        }
+    }
+
+    forEachIndex(chunkCount, pixels, [&](int chunk) {
+        for (int row = chunk * chunkRows; row < std::min((chunk + 1) * chunkRows, paddedRows); ++row) {
+            accumulateColumns(columnSums.row(chunk), squaredRow(chunk), sourceRow(row), _cols);
+            prefixRow(columnSums.row(chunk), _sums.row(row + 1), _cols, _border);
+            if (squares) {
+                prefixRow(squaredColumnSums.row(chunk), _squaredSums.row(row + 1), _cols, _border);
+            }
+        }
+    });
+}
+
+double IntegralImage::boxMean(int row, int col, int radiusY, int radiusX) const {
+    const double area = static_cast<double>(2 * radiusY + 1) * (2 * radiusX + 1);
+    return boxSum(row, col, radiusY, radiusX) / area;
+}
+
+double IntegralImage::boxVariance(int row, int col, int radiusY, int radiusX) const {
+    if (!hasSquares()) {
+        throw std::runtime_error("Integral image was built without squared sums.");
+    }
+    const uint64_t area = static_cast<uint64_t>(2 * radiusY + 1) * (2 * radiusX + 1);
+    const uint64_t sum = boxSum(row, col, radiusY, radiusX);
+    const uint64_t squaredSum = this->squaredSum(row - radiusY, col - radiusX, 2 * radiusY + 1, 2 * radiusX + 1);
+    // n * sum(x^2) >= sum(x)^2, and the difference is exact modulo 2^64
+    return static_cast<double>(area * squaredSum - sum * sum) / (static_cast<double>(area) * area);
+}
@@ -0,0 +1,40 @@
+#include "prof_utils.hpp"
+#include "laplacian_of_gaussian.hpp"
+
+
+void LaplacianOfGaussian::applyBenchmark(const cv::Mat& input, cv::Mat& output) const {
+    PROF_EXEC_TIME;
+
+    cv::Mat smoothed;
+    cv::GaussianBlur(input, smoothed, cv::Size(5, 5), 0, 0, cv::BORDER_REPLICATE);
+    cv::Laplacian(smoothed, output, CV_8U, 3, 1, 0, cv::BORDER_REPLICATE);
+}
+
+void LaplacianOfGaussian::apply(const FlatImage& input, FlatImage& output) const {
+    PROF_EXEC_TIME;
+    applySingleKernel(input, output, kernels::LAPLACIAN_OF_GAUSSIAN_5X5, 0);
+}
+
+void LaplacianOfGaussian::applyChannels(const ChannelImage<uchar>& input, ChannelImage<uchar>& output) const {
+    PROF_EXEC_TIME;
+    // Planes run through the single-channel SIMD rows; interleaved pixels in one pass
+    if (input.layout() == ChannelLayout::Planar || input.channels() == 1) {
+        ImageFilter::applyChannels(input, output);
+    } else {
+        convolveChannels(input, output, kernels::LAPLACIAN_OF_GAUSSIAN_5X5);
+    }
+}
+
+void LaplacianOfGaussian::applyChannels(const ChannelImage<uint16_t>& input, ChannelImage<uint16_t>& output) const {
+    PROF_EXEC_TIME;
+    convolveChannels(input, output, kernels::LAPLACIAN_OF_GAUSSIAN_5X5);
+}
+
+void LaplacianOfGaussian::applyChannels(const ChannelImage<float>& input, ChannelImage<float>& output) const {
+    PROF_EXEC_TIME;
+    convolveChannels(input, output, kernels::LAPLACIAN_OF_GAUSSIAN_5X5);
+}
+
+void LaplacianOfGaussian::applyRow(const uchar* const* window, uchar* out, int cols, RowScratch&) const {
+    convolveRow(window, out, cols, kernels::LAPLACIAN_OF_GAUSSIAN_5X5, 0);
+}
@@ -0,0 +1,55 @@
+#include <cmath>
+
+#include "integral_image.hpp"
+#include "local_variance.hpp"
+#include "prof_utils.hpp"
+
+
+LocalVariance::LocalVariance(int ksize) : ksize(ksize)
+{
+    // n * sum(x^2) must stay below 2^64: 255^2 * n^2 < 2^64 for n <= 2^24
+    if (ksize < 1 || ksize % 2 == 0 || ksize > 4095) {
+        throw std::invalid_argument("LocalVariance needs a positive odd kernel size up to 4095.");
+    }
+}
+
+void LocalVariance::applyBenchmark(const cv::Mat& input, cv::Mat& output) const {
+    PROF_EXEC_TIME;
+
+    cv::Mat mean, meanSquares, deviation;
+    cv::boxFilter(input, mean, CV_64F, cv::Size(ksize, ksize), cv::Point(-1, -1), true, cv::BORDER_REPLICATE);
+    cv::sqrBoxFilter(input, meanSquares, CV_64F, cv::Size(ksize, ksize), cv::Point(-1, -1), true, cv::BORDER_REPLICATE);
+    cv::Mat variance = meanSquares - mean.mul(mean);
+    cv::sqrt(cv::max(variance, 0.0), deviation);
+    deviation.convertTo(output, CV_8U);
+}
+
+void LocalVariance::apply(const FlatImage& input, FlatImage& output) const {
+    PROF_EXEC_TIME;
+
+    const int r = radius();
+    const uint64_t area = static_cast<uint64_t>(ksize) * ksize;
+    const double scale = 1.0 / area;
+
+    IntegralImage integral(ScratchArena::local());
+    integral.build(input, r);
+
+    output.resize(input.rows(), input.cols());
+    forEachIndex(input.rows(), input.size(), [&](int idxi) {
+        const uint32_t* above = integral.sumsRow(idxi - r);
+        const uint32_t* below = integral.sumsRow(idxi + r + 1);
+        const uint64_t* squaredAbove = integral.squaredSumsRow(idxi - r);
+        const uint64_t* squaredBelow = integral.squaredSumsRow(idxi + r + 1);
+        uchar* out = output.row(idxi);
+
+        for (int idxj = 0; idxj < input.cols(); ++idxj) {
+            const int left = idxj - r;
+            const int right = idxj + r + 1;
+            const uint64_t sum = below[right] - below[left] - above[right] + above[left];
+            const uint64_t squaredSum = squaredBelow[right] - squaredBelow[left] - squaredAbove[right] + squaredAbove[left];
+            // n^2 * variance, exact in 64 bits
+            const uint64_t scaledVariance = area * squaredSum - sum * sum;
+            out[idxj] = static_cast<uchar>(std::nearbyint(std::sqrt(static_cast<double>(scaledVariance)) * scale));
+        }
+    });
+}
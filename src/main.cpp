@@ -1,37 +1,162 @@
+#include <cstdlib>
+#include <filesystem>
+
 #include "io_utils.hpp"
+#include "prof_utils.hpp"
+#include "raw_image.hpp"
 #include "filter_pipeline.hpp"
 #include "blur.hpp"
 #include "scharr.hpp"
 #include "sobel.hpp"
+#include "strip_io.hpp"
+#include "video_pipeline.hpp"
 
-int main(int argc, char** argv) {
-    if (argc < 3) {
-        std::cerr << "Usage: " << argv[0] << " <input_image_path> <output_image_path>" << std::endl;
+// Filters every input into output_dir under the same file name, spreading the batch over the cores
+static int runBatch(const FilterPipeline& pipeline, const std::string& outputDir, const std::vector<std::string>& inputPaths) {
+    std::vector<cv::Mat> images;
+    std::vector<FlatImage> inputs, outputs;
+    for (const auto& path : inputPaths) {
+        images.push_back(cv::imread(path, cv::IMREAD_GRAYSCALE));
+        if (images.back().empty()) {
+            std::cerr << "Failed to open the image at: " << path << std::endl;
+            return -1;
+        }
+        inputs.push_back(FlatImageFactory::wrap(images.back()));
+    }
+
+    BatchReport report = pipeline.applyBatch(inputs, outputs);
+    std::cout << "Filtered " << report.images << " images in " << report.seconds << " s ("
+              << report.imagesPerSecond << " images/s)" << std::endl;
+
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        auto outputPath = std::filesystem::path(outputDir) / std::filesystem::path(inputPaths[i]).filename();
+        writeImage(outputPath.string(), FlatImageFactory::toMat(outputs[i]));
+    }
+    return 0;
+}
+
+// Decodes, filters and encodes a video with the three stages running concurrently
+static int runVideo(const FilterPipeline& pipeline, const std::string& inputPath, const std::string& outputPath) {
+    try {
+        VideoCaptureSource source(inputPath);
+        VideoWriterSink sink(outputPath, source.fps() > 0 ? source.fps() : 30, source.rows(), source.cols());
+        VideoReport report = VideoPipeline(pipeline).run(source, sink);
+        std::cout << "Filtered " << report.frames << " frames in " << report.seconds << " s ("
+                  << report.framesPerSecond << " frames/s, mean latency " << report.meanLatencyMs << " ms)" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Video filtering failed: " << e.what() << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+static int run(int argc, char** argv) {
+    if (argc >= 4 && std::string(argv[1]) == "--batch") {
+        return runBatch(FilterPipeline().addSobelOperator(), argv[2], std::vector<std::string>(argv + 3, argv + argc));
+    }
+    if (argc == 4 && std::string(argv[1]) == "--video") {
+        return runVideo(FilterPipeline().addSobelOperator(), argv[2], argv[3]);
+    }
+
+    if (argc != 3 && !(argc == 5 && std::string(argv[3]) == "--strip-rows")) {
+        std::cerr << "Usage: " << argv[0] << " [--profile] <input_image_path> <output_image_path> [--strip-rows <rows>]" << std::endl;
+        std::cerr << "       " << argv[0] << " [--profile] --batch <output_dir> <input_image_path>..." << std::endl;
+        std::cerr << "       " << argv[0] << " [--profile] --video <input_video_path> <output_video_path>" << std::endl;
         return -1;
     }
 
     std::string inputImagePath = argv[1];
     std::string outputImagePath = argv[2];
-    cv::Mat image = cv::imread(inputImagePath, cv::IMREAD_GRAYSCALE);
+
+    // create pipeline of chained filters
+    auto pipeline = FilterPipeline().addSobelOperator();
+
+    // stream binary PGM files strip by strip, never holding the whole image in memory
+    if (argc == 5) {
+        try {
+            PgmStripReader reader(inputImagePath);
+            PgmStripWriter writer(outputImagePath, reader.rows(), reader.cols());
+            pipeline.applyStreaming(reader, writer, std::stoi(argv[4]));
+        } catch (const std::exception& e) {
+            std::cerr << "Streaming failed: " << e.what() << std::endl;
+            return -1;
+        }
+        std::cout << "Image saved successfully to: " << outputImagePath << std::endl;
+        return 0;
+    }
+
+    // .raw images are memory-mapped: no decoding on the way in, and the pipeline writes the
+    // output file's pages in place
+    auto isRaw = [](const std::string& path) { return path.size() > 4 && path.compare(path.size() - 4, 4, ".raw") == 0; };
+    const bool rawOutput = isRaw(outputImagePath);
+
+    FlatImage input;
+    cv::Mat image;
+    try {
+        if (isRaw(inputImagePath)) {
+            input = mapRawImage(inputImagePath);
+            image = FlatImageFactory::toMat(input);
+        } else {
+            image = cv::imread(inputImagePath, cv::IMREAD_GRAYSCALE);
+            input = FlatImageFactory::wrap(image);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
 
     if (image.empty()) {
         std::cerr << "Failed to open the image at: " << inputImagePath << std::endl;
         return -1;
     }
 
-    // create pipeline of chained filters
-    auto pipeline = FilterPipeline().addSobelOperator();
-
     cv::Mat benchmarkResult;
     pipeline.applyBenchmark(image, benchmarkResult);
 
+    // the pipeline reads the input in place and writes the result Mat in place, without copies
     FlatImage customResult;
-    pipeline.apply(FlatImageFactory::from(image), customResult);
+    cv::Mat customResultMat;
+    if (rawOutput) {
+        customResult = createRawImage(outputImagePath, image.rows, image.cols);
+        customResultMat = FlatImageFactory::toMat(customResult);
+    } else {
+        customResultMat = cv::Mat(image.rows, image.cols, CV_8UC1);
+        customResult = FlatImageFactory::wrap(customResultMat);
+    }
+    pipeline.apply(input, customResult);
 
     // display original image, benchmark result, and custom result
-    cv::Mat customResultMat(customResult.rows(), customResult.cols(), CV_8UC1, const_cast<uchar*>(customResult.data().data()));
     displayImages({std::cref(image), std::cref(benchmarkResult), std::cref(customResultMat)});
-    writeImage(outputImagePath, customResultMat);
+    if (!rawOutput) {
+        writeImage(outputImagePath, customResultMat);
+    }
 
     return 0;
 }
+
+// Profiling is off unless IMAGE_FILTERS_PROFILE is set or --profile comes first on the command
+// line; a profiled run prints a timing summary of every scope once it is done. Set
+// IMAGE_FILTERS_TRACE to a file path to also write a Chrome trace of the run.
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "--profile") {
+        Profiler::setEnabled(true);
+        argv[1] = argv[0];
+        ++argv;
+        --argc;
+    }
+    const char* tracePath = std::getenv("IMAGE_FILTERS_TRACE");
+    if (tracePath) {
+        Profiler::setEnabled(true);
+        Profiler::setTracing(true);
+    }
+
+    int status = run(argc, argv);
+
+    if (Profiler::enabled()) {
+        Profiler::writeSummary(std::cout);
+    }
+    if (tracePath) {
+        Profiler::writeChromeTrace(tracePath);
+        std::cout << "Trace written to: " << tracePath << std::endl;
+    }
+    return status;
+}
@@ -0,0 +1,88 @@
+#include <atomic>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unistd.h>
+
+#include <tbb/task_arena.h>
+
+#include "parallel_utils.hpp"
+
+// Frames whose input and output no longer fit in the last-level cache together
+static size_t cacheDerivedTileMinPixels() {
+    long cacheBytes = -1;
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    cacheBytes = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+    if (cacheBytes <= 0) {
+        cacheBytes = 8 << 20;
+    }
+    return static_cast<size_t>(cacheBytes) / 2;
+}
+
+ExecutionMode ExecutionPolicy::modeFor(size_t pixels) const {
+    if (pixels < parallelMinPixels || tbb::this_task_arena::max_concurrency() <= 1) {
+        return ExecutionMode::Serial;
+    }
+    static const size_t derivedTileMinPixels = cacheDerivedTileMinPixels();
+    const size_t tileThreshold = tileMinPixels ? tileMinPixels : derivedTileMinPixels;
+    return pixels >= tileThreshold ? ExecutionMode::TileParallel : ExecutionMode::ChunkedParallel;
+}
+
+int ExecutionPolicy::chunksFor(int count, size_t pixels) const {
+    if (count <= 1 || modeFor(pixels) == ExecutionMode::Serial) {
+        return 1;
+    }
+    return std::clamp(tbb::this_task_arena::max_concurrency() * chunksPerWorker, 1, count);
+}
+
+ExecutionPolicy ExecutionPolicy::serial() {
+    ExecutionPolicy policy;
+    policy.parallelMinPixels = std::numeric_limits<size_t>::max();
+    return policy;
+}
+
+static size_t environmentSize(const char* name, size_t fallback) {
+    const char* value = std::getenv(name);
+    if (!value || !*value) {
+        return fallback;
+    }
+    try {
+        return std::stoull(value);
+    } catch (const std::exception&) {
+        return fallback;
+    }
+}
+
+static std::atomic<std::shared_ptr<const ExecutionPolicy>>& defaultPolicySnapshot() {
+    static std::atomic<std::shared_ptr<const ExecutionPolicy>> snapshot = [] {
+        ExecutionPolicy fromEnvironment;
+        fromEnvironment.parallelMinPixels = environmentSize("IMAGE_FILTERS_PARALLEL_MIN_PIXELS", fromEnvironment.parallelMinPixels);
+        fromEnvironment.tileMinPixels = environmentSize("IMAGE_FILTERS_TILE_MIN_PIXELS", fromEnvironment.tileMinPixels);
+        return std::make_shared<const ExecutionPolicy>(fromEnvironment);
+    }();
+    return snapshot;
+}
+
+ExecutionPolicy defaultExecutionPolicy() {
+    return *defaultPolicySnapshot().load();
+}
+
+void setDefaultExecutionPolicy(const ExecutionPolicy& policy) {
+    defaultPolicySnapshot().store(std::make_shared<const ExecutionPolicy>(policy));
+}
+
+static thread_local const ExecutionPolicy* scopedPolicy = nullptr;
+
+ExecutionPolicy currentExecutionPolicy() {
+    return scopedPolicy ? *scopedPolicy : defaultExecutionPolicy();
+}
+
+ExecutionPolicyScope::ExecutionPolicyScope(const ExecutionPolicy& policy) : policy(policy), previous(scopedPolicy) {
+    scopedPolicy = &this->policy;
+}
+
+ExecutionPolicyScope::~ExecutionPolicyScope() {
+    scopedPolicy = previous;
+}
@@ -0,0 +1,195 @@
+#include <cstring>
+#include <numeric>
+#include <sstream>
+
+#include "pipeline_plan.hpp"
+#include "prof_utils.hpp"
+
+// Estimated cost of a smoothing pass, in row sweeps per pixel. Separable taps take one sweep per
+// tap and direction; box windows (equal taps) slide their column sums, and above eight columns
+// also their row sums, so wide boxes cost the same as narrow ones.
+static int smoothingCost(const std::vector<int>& taps)
+{
+    const int size = static_cast<int>(taps.size());
+    const bool box = std::all_of(taps.begin(), taps.end(), [&](int tap) { return tap == taps[0]; });
+    if (box) {
+        return 3 + std::min(size, 8);
+    }
+    return 2 * size + 2;
+}
+
+// Cost of writing an intermediate image and reading it back in the next stage, in the same
+// units. Small while frames stay in the last-level cache; measured at 1080p, where a 5-tap
+// smoothing pass costs about as much as two box blurs.
+static constexpr int INTERMEDIATE_COST = 2;
+
+static std::vector<int> convolveTaps(const std::vector<int>& first, const std::vector<int>& second)
+{
+    std::vector<int> taps(first.size() + second.size() - 1, 0);
+    for (size_t i = 0; i < first.size(); ++i) {
+        for (size_t j = 0; j < second.size(); ++j) {
+            taps[i + j] += first[i] * second[j];
+        }
+    }
+    return taps;
+}
+
+static std::vector<int> foldTaps(const std::vector<std::shared_ptr<const ImageFilter>>& stages)
+{
+    std::vector<int> taps = {1};
+    for (const auto& stage : stages) {
+        taps = convolveTaps(taps, stage->smoothingTaps());
+    }
+    return taps;
+}
+
+FoldedSmoothing::FoldedSmoothing(std::vector<std::shared_ptr<const ImageFilter>> stages)
+    : _stages(std::move(stages)), folded(foldTaps(_stages)), edgeBand(0)
+{
+    if (_stages.empty()) {
+        throw std::invalid_argument("FoldedSmoothing needs at least one stage.");
+    }
+    for (size_t stage = 1; stage < _stages.size(); ++stage) {
+        edgeBand += _stages[stage]->radius();
+    }
+}
+
+std::string FoldedSmoothing::signature() const {
+    std::string text = "FoldedSmoothing(";
+    for (size_t stage = 0; stage < _stages.size(); ++stage) {
+        const std::string stageSignature = _stages[stage]->signature();
+        if (stageSignature.empty()) {
+            return {};
+        }
+        text += (stage ? "," : "") + stageSignature;
+    }
+    return text + ")";
+}
+
+void FoldedSmoothing::applyBenchmark(const cv::Mat& input, cv::Mat& output) const {
+    PROF_EXEC_TIME;
+
+    cv::Mat temp = input;
+    for (const auto& stage : _stages) {
+        stage->applyBenchmark(temp, output);
+        temp = std::move(output);
+    }
+    output = std::move(temp);
+}
+
+void FoldedSmoothing::applyStages(const FlatImage& input, FlatImage& output) const {
+    ScratchArena& arena = ScratchArena::local();
+    FlatImage buffers[2] = {FlatImage(arena), FlatImage(arena)};
+
+    const FlatImage* source = &input;
+    for (size_t stage = 0; stage < _stages.size(); ++stage) {
+        FlatImage& target = stage + 1 == _stages.size() ? output : buffers[stage % 2];
+        _stages[stage]->apply(*source, target);
+        source = &target;
+    }
+}
+
+// Runs the stages on the rectangle extended by radius() pixels, clipped to the image, and copies
+// the rectangle out. Clipped sides are image edges, which the stages replicate as the chain does.
+void FoldedSmoothing::applyBand(const FlatImage& input, FlatImage& output, int row, int col, int rows, int cols) const {
+    const int halo = radius();
+    const int top = std::max(row - halo, 0);
+    const int left = std::max(col - halo, 0);
+    const int bottom = std::min(row + rows + halo, input.rows());
+    const int right = std::min(col + cols + halo, input.cols());
+
+    FlatImage filtered(ScratchArena::local());
+    applyStages(input.subView(top, left, bottom - top, right - left), filtered);
+    for (int i = 0; i < rows; ++i) {
+        std::memcpy(&output(row + i, col), &filtered(row - top + i, col - left), cols * sizeof(uchar));
+    }
+}
+
+void FoldedSmoothing::apply(const FlatImage& input, FlatImage& output) const {
+    PROF_EXEC_TIME;
+
+    const int rows = input.rows();
+    const int cols = input.cols();
+    if (rows <= 2 * edgeBand || cols <= 2 * edgeBand) {
+        applyStages(input, output);
+        return;
+    }
+
+    folded.apply(input, output);
+    if (edgeBand > 0) {
+        applyBand(input, output, 0, 0, edgeBand, cols);
+        applyBand(input, output, rows - edgeBand, 0, edgeBand, cols);
+        applyBand(input, output, edgeBand, 0, rows - 2 * edgeBand, edgeBand);
+        applyBand(input, output, edgeBand, cols - edgeBand, rows - 2 * edgeBand, edgeBand);
+    }
+}
+
+PipelinePlan PipelinePlan::build(const std::vector<std::shared_ptr<const ImageFilter>>& filters, const PlanOptions& options)
+{
+    PipelinePlan plan;
+
+    for (size_t stage = 0; stage < filters.size(); ++stage) {
+        const std::shared_ptr<const ImageFilter>& filter = filters[stage];
+        std::vector<int> taps = filter->smoothingTaps();
+
+        // one tap t smooths by t * t / t^2, the identity
+        if (options.dropNoOps && taps.size() == 1) {
+            plan._dropped.push_back(stage);
+            continue;
+        }
+
+        if (options.foldSmoothing && !taps.empty() && !plan._steps.empty() && !plan._steps.back().smoothingTaps.empty()) {
+            PlanStep& previous = plan._steps.back();
+            std::vector<int> folded = convolveTaps(previous.smoothingTaps, taps);
+            if (SeparableSmoothing::supports(folded) &&
+                    smoothingCost(folded) < smoothingCost(previous.smoothingTaps) + smoothingCost(taps) + INTERMEDIATE_COST) {
+                previous.stages.push_back(stage);
+                std::vector<std::shared_ptr<const ImageFilter>> run;
+                for (size_t folds : previous.stages) {
+                    run.push_back(filters[folds]);
+                }
+                previous.filter = std::make_shared<FoldedSmoothing>(std::move(run));
+                previous.smoothingTaps = std::move(folded);
+                previous.folded = true;
+                continue;
+            }
+        }
+
+        plan._steps.push_back(PlanStep{filter, {stage}, std::move(taps), false});
+    }
+
+    // the first step reads the input, which never needs a guard band
+    for (size_t step = 1; step < plan._steps.size(); ++step) {
+        const int radius = plan._steps[step].filter->radius();
+        if (radius != ImageFilter::UNBOUNDED_RADIUS) {
+            plan._guard = std::max(plan._guard, radius);
+        }
+    }
+    return plan;
+}
+
+std::string PipelinePlan::describe() const
+{
+    std::ostringstream text;
+    for (const PlanStep& step : _steps) {
+        text << (step.stages.size() > 1 ? "stages " : "stage ");
+        for (size_t k = 0; k < step.stages.size(); ++k) {
+            text << (k ? "+" : "") << step.stages[k];
+        }
+        if (step.folded) {
+            text << ": folded smoothing, taps";
+            for (int tap : step.smoothingTaps) {
+                text << ' ' << tap;
+            }
+            text << " / " << std::accumulate(step.smoothingTaps.begin(), step.smoothingTaps.end(), 0) << "^2";
+        } else {
+            text << ": radius " << step.filter->radius();
+        }
+        text << '\n';
+    }
+    for (size_t stage : _dropped) {
+        text << "stage " << stage << ": dropped, no-op\n";
+    }
+    text << bufferCount() << " intermediate buffer" << (bufferCount() == 1 ? "" : "s") << ", guard " << _guard << '\n';
+    return text.str();
+}
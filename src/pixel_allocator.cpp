@@ -0,0 +1,112 @@
+#include <atomic>
+#include <cstring>
+#include <new>
+
+#include "pixel_allocator.hpp"
+
+static std::atomic<size_t> allocationCount{0};
+
+static size_t alignedSize(size_t bytes) {
+    return (bytes + PixelAllocator::ALIGNMENT - 1) / PixelAllocator::ALIGNMENT * PixelAllocator::ALIGNMENT;
+}
+
+class AlignedHeapAllocator : public PixelAllocator {
+public:
+    void* allocate(size_t bytes) override {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        void* ptr = ::operator new(alignedSize(bytes), std::align_val_t(ALIGNMENT));
+        std::memset(ptr, 0, bytes);
+        return ptr;
+    }
+
+    void deallocate(void* ptr, size_t bytes) override {
+        ::operator delete(ptr, alignedSize(bytes), std::align_val_t(ALIGNMENT));
+    }
+};
+
+PixelAllocator& defaultPixelAllocator() {
+    static AlignedHeapAllocator allocator;
+    return allocator;
+}
+
+size_t pixelAllocationCount() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+ScratchArena::~ScratchArena() {
+    release();
+}
+
+void* ScratchArena::allocate(size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = pool.find(alignedSize(bytes));
+        if (it != pool.end() && !it->second.empty()) {
+            void* ptr = it->second.back();
+            it->second.pop_back();
+            pooled -= it->first;
+            return ptr;
+        }
+    }
+    return upstream.allocate(alignedSize(bytes));
+}
+
+void ScratchArena::deallocate(void* ptr, size_t bytes) {
+    const size_t size = alignedSize(bytes);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pooled + size <= maxPooled) {
+            pool[size].push_back(ptr);
+            pooled += size;
+            return;
+        }
+    }
+    upstream.deallocate(ptr, size);
+}
+
+std::shared_ptr<void> ScratchArena::share() {
+    return weak_from_this().lock();
+}
+
+void ScratchArena::release() {
+    trim(0);
+}
+
+void ScratchArena::trim(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    trimLocked(bytes);
+}
+
+void ScratchArena::trimLocked(size_t bytes) {
+    for (auto it = pool.rbegin(); it != pool.rend() && pooled > bytes; ++it) {
+        auto& buffers = it->second;
+        while (!buffers.empty() && pooled > bytes) {
+            upstream.deallocate(buffers.back(), it->first);
+            buffers.pop_back();
+            pooled -= it->first;
+        }
+    }
+    std::erase_if(pool, [](const auto& entry) { return entry.second.empty(); });
+}
+
+size_t ScratchArena::pooledBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pooled;
+}
+
+size_t ScratchArena::maxPooledBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return maxPooled;
+}
+
+void ScratchArena::setMaxPooledBytes(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    maxPooled = bytes;
+    trimLocked(bytes);
+}
+
+ScratchArena& ScratchArena::local() {
+    // shared, so that arrays which outlive the thread keep the arena alive
+    thread_local std::shared_ptr<ScratchArena> arena = std::make_shared<ScratchArena>();
+    return *arena;
+}
@@ -0,0 +1,264 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "prof_utils.hpp"
+
+// Durations are bucketed on a log scale with four buckets per power of two of nanoseconds
+constexpr int HISTOGRAM_BUCKETS = 256;
+// Trace events kept per thread; later scopes still count in the statistics
+constexpr size_t MAX_TRACE_EVENTS = 1 << 20;
+
+static int histogramBucket(uint64_t ns) {
+    if (ns < 4) {
+        return static_cast<int>(ns);
+    }
+    const int exponent = 63 - __builtin_clzll(ns);
+    const int quarter = static_cast<int>(ns >> (exponent - 2)) & 3;
+    return 4 + (exponent - 2) * 4 + quarter;
+}
+
+// Largest duration that falls into `bucket`
+static uint64_t histogramBucketLimit(int bucket) {
+    if (bucket < 4) {
+        return bucket;
+    }
+    const int exponent = (bucket - 4) / 4 + 2;
+    const uint64_t quarter = (bucket - 4) % 4;
+    return ((5 + quarter) << (exponent - 2)) - 1;
+}
+
+struct ScopeRecord
+{
+    uint64_t calls = 0;
+    uint64_t totalNs = 0;
+    uint64_t selfNs = 0;
+    uint64_t minNs = UINT64_MAX;
+    uint64_t maxNs = 0;
+    uint64_t histogram[HISTOGRAM_BUCKETS] = {};
+
+    void add(uint64_t ns, uint64_t childNs) {
+        ++calls;
+        totalNs += ns;
+        selfNs += ns - std::min(ns, childNs);
+        minNs = std::min(minNs, ns);
+        maxNs = std::max(maxNs, ns);
+        ++histogram[histogramBucket(ns)];
+    }
+
+    void merge(const ScopeRecord& other) {
+        calls += other.calls;
+        totalNs += other.totalNs;
+        selfNs += other.selfNs;
+        minNs = std::min(minNs, other.minNs);
+        maxNs = std::max(maxNs, other.maxNs);
+        for (int bucket = 0; bucket < HISTOGRAM_BUCKETS; ++bucket) {
+            histogram[bucket] += other.histogram[bucket];
+        }
+    }
+};
+
+struct TraceEvent
+{
+    const char* name;
+    uint64_t startNs;
+    uint64_t durationNs;
+};
+
+// Everything one thread has recorded. Only the owning thread writes; the mutex is uncontended
+// except while a snapshot or reset reads it from another thread.
+struct ThreadProfile
+{
+    std::mutex mutex;
+    int threadIndex = 0;
+    std::unordered_map<const char*, ScopeRecord> scopes; // keyed by the literal's address
+    std::vector<TraceEvent> events;
+    size_t droppedEvents = 0;
+    std::vector<uint64_t> childNs; // time spent in nested scopes, one entry per open scope
+};
+
+// Profiles outlive their threads so pool workers that exit still show up in the summary
+static std::mutex registryMutex;
+static std::vector<std::shared_ptr<ThreadProfile>> registry;
+
+static ThreadProfile& threadProfile() {
+    static thread_local std::shared_ptr<ThreadProfile> profile = [] {
+        auto created = std::make_shared<ThreadProfile>();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        created->threadIndex = static_cast<int>(registry.size());
+        registry.push_back(created);
+        return created;
+    }();
+    return *profile;
+}
+
+static uint64_t nowNs() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+static std::string environmentProfileMode() {
+    const char* value = std::getenv("IMAGE_FILTERS_PROFILE");
+    return value ? value : "";
+}
+
+std::atomic<bool> Profiler::statsEnabled{environmentProfileMode() == "1" || environmentProfileMode() == "stats" || environmentProfileMode() == "trace"};
+std::atomic<bool> Profiler::traceEnabled{environmentProfileMode() == "trace"};
+
+void Profiler::setEnabled(bool enable) {
+    statsEnabled.store(enable, std::memory_order_relaxed);
+}
+
+void Profiler::setTracing(bool enable) {
+    traceEnabled.store(enable, std::memory_order_relaxed);
+}
+
+uint64_t Profiler::begin() {
+    threadProfile().childNs.push_back(0);
+    return nowNs();
+}
+
+void Profiler::end(const char* name, uint64_t startNs) {
+    const uint64_t durationNs = nowNs() - startNs;
+    ThreadProfile& profile = threadProfile();
+    const uint64_t childNs = profile.childNs.back();
+    profile.childNs.pop_back();
+    if (!profile.childNs.empty()) {
+        profile.childNs.back() += durationNs;
+    }
+
+    std::lock_guard<std::mutex> lock(profile.mutex);
+    profile.scopes[name].add(durationNs, childNs);
+    if (tracing()) {
+        if (profile.events.size() < MAX_TRACE_EVENTS) {
+            profile.events.push_back({name, startNs, durationNs});
+        } else {
+            ++profile.droppedEvents;
+        }
+    }
+}
+
+static std::vector<std::shared_ptr<ThreadProfile>> registeredProfiles() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    return registry;
+}
+
+void Profiler::reset() {
+    for (const auto& profile : registeredProfiles()) {
+        std::lock_guard<std::mutex> lock(profile->mutex);
+        profile->scopes.clear();
+        profile->events.clear();
+        profile->droppedEvents = 0;
+    }
+}
+
+std::vector<ProfileStats> Profiler::snapshot() {
+    std::map<std::string, ScopeRecord> merged;
+    for (const auto& profile : registeredProfiles()) {
+        std::lock_guard<std::mutex> lock(profile->mutex);
+        for (const auto& [name, record] : profile->scopes) {
+            merged[name].merge(record);
+        }
+    }
+
+    std::vector<ProfileStats> stats;
+    for (const auto& [name, record] : merged) {
+        ProfileStats entry;
+        entry.name = name;
+        entry.calls = record.calls;
+        entry.totalUs = record.totalNs / 1e3;
+        entry.selfUs = record.selfNs / 1e3;
+        entry.minUs = record.minNs / 1e3;
+        entry.meanUs = entry.totalUs / record.calls;
+        entry.maxUs = record.maxNs / 1e3;
+
+        const uint64_t rank = (record.calls * 99 + 99) / 100;
+        uint64_t seen = 0;
+        for (int bucket = 0; bucket < HISTOGRAM_BUCKETS; ++bucket) {
+            seen += record.histogram[bucket];
+            if (seen >= rank) {
+                entry.p99Us = std::clamp(histogramBucketLimit(bucket), record.minNs, record.maxNs) / 1e3;
+                break;
+            }
+        }
+        stats.push_back(entry);
+    }
+    std::sort(stats.begin(), stats.end(), [](const ProfileStats& a, const ProfileStats& b) { return a.totalUs > b.totalUs; });
+    return stats;
+}
+
+void Profiler::writeSummary(std::ostream& out) {
+    const auto stats = snapshot();
+    if (stats.empty()) {
+        return;
+    }
+    out << std::left << std::setw(32) << "scope" << std::right << std::setw(10) << "calls" << std::setw(14) << "total us"
+        << std::setw(14) << "self us" << std::setw(12) << "min us" << std::setw(12) << "mean us" << std::setw(12) << "p99 us"
+        << std::setw(12) << "max us" << '\n';
+    out << std::fixed << std::setprecision(1);
+    for (const auto& entry : stats) {
+        out << std::left << std::setw(32) << entry.name << std::right << std::setw(10) << entry.calls << std::setw(14) << entry.totalUs
+            << std::setw(14) << entry.selfUs << std::setw(12) << entry.minUs << std::setw(12) << entry.meanUs << std::setw(12) << entry.p99Us
+            << std::setw(12) << entry.maxUs << '\n';
+    }
+    out << std::defaultfloat << std::flush;
+}
+
+static void writeJsonString(std::ostream& out, const char* text) {
+    out << '"';
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out << '\\' << *c;
+        } else if (static_cast<unsigned char>(*c) >= 0x20) {
+            out << *c;
+        }
+    }
+    out << '"';
+}
+
+void Profiler::writeChromeTrace(const std::string& path) {
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open " + path);
+    }
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto separator = [&] {
+        if (!first) {
+            file << ",\n";
+        }
+        first = false;
+    };
+    file << std::fixed << std::setprecision(3);
+    for (const auto& profile : registeredProfiles()) {
+        std::lock_guard<std::mutex> lock(profile->mutex);
+        separator();
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << profile->threadIndex
+             << ",\"args\":{\"name\":\"thread " << profile->threadIndex << "\"}}";
+        for (const auto& event : profile->events) {
+            separator();
+            file << "{\"name\":";
+            writeJsonString(file, event.name);
+            file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << profile->threadIndex << ",\"ts\":" << event.startNs / 1e3
+                 << ",\"dur\":" << event.durationNs / 1e3 << "}";
+        }
+        if (profile->droppedEvents) {
+            separator();
+            file << "{\"name\":\"dropped events\",\"ph\":\"C\",\"pid\":1,\"tid\":" << profile->threadIndex
+                 << ",\"ts\":0,\"args\":{\"count\":" << profile->droppedEvents << "}}";
+        }
+    }
+    file << "]}\n";
+    if (!file) {
+        throw std::runtime_error("Failed to write " + path);
+    }
+}
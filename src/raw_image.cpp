@@ -0,0 +1,116 @@
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "raw_image.hpp"
+
+constexpr uint64_t RAW_IMAGE_DATA_OFFSET = 4096;
+
+// Unmaps the file when the last view referencing it goes away
+struct RawImageMapping
+{
+    void* address;
+    size_t length;
+
+    RawImageMapping(void* address, size_t length) : address(address), length(length) {}
+    RawImageMapping(const RawImageMapping&) = delete;
+    RawImageMapping& operator=(const RawImageMapping&) = delete;
+
+    ~RawImageMapping() {
+        munmap(address, length);
+    }
+};
+
+static FlatImage mapRawImageFile(const std::string& path, bool writable) {
+    int fd = ::open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open " + path);
+    }
+
+    struct stat info;
+    RawImageHeader header;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(header)) ||
+        pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+        ::close(fd);
+        throw std::runtime_error(path + " is not a raw image file.");
+    }
+
+    // the sizes are checked against the file before any of them is used, so a corrupt header
+    // cannot overflow the length or produce a view past the end of the mapping
+    const uint64_t fileSize = static_cast<uint64_t>(info.st_size);
+    constexpr uint64_t maxDimension = std::numeric_limits<int>::max();
+    if (std::memcmp(header.magic, RAW_IMAGE_MAGIC, sizeof(header.magic)) != 0 || header.type != CV_8UC1 ||
+        header.rows > maxDimension || header.cols > maxDimension || header.pitch > maxDimension ||
+        header.pitch < header.cols || header.dataOffset < sizeof(header) ||
+        header.dataOffset % PixelAllocator::ALIGNMENT != 0 || header.dataOffset > fileSize ||
+        static_cast<uint64_t>(header.rows) * header.pitch > fileSize - header.dataOffset) {
+        ::close(fd);
+        throw std::runtime_error(path + " has an invalid or unsupported raw image header.");
+    }
+    const uint64_t length = header.dataOffset + static_cast<uint64_t>(header.rows) * header.pitch;
+
+    // read-only images are mapped copy-on-write: a write through a copy of the view changes a
+    // private copy of the page, never the file
+    void* address = mmap(nullptr, length, PROT_READ | PROT_WRITE, writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        throw std::runtime_error("Failed to map " + path);
+    }
+
+    // filters sweep rows top to bottom
+    madvise(address, length, MADV_SEQUENTIAL);
+
+    auto mapping = std::make_shared<RawImageMapping>(address, length);
+    uchar* pixels = static_cast<uchar*>(address) + header.dataOffset;
+    return FlatImage::adopt(pixels, header.rows, header.cols, header.pitch, mapping);
+}
+
+FlatImage mapRawImage(const std::string& path) {
+    return mapRawImageFile(path, false);
+}
+
+FlatImage mapRawImageWritable(const std::string& path) {
+    return mapRawImageFile(path, true);
+}
+
+FlatImage createRawImage(const std::string& path, int rows, int cols) {
+    if (rows < 0 || cols < 0) {
+        throw std::invalid_argument("Invalid raw image dimensions.");
+    }
+
+    RawImageHeader header{};
+    std::memcpy(header.magic, RAW_IMAGE_MAGIC, sizeof(header.magic));
+    header.rows = rows;
+    header.cols = cols;
+    header.pitch = (cols + PixelAllocator::ALIGNMENT - 1) / PixelAllocator::ALIGNMENT * PixelAllocator::ALIGNMENT;
+    header.type = CV_8UC1;
+    header.dataOffset = RAW_IMAGE_DATA_OFFSET;
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create " + path);
+    }
+    // the file is sparse until the pixels are written
+    const off_t length = header.dataOffset + static_cast<off_t>(header.rows) * header.pitch;
+    const bool written = ftruncate(fd, length) == 0 &&
+                         pwrite(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+    ::close(fd);
+    if (!written) {
+        throw std::runtime_error("Failed to write " + path);
+    }
+
+    return mapRawImageWritable(path);
+}
+
+void writeRawImage(const std::string& path, const FlatImage& image) {
+    FlatImage mapped = createRawImage(path, image.rows(), image.cols());
+    for (int i = 0; i < image.rows(); ++i) {
+        std::memcpy(mapped.row(i), image.row(i), image.cols() * sizeof(uchar));
+    }
+}
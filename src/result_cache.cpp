@@ -0,0 +1,120 @@
+#include <algorithm>
+
+#include "prof_utils.hpp"
+#include "result_cache.hpp"
+
+
+namespace {
+
+size_t pixelBytes(const FlatImage& image) {
+    return static_cast<size_t>(image.rows()) * image.cols();
+}
+
+void copyPixels(const FlatImage& src, FlatImage& dst) {
+    dst.resize(src.rows(), src.cols());
+    for (int i = 0; i < src.rows(); ++i) {
+        std::copy_n(src.row(i), src.cols(), dst.row(i));
+    }
+}
+
+} // namespace
+
+
+ResultCache::ResultCache(size_t capacityBytes) : capacityBytes(capacityBytes) {}
+
+size_t ResultCache::KeyHash::operator()(const ResultKey& key) const {
+    // content is already a well mixed hash
+    return static_cast<size_t>(key.content ^ (key.pipeline * 0x9E3779B97F4A7C15ULL));
+}
+
+bool ResultCache::lookup(const ResultKey& key, FlatImage& output) {
+    PROF_EXEC_TIME;
+
+    std::shared_ptr<const FlatImage> pixels;
+    {
+        std::lock_guard lock(mutex);
+        auto found = index.find(key);
+        if (found == index.end()) {
+            ++counters.misses;
+            return false;
+        }
+        ++counters.hits;
+        entries.splice(entries.begin(), entries, found->second);
+        pixels = found->second->pixels;
+    }
+    // the entry may be evicted meanwhile; the shared pointer keeps its pixels alive
+    copyPixels(*pixels, output);
+    return true;
+}
+
+void ResultCache::insert(const ResultKey& key, const FlatImage& result) {
+    PROF_EXEC_TIME;
+
+    const size_t bytes = pixelBytes(result);
+    if (bytes > capacityBytes) {
+        return;
+    }
+
+    // make room and reserve the bytes first, then copy without holding the lock
+    std::shared_ptr<FlatImage> pixels;
+    {
+        std::lock_guard lock(mutex);
+        if (auto found = index.find(key); found != index.end()) {
+            eraseLocked(found);
+        }
+        pixels = evictUntil(capacityBytes - bytes);
+        counters.bytes += bytes;
+    }
+    if (!pixels) {
+        pixels = std::make_shared<FlatImage>();
+    }
+    copyPixels(result, *pixels);
+
+    std::lock_guard lock(mutex);
+    if (auto found = index.find(key); found != index.end()) {
+        eraseLocked(found); // another thread stored the same result meanwhile
+    }
+    entries.push_front(Entry{key, std::move(pixels)});
+    index.emplace(key, entries.begin());
+    ++counters.entries;
+    ++counters.insertions;
+}
+
+void ResultCache::eraseLocked(std::unordered_map<ResultKey, std::list<Entry>::iterator, KeyHash>::iterator found) {
+    counters.bytes -= pixelBytes(*found->second->pixels);
+    entries.erase(found->second);
+    index.erase(found);
+    --counters.entries;
+}
+
+std::shared_ptr<FlatImage> ResultCache::evictUntil(size_t bytes) {
+    std::shared_ptr<FlatImage> recycled;
+    // bytes reserved by inserts still copying have no entry to evict yet
+    while (counters.bytes > bytes && !entries.empty()) {
+        Entry& last = entries.back();
+        counters.bytes -= pixelBytes(*last.pixels);
+        if (last.pixels.use_count() == 1) {
+            recycled = std::move(last.pixels);
+        }
+        index.erase(last.key);
+        entries.pop_back();
+        --counters.entries;
+        ++counters.evictions;
+    }
+    return recycled;
+}
+
+void ResultCache::clear() {
+    std::lock_guard lock(mutex);
+    for (const Entry& entry : entries) {
+        counters.bytes -= pixelBytes(*entry.pixels);
+    }
+    entries.clear();
+    index.clear();
+    counters.entries = 0;
+}
+
+ResultCacheStats ResultCache::stats() const {
+    std::lock_guard lock(mutex);
+    return counters;
+}
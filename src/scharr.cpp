@@ -8,5 +8,34 @@ void ScharrOperator::applyBenchmark(const cv::Mat& input, cv::Mat& output) const
 
 void ScharrOperator::apply(const FlatImage& input, FlatImage& output) const {
     PROF_EXEC_TIME;
-    applyXYKernels(input, output, KERNELX, KERNELY, 50);
+    applySeparableXYKernels(input, output, SEPARABLE_KERNELX, SEPARABLE_KERNELY, 50);
+}
+
+void ScharrOperator::applyChannels(const ChannelImage<uchar>& input, ChannelImage<uchar>& output) const {
+    PROF_EXEC_TIME;
+    // Planes run through the single-channel SIMD rows; interleaved pixels in one pass
+    if (input.layout() == ChannelLayout::Planar || input.channels() == 1) {
+        ImageFilter::applyChannels(input, output);
+    } else {
+        convolveXYChannels(input, output, kernels::SCHARR_3X3_X, kernels::SCHARR_3X3_Y, 50);
+    }
+}
+
+void ScharrOperator::applyChannels(const ChannelImage<uint16_t>& input, ChannelImage<uint16_t>& output) const {
+    PROF_EXEC_TIME;
+    convolveXYChannels(input, output, kernels::SCHARR_3X3_X, kernels::SCHARR_3X3_Y, 50);
+}
+
+void ScharrOperator::applyChannels(const ChannelImage<float>& input, ChannelImage<float>& output) const {
+    PROF_EXEC_TIME;
+    convolveXYChannels(input, output, kernels::SCHARR_3X3_X, kernels::SCHARR_3X3_Y, 50);
+}
+
+void ScharrOperator::applyGradientField(const FlatImage& input, GradientField& field) const {
+    PROF_EXEC_TIME;
+    applyXYKernels(input, field, KERNELX, KERNELY);
+}
+
+void ScharrOperator::applyRow(const uchar* const* window, uchar* out, int cols, RowScratch&) const {
+    xyGradientRow(window, out, cols, KERNELX, KERNELY, 50);
 }
@@ -0,0 +1,64 @@
+#include <numeric>
+
+#include "prof_utils.hpp"
+#include "separable_smoothing.hpp"
+
+
+SeparableSmoothing::SeparableSmoothing(std::vector<int> taps) : taps(std::move(taps))
+{
+    if (!supports(this->taps)) {
+        throw std::invalid_argument("SeparableSmoothing needs an odd number of non-negative taps whose squared sum fits 8-bit sums.");
+    }
+}
+
+bool SeparableSmoothing::supports(const std::vector<int>& taps) {
+    if (taps.size() % 2 == 0 || std::any_of(taps.begin(), taps.end(), [](int tap) { return tap < 0; })) {
+        return false;
+    }
+    const uint64_t weight = std::accumulate(taps.begin(), taps.end(), uint64_t(0));
+    // every window sum, rounding bias included, must fit in uint32
+    return weight > 0 && weight <= UINT16_MAX && weight * weight * 255 <= UINT32_MAX - weight * weight / 2;
+}
+
+std::string SeparableSmoothing::signature() const {
+    std::string text = "SeparableSmoothing(";
+    for (size_t k = 0; k < taps.size(); ++k) {
+        text += (k ? "," : "") + std::to_string(taps[k]);
+    }
+    return text + ")";
+}
+
+void SeparableSmoothing::applyBenchmark(const cv::Mat& input, cv::Mat& output) const {
+    PROF_EXEC_TIME;
+
+    const double weight = std::accumulate(taps.begin(), taps.end(), 0.0);
+    cv::Mat kernel(static_cast<int>(taps.size()), 1, CV_64F);
+    for (size_t k = 0; k < taps.size(); ++k) {
+        kernel.at<double>(static_cast<int>(k), 0) = taps[k] / weight;
+    }
+    cv::sepFilter2D(input, output, -1, kernel, kernel, cv::Point(-1, -1), 0, cv::BORDER_REPLICATE);
+}
+
+void SeparableSmoothing::apply(const FlatImage& input, FlatImage& output) const {
+    PROF_EXEC_TIME;
+    smoothSeparable(input, output, taps);
+}
+
+void SeparableSmoothing::applyChannels(const ChannelImage<uchar>& input, ChannelImage<uchar>& output) const {
+    PROF_EXEC_TIME;
+    smoothSeparable(input, output, taps);
+}
+
+void SeparableSmoothing::applyChannels(const ChannelImage<uint16_t>& input, ChannelImage<uint16_t>& output) const {
+    PROF_EXEC_TIME;
+    smoothSeparable(input, output, taps);
+}
+
+void SeparableSmoothing::applyChannels(const ChannelImage<float>& input, ChannelImage<float>& output) const {
+    PROF_EXEC_TIME;
+    smoothSeparable(input, output, taps);
+}
+
+void SeparableSmoothing::applyRow(const uchar* const* window, uchar* out, int cols, RowScratch& scratch) const {
+    smoothSeparableRow(window, out, cols, taps, scratch);
+}
@@ -0,0 +1,1011 @@
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "simd_kernels.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define IMAGE_FILTERS_X86 1
+#endif
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+
+namespace {
+
+int scalarXYGradientRow(const uchar*, const uchar*, const uchar*, uchar*, int, const int16_t*, const int16_t*, uchar) {
+    return 1;
+}
+
+int scalarSingleGradientRow(const uchar*, const uchar*, const uchar*, uchar*, int, const int16_t*, uchar) {
+    return 1;
+}
+
+int scalarGradientFieldRow(const uchar*, const uchar*, const uchar*, const GradientRow&, int, const int16_t*, const int16_t*, GradientNorm) {
+    return 1;
+}
+
+int scalarSuppressNonMaximaRow(const float*, const float*, const float*, const uchar*, uchar*, int, float, float) {
+    return 1;
+}
+
+int scalarHorizontalRow(const uchar*, int16_t*, int, const int16_t*) {
+    return 1;
+}
+
+int scalarVerticalXYRow(const int16_t* const[3], const int16_t* const[3], uchar*, int, const int16_t*, const int16_t*, uchar) {
+    return 0;
+}
+
+int scalarVerticalSingleRow(const int16_t* const[3], uchar*, int, const int16_t*, uchar) {
+    return 0;
+}
+
+// Fixed-point row loops. Arguments are taken by value so the stores cannot alias them, which
+// keeps every loop vectorizable; always_inline lets target("avx2") wrappers rebuild them for AVX2.
+template <typename T>
+[[gnu::always_inline]] inline void accumulateLoop(uint32_t* sums, const T* src, uint32_t tap, int count) {
+    for (int j = 0; j < count; ++j) {
+        sums[j] += tap * src[j];
+    }
+}
+
+[[gnu::always_inline]] inline void slideLoop(uint32_t* sums, const uchar* entering, const uchar* leaving, int count) {
+    for (int j = 0; j < count; ++j) {
+        sums[j] += entering[j] - leaving[j];
+    }
+}
+
+[[gnu::always_inline]] inline void divideLoop(const uint32_t* sums, uchar* out, int count, const FixedPointDivisor divide) {
+    for (int j = 0; j < count; ++j) {
+        out[j] = static_cast<uchar>(divide(sums[j]));
+    }
+}
+
+// cv::BORDER_REFLECT_101 index of column j in a row of `count` pixels
+inline int reflect101(int j, int count) {
+    if (count == 1) {
+        return 0;
+    }
+    while (j < 0 || j >= count) {
+        j = j < 0 ? -j : 2 * count - 2 - j;
+    }
+    return j;
+}
+
+[[gnu::always_inline]] inline void pyramidDownLoop(const uchar* const window[5], uchar* out, int srcCols, uint16_t* sums) {
+    const uchar* r0 = window[0];
+    const uchar* r1 = window[1];
+    const uchar* r2 = window[2];
+    const uchar* r3 = window[3];
+    const uchar* r4 = window[4];
+    uint16_t* center = sums + 2;
+    for (int j = 0; j < srcCols; ++j) {
+        center[j] = static_cast<uint16_t>(r0[j] + r4[j] + 4 * (r1[j] + r3[j]) + 6 * r2[j]);
+    }
+    for (int k = 1; k <= 2; ++k) {
+        center[-k] = center[reflect101(-k, srcCols)];
+        center[srcCols - 1 + k] = center[reflect101(srcCols - 1 + k, srcCols)];
+    }
+
+    const int dstCols = (srcCols + 1) / 2;
+    for (int k = 0; k < dstCols; ++k) {
+        const uint16_t* s = center + 2 * k;
+        out[k] = static_cast<uchar>((s[-2] + s[2] + 4 * (s[-1] + s[1]) + 6 * s[0] + 128) >> 8);
+    }
+}
+
+void portableAccumulateRow(uint32_t* sums, const uchar* src, uint32_t tap, int count) {
+    accumulateLoop(sums, src, tap, count);
+}
+
+void portableAccumulateSumsRow(uint32_t* sums, const uint32_t* src, uint32_t tap, int count) {
+    accumulateLoop(sums, src, tap, count);
+}
+
+void portableSlideRow(uint32_t* sums, const uchar* entering, const uchar* leaving, int count) {
+    slideLoop(sums, entering, leaving, count);
+}
+
+void portableDivideRow(const uint32_t* sums, uchar* out, int count, const FixedPointDivisor& divide) {
+    divideLoop(sums, out, count, divide);
+}
+
+void portablePyramidDownRow(const uchar* const window[5], uchar* out, int srcCols, uint16_t* sums) {
+    pyramidDownLoop(window, out, srcCols, sums);
+}
+
+inline uint64_t loadWord(const uchar* src) {
+    uint64_t word;
+    std::memcpy(&word, src, sizeof(word));
+    return word;
+}
+
+void scalarHashStripes(uint64_t* lanes, const uchar* data, int stripes, const uchar* secret) {
+    uint64_t acc[8];
+    std::memcpy(acc, lanes, sizeof(acc));
+    for (int s = 0; s < stripes; ++s) {
+        for (int lane = 0; lane < 8; ++lane) {
+            const uint64_t value = loadWord(data + 64 * s + 8 * lane);
+            const uint64_t keyed = value ^ loadWord(secret + 8 * s + 8 * lane);
+            acc[lane ^ 1] += value;
+            acc[lane] += (keyed & 0xFFFFFFFF) * (keyed >> 32);
+        }
+    }
+    std::memcpy(lanes, acc, sizeof(acc));
+}
+
+#ifdef IMAGE_FILTERS_X86
+
+// 16 pixels per iteration: each 16-byte load is widened into two 8-lane int16 halves.
+struct Sse2Block {
+    __m128i lo, hi;
+};
+
+__attribute__((target("sse2")))
+inline void sse2Load(const uchar* src, Sse2Block& block) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    block.lo = _mm_unpacklo_epi8(bytes, zero);
+    block.hi = _mm_unpackhi_epi8(bytes, zero);
+}
+
+__attribute__((target("sse2")))
+inline void sse2Accumulate(Sse2Block& acc, const Sse2Block taps[9], const int16_t* kernel) {
+    acc.lo = _mm_setzero_si128();
+    acc.hi = _mm_setzero_si128();
+    for (int t = 0; t < 9; ++t) {
+        if (kernel[t] == 0) {
+            continue;
+        }
+        const __m128i k = _mm_set1_epi16(kernel[t]);
+        acc.lo = _mm_add_epi16(acc.lo, _mm_mullo_epi16(taps[t].lo, k));
+        acc.hi = _mm_add_epi16(acc.hi, _mm_mullo_epi16(taps[t].hi, k));
+    }
+}
+
+// min(|x|, 255)
+__attribute__((target("sse2")))
+inline __m128i sse2AbsClamp(__m128i x) {
+    const __m128i abs = _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+    return _mm_min_epi16(abs, _mm_set1_epi16(255));
+}
+
+// x < threshold ? 0 : x
+__attribute__((target("sse2")))
+inline __m128i sse2Threshold(__m128i x, __m128i threshold) {
+    return _mm_andnot_si128(_mm_cmplt_epi16(x, threshold), x);
+}
+
+__attribute__((target("sse2")))
+inline void sse2LoadTaps(const uchar* above, const uchar* center, const uchar* below, int j, Sse2Block taps[9]) {
+    const uchar* rows[3] = {above, center, below};
+    for (int r = 0; r < 3; ++r) {
+        sse2Load(rows[r] + j - 1, taps[r * 3 + 0]);
+        sse2Load(rows[r] + j    , taps[r * 3 + 1]);
+        sse2Load(rows[r] + j + 1, taps[r * 3 + 2]);
+    }
+}
+
+__attribute__((target("sse2")))
+int sse2XYGradientRow(const uchar* above, const uchar* center, const uchar* below, uchar* out, int cols,
+                      const int16_t* kernelX, const int16_t* kernelY, uchar threshold) {
+    const __m128i thresholdVec = _mm_set1_epi16(threshold);
+    int j = 1;
+    for (; j + 16 <= cols - 1; j += 16) {
+        Sse2Block taps[9], gx, gy;
+        sse2LoadTaps(above, center, below, j, taps);
+        sse2Accumulate(gx, taps, kernelX);
+        sse2Accumulate(gy, taps, kernelY);
+
+        __m128i lo = _mm_srli_epi16(_mm_add_epi16(sse2AbsClamp(gx.lo), sse2AbsClamp(gy.lo)), 1);
+        __m128i hi = _mm_srli_epi16(_mm_add_epi16(sse2AbsClamp(gx.hi), sse2AbsClamp(gy.hi)), 1);
+        lo = sse2Threshold(lo, thresholdVec);
+        hi = sse2Threshold(hi, thresholdVec);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + j), _mm_packus_epi16(lo, hi));
+    }
+    return j;
+}
+
+__attribute__((target("sse2")))
+int sse2SingleGradientRow(const uchar* above, const uchar* center, const uchar* below, uchar* out, int cols,
+                          const int16_t* kernel, uchar threshold) {
+    const __m128i thresholdVec = _mm_set1_epi16(threshold);
+    int j = 1;
+    for (; j + 16 <= cols - 1; j += 16) {
+        Sse2Block taps[9], g;
+        sse2LoadTaps(above, center, below, j, taps);
+        sse2Accumulate(g, taps, kernel);
+
+        __m128i lo = sse2Threshold(sse2AbsClamp(g.lo), thresholdVec);
+        __m128i hi = sse2Threshold(sse2AbsClamp(g.hi), thresholdVec);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + j), _mm_packus_epi16(lo, hi));
+    }
+    return j;
+}
+
+// Writes the derivatives and magnitudes of the 8 pixels at column j and returns their
+// GradientDirection values as int16 lanes
+__attribute__((target("sse2")))
+inline __m128i sse2GradientField(__m128i gx, __m128i gy, const GradientRow& out, int j, GradientNorm norm) {
+    if (out.gx) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out.gx + j), gx);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out.gy + j), gy);
+    }
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ax = _mm_max_epi16(gx, _mm_sub_epi16(zero, gx));
+    const __m128i ay = _mm_max_epi16(gy, _mm_sub_epi16(zero, gy));
+
+    if (out.magnitude) {
+        __m128 lo, hi;
+        if (norm == GradientNorm::L1) {
+            // |gx| + |gy| <= 65280 still fits unsigned 16 bits
+            const __m128i sum = _mm_add_epi16(ax, ay);
+            lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(sum, zero));
+            hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(sum, zero));
+        } else {
+            const __m128i pairsLo = _mm_unpacklo_epi16(gx, gy);
+            const __m128i pairsHi = _mm_unpackhi_epi16(gx, gy);
+            lo = _mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(pairsLo, pairsLo)));
+            hi = _mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(pairsHi, pairsHi)));
+        }
+        _mm_storeu_ps(out.magnitude + j, lo);
+        _mm_storeu_ps(out.magnitude + j + 4, hi);
+    }
+
+    // |gy| - 2 |gx| saturates instead of wrapping, so the vertical test stays in 16 bits
+    const __m128i tan22 = _mm_mulhi_epi16(ax, _mm_set1_epi16(TAN_22_5_Q16));
+    const __m128i notHorizontal = _mm_cmpgt_epi16(ay, tan22);
+    const __m128i vertical = _mm_cmpgt_epi16(_mm_subs_epi16(_mm_subs_epi16(ay, ax), ax), tan22);
+    const __m128i opposite = _mm_srai_epi16(_mm_xor_si128(gx, gy), 15);
+
+    __m128i direction = _mm_or_si128(_mm_set1_epi16(1), _mm_and_si128(opposite, _mm_set1_epi16(2)));
+    direction = _mm_and_si128(notHorizontal, direction);
+    return _mm_or_si128(_mm_andnot_si128(vertical, direction), _mm_and_si128(vertical, _mm_set1_epi16(2)));
+}
+
+__attribute__((target("sse2")))
+int sse2GradientFieldRow(const uchar* above, const uchar* center, const uchar* below, const GradientRow& out, int cols,
+                         const int16_t* kernelX, const int16_t* kernelY, GradientNorm norm) {
+    int j = 1;
+    for (; j + 16 <= cols - 1; j += 16) {
+        Sse2Block taps[9], gx, gy;
+        sse2LoadTaps(above, center, below, j, taps);
+        sse2Accumulate(gx, taps, kernelX);
+        sse2Accumulate(gy, taps, kernelY);
+
+        __m128i lo = sse2GradientField(gx.lo, gy.lo, out, j, norm);
+        __m128i hi = sse2GradientField(gx.hi, gy.hi, out, j + 8, norm);
+        if (out.orientation) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out.orientation + j), _mm_packus_epi16(lo, hi));
+        }
+    }
+    return j;
+}
+
+// Weighted sum of three int16 vectors, skipping zero weights.
+__attribute__((target("sse2")))
+inline __m128i sse2Taps3(__m128i a, __m128i b, __m128i c, const int16_t* taps) {
+    __m128i acc = _mm_setzero_si128();
+    if (taps[0]) acc = _mm_add_epi16(acc, _mm_mullo_epi16(a, _mm_set1_epi16(taps[0])));
+    if (taps[1]) acc = _mm_add_epi16(acc, _mm_mullo_epi16(b, _mm_set1_epi16(taps[1])));
+    if (taps[2]) acc = _mm_add_epi16(acc, _mm_mullo_epi16(c, _mm_set1_epi16(taps[2])));
+    return acc;
+}
+
+__attribute__((target("sse2")))
+int sse2HorizontalRow(const uchar* src, int16_t* dst, int cols, const int16_t* taps) {
+    int j = 1;
+    for (; j + 16 <= cols - 1; j += 16) {
+        Sse2Block left, mid, right;
+        sse2Load(src + j - 1, left);
+        sse2Load(src + j, mid);
+        sse2Load(src + j + 1, right);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + j), sse2Taps3(left.lo, mid.lo, right.lo, taps));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + j + 8), sse2Taps3(left.hi, mid.hi, right.hi, taps));
+    }
+    return j;
+}
+
+__attribute__((target("sse2")))
+inline __m128i sse2Vertical(const int16_t* const window[3], int j, const int16_t* column) {
+    return sse2Taps3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(window[0] + j)),
+                     _mm_loadu_si128(reinterpret_cast<const __m128i*>(window[1] + j)),
+                     _mm_loadu_si128(reinterpret_cast<const __m128i*>(window[2] + j)), column);
+}
+
+__attribute__((target("sse2")))
+int sse2VerticalXYRow(const int16_t* const windowX[3], const int16_t* const windowY[3], uchar* out, int cols,
+                      const int16_t* columnX, const int16_t* columnY, uchar threshold) {
+    const __m128i thresholdVec = _mm_set1_epi16(threshold);
+    int j = 0;
+    for (; j + 16 <= cols; j += 16) {
+        __m128i lo = _mm_srli_epi16(_mm_add_epi16(sse2AbsClamp(sse2Vertical(windowX, j, columnX)), sse2AbsClamp(sse2Vertical(windowY, j, columnY))), 1);
+        __m128i hi = _mm_srli_epi16(_mm_add_epi16(sse2AbsClamp(sse2Vertical(windowX, j + 8, columnX)), sse2AbsClamp(sse2Vertical(windowY, j + 8, columnY))), 1);
+        lo = sse2Threshold(lo, thresholdVec);
+        hi = sse2Threshold(hi, thresholdVec);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + j), _mm_packus_epi16(lo, hi));
+    }
+    return j;
+}
+
+__attribute__((target("sse2")))
+int sse2VerticalSingleRow(const int16_t* const window[3], uchar* out, int cols, const int16_t* column, uchar threshold) {
+    const __m128i thresholdVec = _mm_set1_epi16(threshold);
+    int j = 0;
+    for (; j + 16 <= cols; j += 16) {
+        __m128i lo = sse2Threshold(sse2AbsClamp(sse2Vertical(window, j, column)), thresholdVec);
+        __m128i hi = sse2Threshold(sse2AbsClamp(sse2Vertical(window, j + 8, column)), thresholdVec);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + j), _mm_packus_epi16(lo, hi));
+    }
+    return j;
+}
+
+__attribute__((target("sse2")))
+inline __m128 sse2Select(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Thinning of four pixels: gathers the neighbour pair of every direction, keeps the pair the
+// direction codes select and returns 0, 1 or 2 per int32 lane. Only the diagonals (odd codes)
+// require the second neighbour to be strictly smaller as well.
+__attribute__((target("sse2")))
+inline __m128i sse2SuppressNonMaxima(const float* above, const float* center, const float* below, __m128i direction, int j,
+                                     __m128 low, __m128 high) {
+    const __m128 horizontal = _mm_castsi128_ps(_mm_cmpeq_epi32(direction, _mm_setzero_si128()));
+    const __m128 diagonal = _mm_castsi128_ps(_mm_cmpeq_epi32(direction, _mm_set1_epi32(1)));
+    const __m128 vertical = _mm_castsi128_ps(_mm_cmpeq_epi32(direction, _mm_set1_epi32(2)));
+    const __m128 strict = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(direction, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+
+    __m128 first = sse2Select(diagonal, _mm_loadu_ps(above + j + 1), _mm_loadu_ps(above + j - 1));
+    first = sse2Select(vertical, _mm_loadu_ps(above + j), first);
+    first = sse2Select(horizontal, _mm_loadu_ps(center + j - 1), first);
+    __m128 second = sse2Select(diagonal, _mm_loadu_ps(below + j - 1), _mm_loadu_ps(below + j + 1));
+    second = sse2Select(vertical, _mm_loadu_ps(below + j), second);
+    second = sse2Select(horizontal, _mm_loadu_ps(center + j + 1), second);
+
+    const __m128 m = _mm_loadu_ps(center + j);
+    const __m128 secondSmaller = sse2Select(strict, _mm_cmpgt_ps(m, second), _mm_cmpge_ps(m, second));
+    const __m128 keep = _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(m, first), secondSmaller), _mm_cmpgt_ps(m, low));
+    const __m128 strong = _mm_and_ps(keep, _mm_cmpgt_ps(m, high));
+    // the masks are -1, so subtracting both counts 1 for weak and 2 for strong
+    return _mm_sub_epi32(_mm_sub_epi32(_mm_setzero_si128(), _mm_castps_si128(keep)), _mm_castps_si128(strong));
+}
+
+__attribute__((target("sse2")))
+int sse2SuppressNonMaximaRow(const float* above, const float* center, const float* below, const uchar* direction, uchar* out,
+                             int cols, float low, float high) {
+    const __m128 lowVec = _mm_set1_ps(low);
+    const __m128 highVec = _mm_set1_ps(high);
+    int j = 1;
+    for (; j + 8 <= cols - 1; j += 8) {
+        const __m128i codes = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(direction + j)), _mm_setzero_si128());
+        const __m128i lo = sse2SuppressNonMaxima(above, center, below, _mm_unpacklo_epi16(codes, _mm_setzero_si128()), j, lowVec, highVec);
+        const __m128i hi = sse2SuppressNonMaxima(above, center, below, _mm_unpackhi_epi16(codes, _mm_setzero_si128()), j + 4, lowVec, highVec);
+        const __m128i states = _mm_packs_epi32(lo, hi);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + j), _mm_packus_epi16(states, states));
+    }
+    return j;
+}
+
+// 32 pixels per iteration: each 32-byte load is widened into two 16-lane int16 halves.
+struct Avx2Block {
+    __m256i lo, hi;
+};
+
+__attribute__((target("avx2")))
+inline void avx2Load(const uchar* src, Avx2Block& block) {
+    __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+    block.lo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(bytes));
+    block.hi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(bytes, 1));
+}
+
+__attribute__((target("avx2")))
+inline void avx2Accumulate(Avx2Block& acc, const Avx2Block taps[9], const int16_t* kernel) {
+    acc.lo = _mm256_setzero_si256();
+    acc.hi = _mm256_setzero_si256();
+    for (int t = 0; t < 9; ++t) {
+        if (kernel[t] == 0) {
+            continue;
+        }
+        const __m256i k = _mm256_set1_epi16(kernel[t]);
+        acc.lo = _mm256_add_epi16(acc.lo, _mm256_mullo_epi16(taps[t].lo, k));
+        acc.hi = _mm256_add_epi16(acc.hi, _mm256_mullo_epi16(taps[t].hi, k));
+    }
+}
+
+__attribute__((target("avx2")))
+inline __m256i avx2AbsClamp(__m256i x) {
+    return _mm256_min_epi16(_mm256_abs_epi16(x), _mm256_set1_epi16(255));
+}
+
+__attribute__((target("avx2")))
+inline __m256i avx2Threshold(__m256i x, __m256i threshold) {
+    return _mm256_andnot_si256(_mm256_cmpgt_epi16(threshold, x), x);
+}
+
+// packus works per 128-bit lane, so restore pixel order after packing
+__attribute__((target("avx2")))
+inline void avx2Store(uchar* dst, __m256i lo, __m256i hi) {
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), packed);
+}
+
+__attribute__((target("avx2")))
+inline void avx2LoadTaps(const uchar* above, const uchar* center, const uchar* below, int j, Avx2Block taps[9]) {
+    const uchar* rows[3] = {above, center, below};
+    for (int r = 0; r < 3; ++r) {
+        avx2Load(rows[r] + j - 1, taps[r * 3 + 0]);
+        avx2Load(rows[r] + j    , taps[r * 3 + 1]);
+        avx2Load(rows[r] + j + 1, taps[r * 3 + 2]);
+    }
+}
+
+__attribute__((target("avx2")))
+int avx2XYGradientRow(const uchar* above, const uchar* center, const uchar* below, uchar* out, int cols,
+                      const int16_t* kernelX, const int16_t* kernelY, uchar threshold) {
+    const __m256i thresholdVec = _mm256_set1_epi16(threshold);
+    int j = 1;
+    for (; j + 32 <= cols - 1; j += 32) {
+        Avx2Block taps[9], gx, gy;
+        avx2LoadTaps(above, center, below, j, taps);
+        avx2Accumulate(gx, taps, kernelX);
+        avx2Accumulate(gy, taps, kernelY);
+
+        __m256i lo = _mm256_srli_epi16(_mm256_add_epi16(avx2AbsClamp(gx.lo), avx2AbsClamp(gy.lo)), 1);
+        __m256i hi = _mm256_srli_epi16(_mm256_add_epi16(avx2AbsClamp(gx.hi), avx2AbsClamp(gy.hi)), 1);
+
+        avx2Store(out + j, avx2Threshold(lo, thresholdVec), avx2Threshold(hi, thresholdVec));
+    }
+    // finish the tail with the 16-wide kernel
+    return j - 1 + sse2XYGradientRow(above + j - 1, center + j - 1, below + j - 1, out + j - 1, cols - j + 1, kernelX, kernelY, threshold);
+}
+
+__attribute__((target("avx2")))
+int avx2SingleGradientRow(const uchar* above, const uchar* center, const uchar* below, uchar* out, int cols,
+                          const int16_t* kernel, uchar threshold) {
+    const __m256i thresholdVec = _mm256_set1_epi16(threshold);
+    int j = 1;
+    for (; j + 32 <= cols - 1; j += 32) {
+        Avx2Block taps[9], g;
+        avx2LoadTaps(above, center, below, j, taps);
+        avx2Accumulate(g, taps, kernel);
+
+        avx2Store(out + j, avx2Threshold(avx2AbsClamp(g.lo), thresholdVec), avx2Threshold(avx2AbsClamp(g.hi), thresholdVec));
+    }
+    return j - 1 + sse2SingleGradientRow(above + j - 1, center + j - 1, below + j - 1, out + j - 1, cols - j + 1, kernel, threshold);
+}
+
+// 16 pixels at column j, as sse2GradientField
+__attribute__((target("avx2")))
+inline __m256i avx2GradientField(__m256i gx, __m256i gy, const GradientRow& out, int j, GradientNorm norm) {
+    if (out.gx) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.gx + j), gx);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.gy + j), gy);
+    }
+
+    const __m256i ax = _mm256_abs_epi16(gx);
+    const __m256i ay = _mm256_abs_epi16(gy);
+
+    if (out.magnitude) {
+        __m256 first, second;
+        if (norm == GradientNorm::L1) {
+            const __m256i sum = _mm256_add_epi16(ax, ay);
+            first = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(sum)));
+            second = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(sum, 1)));
+        } else {
+            // unpacking works per 128-bit lane: pixels 0-3 and 8-11, then 4-7 and 12-15
+            const __m256i pairsLo = _mm256_unpacklo_epi16(gx, gy);
+            const __m256i pairsHi = _mm256_unpackhi_epi16(gx, gy);
+            const __m256i squaresLo = _mm256_madd_epi16(pairsLo, pairsLo);
+            const __m256i squaresHi = _mm256_madd_epi16(pairsHi, pairsHi);
+            first = _mm256_sqrt_ps(_mm256_cvtepi32_ps(_mm256_permute2x128_si256(squaresLo, squaresHi, 0x20)));
+            second = _mm256_sqrt_ps(_mm256_cvtepi32_ps(_mm256_permute2x128_si256(squaresLo, squaresHi, 0x31)));
+        }
+        _mm256_storeu_ps(out.magnitude + j, first);
+        _mm256_storeu_ps(out.magnitude + j + 8, second);
+    }
+
+    const __m256i tan22 = _mm256_mulhi_epi16(ax, _mm256_set1_epi16(TAN_22_5_Q16));
+    const __m256i notHorizontal = _mm256_cmpgt_epi16(ay, tan22);
+    const __m256i vertical = _mm256_cmpgt_epi16(_mm256_subs_epi16(_mm256_subs_epi16(ay, ax), ax), tan22);
+    const __m256i opposite = _mm256_srai_epi16(_mm256_xor_si256(gx, gy), 15);
+
+    __m256i direction = _mm256_or_si256(_mm256_set1_epi16(1), _mm256_and_si256(opposite, _mm256_set1_epi16(2)));
+    direction = _mm256_and_si256(notHorizontal, direction);
+    return _mm256_blendv_epi8(direction, _mm256_set1_epi16(2), vertical);
+}
+
+__attribute__((target("avx2")))
+int avx2GradientFieldRow(const uchar* above, const uchar* center, const uchar* below, const GradientRow& out, int cols,
+                         const int16_t* kernelX, const int16_t* kernelY, GradientNorm norm) {
+    int j = 1;
+    for (; j + 32 <= cols - 1; j += 32) {
+        Avx2Block taps[9], gx, gy;
+        avx2LoadTaps(above, center, below, j, taps);
+        avx2Accumulate(gx, taps, kernelX);
+        avx2Accumulate(gy, taps, kernelY);
+
+        __m256i lo = avx2GradientField(gx.lo, gy.lo, out, j, norm);
+        __m256i hi = avx2GradientField(gx.hi, gy.hi, out, j + 16, norm);
+        if (out.orientation) {
+            avx2Store(out.orientation + j, lo, hi);
+        }
+    }
+    return j - 1 + sse2GradientFieldRow(above + j - 1, center + j - 1, below + j - 1, out.shifted(j - 1), cols - j + 1, kernelX, kernelY, norm);
+}
+
+__attribute__((target("avx2")))
+inline __m256i avx2Taps3(__m256i a, __m256i b, __m256i c, const int16_t* taps) {
+    __m256i acc = _mm256_setzero_si256();
+    if (taps[0]) acc = _mm256_add_epi16(acc, _mm256_mullo_epi16(a, _mm256_set1_epi16(taps[0])));
+    if (taps[1]) acc = _mm256_add_epi16(acc, _mm256_mullo_epi16(b, _mm256_set1_epi16(taps[1])));
+    if (taps[2]) acc = _mm256_add_epi16(acc, _mm256_mullo_epi16(c, _mm256_set1_epi16(taps[2])));
+    return acc;
+}
+
+__attribute__((target("avx2")))
+int avx2HorizontalRow(const uchar* src, int16_t* dst, int cols, const int16_t* taps) {
+    int j = 1;
+    for (; j + 32 <= cols - 1; j += 32) {
+        Avx2Block left, mid, right;
+        avx2Load(src + j - 1, left);
+        avx2Load(src + j, mid);
+        avx2Load(src + j + 1, right);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + j), avx2Taps3(left.lo, mid.lo, right.lo, taps));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + j + 16), avx2Taps3(left.hi, mid.hi, right.hi, taps));
+    }
+    return j - 1 + sse2HorizontalRow(src + j - 1, dst + j - 1, cols - j + 1, taps);
+}
+
+__attribute__((target("avx2")))
+inline __m256i avx2Vertical(const int16_t* const window[3], int j, const int16_t* column) {
+    return avx2Taps3(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(window[0] + j)),
+                     _mm256_loadu_si256(reinterpret_cast<const __m256i*>(window[1] + j)),
+                     _mm256_loadu_si256(reinterpret_cast<const __m256i*>(window[2] + j)), column);
+}
+
+__attribute__((target("avx2")))
+int avx2VerticalXYRow(const int16_t* const windowX[3], const int16_t* const windowY[3], uchar* out, int cols,
+                      const int16_t* columnX, const int16_t* columnY, uchar threshold) {
+    const __m256i thresholdVec = _mm256_set1_epi16(threshold);
+    int j = 0;
+    for (; j + 32 <= cols; j += 32) {
+        __m256i lo = _mm256_srli_epi16(_mm256_add_epi16(avx2AbsClamp(avx2Vertical(windowX, j, columnX)), avx2AbsClamp(avx2Vertical(windowY, j, columnY))), 1);
+        __m256i hi = _mm256_srli_epi16(_mm256_add_epi16(avx2AbsClamp(avx2Vertical(windowX, j + 16, columnX)), avx2AbsClamp(avx2Vertical(windowY, j + 16, columnY))), 1);
+        avx2Store(out + j, avx2Threshold(lo, thresholdVec), avx2Threshold(hi, thresholdVec));
+    }
+    return j;
+}
+
+__attribute__((target("avx2")))
+int avx2VerticalSingleRow(const int16_t* const window[3], uchar* out, int cols, const int16_t* column, uchar threshold) {
+    const __m256i thresholdVec = _mm256_set1_epi16(threshold);
+    int j = 0;
+    for (; j + 32 <= cols; j += 32) {
+        avx2Store(out + j, avx2Threshold(avx2AbsClamp(avx2Vertical(window, j, column)), thresholdVec),
+                  avx2Threshold(avx2AbsClamp(avx2Vertical(window, j + 16, column)), thresholdVec));
+    }
+    return j;
+}
+
+__attribute__((target("avx2")))
+inline __m256i avx2SuppressNonMaxima(const float* above, const float* center, const float* below, __m256i direction, int j,
+                                     __m256 low, __m256 high) {
+    const __m256 horizontal = _mm256_castsi256_ps(_mm256_cmpeq_epi32(direction, _mm256_setzero_si256()));
+    const __m256 diagonal = _mm256_castsi256_ps(_mm256_cmpeq_epi32(direction, _mm256_set1_epi32(1)));
+    const __m256 vertical = _mm256_castsi256_ps(_mm256_cmpeq_epi32(direction, _mm256_set1_epi32(2)));
+    const __m256 strict = _mm256_castsi256_ps(_mm256_slli_epi32(direction, 31));
+
+    __m256 first = _mm256_blendv_ps(_mm256_loadu_ps(above + j - 1), _mm256_loadu_ps(above + j + 1), diagonal);
+    first = _mm256_blendv_ps(first, _mm256_loadu_ps(above + j), vertical);
+    first = _mm256_blendv_ps(first, _mm256_loadu_ps(center + j - 1), horizontal);
+    __m256 second = _mm256_blendv_ps(_mm256_loadu_ps(below + j + 1), _mm256_loadu_ps(below + j - 1), diagonal);
+    second = _mm256_blendv_ps(second, _mm256_loadu_ps(below + j), vertical);
+    second = _mm256_blendv_ps(second, _mm256_loadu_ps(center + j + 1), horizontal);
+
+    const __m256 m = _mm256_loadu_ps(center + j);
+    const __m256 secondSmaller = _mm256_blendv_ps(_mm256_cmp_ps(m, second, _CMP_GE_OQ), _mm256_cmp_ps(m, second, _CMP_GT_OQ), strict);
+    const __m256 keep = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(m, first, _CMP_GT_OQ), secondSmaller), _mm256_cmp_ps(m, low, _CMP_GT_OQ));
+    const __m256 strong = _mm256_and_ps(keep, _mm256_cmp_ps(m, high, _CMP_GT_OQ));
+    return _mm256_sub_epi32(_mm256_sub_epi32(_mm256_setzero_si256(), _mm256_castps_si256(keep)), _mm256_castps_si256(strong));
+}
+
+__attribute__((target("avx2")))
+int avx2SuppressNonMaximaRow(const float* above, const float* center, const float* below, const uchar* direction, uchar* out,
+                             int cols, float low, float high) {
+    const __m256 lowVec = _mm256_set1_ps(low);
+    const __m256 highVec = _mm256_set1_ps(high);
+    int j = 1;
+    for (; j + 16 <= cols - 1; j += 16) {
+        const __m128i codes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(direction + j));
+        const __m256i lo = avx2SuppressNonMaxima(above, center, below, _mm256_cvtepu8_epi32(codes), j, lowVec, highVec);
+        const __m256i hi = avx2SuppressNonMaxima(above, center, below, _mm256_cvtepu8_epi32(_mm_srli_si128(codes, 8)), j + 8, lowVec, highVec);
+        // packs works within 128-bit lanes; the permute restores pixel order
+        const __m256i states = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + j),
+                         _mm_packus_epi16(_mm256_castsi256_si128(states), _mm256_extracti128_si256(states, 1)));
+    }
+    return j;
+}
+
+__attribute__((target("avx2")))
+void avx2AccumulateRow(uint32_t* sums, const uchar* src, uint32_t tap, int count) {
+    accumulateLoop(sums, src, tap, count);
+}
+
+__attribute__((target("avx2")))
+void avx2AccumulateSumsRow(uint32_t* sums, const uint32_t* src, uint32_t tap, int count) {
+    accumulateLoop(sums, src, tap, count);
+}
+
+__attribute__((target("avx2")))
+void avx2SlideRow(uint32_t* sums, const uchar* entering, const uchar* leaving, int count) {
+    slideLoop(sums, entering, leaving, count);
+}
+
+__attribute__((target("avx2")))
+void avx2DivideRow(const uint32_t* sums, uchar* out, int count, const FixedPointDivisor& divide) {
+    divideLoop(sums, out, count, divide);
+}
+
+__attribute__((target("avx2")))
+void avx2PyramidDownRow(const uchar* const window[5], uchar* out, int srcCols, uint16_t* sums) {
+    pyramidDownLoop(window, out, srcCols, sums);
+}
+
+// Two lanes per register: mul_epu32 multiplies the low halves of each lane by the high halves
+// moved down, and the 64-bit halves of the data are swapped to land on the neighbouring lane.
+__attribute__((target("sse2")))
+void sse2HashStripes(uint64_t* lanes, const uchar* data, int stripes, const uchar* secret) {
+    __m128i acc[4];
+    for (int i = 0; i < 4; ++i) {
+        acc[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lanes) + i);
+    }
+    for (int s = 0; s < stripes; ++s) {
+        for (int i = 0; i < 4; ++i) {
+            const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 64 * s) + i);
+            const __m128i keyed = _mm_xor_si128(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret + 8 * s) + i));
+            const __m128i product = _mm_mul_epu32(keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+            acc[i] = _mm_add_epi64(acc[i], _mm_add_epi64(product, _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2))));
+        }
+    }
+    for (int i = 0; i < 4; ++i) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes) + i, acc[i]);
+    }
+}
+
+// Same as the SSE2 stripes with four lanes per register; the shuffles stay within 128-bit lanes.
+__attribute__((target("avx2")))
+void avx2HashStripes(uint64_t* lanes, const uchar* data, int stripes, const uchar* secret) {
+    __m256i acc[2];
+    for (int i = 0; i < 2; ++i) {
+        acc[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes) + i);
+    }
+    for (int s = 0; s < stripes; ++s) {
+        for (int i = 0; i < 2; ++i) {
+            const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 64 * s) + i);
+            const __m256i keyed = _mm256_xor_si256(value, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(secret + 8 * s) + i));
+            const __m256i product = _mm256_mul_epu32(keyed, _mm256_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+            acc[i] = _mm256_add_epi64(acc[i], _mm256_add_epi64(product, _mm256_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2))));
+        }
+    }
+    for (int i = 0; i < 2; ++i) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes) + i, acc[i]);
+    }
+}
+
+#endif // IMAGE_FILTERS_X86
+
+#if defined(__ARM_NEON)
+
+// 16 pixels per iteration: each 16-byte load is widened into two 8-lane int16 halves.
+struct NeonBlock {
+    int16x8_t lo, hi;
+};
+
+inline void neonLoad(const uchar* src, NeonBlock& block) {
+    uint8x16_t bytes = vld1q_u8(src);
+    block.lo = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(bytes)));
+    block.hi = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(bytes)));
+}
+
+inline void neonLoadTaps(const uchar* above, const uchar* center, const uchar* below, int j, NeonBlock taps[9]) {
+    const uchar* rows[3] = {above, center, below};
+    for (int r = 0; r < 3; ++r) {
+        neonLoad(rows[r] + j - 1, taps[r * 3 + 0]);
+        neonLoad(rows[r] + j    , taps[r * 3 + 1]);
+        neonLoad(rows[r] + j + 1, taps[r * 3 + 2]);
+    }
+}
+
+inline void neonAccumulate(NeonBlock& acc, const NeonBlock taps[9], const int16_t* kernel) {
+    acc.lo = vdupq_n_s16(0);
+    acc.hi = vdupq_n_s16(0);
+    for (int t = 0; t < 9; ++t) {
+        if (kernel[t] == 0) {
+            continue;
+        }
+        acc.lo = vmlaq_n_s16(acc.lo, taps[t].lo, kernel[t]);
+        acc.hi = vmlaq_n_s16(acc.hi, taps[t].hi, kernel[t]);
+    }
+}
+
+inline int16x8_t neonAbsClamp(int16x8_t x) {
+    return vminq_s16(vabsq_s16(x), vdupq_n_s16(255));
+}
+
+inline int16x8_t neonThreshold(int16x8_t x, int16x8_t threshold) {
+    return vbicq_s16(x, vreinterpretq_s16_u16(vcltq_s16(x, threshold)));
+}
+
+int neonXYGradientRow(const uchar* above, const uchar* center, const uchar* below, uchar* out, int cols,
+                      const int16_t* kernelX, const int16_t* kernelY, uchar threshold) {
+    const int16x8_t thresholdVec = vdupq_n_s16(threshold);
+    int j = 1;
+    for (; j + 16 <= cols - 1; j += 16) {
+        NeonBlock taps[9], gx, gy;
+        neonLoadTaps(above, center, below, j, taps);
+        neonAccumulate(gx, taps, kernelX);
+        neonAccumulate(gy, taps, kernelY);
+
+        int16x8_t lo = vshrq_n_s16(vaddq_s16(neonAbsClamp(gx.lo), neonAbsClamp(gy.lo)), 1);
+        int16x8_t hi = vshrq_n_s16(vaddq_s16(neonAbsClamp(gx.hi), neonAbsClamp(gy.hi)), 1);
+        lo = neonThreshold(lo, thresholdVec);
+        hi = neonThreshold(hi, thresholdVec);
+
+        vst1q_u8(out + j, vcombine_u8(vqmovun_s16(lo), vqmovun_s16(hi)));
+    }
+    return j;
+}
+
+int neonSingleGradientRow(const uchar* above, const uchar* center, const uchar* below, uchar* out, int cols,
+                          const int16_t* kernel, uchar threshold) {
+    const int16x8_t thresholdVec = vdupq_n_s16(threshold);
+    int j = 1;
+    for (; j + 16 <= cols - 1; j += 16) {
+        NeonBlock taps[9], g;
+        neonLoadTaps(above, center, below, j, taps);
+        neonAccumulate(g, taps, kernel);
+
+        int16x8_t lo = neonThreshold(neonAbsClamp(g.lo), thresholdVec);
+        int16x8_t hi = neonThreshold(neonAbsClamp(g.hi), thresholdVec);
+
+        vst1q_u8(out + j, vcombine_u8(vqmovun_s16(lo), vqmovun_s16(hi)));
+    }
+    return j;
+}
+
+// 8 pixels at column j, as sse2GradientField
+inline int16x8_t neonGradientField(int16x8_t gx, int16x8_t gy, const GradientRow& out, int j, GradientNorm norm) {
+    if (out.gx) {
+        vst1q_s16(out.gx + j, gx);
+        vst1q_s16(out.gy + j, gy);
+    }
+
+    const int16x8_t ax = vabsq_s16(gx);
+    const int16x8_t ay = vabsq_s16(gy);
+
+    if (out.magnitude) {
+        float32x4_t lo, hi;
+        if (norm == GradientNorm::L1) {
+            const uint16x8_t sum = vaddq_u16(vreinterpretq_u16_s16(ax), vreinterpretq_u16_s16(ay));
+            lo = vcvtq_f32_u32(vmovl_u16(vget_low_u16(sum)));
+            hi = vcvtq_f32_u32(vmovl_u16(vget_high_u16(sum)));
+        } else {
+            lo = vcvtq_f32_s32(vmlal_s16(vmull_s16(vget_low_s16(gx), vget_low_s16(gx)), vget_low_s16(gy), vget_low_s16(gy)));
+            hi = vcvtq_f32_s32(vmlal_s16(vmull_s16(vget_high_s16(gx), vget_high_s16(gx)), vget_high_s16(gy), vget_high_s16(gy)));
+#if defined(__aarch64__)
+            lo = vsqrtq_f32(lo);
+            hi = vsqrtq_f32(hi);
+#endif
+        }
+        vst1q_f32(out.magnitude + j, lo);
+        vst1q_f32(out.magnitude + j + 4, hi);
+#if !defined(__aarch64__)
+        if (norm == GradientNorm::L2) {
+            for (int k = 0; k < 8; ++k) {
+                out.magnitude[j + k] = std::sqrt(out.magnitude[j + k]);
+            }
+        }
+#endif
+    }
+
+    // vqdmulh doubles the product, so half the constant gives (a * TAN_22_5_Q16) >> 16
+    const int16x8_t tan22 = vqdmulhq_s16(ax, vdupq_n_s16(TAN_22_5_Q16 / 2));
+    const uint16x8_t notHorizontal = vcgtq_s16(ay, tan22);
+    const uint16x8_t vertical = vcgtq_s16(vqsubq_s16(vqsubq_s16(ay, ax), ax), tan22);
+    const int16x8_t opposite = vshrq_n_s16(veorq_s16(gx, gy), 15);
+
+    int16x8_t direction = vorrq_s16(vdupq_n_s16(1), vandq_s16(opposite, vdupq_n_s16(2)));
+    direction = vandq_s16(direction, vreinterpretq_s16_u16(notHorizontal));
+    return vbslq_s16(vertical, vdupq_n_s16(2), direction);
+}
+
+int neonGradientFieldRow(const uchar* above, const uchar* center, const uchar* below, const GradientRow& out, int cols,
+                         const int16_t* kernelX, const int16_t* kernelY, GradientNorm norm) {
+    int j = 1;
+    for (; j + 16 <= cols - 1; j += 16) {
+        NeonBlock taps[9], gx, gy;
+        neonLoadTaps(above, center, below, j, taps);
+        neonAccumulate(gx, taps, kernelX);
+        neonAccumulate(gy, taps, kernelY);
+
+        int16x8_t lo = neonGradientField(gx.lo, gy.lo, out, j, norm);
+        int16x8_t hi = neonGradientField(gx.hi, gy.hi, out, j + 8, norm);
+        if (out.orientation) {
+            vst1q_u8(out.orientation + j, vcombine_u8(vqmovun_s16(lo), vqmovun_s16(hi)));
+        }
+    }
+    return j;
+}
+
+inline int16x8_t neonTaps3(int16x8_t a, int16x8_t b, int16x8_t c, const int16_t* taps) {
+    int16x8_t acc = vdupq_n_s16(0);
+    if (taps[0]) acc = vmlaq_n_s16(acc, a, taps[0]);
+    if (taps[1]) acc = vmlaq_n_s16(acc, b, taps[1]);
+    if (taps[2]) acc = vmlaq_n_s16(acc, c, taps[2]);
+    return acc;
+}
+
+inline uint32x4_t neonSuppressNonMaxima(const float* above, const float* center, const float* below, uint32x4_t direction, int j,
+                                        float32x4_t low, float32x4_t high) {
+    const uint32x4_t horizontal = vceqq_u32(direction, vdupq_n_u32(0));
+    const uint32x4_t diagonal = vceqq_u32(direction, vdupq_n_u32(1));
+    const uint32x4_t vertical = vceqq_u32(direction, vdupq_n_u32(2));
+    const uint32x4_t strict = vtstq_u32(direction, vdupq_n_u32(1));
+
+    float32x4_t first = vbslq_f32(diagonal, vld1q_f32(above + j + 1), vld1q_f32(above + j - 1));
+    first = vbslq_f32(vertical, vld1q_f32(above + j), first);
+    first = vbslq_f32(horizontal, vld1q_f32(center + j - 1), first);
+    float32x4_t second = vbslq_f32(diagonal, vld1q_f32(below + j - 1), vld1q_f32(below + j + 1));
+    second = vbslq_f32(vertical, vld1q_f32(below + j), second);
+    second = vbslq_f32(horizontal, vld1q_f32(center + j + 1), second);
+
+    const float32x4_t m = vld1q_f32(center + j);
+    const uint32x4_t secondSmaller = vbslq_u32(strict, vcgtq_f32(m, second), vcgeq_f32(m, second));
+    const uint32x4_t keep = vandq_u32(vandq_u32(vcgtq_f32(m, first), secondSmaller), vcgtq_f32(m, low));
+    const uint32x4_t strong = vandq_u32(keep, vcgtq_f32(m, high));
+    return vsubq_u32(vsubq_u32(vdupq_n_u32(0), keep), strong);
+}
+
+int neonSuppressNonMaximaRow(const float* above, const float* center, const float* below, const uchar* direction, uchar* out,
+                             int cols, float low, float high) {
+    const float32x4_t lowVec = vdupq_n_f32(low);
+    const float32x4_t highVec = vdupq_n_f32(high);
+    int j = 1;
+    for (; j + 8 <= cols - 1; j += 8) {
+        const uint16x8_t codes = vmovl_u8(vld1_u8(direction + j));
+        const uint32x4_t lo = neonSuppressNonMaxima(above, center, below, vmovl_u16(vget_low_u16(codes)), j, lowVec, highVec);
+        const uint32x4_t hi = neonSuppressNonMaxima(above, center, below, vmovl_u16(vget_high_u16(codes)), j + 4, lowVec, highVec);
+        vst1_u8(out + j, vmovn_u16(vcombine_u16(vmovn_u32(lo), vmovn_u32(hi))));
+    }
+    return j;
+}
+
+int neonHorizontalRow(const uchar* src, int16_t* dst, int cols, const int16_t* taps) {
+    int j = 1;
+    for (; j + 16 <= cols - 1; j += 16) {
+        NeonBlock left, mid, right;
+        neonLoad(src + j - 1, left);
+        neonLoad(src + j, mid);
+        neonLoad(src + j + 1, right);
+        vst1q_s16(dst + j, neonTaps3(left.lo, mid.lo, right.lo, taps));
+        vst1q_s16(dst + j + 8, neonTaps3(left.hi, mid.hi, right.hi, taps));
+    }
+    return j;
+}
+
+inline int16x8_t neonVertical(const int16_t* const window[3], int j, const int16_t* column) {
+    return neonTaps3(vld1q_s16(window[0] + j), vld1q_s16(window[1] + j), vld1q_s16(window[2] + j), column);
+}
+
+int neonVerticalXYRow(const int16_t* const windowX[3], const int16_t* const windowY[3], uchar* out, int cols,
+                      const int16_t* columnX, const int16_t* columnY, uchar threshold) {
+    const int16x8_t thresholdVec = vdupq_n_s16(threshold);
+    int j = 0;
+    for (; j + 16 <= cols; j += 16) {
+        int16x8_t lo = vshrq_n_s16(vaddq_s16(neonAbsClamp(neonVertical(windowX, j, columnX)), neonAbsClamp(neonVertical(windowY, j, columnY))), 1);
+        int16x8_t hi = vshrq_n_s16(vaddq_s16(neonAbsClamp(neonVertical(windowX, j + 8, columnX)), neonAbsClamp(neonVertical(windowY, j + 8, columnY))), 1);
+        vst1q_u8(out + j, vcombine_u8(vqmovun_s16(neonThreshold(lo, thresholdVec)), vqmovun_s16(neonThreshold(hi, thresholdVec))));
+    }
+    return j;
+}
+
+int neonVerticalSingleRow(const int16_t* const window[3], uchar* out, int cols, const int16_t* column, uchar threshold) {
+    const int16x8_t thresholdVec = vdupq_n_s16(threshold);
+    int j = 0;
+    for (; j + 16 <= cols; j += 16) {
+        int16x8_t lo = neonThreshold(neonAbsClamp(neonVertical(window, j, column)), thresholdVec);
+        int16x8_t hi = neonThreshold(neonAbsClamp(neonVertical(window, j + 8, column)), thresholdVec);
+        vst1q_u8(out + j, vcombine_u8(vqmovun_s16(lo), vqmovun_s16(hi)));
+    }
+    return j;
+}
+
+void neonHashStripes(uint64_t* lanes, const uchar* data, int stripes, const uchar* secret) {
+    uint64x2_t acc[4];
+    for (int i = 0; i < 4; ++i) {
+        acc[i] = vld1q_u64(lanes + 2 * i);
+    }
+    for (int s = 0; s < stripes; ++s) {
+        for (int i = 0; i < 4; ++i) {
+            const uint64x2_t value = vreinterpretq_u64_u8(vld1q_u8(data + 64 * s + 16 * i));
+            const uint64x2_t keyed = veorq_u64(value, vreinterpretq_u64_u8(vld1q_u8(secret + 8 * s + 16 * i)));
+            const uint64x2_t product = vmull_u32(vmovn_u64(keyed), vshrn_n_u64(keyed, 32));
+            acc[i] = vaddq_u64(acc[i], vaddq_u64(product, vextq_u64(value, value, 1)));
+        }
+    }
+    for (int i = 0; i < 4; ++i) {
+        vst1q_u64(lanes + 2 * i, acc[i]);
+    }
+}
+
+#endif // __ARM_NEON
+
+#define PORTABLE_FIXED_POINT_ROWS portableAccumulateRow, portableAccumulateSumsRow, portableSlideRow, portableDivideRow
+
+const SimdKernelSet SCALAR_KERNELS = {"scalar", scalarXYGradientRow, scalarSingleGradientRow, scalarGradientFieldRow, scalarSuppressNonMaximaRow,
+                                      scalarHorizontalRow, scalarVerticalXYRow, scalarVerticalSingleRow,
+                                      PORTABLE_FIXED_POINT_ROWS, scalarHashStripes, portablePyramidDownRow};
+#ifdef IMAGE_FILTERS_X86
+const SimdKernelSet SSE2_KERNELS = {"sse2", sse2XYGradientRow, sse2SingleGradientRow, sse2GradientFieldRow, sse2SuppressNonMaximaRow,
+                                    sse2HorizontalRow, sse2VerticalXYRow, sse2VerticalSingleRow,
+                                    PORTABLE_FIXED_POINT_ROWS, sse2HashStripes, portablePyramidDownRow};
+const SimdKernelSet AVX2_KERNELS = {"avx2", avx2XYGradientRow, avx2SingleGradientRow, avx2GradientFieldRow, avx2SuppressNonMaximaRow,
+                                    avx2HorizontalRow, avx2VerticalXYRow, avx2VerticalSingleRow,
+                                    avx2AccumulateRow, avx2AccumulateSumsRow, avx2SlideRow, avx2DivideRow, avx2HashStripes, avx2PyramidDownRow};
+#endif
+#if defined(__ARM_NEON)
+const SimdKernelSet NEON_KERNELS = {"neon", neonXYGradientRow, neonSingleGradientRow, neonGradientFieldRow, neonSuppressNonMaximaRow,
+                                    neonHorizontalRow, neonVerticalXYRow, neonVerticalSingleRow,
+                                    PORTABLE_FIXED_POINT_ROWS, neonHashStripes, portablePyramidDownRow};
+#endif
+
+const SimdKernelSet& selectSimdKernels() {
+    auto supported = supportedSimdKernels();
+
+    if (const char* requested = std::getenv("IMAGE_FILTERS_SIMD")) {
+        for (const SimdKernelSet* kernels : supported) {
+            if (std::strcmp(kernels->name, requested) == 0) {
+                return *kernels;
+            }
+        }
+    }
+
+    return *supported.front();
+}
+
+} // namespace
+
+
+std::vector<const SimdKernelSet*> supportedSimdKernels() {
+    std::vector<const SimdKernelSet*> supported;
+
+#ifdef IMAGE_FILTERS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        supported.push_back(&AVX2_KERNELS);
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        supported.push_back(&SSE2_KERNELS);
+    }
+#endif
+#if defined(__ARM_NEON)
+    supported.push_back(&NEON_KERNELS);
+#endif
+
+    supported.push_back(&SCALAR_KERNELS);
+    return supported;
+}
+
+const SimdKernelSet& activeSimdKernels() {
+    static const SimdKernelSet& kernels = selectSimdKernels();
+    return kernels;
+}
@@ -4,13 +4,94 @@
 #include "sobel.hpp"
 
 
+SobelOperator::SobelOperator(int ksize) : ksize(ksize)
+{
+    if (ksize != 3 && ksize != 5 && ksize != 7) {
+        throw std::invalid_argument("SobelOperator supports kernel sizes 3, 5 and 7.");
+    }
+}
+
 void SobelOperator::applyBenchmark(const cv::Mat& input, cv::Mat& output) const {
     PROF_EXEC_TIME;
 
-    cv::Sobel(input, output, CV_8U, 1, 1);
+    cv::Sobel(input, output, CV_8U, 1, 1, ksize);
 }
 
 void SobelOperator::apply(const FlatImage& input, FlatImage& output) const {
     PROF_EXEC_TIME;
-    applyXYKernels(input, output, KERNELX, KERNELY, 50);
+    switch (ksize) {
+    case 5:
+        applyXYKernels(input, output, kernels::SOBEL_5X5_X, kernels::SOBEL_5X5_Y, 50);
+        break;
+    case 7:
+        applyXYKernels(input, output, kernels::SOBEL_7X7_X, kernels::SOBEL_7X7_Y, 50);
+        break;
+    default:
+        applySeparableXYKernels(input, output, SEPARABLE_KERNELX, SEPARABLE_KERNELY, 50);
+        break;
+    }
+}
+
+void SobelOperator::applyChannels(const ChannelImage<uchar>& input, ChannelImage<uchar>& output) const {
+    PROF_EXEC_TIME;
+    // Planes run through the single-channel SIMD rows; interleaved pixels in one pass
+    if (input.layout() == ChannelLayout::Planar || input.channels() == 1) {
+        ImageFilter::applyChannels(input, output);
+    } else {
+        convolveAllChannels(input, output);
+    }
+}
+
+void SobelOperator::applyChannels(const ChannelImage<uint16_t>& input, ChannelImage<uint16_t>& output) const {
+    PROF_EXEC_TIME;
+    convolveAllChannels(input, output);
+}
+
+void SobelOperator::applyChannels(const ChannelImage<float>& input, ChannelImage<float>& output) const {
+    PROF_EXEC_TIME;
+    convolveAllChannels(input, output);
+}
+
+template <ChannelSample T>
+void SobelOperator::convolveAllChannels(const ChannelImage<T>& input, ChannelImage<T>& output) const {
+    switch (ksize) {
+    case 5:
+        convolveXYChannels(input, output, kernels::SOBEL_5X5_X, kernels::SOBEL_5X5_Y, 50);
+        break;
+    case 7:
+        convolveXYChannels(input, output, kernels::SOBEL_7X7_X, kernels::SOBEL_7X7_Y, 50);
+        break;
+    default:
+        convolveXYChannels(input, output, kernels::SOBEL_3X3_X, kernels::SOBEL_3X3_Y, 50);
+        break;
+    }
+}
+
+void SobelOperator::applyGradientField(const FlatImage& input, GradientField& field) const {
+    PROF_EXEC_TIME;
+    switch (ksize) {
+    case 5:
+        applyXYKernels(input, field, kernels::SOBEL_5X5_X, kernels::SOBEL_5X5_Y);
+        break;
+    case 7:
+        applyXYKernels(input, field, kernels::SOBEL_7X7_X, kernels::SOBEL_7X7_Y);
+        break;
+    default:
+        applyXYKernels(input, field, KERNELX, KERNELY);
+        break;
+    }
+}
+
+void SobelOperator::applyRow(const uchar* const* window, uchar* out, int cols, RowScratch&) const {
+    switch (ksize) {
+    case 5:
+        convolveXYRow(window, out, cols, kernels::SOBEL_5X5_X, kernels::SOBEL_5X5_Y, 50);
+        break;
+    case 7:
+        convolveXYRow(window, out, cols, kernels::SOBEL_7X7_X, kernels::SOBEL_7X7_Y, 50);
+        break;
+    default:
+        xyGradientRow(window, out, cols, KERNELX, KERNELY, 50);
+        break;
+    }
 }
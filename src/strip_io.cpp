@@ -0,0 +1,100 @@
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+
+#include "strip_io.hpp"
+
+static void checkStrip(const FlatImage& strip, int nextRow, int rows, int cols) {
+    if (strip.cols() != cols || nextRow + strip.rows() > rows) {
+        throw std::invalid_argument("Strip does not fit the remaining image rows.");
+    }
+}
+
+MatStripReader::MatStripReader(const cv::Mat& image) : image(image) {
+    if (image.type() != CV_8UC1) {
+        throw std::invalid_argument("Only single-channel 8-bit images can be streamed.");
+    }
+}
+
+void MatStripReader::read(FlatImage& strip) {
+    checkStrip(strip, nextRow, image.rows, image.cols);
+    for (int i = 0; i < strip.rows(); ++i) {
+        std::memcpy(strip.row(i), image.ptr<uchar>(nextRow + i), image.cols * sizeof(uchar));
+    }
+    nextRow += strip.rows();
+}
+
+MatStripWriter::MatStripWriter(cv::Mat& image, int rows, int cols) : image(image) {
+    image = cv::Mat(rows, cols, CV_8UC1);
+}
+
+void MatStripWriter::write(const FlatImage& strip) {
+    checkStrip(strip, nextRow, image.rows, image.cols);
+    for (int i = 0; i < strip.rows(); ++i) {
+        std::memcpy(image.ptr<uchar>(nextRow + i), strip.row(i), image.cols * sizeof(uchar));
+    }
+    nextRow += strip.rows();
+}
+
+// Next whitespace-separated header token, skipping '#' comments
+static std::string nextPgmToken(std::ifstream& file) {
+    std::string token;
+    char c;
+    while (file.get(c)) {
+        if (c == '#') {
+            std::string comment;
+            std::getline(file, comment);
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            if (!token.empty()) {
+                return token;
+            }
+        } else {
+            token += c;
+        }
+    }
+    return token;
+}
+
+PgmStripReader::PgmStripReader(const std::string& path) : file(path, std::ios::binary) {
+    if (!file) {
+        throw std::runtime_error("Failed to open " + path);
+    }
+    if (nextPgmToken(file) != "P5") {
+        throw std::runtime_error(path + " is not a binary PGM file.");
+    }
+    imageCols = std::stoi(nextPgmToken(file));
+    imageRows = std::stoi(nextPgmToken(file));
+    if (std::stoi(nextPgmToken(file)) > 255) {
+        throw std::runtime_error(path + " is not an 8-bit PGM file.");
+    }
+    // the single whitespace after maxval was consumed by nextPgmToken
+}
+
+void PgmStripReader::read(FlatImage& strip) {
+    checkStrip(strip, nextRow, imageRows, imageCols);
+    for (int i = 0; i < strip.rows(); ++i) {
+        if (!file.read(reinterpret_cast<char*>(strip.row(i)), imageCols)) {
+            throw std::runtime_error("Unexpected end of PGM pixel data.");
+        }
+    }
+    nextRow += strip.rows();
+}
+
+PgmStripWriter::PgmStripWriter(const std::string& path, int rows, int cols)
+    : file(path, std::ios::binary), imageRows(rows), imageCols(cols) {
+    if (!file) {
+        throw std::runtime_error("Failed to open " + path);
+    }
+    file << "P5\n" << cols << " " << rows << "\n255\n";
+}
+
+void PgmStripWriter::write(const FlatImage& strip) {
+    checkStrip(strip, nextRow, imageRows, imageCols);
+    for (int i = 0; i < strip.rows(); ++i) {
+        file.write(reinterpret_cast<const char*>(strip.row(i)), imageCols);
+    }
+    if (!file) {
+        throw std::runtime_error("Failed to write PGM pixel data.");
+    }
+    nextRow += strip.rows();
+}
@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "spsc_queue.hpp"
+#include "video_pipeline.hpp"
+
+VideoCaptureSource::VideoCaptureSource(const std::string& path) : capture(path) {
+    if (!capture.isOpened()) {
+        throw std::runtime_error("Failed to open the video at: " + path);
+    }
+    frameRows = static_cast<int>(capture.get(cv::CAP_PROP_FRAME_HEIGHT));
+    frameCols = static_cast<int>(capture.get(cv::CAP_PROP_FRAME_WIDTH));
+    framesPerSecond = capture.get(cv::CAP_PROP_FPS);
+}
+
+bool VideoCaptureSource::read(FlatImage& frame) {
+    if (!capture.read(decoded) || decoded.empty()) {
+        return false;
+    }
+    frame.resize(decoded.rows, decoded.cols);
+    if (decoded.type() == CV_8UC1) {
+        for (int i = 0; i < decoded.rows; ++i) {
+            std::memcpy(frame.row(i), decoded.ptr<uchar>(i), decoded.cols * sizeof(uchar));
+        }
+        return true;
+    }
+
+    // the header matches the frame's size and type, so cvtColor writes into the frame in place
+    cv::Mat gray = FlatImageFactory::toMat(frame);
+    cv::cvtColor(decoded, gray, decoded.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+    if (gray.data != frame.data()) {
+        throw std::runtime_error("Unsupported video frame format.");
+    }
+    return true;
+}
+
+SyntheticFrameSource::SyntheticFrameSource(int rows, int cols, int frames) : frameRows(rows), frameCols(cols), frames(frames) {
+    if (rows <= 0 || cols <= 0 || frames < 0) {
+        throw std::invalid_argument("Invalid synthetic video dimensions.");
+    }
+}
+
+bool SyntheticFrameSource::read(FlatImage& frame) {
+    if (nextFrame == frames) {
+        return false;
+    }
+    frame.resize(frameRows, frameCols);
+    const int side = std::max(1, std::min(frameRows, frameCols) / 4);
+    const int squareRow = (nextFrame * 3) % std::max(1, frameRows - side);
+    const int squareCol = (nextFrame * 5) % std::max(1, frameCols - side);
+    for (int i = 0; i < frameRows; ++i) {
+        uchar* row = frame.row(i);
+        for (int j = 0; j < frameCols; ++j) {
+            const bool inSquare = i >= squareRow && i < squareRow + side && j >= squareCol && j < squareCol + side;
+            row[j] = inSquare ? 255 : static_cast<uchar>((i + 2 * j + 4 * nextFrame) & 0x7f);
+        }
+    }
+    ++nextFrame;
+    return true;
+}
+
+VideoWriterSink::VideoWriterSink(const std::string& path, double fps, int rows, int cols, int fourcc)
+    : writer(path, fourcc, fps, cv::Size(cols, rows), false) {
+    if (!writer.isOpened()) {
+        throw std::runtime_error("Failed to open the video writer at: " + path);
+    }
+}
+
+void VideoWriterSink::write(const FlatImage& frame) {
+    writer.write(FlatImageFactory::toMat(frame));
+}
+
+VideoPipeline::VideoPipeline(const FilterPipeline& pipeline, const VideoOptions& options)
+    : pipeline(pipeline), ring(options.ringFrames) {
+    if (options.ringFrames == 0) {
+        throw std::invalid_argument("VideoPipeline needs at least one frame buffer.");
+    }
+}
+
+VideoReport VideoPipeline::run(FrameSource& source, FrameSink& sink) {
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    auto now = [&] { return std::chrono::duration<double>(Clock::now() - start).count(); };
+
+    // Slot indices circulate free -> read -> filtered -> free; END_OF_STREAM follows the last frame.
+    // Every queue has room for the whole ring plus the marker, so pushes never wait.
+    constexpr int END_OF_STREAM = -1;
+    SpscQueue<int> freeSlots(ring.size() + 1);
+    SpscQueue<int> readSlots(ring.size() + 1);
+    SpscQueue<int> filteredSlots(ring.size() + 1);
+    for (int slot = 0; slot < static_cast<int>(ring.size()); ++slot) {
+        freeSlots.tryPush(slot);
+    }
+
+    std::atomic<bool> stopped{false};
+    std::exception_ptr failure;
+    std::mutex failureMutex;
+    auto fail = [&] {
+        std::lock_guard<std::mutex> lock(failureMutex);
+        if (!failure) {
+            failure = std::current_exception();
+        }
+        stopped.store(true, std::memory_order_release);
+    };
+
+    // Spins, then yields, until a slot arrives; false once another stage has failed
+    auto pop = [&](SpscQueue<int>& queue, int& slot) {
+        for (int spins = 0; !queue.tryPop(slot); ++spins) {
+            if (stopped.load(std::memory_order_acquire)) {
+                return false;
+            }
+            if (spins > 64) {
+                std::this_thread::yield();
+            }
+        }
+        return true;
+    };
+
+    VideoReport report;
+
+    std::thread reader([&] {
+        try {
+            int slot;
+            while (pop(freeSlots, slot)) {
+                FrameSlot& frame = ring[slot];
+                frame.readStart = now();
+                if (!source.read(frame.input)) {
+                    readSlots.tryPush(END_OF_STREAM);
+                    return;
+                }
+                report.readSeconds += now() - frame.readStart;
+                readSlots.tryPush(slot);
+            }
+        } catch (...) {
+            fail();
+        }
+    });
+
+    std::thread writer([&] {
+        try {
+            double totalLatency = 0;
+            int slot;
+            while (pop(filteredSlots, slot) && slot != END_OF_STREAM) {
+                FrameSlot& frame = ring[slot];
+                const double writeStart = now();
+                sink.write(frame.output);
+                const double writeEnd = now();
+                report.writeSeconds += writeEnd - writeStart;
+
+                const double latency = writeEnd - frame.readStart;
+                totalLatency += latency;
+                report.maxLatencyMs = std::max(report.maxLatencyMs, latency * 1e3);
+                ++report.frames;
+                freeSlots.tryPush(slot);
+            }
+            if (report.frames) {
+                report.meanLatencyMs = totalLatency * 1e3 / report.frames;
+            }
+        } catch (...) {
+            fail();
+        }
+    });
+
+    try {
+        int slot;
+        while (pop(readSlots, slot)) {
+            if (slot == END_OF_STREAM) {
+                filteredSlots.tryPush(END_OF_STREAM);
+                break;
+            }
+            FrameSlot& frame = ring[slot];
+            const double filterStart = now();
+            pipeline.apply(frame.input, frame.output);
+            report.filterSeconds += now() - filterStart;
+            filteredSlots.tryPush(slot);
+        }
+    } catch (...) {
+        fail();
+    }
+
+    reader.join();
+    writer.join();
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+
+    report.seconds = now();
+    report.framesPerSecond = report.seconds > 0 ? report.frames / report.seconds : 0;
+    return report;
+}
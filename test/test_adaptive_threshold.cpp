@@ -0,0 +1,58 @@
+#include <opencv2/opencv.hpp>
+#include <gtest/gtest.h>
+
+#include "adaptive_threshold.hpp"
+#include "test_utils.hpp"
+
+
+// cv::adaptiveThreshold(MEAN_C, BINARY): the window mean is rounded to 8 bits first
+static FlatImage referenceThreshold(const FlatImage& input, int ksize, int offset) {
+    const int radius = ksize / 2;
+    const int area = ksize * ksize;
+    FlatImage output(input.rows(), input.cols());
+    for (int i = 0; i < input.rows(); ++i) {
+        for (int j = 0; j < input.cols(); ++j) {
+            int sum = 0;
+            for (int r = -radius; r <= radius; ++r) {
+                for (int c = -radius; c <= radius; ++c) {
+                    sum += input(std::clamp(i + r, 0, input.rows() - 1), std::clamp(j + c, 0, input.cols() - 1));
+                }
+            }
+            const int mean = (sum + area / 2) / area;
+            output(i, j) = input(i, j) - mean > -offset ? 255 : 0;
+        }
+    }
+    return output;
+}
+
+TEST(AdaptiveThreshold, ConstantImage) {
+    FlatImage input = createTestImage(5, 5, 120);
+    FlatImage output;
+
+    // every pixel equals its mean: above it once the offset is positive
+    AdaptiveThreshold(3, 5).apply(input, output);
+    for (uchar px : output) {
+        ASSERT_EQ(px, 255);
+    }
+
+    AdaptiveThreshold(3, 0).apply(input, output);
+    for (uchar px : output) {
+        ASSERT_EQ(px, 0);
+    }
+}
+
+TEST(AdaptiveThreshold, MatchesBruteForce) {
+    for (int ksize : {3, 15, 51}) {
+        for (int offset : {-3, 0, 7}) {
+            FlatImage input = createRandomImage(70, 90, ksize + offset);
+            FlatImage output;
+            AdaptiveThreshold(ksize, offset).apply(input, output);
+            expectImagesEqual(output, referenceThreshold(input, ksize, offset));
+        }
+    }
+}
+
+TEST(AdaptiveThreshold, RejectsInvalidSizes) {
+    ASSERT_THROW(AdaptiveThreshold(1), std::invalid_argument);
+    ASSERT_THROW(AdaptiveThreshold(14), std::invalid_argument);
+}
@@ -5,6 +5,25 @@
 #include "test_utils.hpp"
 
 
+// Box mean with replicated borders, rounded to nearest (cv::blur with BORDER_REPLICATE)
+static FlatImage referenceBoxMean(const FlatImage& input, int ksize) {
+    const int radius = ksize / 2;
+    const int area = ksize * ksize;
+    FlatImage output(input.rows(), input.cols());
+    for (int i = 0; i < input.rows(); ++i) {
+        for (int j = 0; j < input.cols(); ++j) {
+            int sum = 0;
+            for (int r = -radius; r <= radius; ++r) {
+                for (int c = -radius; c <= radius; ++c) {
+                    sum += input(std::clamp(i + r, 0, input.rows() - 1), std::clamp(j + c, 0, input.cols() - 1));
+                }
+            }
+            output(i, j) = static_cast<uchar>((sum + area / 2) / area);
+        }
+    }
+    return output;
+}
+
 TEST(Blur, TestBlur) {
     FlatImage input = createTestImage(5, 5, 200);
     FlatImage output;
@@ -15,18 +34,32 @@ TEST(Blur, TestBlur) {
     ASSERT_EQ(output.rows(), input.rows());
     ASSERT_EQ(output.cols(), input.cols());
 
-    std::vector<std::vector<int>> expectedData = {
-        {200,  200,  200,  200, 200},
-        {200,  200,  200,  200, 200},
-        {200,  200,  200,  200, 200},
-        {200,  200,  200,  200, 200},
-        {200,  200,  200,  200, 200}
-    };
-    FlatImage expectedOutput = FlatImageFactory::from(expectedData);
-
-    for (int i = 0; i < output.rows(); ++i) {
-        for (int j = 0; j < output.cols(); ++j) {
-            ASSERT_NEAR(output(i, j), expectedOutput(i, j), 2);
+    // the mean of a constant image is exact
+    expectImagesEqual(output, input);
+}
+
+TEST(Blur, MatchesRoundedBoxMean) {
+    for (auto [rows, cols] : {std::pair{37, 53}, std::pair{4, 90}, std::pair{60, 3}}) {
+        FlatImage input = createRandomImage(rows, cols, rows * cols);
+        for (int ksize : {1, 3, 5, 7, 9, 11, 21}) {
+            SCOPED_TRACE(ksize);
+            FlatImage output;
+            Blur(ksize).apply(input, output);
+            expectImagesEqual(output, referenceBoxMean(input, ksize));
         }
     }
 }
+
+TEST(Blur, SaturatedInput) {
+    FlatImage input = createTestImage(5, 5, 255);
+    FlatImage output;
+    Blur(31).apply(input, output);
+    expectImagesEqual(output, input);
+}
+
+TEST(Blur, KernelSize) {
+    ASSERT_EQ(Blur().radius(), 1);
+    ASSERT_EQ(Blur(15).radius(), 7);
+    ASSERT_THROW(Blur(0), std::invalid_argument);
+    ASSERT_THROW(Blur(4), std::invalid_argument);
+}
@@ -0,0 +1,221 @@
+#include <queue>
+
+#include <opencv2/opencv.hpp>
+#include <gtest/gtest.h>
+
+#include "blur.hpp"
+#include "canny.hpp"
+#include "gaussian_blur.hpp"
+#include "filter_pipeline.hpp"
+#include "sobel.hpp"
+#include "test_utils.hpp"
+
+
+// Random blobs: smoothed noise has long connected edges of every orientation
+static FlatImage createBlobImage(int rows, int cols, unsigned int seed) {
+    FlatImage noise = createRandomImage(rows, cols, seed), blobs;
+    Blur(7).apply(noise, blobs);
+    for (uchar& px : blobs) {
+        px = static_cast<uchar>(std::clamp((px - 128) * 8 + 128, 0, 255));
+    }
+    return blobs;
+}
+
+// Straightforward Canny: brute-force Sobel, the same thinning rules and a breadth-first
+// hysteresis from every strong pixel
+static FlatImage referenceCanny(const FlatImage& input, double low, double high, GradientNorm norm) {
+    const int rows = input.rows(), cols = input.cols();
+    auto px = [&](int i, int j) { return static_cast<int>(input(std::clamp(i, 0, rows - 1), std::clamp(j, 0, cols - 1))); };
+
+    std::vector<float> magnitude(rows * cols);
+    std::vector<GradientDirection> direction(rows * cols);
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            int gx = 0, gy = 0;
+            for (int r = 0; r < 3; ++r) {
+                for (int c = 0; c < 3; ++c) {
+                    gx += px(i + r - 1, j + c - 1) * SobelOperator::KERNELX[r][c];
+                    gy += px(i + r - 1, j + c - 1) * SobelOperator::KERNELY[r][c];
+                }
+            }
+            magnitude[i * cols + j] = gradientMagnitude(gx, gy, norm);
+            direction[i * cols + j] = quantizeDirection(gx, gy);
+        }
+    }
+    auto mag = [&](int i, int j) { return i < 0 || i >= rows || j < 0 || j >= cols ? 0.0f : magnitude[i * cols + j]; };
+
+    std::vector<uchar> state(rows * cols, 0);
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            const float m = mag(i, j);
+            if (!(m > static_cast<float>(low))) {
+                continue;
+            }
+            bool peak = false;
+            switch (direction[i * cols + j]) {
+            case GradientDirection::Horizontal: peak = m > mag(i, j - 1) && m >= mag(i, j + 1); break;
+            case GradientDirection::Vertical: peak = m > mag(i - 1, j) && m >= mag(i + 1, j); break;
+            case GradientDirection::Diagonal: peak = m > mag(i - 1, j + 1) && m > mag(i + 1, j - 1); break;
+            case GradientDirection::AntiDiagonal: peak = m > mag(i - 1, j - 1) && m > mag(i + 1, j + 1); break;
+            }
+            if (peak) {
+                state[i * cols + j] = m > static_cast<float>(high) ? 2 : 1;
+            }
+        }
+    }
+
+    FlatImage output(rows, cols);
+    std::queue<std::pair<int, int>> queue;
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            output(i, j) = 0;
+            if (state[i * cols + j] == 2) {
+                queue.emplace(i, j);
+            }
+        }
+    }
+    while (!queue.empty()) {
+        auto [i, j] = queue.front();
+        queue.pop();
+        if (output(i, j)) {
+            continue;
+        }
+        output(i, j) = 255;
+        for (int r = std::max(i - 1, 0); r <= std::min(i + 1, rows - 1); ++r) {
+            for (int c = std::max(j - 1, 0); c <= std::min(j + 1, cols - 1); ++c) {
+                if (state[r * cols + c] && !output(r, c)) {
+                    queue.emplace(r, c);
+                }
+            }
+        }
+    }
+    return output;
+}
+
+TEST(CannyEdgeDetector, MatchesReference) {
+    for (GradientNorm norm : {GradientNorm::L1, GradientNorm::L2}) {
+        for (auto [low, high] : {std::pair{50.0, 150.0}, {100.0, 300.0}, {20.5, 20.5}}) {
+            FlatImage input = createBlobImage(83, 117, static_cast<unsigned int>(low));
+            FlatImage output;
+            CannyEdgeDetector(low, high, norm).apply(input, output);
+            expectImagesEqual(output, referenceCanny(input, low, high, norm));
+        }
+    }
+}
+
+TEST(CannyEdgeDetector, StepEdgeIsOnePixelWide) {
+    FlatImage input(12, 16);
+    for (int i = 0; i < 12; ++i) {
+        for (int j = 0; j < 16; ++j) {
+            input(i, j) = j < 8 ? 20 : 220;
+        }
+    }
+    FlatImage output;
+    CannyEdgeDetector().apply(input, output);
+
+    // both columns at the step have the same magnitude; the tie keeps the left one
+    for (int i = 0; i < 12; ++i) {
+        for (int j = 0; j < 16; ++j) {
+            ASSERT_EQ(output(i, j), j == 7 ? 255 : 0) << "at (" << i << ", " << j << ")";
+        }
+    }
+}
+
+TEST(CannyEdgeDetector, HysteresisCrossesChunks) {
+    // a weak line running through every row chunk, made strong only in the last row, and an
+    // isolated weak line that must disappear
+    const int rows = 300, cols = 40;
+    FlatImage candidates(rows, cols);
+    std::fill(candidates.begin(), candidates.end(), 0);
+    for (int i = 0; i < rows; ++i) {
+        candidates(i, 5 + (i / 7) % 2) = CannyEdgeDetector::WEAK;
+        candidates(i, 30) = CannyEdgeDetector::WEAK;
+    }
+    candidates(rows - 1, 5 + ((rows - 1) / 7) % 2) = CannyEdgeDetector::STRONG;
+
+    ExecutionPolicy chunked;
+    chunked.parallelMinPixels = 0;
+    chunked.chunksPerWorker = 64;
+    for (const ExecutionPolicy& policy : {ExecutionPolicy::serial(), chunked}) {
+        ExecutionPolicyScope scope(policy);
+        FlatImage output;
+        CannyEdgeDetector::traceEdges(candidates, output);
+        for (int i = 0; i < rows; ++i) {
+            for (int j = 0; j < cols; ++j) {
+                const bool onLine = j == 5 + (i / 7) % 2;
+                ASSERT_EQ(output(i, j), onLine ? 255 : 0) << "at (" << i << ", " << j << ")";
+            }
+        }
+    }
+}
+
+TEST(CannyEdgeDetector, RunTablesFitTheRunsFound) {
+    // no candidates at all, then one row of isolated candidates, the most runs a row can hold,
+    // with a strong one in the middle and a run crossing a 64-pixel block
+    FlatImage empty(4, 70), output;
+    std::fill(empty.begin(), empty.end(), 0);
+    CannyEdgeDetector::traceEdges(empty, output);
+    ASSERT_TRUE(std::all_of(output.begin(), output.end(), [](uchar px) { return px == 0; }));
+
+    FlatImage candidates(2, 131);
+    std::fill(candidates.begin(), candidates.end(), 0);
+    for (int j = 0; j < 131; j += 2) {
+        candidates(0, j) = CannyEdgeDetector::WEAK;
+    }
+    candidates(0, 64) = CannyEdgeDetector::STRONG;
+    std::fill(candidates.row(1) + 60, candidates.row(1) + 70, CannyEdgeDetector::WEAK);
+    CannyEdgeDetector::traceEdges(candidates, output);
+    for (int j = 0; j < 131; ++j) {
+        ASSERT_EQ(output(0, j), j >= 60 && j <= 70 && j % 2 == 0 ? 255 : 0) << "at column " << j;
+        ASSERT_EQ(output(1, j), j >= 60 && j < 70 ? 255 : 0) << "at column " << j;
+    }
+}
+
+TEST(CannyEdgeDetector, ChunkedRunMatchesSerial) {
+    FlatImage input = createBlobImage(257, 190, 11);
+    FlatImage serial, chunked;
+    {
+        ExecutionPolicyScope scope(ExecutionPolicy::serial());
+        CannyEdgeDetector(40, 120).apply(input, serial);
+    }
+    {
+        ExecutionPolicy policy;
+        policy.parallelMinPixels = 0;
+        policy.chunksPerWorker = 32;
+        ExecutionPolicyScope scope(policy);
+        CannyEdgeDetector(40, 120).apply(input, chunked);
+    }
+    expectImagesEqual(chunked, serial);
+}
+
+TEST(CannyEdgeDetector, PipelineSeesWholeImage) {
+    FlatImage input = createBlobImage(120, 140, 5);
+    auto pipeline = FilterPipeline().addGaussianBlur().addCannyEdgeDetector(30, 90);
+    ASSERT_EQ(pipeline.haloRadius(), ImageFilter::UNBOUNDED_RADIUS);
+
+    FlatImage smoothed, expected;
+    GaussianBlur().apply(input, smoothed);
+    CannyEdgeDetector(30, 90).apply(smoothed, expected);
+
+    // tiles would cut edges apart, so a tile-parallel policy still runs the chain whole
+    ExecutionPolicy tiled;
+    tiled.parallelMinPixels = 0;
+    tiled.tileMinPixels = 1;
+    pipeline.setExecutionPolicy(tiled);
+    FlatImage output;
+    pipeline.apply(input, output);
+    expectImagesEqual(output, expected);
+
+    pipeline.applyTiled(input, output, {32, 32});
+    expectImagesEqual(output, expected);
+
+    cv::Mat inputMat = FlatImageFactory::toMat(input), outputMat;
+    MatStripReader reader(inputMat);
+    MatStripWriter writer(outputMat, input.rows(), input.cols());
+    ASSERT_THROW(pipeline.applyStreaming(reader, writer, 16), std::invalid_argument);
+}
+
+TEST(CannyEdgeDetector, RejectsInvalidThresholds) {
+    ASSERT_THROW(CannyEdgeDetector(-1, 10), std::invalid_argument);
+    ASSERT_THROW(CannyEdgeDetector(100, 50), std::invalid_argument);
+}
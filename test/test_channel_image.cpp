@@ -0,0 +1,289 @@
+#include <opencv2/opencv.hpp>
+#include <gtest/gtest.h>
+
+#include "blur.hpp"
+#include "channel_image.hpp"
+#include "filter_pipeline.hpp"
+#include "gaussian_blur.hpp"
+#include "laplacian_of_gaussian.hpp"
+#include "scharr.hpp"
+#include "sobel.hpp"
+#include "test_utils.hpp"
+
+
+template <typename T>
+static ChannelImage<T> createRandomChannels(int rows, int cols, int channels, ChannelLayout layout, T maxValue, unsigned int seed = 0) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> dist(0, maxValue);
+    ChannelImage<T> image(rows, cols, channels, layout);
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            for (int c = 0; c < channels; ++c) {
+                image(i, j, c) = static_cast<T>(dist(rng));
+            }
+        }
+    }
+    return image;
+}
+
+template <typename T>
+static FlatArray<T> extractChannel(const ChannelImage<T>& image, int channel) {
+    FlatArray<T> plane(image.rows(), image.cols());
+    for (int i = 0; i < image.rows(); ++i) {
+        for (int j = 0; j < image.cols(); ++j) {
+            plane(i, j) = image(i, j, channel);
+        }
+    }
+    return plane;
+}
+
+// Separable smoothing of one channel with replicated borders, rounded to nearest for integers
+template <typename T>
+static FlatArray<T> referenceSmooth(const ChannelImage<T>& image, int channel, const std::vector<int>& taps) {
+    const int radius = static_cast<int>(taps.size() / 2);
+    double weight = 0;
+    for (int tap : taps) {
+        weight += tap;
+    }
+    FlatArray<T> output(image.rows(), image.cols());
+    for (int i = 0; i < image.rows(); ++i) {
+        for (int j = 0; j < image.cols(); ++j) {
+            double sum = 0;
+            for (int r = -radius; r <= radius; ++r) {
+                for (int c = -radius; c <= radius; ++c) {
+                    sum += taps[r + radius] * taps[c + radius] *
+                           static_cast<double>(image(std::clamp(i + r, 0, image.rows() - 1), std::clamp(j + c, 0, image.cols() - 1), channel));
+                }
+            }
+            const double mean = sum / (weight * weight);
+            output(i, j) = std::is_integral_v<T> ? static_cast<T>(std::floor(mean + 0.5)) : static_cast<T>(mean);
+        }
+    }
+    return output;
+}
+
+template <typename T>
+static void expectChannelsEqual(const ChannelImage<T>& actual, const ChannelImage<T>& expected) {
+    ASSERT_EQ(actual.rows(), expected.rows());
+    ASSERT_EQ(actual.cols(), expected.cols());
+    ASSERT_EQ(actual.channels(), expected.channels());
+    for (int i = 0; i < actual.rows(); ++i) {
+        for (int j = 0; j < actual.cols(); ++j) {
+            for (int c = 0; c < actual.channels(); ++c) {
+                ASSERT_EQ(actual(i, j, c), expected(i, j, c)) << "at (" << i << ", " << j << ", " << c << ")";
+            }
+        }
+    }
+}
+
+// Gradient filter response of one channel with replicated borders: |X| and |Y| saturate at the
+// full-scale value and are averaged, or |kernel| saturates when there is no Y kernel; the
+// threshold is in 8-bit units
+template <typename T>
+static FlatArray<T> referenceGradient(const ChannelImage<T>& image, int channel, const DynamicKernel<int>& kernelX,
+                                      const DynamicKernel<int>* kernelY, int threshold, double fullScale) {
+    auto respond = [&](const DynamicKernel<int>& kernel, int i, int j) {
+        double sum = 0;
+        for (int r = 0; r < kernel.rows; ++r) {
+            for (int c = 0; c < kernel.cols; ++c) {
+                sum += kernel(r, c) * static_cast<double>(image(std::clamp(i + r - kernel.radiusY(), 0, image.rows() - 1),
+                                                                std::clamp(j + c - kernel.radiusX(), 0, image.cols() - 1), channel));
+            }
+        }
+        const double response = std::abs(sum / kernel.divisor);
+        return std::is_integral_v<T> ? std::floor(response + 0.5) : response;
+    };
+    const double minimum = std::is_integral_v<T> ? std::floor(threshold * fullScale / 255) : threshold * fullScale / 255;
+
+    FlatArray<T> output(image.rows(), image.cols());
+    for (int i = 0; i < image.rows(); ++i) {
+        for (int j = 0; j < image.cols(); ++j) {
+            double gradient = std::min(respond(kernelX, i, j), fullScale);
+            if (kernelY) {
+                gradient = (gradient + std::min(respond(*kernelY, i, j), fullScale)) / 2;
+                gradient = std::is_integral_v<T> ? std::floor(gradient) : gradient;
+            }
+            output(i, j) = static_cast<T>(gradient < minimum ? 0 : gradient);
+        }
+    }
+    return output;
+}
+
+TEST(ChannelImage, LayoutsAddressTheSamePixels) {
+    ChannelImage<uint16_t> interleaved(3, 4, 3, ChannelLayout::Interleaved);
+    ChannelImage<uint16_t> planar(3, 4, 3, ChannelLayout::Planar);
+    ASSERT_EQ(interleaved.samples().rows(), 3);
+    ASSERT_EQ(interleaved.samples().cols(), 12);
+    ASSERT_EQ(planar.samples().rows(), 9);
+    ASSERT_EQ(planar.samples().cols(), 4);
+
+    interleaved(1, 2, 1) = 700;
+    planar(1, 2, 1) = 700;
+    ASSERT_EQ(interleaved.samples()(1, 7), 700);
+    ASSERT_EQ(planar.samples()(4, 2), 700);
+    ASSERT_EQ(planar.plane(1)(1, 2), 700);
+    ASSERT_THROW(interleaved.plane(0), std::invalid_argument);
+}
+
+TEST(ChannelImage, ConvertRoundTripsBetweenLayouts) {
+    auto input = createRandomChannels<uchar>(7, 9, 4, ChannelLayout::Interleaved, 255);
+    ChannelImage<uchar> planar(0, 0, 1, ChannelLayout::Planar);
+    ChannelImage<uchar> interleaved;
+
+    ChannelImageFactory::convert(input, planar);
+    ASSERT_EQ(planar.layout(), ChannelLayout::Planar);
+    expectChannelsEqual(planar, input);
+
+    ChannelImageFactory::convert(planar, interleaved);
+    ASSERT_EQ(interleaved.layout(), ChannelLayout::Interleaved);
+    expectChannelsEqual(interleaved, input);
+}
+
+TEST(ChannelImage, WrapViewsMatSamples) {
+    cv::Mat mat(5, 6, CV_16UC3);
+    mat.at<uint16_t>(2, 3 * 3 + 2) = 40000;
+
+    ChannelImage<uint16_t> view = ChannelImageFactory::wrap<uint16_t>(mat);
+    ASSERT_EQ(view.rows(), 5);
+    ASSERT_EQ(view.cols(), 6);
+    ASSERT_EQ(view.channels(), 3);
+    ASSERT_EQ(view(2, 3, 2), 40000);
+
+    view(4, 5, 0) = 123;
+    ASSERT_EQ(mat.at<uint16_t>(4, 15), 123);
+    ASSERT_EQ(ChannelImageFactory::toMat(view).data, mat.data);
+
+    ASSERT_THROW(ChannelImageFactory::wrap<uchar>(mat), std::invalid_argument);
+    ASSERT_THROW(ChannelImageFactory::wrap<float>(mat), std::invalid_argument);
+}
+
+TEST(ChannelImage, BlurMatchesEachChannelAlone) {
+    for (ChannelLayout layout : {ChannelLayout::Interleaved, ChannelLayout::Planar}) {
+        for (int ksize : {3, 5, 11}) {
+            auto input = createRandomChannels<uchar>(37, 53, 3, layout, 255, ksize);
+            ChannelImage<uchar> output;
+            Blur(ksize).applyChannels(input, output);
+            ASSERT_EQ(output.layout(), layout);
+
+            for (int c = 0; c < 3; ++c) {
+                FlatImage expected;
+                Blur(ksize).apply(extractChannel(input, c), expected);
+                expectImagesEqual(extractChannel(output, c), expected);
+            }
+        }
+    }
+}
+
+TEST(ChannelImage, SmoothsSixteenBitSamples) {
+    for (ChannelLayout layout : {ChannelLayout::Interleaved, ChannelLayout::Planar}) {
+        auto input = createRandomChannels<uint16_t>(23, 31, 4, layout, 65535);
+        ChannelImage<uint16_t> gaussian, box;
+        GaussianBlur(7).applyChannels(input, gaussian);
+        Blur(9).applyChannels(input, box);
+
+        for (int c = 0; c < 4; ++c) {
+            auto expectedGaussian = referenceSmooth(input, c, {2, 7, 14, 18, 14, 7, 2});
+            auto expectedBox = referenceSmooth(input, c, std::vector<int>(9, 1));
+            auto actualGaussian = extractChannel(gaussian, c);
+            auto actualBox = extractChannel(box, c);
+            for (int i = 0; i < input.rows(); ++i) {
+                for (int j = 0; j < input.cols(); ++j) {
+                    ASSERT_EQ(actualGaussian(i, j), expectedGaussian(i, j)) << "at (" << i << ", " << j << ", " << c << ")";
+                    ASSERT_EQ(actualBox(i, j), expectedBox(i, j)) << "at (" << i << ", " << j << ", " << c << ")";
+                }
+            }
+        }
+    }
+
+    // 65535 * 257^2 no longer fits the 32-bit sums
+    auto small = createRandomChannels<uint16_t>(4, 4, 1, ChannelLayout::Interleaved, 65535);
+    ChannelImage<uint16_t> output;
+    ASSERT_THROW(Blur(257).applyChannels(small, output), std::invalid_argument);
+}
+
+TEST(ChannelImage, SmoothsFloatSamples) {
+    auto input = createRandomChannels<float>(19, 27, 3, ChannelLayout::Interleaved, 1.0f);
+    ChannelImage<float> gaussian, box;
+    GaussianBlur(5).applyChannels(input, gaussian);
+    Blur(15).applyChannels(input, box);
+
+    for (int c = 0; c < 3; ++c) {
+        auto expectedGaussian = referenceSmooth(input, c, {1, 4, 6, 4, 1});
+        auto expectedBox = referenceSmooth(input, c, std::vector<int>(15, 1));
+        auto actualGaussian = extractChannel(gaussian, c);
+        auto actualBox = extractChannel(box, c);
+        for (int i = 0; i < input.rows(); ++i) {
+            for (int j = 0; j < input.cols(); ++j) {
+                ASSERT_NEAR(actualGaussian(i, j), expectedGaussian(i, j), 1e-5);
+                ASSERT_NEAR(actualBox(i, j), expectedBox(i, j), 1e-5);
+            }
+        }
+    }
+}
+
+TEST(ChannelImage, GradientFiltersMatchPerChannelRuns) {
+    const std::vector<std::shared_ptr<const ImageFilter>> filters = {
+        std::make_shared<SobelOperator>(3), std::make_shared<SobelOperator>(5), std::make_shared<SobelOperator>(7),
+        std::make_shared<ScharrOperator>(), std::make_shared<LaplacianOfGaussian>()};
+    for (const auto& filter : filters) {
+        for (ChannelLayout layout : {ChannelLayout::Interleaved, ChannelLayout::Planar}) {
+            auto input = createRandomChannels<uchar>(20, 24, 3, layout, 255);
+            ChannelImage<uchar> output;
+            filter->applyChannels(input, output);
+            ASSERT_EQ(output.layout(), layout);
+
+            for (int c = 0; c < 3; ++c) {
+                FlatImage expected;
+                filter->apply(extractChannel(input, c), expected);
+                expectImagesEqual(extractChannel(output, c), expected);
+            }
+        }
+    }
+}
+
+TEST(ChannelImage, GradientFiltersScaleToDeepSamples) {
+    const DynamicKernel<int> sobelX(kernels::SOBEL_5X5_X), sobelY(kernels::SOBEL_5X5_Y);
+    const DynamicKernel<int> laplacian(kernels::LAPLACIAN_OF_GAUSSIAN_5X5);
+    auto expectChannelNear = [](const auto& actual, const auto& expected, double tolerance) {
+        for (int i = 0; i < actual.rows(); ++i) {
+            for (int j = 0; j < actual.cols(); ++j) {
+                ASSERT_NEAR(actual(i, j), expected(i, j), tolerance) << "at (" << i << ", " << j << ")";
+            }
+        }
+    };
+
+    auto deep = createRandomChannels<uint16_t>(17, 13, 3, ChannelLayout::Interleaved, 65535);
+    ChannelImage<uint16_t> deepOutput;
+    SobelOperator(5).applyChannels(deep, deepOutput);
+    for (int c = 0; c < 3; ++c) {
+        expectChannelNear(extractChannel(deepOutput, c), referenceGradient(deep, c, sobelX, &sobelY, 50, 65535), 0);
+    }
+    LaplacianOfGaussian().applyChannels(deep, deepOutput);
+    for (int c = 0; c < 3; ++c) {
+        expectChannelNear(extractChannel(deepOutput, c), referenceGradient(deep, c, laplacian, nullptr, 0, 65535), 0);
+    }
+
+    auto real = createRandomChannels<float>(17, 13, 2, ChannelLayout::Planar, 1.0f);
+    ChannelImage<float> realOutput;
+    SobelOperator(5).applyChannels(real, realOutput);
+    ASSERT_EQ(realOutput.layout(), ChannelLayout::Planar);
+    for (int c = 0; c < 2; ++c) {
+        expectChannelNear(extractChannel(realOutput, c), referenceGradient(real, c, sobelX, &sobelY, 50, 1.0), 1e-5);
+    }
+}
+
+TEST(ChannelImage, PipelineMatchesPerChannelRuns) {
+    for (ChannelLayout layout : {ChannelLayout::Interleaved, ChannelLayout::Planar}) {
+        auto pipeline = FilterPipeline().addBlur(5).addGaussianBlur().addSobelOperator();
+        auto input = createRandomChannels<uchar>(41, 35, 3, layout, 255);
+        ChannelImage<uchar> output;
+        pipeline.apply(input, output);
+        ASSERT_EQ(output.layout(), layout);
+
+        for (int c = 0; c < 3; ++c) {
+            FlatImage expected;
+            pipeline.apply(extractChannel(input, c), expected);
+            expectImagesEqual(extractChannel(output, c), expected);
+        }
+    }
+}
@@ -0,0 +1,192 @@
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include <opencv2/opencv.hpp>
+#include <tbb/global_control.h>
+#include <tbb/task_arena.h>
+#include <gtest/gtest.h>
+
+#include "dirty_regions.hpp"
+#include "filter_pipeline.hpp"
+#include "test_utils.hpp"
+
+
+static void expectCovered(const std::vector<PixelRect>& rects, int row, int col) {
+    for (const PixelRect& rect : rects) {
+        if (row >= rect.row && row < rect.row + rect.rows && col >= rect.col && col < rect.col + rect.cols) {
+            return;
+        }
+    }
+    FAIL() << "(" << row << ", " << col << ") is not covered";
+}
+
+TEST(DirtyRegions, FindChangedRects) {
+    FlatImage previous = createRandomImage(100, 70, 1);
+    FlatImage current = previous;
+    ASSERT_TRUE(findChangedRects(previous, current, 16).empty());
+
+    // one pixel, and a patch spanning two cell rows and the partial last cell column
+    current(3, 40) ^= 1;
+    for (int i = 30; i < 50; ++i) {
+        for (int j = 60; j < 70; ++j) {
+            current(i, j) ^= 0x80;
+        }
+    }
+    std::vector<PixelRect> rects = findChangedRects(previous, current, 16);
+    ASSERT_EQ(rects.size(), 2u);
+    ASSERT_NE(std::find(rects.begin(), rects.end(), PixelRect{0, 32, 16, 16}), rects.end());
+    ASSERT_NE(std::find(rects.begin(), rects.end(), PixelRect{16, 48, 48, 22}), rects.end());
+
+    // different dimensions change everything
+    ASSERT_EQ(findChangedRects(FlatImage(10, 10), current), std::vector<PixelRect>{PixelRect(0, 0, 100, 70)});
+    EXPECT_THROW(findChangedRects(previous, current, 0), std::invalid_argument);
+}
+
+TEST(DirtyRegions, FindChangedRectsInViews) {
+    FlatImage previous = createRandomImage(60, 80, 2);
+    FlatImage current = previous;
+    current(25, 45) += 1;
+
+    std::vector<PixelRect> rects = findChangedRects(previous.subView(10, 20, 40, 50), current.subView(10, 20, 40, 50), 8);
+    ASSERT_EQ(rects, std::vector<PixelRect>{PixelRect(8, 24, 8, 8)});
+}
+
+TEST(DirtyRegions, CoverRectsGrowsClipsAndMerges) {
+    // clipped at the image border
+    ASSERT_EQ(coverRects({{0, 0, 4, 4}}, 2, 50, 50), std::vector<PixelRect>{PixelRect(0, 0, 6, 6)});
+    ASSERT_EQ(coverRects({{46, 10, 4, 4}}, 3, 50, 50), std::vector<PixelRect>{PixelRect(43, 7, 7, 10)});
+    ASSERT_TRUE(coverRects({{5, 5, 0, 3}}, 3, 50, 50).empty());
+
+    // halos that overlap merge into one box; distant rectangles stay apart
+    ASSERT_EQ(coverRects({{10, 10, 4, 4}, {10, 16, 4, 4}}, 2, 50, 50), std::vector<PixelRect>{PixelRect(8, 8, 8, 14)});
+    ASSERT_EQ(coverRects({{0, 0, 2, 2}, {40, 40, 2, 2}}, 1, 50, 50).size(), 2u);
+
+    // the cover is disjoint and covers every grown rectangle
+    std::vector<PixelRect> rects = {{5, 5, 10, 2}, {5, 5, 2, 30}, {12, 30, 3, 3}, {40, 0, 2, 2}, {30, 20, 1, 1}};
+    std::vector<PixelRect> cover = coverRects(rects, 2, 50, 50);
+    for (size_t a = 0; a < cover.size(); ++a) {
+        for (size_t b = a + 1; b < cover.size(); ++b) {
+            const bool disjoint = cover[a].row + cover[a].rows <= cover[b].row || cover[b].row + cover[b].rows <= cover[a].row
+                || cover[a].col + cover[a].cols <= cover[b].col || cover[b].col + cover[b].cols <= cover[a].col;
+            ASSERT_TRUE(disjoint);
+        }
+    }
+    for (const PixelRect& rect : rects) {
+        for (int i = std::max(rect.row - 2, 0); i < std::min(rect.row + rect.rows + 2, 50); ++i) {
+            for (int j = std::max(rect.col - 2, 0); j < std::min(rect.col + rect.cols + 2, 50); ++j) {
+                expectCovered(cover, i, j);
+            }
+        }
+    }
+}
+
+TEST(DirtyRegions, ApplyIncrementalMatchesFullRecompute) {
+    FlatImage previous = createRandomImage(120, 150, 3);
+    std::vector<FilterPipeline> pipelines;
+    pipelines.push_back(FilterPipeline().addBlur().addSobelOperator());
+    pipelines.push_back(FilterPipeline().addGaussianBlur(7).addBlur(5).addLaplacianOfGaussian());
+    pipelines.push_back(FilterPipeline().addLocalVariance(9).addScharrOperator());
+
+    for (FilterPipeline& pipeline : pipelines) {
+        FlatImage current = previous;
+        for (int i = 20; i < 30; ++i) {
+            for (int j = 0; j < 12; ++j) {
+                current(i, j) = 255 - current(i, j);
+            }
+        }
+        current(80, 100) = current(80, 100) / 2;
+        current(119, 149) = current(119, 149) + 1;
+
+        FlatImage output, expected;
+        pipeline.apply(previous, output);
+        pipeline.apply(current, expected);
+
+        IncrementalReport report = pipeline.applyIncremental(previous, current, output, IncrementalOptions{8, 0.5});
+        ASSERT_FALSE(report.full);
+        ASSERT_LT(report.pixels, current.size() / 2);
+        expectImagesEqual(output, expected);
+    }
+}
+
+TEST(DirtyRegions, ApplyIncrementalFallsBack) {
+    FlatImage previous = createRandomImage(50, 60, 4);
+    FlatImage current = createRandomImage(50, 60, 5);
+    FilterPipeline pipeline = FilterPipeline().addBlur();
+
+    FlatImage output, expected;
+    pipeline.apply(previous, output);
+    pipeline.apply(current, expected);
+    IncrementalReport report = pipeline.applyIncremental(previous, current, output);
+    ASSERT_TRUE(report.full);
+    ASSERT_EQ(report.pixels, current.size());
+    expectImagesEqual(output, expected);
+
+    // no earlier output to update
+    FlatImage empty;
+    ASSERT_TRUE(pipeline.applyIncremental(current, empty, {PixelRect{0, 0, 1, 1}}).full);
+    expectImagesEqual(empty, expected);
+
+    // edges may cross the whole frame
+    FilterPipeline canny = FilterPipeline().addCannyEdgeDetector();
+    canny.apply(previous, output);
+    ASSERT_TRUE(canny.applyIncremental(current, output, {PixelRect{0, 0, 1, 1}}).full);
+    canny.apply(current, expected);
+    expectImagesEqual(output, expected);
+
+    // nothing changed
+    pipeline.apply(current, output);
+    report = pipeline.applyIncremental(current, current, output);
+    ASSERT_FALSE(report.full);
+    ASSERT_EQ(report.pixels, 0u);
+}
+
+// Copies its input and records the policy each call ran under
+class PolicyRecorder : public ImageFilter
+{
+public:
+    void apply(const FlatImage& input, FlatImage& output) const override {
+        output.resize(input.rows(), input.cols());
+        for (int i = 0; i < input.rows(); ++i) {
+            std::copy(input.row(i), input.row(i) + input.cols(), output.row(i));
+        }
+        // long enough for idle workers to take the other rectangles
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        std::lock_guard<std::mutex> lock(mutex);
+        chunksPerWorker.push_back(currentExecutionPolicy().chunksPerWorker);
+    }
+    void applyBenchmark(const cv::Mat& input, cv::Mat& output) const override { output = input.clone(); }
+
+    mutable std::mutex mutex;
+    mutable std::vector<int> chunksPerWorker;
+};
+
+TEST(DirtyRegions, ApplyIncrementalKeepsThePolicyOnWorkers) {
+    FlatImage previous = createRandomImage(200, 200, 6);
+    FlatImage current = previous;
+    std::vector<PixelRect> dirty;
+    for (int k = 0; k < 8; ++k) {
+        dirty.push_back(PixelRect{k * 24, (k * 37) % 180, 4, 4});
+    }
+
+    auto recorder = std::make_shared<PolicyRecorder>();
+    FilterPipeline pipeline = FilterPipeline().add(recorder);
+    ExecutionPolicy policy;
+    policy.parallelMinPixels = 0;
+    policy.chunksPerWorker = 7;
+    pipeline.setExecutionPolicy(policy);
+
+    // an arena with workers, so the rectangles leave the calling thread even on a single core
+    tbb::global_control workers(tbb::global_control::max_allowed_parallelism, 4);
+    FlatImage output;
+    pipeline.apply(previous, output);
+    recorder->chunksPerWorker.clear();
+    IncrementalReport report;
+    tbb::task_arena(4).execute([&] { report = pipeline.applyIncremental(current, output, dirty); });
+    ASSERT_FALSE(report.full);
+    ASSERT_GT(report.recomputed.size(), 1u);
+    ASSERT_EQ(recorder->chunksPerWorker.size(), report.recomputed.size());
+    for (int chunks : recorder->chunksPerWorker) {
+        ASSERT_EQ(chunks, 7);
+    }
+}
@@ -0,0 +1,268 @@
+#include <opencv2/opencv.hpp>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include <tbb/task_arena.h>
+
+#include "filter_pipeline.hpp"
+#include "test_utils.hpp"
+
+
+TEST(FilterPipeline, HaloRadius) {
+    ASSERT_EQ(FilterPipeline().haloRadius(), 0);
+    ASSERT_EQ(FilterPipeline().addBlur().addSobelOperator().haloRadius(), 2);
+    ASSERT_EQ(FilterPipeline().addGaussianBlur(7).addSobelOperator(5).addScharrOperator().haloRadius(), 6);
+    ASSERT_EQ(FilterPipeline().addBlur(15).addBlur().haloRadius(), 8);
+}
+
+TEST(FilterPipeline, TiledMatchesPerStage) {
+    FlatImage input = createRandomImage(100, 77, 1);
+
+    std::vector<FilterPipeline> pipelines;
+    pipelines.push_back(FilterPipeline().addBlur().addSobelOperator());
+    pipelines.push_back(FilterPipeline().addGaussianBlur(7).addScharrOperator().addBlur());
+    pipelines.push_back(FilterPipeline().addLaplacianOfGaussian().addSobelOperator(5));
+    pipelines.push_back(FilterPipeline().addBlur(9).addGaussianBlur(5));
+
+    for (auto& pipeline : pipelines) {
+        FlatImage expected;
+        pipeline.apply(input, expected);
+
+        for (TileOptions options : {TileOptions{16, 16}, TileOptions{7, 13}, TileOptions{1, 77}, TileOptions{}}) {
+            FlatImage tiled;
+            pipeline.applyTiled(input, tiled, options);
+            expectImagesEqual(tiled, expected);
+        }
+    }
+}
+
+TEST(FilterPipeline, ApplyRegion) {
+    FlatImage input = createRandomImage(40, 50, 2);
+    auto pipeline = FilterPipeline().addBlur().addScharrOperator();
+
+    FlatImage expected;
+    pipeline.apply(input, expected);
+
+    FlatImage region(input.rows(), input.cols());
+    pipeline.applyRegion(input, region, 10, 20, 5, 7);
+
+    for (int i = 10; i < 15; ++i) {
+        for (int j = 20; j < 27; ++j) {
+            ASSERT_EQ(region(i, j), expected(i, j));
+        }
+    }
+}
+
+TEST(FilterPipeline, ApplyInPlace) {
+    FlatImage input = createRandomImage(60, 70, 5);
+
+    std::vector<FilterPipeline> pipelines;
+    pipelines.push_back(FilterPipeline());
+    pipelines.push_back(FilterPipeline().addBlur(5));
+    pipelines.push_back(FilterPipeline().addGaussianBlur().addSobelOperator());
+
+    for (auto& pipeline : pipelines) {
+        FlatImage expected;
+        pipeline.apply(input, expected);
+
+        FlatImage image = input;
+        pipeline.apply(image, image);
+        expectImagesEqual(image, expected);
+
+        image = input;
+        pipeline.applyTiled(image, image, {16, 16});
+        expectImagesEqual(image, expected);
+
+        // output viewing the same buffer as the input, shifted by a row
+        FlatImage canvas(input.rows() + 1, input.cols());
+        for (int i = 0; i < input.rows(); ++i) {
+            std::memcpy(canvas.row(i), input.row(i), input.cols());
+        }
+        FlatImage shifted = canvas.subView(1, 0, input.rows(), input.cols());
+        pipeline.apply(canvas.subView(0, 0, input.rows(), input.cols()), shifted);
+        expectImagesEqual(shifted, expected);
+    }
+}
+
+TEST(FilterPipeline, StreamingMatchesWholeImage) {
+    FlatImage input = createRandomImage(97, 45, 3);
+    cv::Mat inputMat = FlatImageFactory::toMat(input);
+
+    std::vector<FilterPipeline> pipelines;
+    pipelines.push_back(FilterPipeline());
+    pipelines.push_back(FilterPipeline().addBlur().addSobelOperator());
+    pipelines.push_back(FilterPipeline().addGaussianBlur(7).addLaplacianOfGaussian().addScharrOperator());
+
+    for (auto& pipeline : pipelines) {
+        FlatImage expected;
+        pipeline.apply(input, expected);
+
+        for (int stripRows : {1, 5, 32, 97, 500}) {
+            MatStripReader reader(inputMat);
+            cv::Mat outputMat;
+            MatStripWriter writer(outputMat, input.rows(), input.cols());
+            pipeline.applyStreaming(reader, writer, stripRows);
+            expectImagesEqual(FlatImageFactory::wrap(outputMat), expected);
+        }
+    }
+
+    MatStripReader reader(inputMat);
+    cv::Mat outputMat;
+    MatStripWriter writer(outputMat, input.rows(), input.cols());
+    ASSERT_THROW(FilterPipeline().applyStreaming(reader, writer, 0), std::invalid_argument);
+}
+
+TEST(FilterPipeline, StreamingPgmFiles) {
+    FlatImage input = createRandomImage(60, 33, 4);
+    const std::string inputPath = testing::TempDir() + "streaming_input.pgm";
+    const std::string outputPath = testing::TempDir() + "streaming_output.pgm";
+    {
+        PgmStripWriter writer(inputPath, input.rows(), input.cols());
+        writer.write(input);
+    }
+
+    auto pipeline = FilterPipeline().addGaussianBlur().addSobelOperator();
+    {
+        PgmStripReader reader(inputPath);
+        ASSERT_EQ(reader.rows(), input.rows());
+        ASSERT_EQ(reader.cols(), input.cols());
+        PgmStripWriter writer(outputPath, reader.rows(), reader.cols());
+        pipeline.applyStreaming(reader, writer, 16);
+    }
+
+    FlatImage expected, streamed(input.rows(), input.cols());
+    pipeline.apply(input, expected);
+    PgmStripReader reader(outputPath);
+    reader.read(streamed);
+    expectImagesEqual(streamed, expected);
+
+    std::remove(inputPath.c_str());
+    std::remove(outputPath.c_str());
+}
+
+TEST(FilterPipeline, BatchMatchesSingleImages) {
+    std::vector<FlatImage> inputs;
+    for (int i = 0; i < 9; ++i) {
+        inputs.push_back(createRandomImage(20 + 3 * i, 31 - i, i));
+    }
+    auto pipeline = FilterPipeline().addGaussianBlur().addSobelOperator();
+
+    for (auto parallelism : {BatchParallelism::Auto, BatchParallelism::AcrossImages, BatchParallelism::AcrossRows, BatchParallelism::Both}) {
+        std::vector<FlatImage> outputs;
+        BatchReport report = pipeline.applyBatch(inputs, outputs, {parallelism});
+
+        ASSERT_EQ(report.images, inputs.size());
+        ASSERT_GT(report.imagesPerSecond, 0);
+        if (parallelism != BatchParallelism::Auto) {
+            ASSERT_EQ(report.parallelism, parallelism);
+        }
+        ASSERT_EQ(outputs.size(), inputs.size());
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            FlatImage expected;
+            pipeline.apply(inputs[i], expected);
+            expectImagesEqual(outputs[i], expected);
+        }
+    }
+
+    // a single large image goes to the row-parallel path, many thumbnails to one image per task
+    std::vector<FlatImage> outputs;
+    ASSERT_EQ(pipeline.applyBatch({createRandomImage(64, 64)}, outputs, {BatchParallelism::Auto, 1024}).parallelism, BatchParallelism::AcrossRows);
+    ASSERT_EQ(pipeline.applyBatch(std::vector<FlatImage>(256, createRandomImage(8, 8)), outputs).parallelism, BatchParallelism::AcrossImages);
+}
+
+TEST(ExecutionPolicy, ModeForThresholds) {
+    ExecutionPolicy policy;
+    policy.parallelMinPixels = 100;
+    policy.tileMinPixels = 1000;
+
+    tbb::task_arena arena(4);
+    arena.execute([&] {
+        ASSERT_EQ(policy.modeFor(99), ExecutionMode::Serial);
+        ASSERT_EQ(policy.modeFor(100), ExecutionMode::ChunkedParallel);
+        ASSERT_EQ(policy.modeFor(1000), ExecutionMode::TileParallel);
+        ASSERT_EQ(ExecutionPolicy::serial().modeFor(1 << 30), ExecutionMode::Serial);
+
+        ASSERT_EQ(policy.chunksFor(1000, 50), 1);
+        ASSERT_EQ(policy.chunksFor(3, 500), 3);
+        ASSERT_EQ(policy.chunksFor(1000, 500), 4 * policy.chunksPerWorker);
+    });
+
+    // a single worker never forks
+    tbb::task_arena single(1);
+    single.execute([&] { ASSERT_EQ(policy.modeFor(500), ExecutionMode::Serial); });
+}
+
+TEST(ExecutionPolicy, Scopes) {
+    ExecutionPolicy policy;
+    policy.parallelMinPixels = 7;
+
+    ASSERT_EQ(currentExecutionPolicy().parallelMinPixels, defaultExecutionPolicy().parallelMinPixels);
+    {
+        ExecutionPolicyScope scope(policy);
+        ASSERT_EQ(currentExecutionPolicy().parallelMinPixels, 7u);
+        {
+            SerialRowsScope serial;
+            ASSERT_EQ(currentExecutionPolicy().modeFor(1 << 30), ExecutionMode::Serial);
+
+            std::vector<int> visited;
+            forEachIndex(5, 1 << 30, [&](int index) { visited.push_back(index); });
+            ASSERT_EQ(visited, std::vector<int>({0, 1, 2, 3, 4}));
+        }
+        ASSERT_EQ(currentExecutionPolicy().parallelMinPixels, 7u);
+    }
+    ASSERT_EQ(currentExecutionPolicy().parallelMinPixels, defaultExecutionPolicy().parallelMinPixels);
+}
+
+TEST(ExecutionPolicy, PublishesDefaultSnapshots) {
+    const ExecutionPolicy original = defaultExecutionPolicy();
+    FlatImage input = createRandomImage(64, 64, 9);
+    auto pipeline = FilterPipeline().addBlur().addSobelOperator();
+    FlatImage expected;
+    pipeline.apply(input, expected);
+
+    // a writer swapping the default while pipelines run on other threads
+    std::atomic<bool> done = false;
+    std::thread writer([&] {
+        for (size_t pixels = 1; !done; pixels = pixels % 4096 + 1) {
+            ExecutionPolicy policy = original;
+            policy.parallelMinPixels = pixels;
+            setDefaultExecutionPolicy(policy);
+        }
+    });
+    for (int frame = 0; frame < 20; ++frame) {
+        FlatImage output;
+        pipeline.apply(input, output);
+        expectImagesEqual(output, expected);
+    }
+    done = true;
+    writer.join();
+
+    setDefaultExecutionPolicy(original);
+    ASSERT_EQ(defaultExecutionPolicy().parallelMinPixels, original.parallelMinPixels);
+    ASSERT_EQ(FilterPipeline().executionPolicy().parallelMinPixels, original.parallelMinPixels);
+}
+
+TEST(FilterPipeline, ExecutionModesMatch) {
+    FlatImage input = createRandomImage(120, 90, 8);
+    auto pipeline = FilterPipeline().addGaussianBlur(7).addSobelOperator().addBlur();
+
+    FlatImage expected;
+    pipeline.setExecutionPolicy(ExecutionPolicy::serial());
+    pipeline.apply(input, expected);
+
+    tbb::task_arena arena(4);
+    arena.execute([&] {
+        for (size_t tileMinPixels : {size_t(1) << 30, size_t(1)}) {
+            ExecutionPolicy policy;
+            policy.parallelMinPixels = 1;
+            policy.tileMinPixels = tileMinPixels;
+            pipeline.setExecutionPolicy(policy);
+
+            FlatImage actual;
+            pipeline.apply(input, actual);
+            expectImagesEqual(actual, expected);
+        }
+    });
+}
@@ -0,0 +1,19 @@
+#include <gtest/gtest.h>
+
+#include "fixed_point.hpp"
+
+
+TEST(FixedPointDivisor, RoundsToNearestOverTheWholeRange) {
+    for (uint32_t divisor : {1u, 2u, 3u, 9u, 16u, 25u, 49u, 81u, 121u, 256u, 961u, 4096u, 10201u}) {
+        const uint32_t maxDividend = 255 * divisor;
+        const FixedPointDivisor divide(divisor, maxDividend);
+        for (uint32_t x = 0; x <= maxDividend; ++x) {
+            ASSERT_EQ(divide(x), (x + divisor / 2) / divisor) << "divisor " << divisor << " dividend " << x;
+        }
+    }
+}
+
+TEST(FixedPointDivisor, InvalidDivisor) {
+    ASSERT_THROW(FixedPointDivisor(0, 10), std::invalid_argument);
+    ASSERT_THROW(FixedPointDivisor(10, UINT32_MAX), std::invalid_argument);
+}
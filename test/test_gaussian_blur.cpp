@@ -0,0 +1,75 @@
+#include <opencv2/opencv.hpp>
+#include <gtest/gtest.h>
+
+#include "gaussian_blur.hpp"
+#include "test_utils.hpp"
+
+
+TEST(GaussianBlur, TestGaussianBlurUniform) {
+    FlatImage input = createTestImage(5, 5, 200);
+
+    for (int ksize : {3, 5, 7}) {
+        FlatImage output;
+        GaussianBlur(ksize).apply(input, output);
+
+        ASSERT_EQ(output.rows(), input.rows());
+        ASSERT_EQ(output.cols(), input.cols());
+        expectImagesEqual(output, input);
+    }
+}
+
+TEST(GaussianBlur, TestGaussianBlurImpulse) {
+    FlatImage input(9, 9);
+    input(4, 4) = 255;
+    FlatImage output;
+
+    GaussianBlur(3).apply(input, output);
+
+    // 255 * {1, 2, 1} x {1, 2, 1} / 16, rounded to nearest
+    ASSERT_EQ(output(4, 4), 64);
+    ASSERT_EQ(output(3, 4), 32);
+    ASSERT_EQ(output(3, 3), 16);
+    ASSERT_EQ(output(2, 2), 0);
+}
+
+// Dense Gaussian with replicated borders, divided with round-to-nearest
+template <size_t N>
+static FlatImage referenceGaussian(const FlatImage& input, const std::array<int, N>& taps) {
+    const int radius = N / 2;
+    int weight = 0;
+    for (int tap : taps) {
+        weight += tap;
+    }
+    const int divisor = weight * weight;
+    FlatImage output(input.rows(), input.cols());
+    for (int i = 0; i < input.rows(); ++i) {
+        for (int j = 0; j < input.cols(); ++j) {
+            int sum = 0;
+            for (int r = -radius; r <= radius; ++r) {
+                for (int c = -radius; c <= radius; ++c) {
+                    sum += taps[r + radius] * taps[c + radius] *
+                           input(std::clamp(i + r, 0, input.rows() - 1), std::clamp(j + c, 0, input.cols() - 1));
+                }
+            }
+            output(i, j) = static_cast<uchar>((sum + divisor / 2) / divisor);
+        }
+    }
+    return output;
+}
+
+TEST(GaussianBlur, MatchesDenseKernels) {
+    FlatImage input = createRandomImage(41, 67, 3);
+    FlatImage output;
+
+    GaussianBlur(3).apply(input, output);
+    expectImagesEqual(output, referenceGaussian(input, kernels::GAUSSIAN_3));
+    GaussianBlur(5).apply(input, output);
+    expectImagesEqual(output, referenceGaussian(input, kernels::GAUSSIAN_5));
+    GaussianBlur(7).apply(input, output);
+    expectImagesEqual(output, referenceGaussian(input, kernels::GAUSSIAN_7));
+}
+
+TEST(GaussianBlur, TestInvalidKernelSize) {
+    ASSERT_THROW(GaussianBlur(4), std::invalid_argument);
+    ASSERT_THROW(GaussianBlur(9), std::invalid_argument);
+}
@@ -0,0 +1,126 @@
+#include <opencv2/opencv.hpp>
+#include <gtest/gtest.h>
+
+#include "blur.hpp"
+#include "gradient_field.hpp"
+#include "scharr.hpp"
+#include "sobel.hpp"
+#include "test_utils.hpp"
+
+
+// Raw responses of a square kernel with replicated borders; kernel(r, c) returns the taps
+template <typename KernelType>
+static int referenceResponse(const FlatImage& image, int i, int j, const KernelType& kernel, int size) {
+    const int radius = size / 2;
+    int response = 0;
+    for (int r = 0; r < size; ++r) {
+        for (int c = 0; c < size; ++c) {
+            response += image(std::clamp(i + r - radius, 0, image.rows() - 1), std::clamp(j + c - radius, 0, image.cols() - 1)) * kernel(r, c);
+        }
+    }
+    return response;
+}
+
+static auto taps(const int (&kernel)[3][3]) {
+    return [&kernel](int r, int c) { return kernel[r][c]; };
+}
+
+template <typename KernelType>
+static void expectFieldMatches(const GradientField& field, const FlatImage& image, const KernelType& kernelX, const KernelType& kernelY, int size) {
+    ASSERT_EQ(field.gx.rows(), image.rows());
+    ASSERT_EQ(field.gx.cols(), image.cols());
+    for (int i = 0; i < image.rows(); ++i) {
+        for (int j = 0; j < image.cols(); ++j) {
+            const int gx = std::clamp(referenceResponse(image, i, j, kernelX, size), -32768, 32767);
+            const int gy = std::clamp(referenceResponse(image, i, j, kernelY, size), -32768, 32767);
+            ASSERT_EQ(field.gx(i, j), gx) << "at (" << i << ", " << j << ")";
+            ASSERT_EQ(field.gy(i, j), gy) << "at (" << i << ", " << j << ")";
+            ASSERT_EQ(field.magnitude(i, j), gradientMagnitude(gx, gy, field.norm)) << "at (" << i << ", " << j << ")";
+            ASSERT_EQ(field.orientation(i, j), static_cast<uchar>(quantizeDirection(gx, gy))) << "at (" << i << ", " << j << ")";
+        }
+    }
+}
+
+TEST(GradientField, QuantizesDirections) {
+    ASSERT_EQ(quantizeDirection(100, 0), GradientDirection::Horizontal);
+    ASSERT_EQ(quantizeDirection(-100, 40), GradientDirection::Horizontal);
+    ASSERT_EQ(quantizeDirection(0, -100), GradientDirection::Vertical);
+    ASSERT_EQ(quantizeDirection(40, 100), GradientDirection::Vertical);
+    ASSERT_EQ(quantizeDirection(100, 100), GradientDirection::Diagonal);
+    ASSERT_EQ(quantizeDirection(-100, -43), GradientDirection::Diagonal);
+    ASSERT_EQ(quantizeDirection(100, -100), GradientDirection::AntiDiagonal);
+    ASSERT_EQ(quantizeDirection(-43, 100), GradientDirection::AntiDiagonal);
+
+    // boundaries of cv::Canny: 100 * tan(22.5 deg) = 41.42 and 100 * tan(67.5 deg) = 241.42
+    ASSERT_EQ(quantizeDirection(100, 41), GradientDirection::Horizontal);
+    ASSERT_EQ(quantizeDirection(100, 42), GradientDirection::Diagonal);
+    ASSERT_EQ(quantizeDirection(-100, 241), GradientDirection::AntiDiagonal);
+    ASSERT_EQ(quantizeDirection(-100, 242), GradientDirection::Vertical);
+
+    ASSERT_FLOAT_EQ(gradientMagnitude(3, -4, GradientNorm::L2), 5.0f);
+    ASSERT_FLOAT_EQ(gradientMagnitude(3, -4, GradientNorm::L1), 7.0f);
+}
+
+TEST(GradientField, SobelMatchesBruteForce) {
+    for (GradientNorm norm : {GradientNorm::L1, GradientNorm::L2}) {
+        for (auto [rows, cols] : {std::pair{1, 1}, {2, 3}, {37, 70}, {64, 129}}) {
+            FlatImage input = createRandomImage(rows, cols, rows + cols);
+            GradientField field;
+            field.norm = norm;
+            SobelOperator().applyGradientField(input, field);
+            expectFieldMatches(field, input, taps(SobelOperator::KERNELX), taps(SobelOperator::KERNELY), 3);
+        }
+    }
+}
+
+TEST(GradientField, ScharrAndLargeSobelMatchBruteForce) {
+    FlatImage input = createRandomImage(41, 75, 3);
+    GradientField field;
+
+    ScharrOperator().applyGradientField(input, field);
+    expectFieldMatches(field, input, taps(ScharrOperator::KERNELX), taps(ScharrOperator::KERNELY), 3);
+
+    SobelOperator(5).applyGradientField(input, field);
+    expectFieldMatches(field, input, kernels::SOBEL_5X5_X, kernels::SOBEL_5X5_Y, 5);
+
+    // 7x7 responses exceed int16 and saturate
+    SobelOperator(7).applyGradientField(input, field);
+    expectFieldMatches(field, input, kernels::SOBEL_7X7_X, kernels::SOBEL_7X7_Y, 7);
+}
+
+TEST(GradientField, WritesOnlyRequestedOutputs) {
+    FlatImage input = createRandomImage(30, 50, 9);
+    GradientField full, partial;
+    partial.outputs = GradientMagnitude | GradientOrientation;
+    SobelOperator().applyGradientField(input, full);
+    SobelOperator().applyGradientField(input, partial);
+
+    ASSERT_TRUE(partial.gx.empty());
+    ASSERT_TRUE(partial.gy.empty());
+    ASSERT_TRUE(std::equal(full.magnitude.begin(), full.magnitude.end(), partial.magnitude.begin()));
+    expectImagesEqual(partial.orientation, full.orientation);
+}
+
+TEST(GradientField, StepEdgeOrientation) {
+    // intensity rises to the right: horizontal gradient, positive gx
+    FlatImage input(8, 8);
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            input(i, j) = j < 4 ? 10 : 200;
+        }
+    }
+    GradientField field;
+    SobelOperator().applyGradientField(input, field);
+
+    ASSERT_EQ(field.gx(4, 4), 4 * 190);
+    ASSERT_EQ(field.gy(4, 4), 0);
+    ASSERT_FLOAT_EQ(field.magnitude(4, 4), 760.0f);
+    ASSERT_EQ(field.orientation(4, 4), static_cast<uchar>(GradientDirection::Horizontal));
+    ASSERT_FLOAT_EQ(field.magnitude(4, 1), 0.0f);
+}
+
+TEST(GradientField, OtherFiltersThrow) {
+    FlatImage input = createRandomImage(4, 4);
+    GradientField field;
+    ASSERT_THROW(Blur(3).applyGradientField(input, field), std::invalid_argument);
+}
@@ -1,7 +1,15 @@
 #include <opencv2/opencv.hpp>
 #include <gtest/gtest.h>
 
+#include "adaptive_threshold.hpp"
+#include "blur.hpp"
+#include "canny.hpp"
+#include "gaussian_blur.hpp"
 #include "image_filter.hpp"
+#include "laplacian_of_gaussian.hpp"
+#include "local_variance.hpp"
+#include "scharr.hpp"
+#include "sobel.hpp"
 #include "test_utils.hpp"
 
 class ImageFilterTest : public ImageFilter , public ::testing::Test {
@@ -36,6 +44,24 @@ TEST_F(ImageFilterTest, PadBoundaries) {
     }
 }
 
+TEST_F(ImageFilterTest, PadBoundariesEmpty) {
+    for (auto [rows, cols] : {std::pair{0, 0}, std::pair{0, 4}, std::pair{3, 0}}) {
+        FlatImage input(rows, cols);
+        FlatImage padded;
+        auto [padded_rows, padded_cols] = padBoundaries(input, padded, 2);
+        ASSERT_EQ(padded_rows, rows + 4);
+        ASSERT_EQ(padded_cols, cols + 4);
+        for (uchar pixel : padded) {
+            ASSERT_EQ(pixel, 0);
+        }
+
+        FlatImage unpadded;
+        removeBoundaries(padded, unpadded, 2);
+        ASSERT_EQ(unpadded.rows(), rows);
+        ASSERT_EQ(unpadded.cols(), cols);
+    }
+}
+
 TEST_F(ImageFilterTest, RemoveBoundaries) {
     FlatImage input = createTestImage(5, 5);
     FlatImage output;
@@ -172,3 +198,273 @@ TEST_F(ImageFilterTest, ApplyXYKernels) {
         }
     }
 }
+
+TEST_F(ImageFilterTest, FusedXYGradientMatchesMultiPass) {
+    const std::vector<std::pair<int, int>> sizes = {{1, 1}, {1, 9}, {9, 1}, {2, 2}, {7, 13}, {64, 97}};
+
+    for (auto [rows, cols] : sizes) {
+        FlatImage input = createRandomImage(rows, cols, rows * 31 + cols);
+
+        for (uchar threshold : {0, 50}) {
+            FlatImage fused, multiPass;
+
+            fusedXYGradient(input, fused, SobelOperator::KERNELX, SobelOperator::KERNELY, threshold);
+            applyXYKernelsMultiPass(input, multiPass, SobelOperator::KERNELX, SobelOperator::KERNELY, threshold);
+            expectImagesEqual(fused, multiPass);
+
+            fusedXYGradient(input, fused, ScharrOperator::KERNELX, ScharrOperator::KERNELY, threshold);
+            applyXYKernelsMultiPass(input, multiPass, ScharrOperator::KERNELX, ScharrOperator::KERNELY, threshold);
+            expectImagesEqual(fused, multiPass);
+        }
+    }
+}
+
+TEST_F(ImageFilterTest, FusedXYGradientFloatKernel) {
+    FlatImage input = createRandomImage(16, 16, 7);
+    FlatImage fused, multiPass;
+
+    const float kernelX[3][3] = {
+        {-.5f, 0, .5f},
+        {-1.1f, 0, 1.1f},
+        {-.5f, 0, .5f}
+    };
+
+    const float kernelY[3][3] = {
+        {.5f, 1.1f, .5f},
+        {0, 0, 0},
+        {-.5f, -1.1f, -.5f}
+    };
+
+    fusedXYGradient(input, fused, kernelX, kernelY);
+    applyXYKernelsMultiPass(input, multiPass, kernelX, kernelY);
+    expectImagesEqual(fused, multiPass);
+}
+
+TEST_F(ImageFilterTest, FusedSingleGradientMatchesMultiPass) {
+    const int kernel[3][3] = {
+        {1, -2, 3},
+        {-4, 5, -6},
+        {7, -8, 9}
+    };
+
+    for (auto [rows, cols] : std::vector<std::pair<int, int>>{{1, 1}, {3, 40}, {33, 65}}) {
+        FlatImage input = createRandomImage(rows, cols, rows + cols);
+
+        for (uchar threshold : {0, 50}) {
+            FlatImage fused, padded, gradient, multiPass;
+
+            fusedSingleGradient(input, fused, kernel, threshold);
+
+            auto [padded_rows, padded_cols] = padBoundaries(input, padded);
+            getGradient(padded, gradient, padded_rows, padded_cols, kernel, threshold);
+            removeBoundaries(gradient, multiPass);
+
+            expectImagesEqual(fused, multiPass);
+        }
+    }
+}
+
+TEST_F(ImageFilterTest, FactorizeKernel) {
+    SeparableKernel<int> separable;
+
+    ASSERT_TRUE(factorizeKernel(SobelOperator::KERNELX, separable));
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            ASSERT_EQ(separable.column[r] * separable.row[c], SobelOperator::KERNELX[r][c]);
+        }
+    }
+
+    ASSERT_TRUE(factorizeKernel(ScharrOperator::KERNELY, separable));
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            ASSERT_EQ(separable.column[r] * separable.row[c], ScharrOperator::KERNELY[r][c]);
+        }
+    }
+
+    const int laplacian[3][3] = {
+        {0, 1, 0},
+        {1, -4, 1},
+        {0, 1, 0}
+    };
+    ASSERT_FALSE(factorizeKernel(laplacian, separable));
+
+    const int zero[3][3] = {};
+    ASSERT_FALSE(factorizeKernel(zero, separable));
+}
+
+TEST_F(ImageFilterTest, SeparableMatchesDense) {
+    const SeparableKernel<int> gaussian = {{1, 2, 1}, {1, 2, 1}};
+    const SeparableKernel<int> wide = {{20, 40, 20}, {-9, 0, 9}}; // too heavy for int16, runs in int32
+    const SeparableKernel<int> kernels[] = {SobelOperator::SEPARABLE_KERNELX, SobelOperator::SEPARABLE_KERNELY,
+                                            ScharrOperator::SEPARABLE_KERNELX, ScharrOperator::SEPARABLE_KERNELY,
+                                            gaussian, wide};
+
+    auto expand = [](const SeparableKernel<int>& separable, int kernel[3][3]) {
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                kernel[r][c] = separable.column[r] * separable.row[c];
+            }
+        }
+    };
+
+    for (auto [rows, cols] : std::vector<std::pair<int, int>>{{1, 1}, {2, 3}, {17, 40}, {70, 129}}) {
+        FlatImage input = createRandomImage(rows, cols, rows * cols);
+
+        for (uchar threshold : {0, 50}) {
+            for (size_t k = 0; k < std::size(kernels); k += 2) {
+                int denseX[3][3], denseY[3][3];
+                expand(kernels[k], denseX);
+                expand(kernels[k + 1], denseY);
+
+                FlatImage separable, dense;
+                separableXYGradient(input, separable, kernels[k], kernels[k + 1], threshold);
+                fusedXYGradient(input, dense, denseX, denseY, threshold);
+                expectImagesEqual(separable, dense);
+
+                separableSingleGradient(input, separable, kernels[k], threshold);
+                fusedSingleGradient(input, dense, denseX, threshold);
+                expectImagesEqual(separable, dense);
+            }
+        }
+    }
+}
+
+TEST_F(ImageFilterTest, PadBoundariesRadius) {
+    FlatImage input = createRandomImage(4, 6, 3);
+
+    for (int radius : {2, 3}) {
+        FlatImage padded, unpadded;
+        auto [padded_rows, padded_cols] = padBoundaries(input, padded, radius);
+
+        ASSERT_EQ(padded_rows, input.rows() + 2 * radius);
+        ASSERT_EQ(padded_cols, input.cols() + 2 * radius);
+        for (int i = 0; i < padded_rows; ++i) {
+            for (int j = 0; j < padded_cols; ++j) {
+                int si = std::clamp(i - radius, 0, input.rows() - 1);
+                int sj = std::clamp(j - radius, 0, input.cols() - 1);
+                ASSERT_EQ(padded(i, j), input(si, sj));
+            }
+        }
+
+        removeBoundaries(padded, unpadded, radius);
+        expectImagesEqual(unpadded, input);
+    }
+}
+
+TEST_F(ImageFilterTest, KernelMatchesDenseArray) {
+    FlatImage input = createRandomImage(23, 31, 5);
+    FlatImage expected, actual, dynamic;
+
+    const Kernel<int, 3, 3> kernelX = {{-3, 0, 3, -10, 0, 10, -3, 0, 3}};
+    const Kernel<int, 3, 3> kernelY = {{3, 10, 3, 0, 0, 0, -3, -10, -3}};
+
+    applyXYKernels(input, expected, ScharrOperator::KERNELX, ScharrOperator::KERNELY, 50);
+    applyXYKernels(input, actual, kernelX, kernelY, 50);
+    expectImagesEqual(actual, expected);
+
+    applyXYKernels(input, dynamic, DynamicKernel<int>(kernelX), DynamicKernel<int>(kernelY), 50);
+    expectImagesEqual(dynamic, expected);
+}
+
+TEST_F(ImageFilterTest, DynamicKernelMatchesStatic) {
+    FlatImage input = createRandomImage(19, 17, 9);
+    FlatImage unrolled, dynamic;
+
+    applySingleKernel(input, unrolled, kernels::GAUSSIAN_7X7);
+    applySingleKernel(input, dynamic, DynamicKernel<int>(kernels::GAUSSIAN_7X7));
+    expectImagesEqual(dynamic, unrolled);
+
+    applyXYKernels(input, unrolled, kernels::SOBEL_5X5_X, kernels::SOBEL_5X5_Y, 50);
+    applyXYKernels(input, dynamic, DynamicKernel<int>(kernels::SOBEL_5X5_X), DynamicKernel<int>(kernels::SOBEL_5X5_Y), 50);
+    expectImagesEqual(dynamic, unrolled);
+
+    ASSERT_THROW(DynamicKernel<int>(2, 3, {1, 2, 3, 4, 5, 6}), std::invalid_argument);
+}
+
+TEST_F(ImageFilterTest, NonSquareKernel) {
+    FlatImage input = createRandomImage(8, 8, 11);
+    FlatImage output;
+
+    // 1x3 horizontal difference, padded by max(radius) = 1
+    const Kernel<int, 1, 3> kernel = {{-1, 0, 1}};
+    applySingleKernel(input, output, kernel);
+
+    ASSERT_EQ(output.rows(), input.rows());
+    ASSERT_EQ(output.cols(), input.cols());
+    for (int i = 0; i < input.rows(); ++i) {
+        for (int j = 0; j < input.cols(); ++j) {
+            int left = input(i, std::max(j - 1, 0));
+            int right = input(i, std::min(j + 1, input.cols() - 1));
+            ASSERT_EQ(output(i, j), std::abs(right - left));
+        }
+    }
+}
+
+TEST_F(ImageFilterTest, BorderedSourceReadsInPlace) {
+    FlatImage input = createRandomImage(21, 26, 13);
+
+    FlatImage scratch;
+    const FlatImage& copied = borderedSource(input, scratch, 3);
+    ASSERT_EQ(&copied, &scratch);
+    ASSERT_EQ(copied.border(), 3);
+    expectImagesEqual(copied, input);
+
+    FlatImage guarded(input.rows(), input.cols(), 3);
+    for (int i = 0; i < input.rows(); ++i) {
+        std::copy(input.row(i), input.row(i) + input.cols(), guarded.row(i));
+    }
+    guarded.fillBorder(3);
+    ASSERT_EQ(&borderedSource(guarded, scratch, 2), &guarded);
+    ASSERT_EQ(&borderedSource(guarded, scratch, 4), &scratch);
+
+    FlatImage expected, actual;
+    applySingleKernel(input, expected, kernels::GAUSSIAN_7X7);
+    applySingleKernel(guarded, actual, kernels::GAUSSIAN_7X7);
+    expectImagesEqual(actual, expected);
+
+    applyXYKernels(input, expected, kernels::SOBEL_5X5_X, kernels::SOBEL_5X5_Y, 50);
+    applyXYKernels(guarded, actual, kernels::SOBEL_5X5_X, kernels::SOBEL_5X5_Y, 50);
+    expectImagesEqual(actual, expected);
+}
+
+TEST(ImageFilter, ApplyInPlace) {
+    const std::vector<std::shared_ptr<const ImageFilter>> filters = {
+        std::make_shared<Blur>(), std::make_shared<Blur>(9), std::make_shared<GaussianBlur>(5),
+        std::make_shared<SobelOperator>(3), std::make_shared<SobelOperator>(5), std::make_shared<ScharrOperator>(),
+        std::make_shared<LaplacianOfGaussian>(), std::make_shared<LocalVariance>(), std::make_shared<AdaptiveThreshold>(),
+        std::make_shared<CannyEdgeDetector>()};
+    const FlatImage input = createRandomImage(40, 37, 9);
+
+    for (const auto& filter : filters) {
+        SCOPED_TRACE(filter->signature());
+        FlatImage expected;
+        filter->apply(input, expected);
+
+        FlatImage image = input;
+        filter->apply(image, image);
+        expectImagesEqual(image, expected);
+
+        // output one row below the input in the same buffer
+        FlatImage buffer(41, 37);
+        for (int i = 0; i < 40; ++i) {
+            std::copy(input.row(i), input.row(i) + 37, buffer.row(i));
+        }
+        FlatImage shifted = buffer.subView(1, 0, 40, 37);
+        filter->apply(buffer.subView(0, 0, 40, 37), shifted);
+        expectImagesEqual(shifted, expected);
+    }
+
+    ChannelImage<uchar> channels(23, 19, 3);
+    for (int i = 0; i < 23; ++i) {
+        std::copy(input.row(i), input.row(i) + 57 - 37, channels.samples().row(i));
+        std::copy(input.row(i + 1), input.row(i + 1) + 37, channels.samples().row(i) + 57 - 37);
+    }
+    for (const auto& filter : {filters[1], filters[4]}) {
+        ChannelImage<uchar> expected, image = channels;
+        filter->applyChannels(channels, expected);
+        filter->applyChannels(image, image);
+        for (int i = 0; i < 23; ++i) {
+            ASSERT_TRUE(std::equal(image.samples().row(i), image.samples().row(i) + 57, expected.samples().row(i))) << "row " << i;
+        }
+    }
+}
@@ -0,0 +1,130 @@
+#include <opencv2/opencv.hpp>
+#include <gtest/gtest.h>
+
+#include "filter_pipeline.hpp"
+#include "image_pyramid.hpp"
+#include "test_utils.hpp"
+
+
+static int reflect101(int i, int count) {
+    if (count == 1) {
+        return 0;
+    }
+    while (i < 0 || i >= count) {
+        i = i < 0 ? -i : 2 * count - 2 - i;
+    }
+    return i;
+}
+
+// cv::pyrDown written out: the full 5x5 Gaussian, then every other pixel
+static FlatImage referenceDownsample(const FlatImage& input) {
+    const int taps[5] = {1, 4, 6, 4, 1};
+    FlatImage output((input.rows() + 1) / 2, (input.cols() + 1) / 2);
+    for (int i = 0; i < output.rows(); ++i) {
+        for (int j = 0; j < output.cols(); ++j) {
+            int sum = 0;
+            for (int di = 0; di < 5; ++di) {
+                for (int dj = 0; dj < 5; ++dj) {
+                    sum += taps[di] * taps[dj] * input(reflect101(2 * i + di - 2, input.rows()), reflect101(2 * j + dj - 2, input.cols()));
+                }
+            }
+            output(i, j) = static_cast<uchar>((sum + 128) >> 8);
+        }
+    }
+    return output;
+}
+
+TEST(ImagePyramid, DownsampleMatchesReference) {
+    for (auto [rows, cols] : {std::pair{1, 1}, std::pair{1, 9}, std::pair{8, 1}, std::pair{2, 3}, std::pair{5, 7}, std::pair{64, 65}, std::pair{101, 130}}) {
+        FlatImage input = createRandomImage(rows, cols, rows * 131 + cols);
+        FlatImage output;
+        gaussianDownsample(input, output);
+        expectImagesEqual(output, referenceDownsample(input));
+    }
+
+    // strided view input, chunked rows
+    ExecutionPolicy chunked;
+    chunked.parallelMinPixels = 0;
+    chunked.chunksPerWorker = 16;
+    ExecutionPolicyScope scope(chunked);
+    FlatImage image = createRandomImage(90, 80, 3);
+    FlatImage view = image.subView(5, 7, 77, 61);
+    FlatImage output;
+    gaussianDownsample(view, output);
+    expectImagesEqual(output, referenceDownsample(FlatImage(view)));
+}
+
+TEST(ImagePyramid, LevelsShareOneBuffer) {
+    FlatImage base = createRandomImage(100, 150, 4);
+    ImagePyramid pyramid(base, 4);
+
+    ASSERT_EQ(pyramid.levels(), 4);
+    expectImagesEqual(pyramid.level(0), base);
+    const std::pair<int, int> shapes[4] = {{100, 150}, {50, 75}, {25, 38}, {13, 19}};
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQ(pyramid.level(i).rows(), shapes[i].first);
+        ASSERT_EQ(pyramid.level(i).cols(), shapes[i].second);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(pyramid.level(i).data()) % 64, 0u);
+        if (i > 0) {
+            ASSERT_GT(pyramid.level(i).data(), pyramid.level(i - 1).data());
+            expectImagesEqual(pyramid.level(i), referenceDownsample(pyramid.level(i - 1)));
+        }
+    }
+    ASSERT_LT(pyramid.level(3).data() + pyramid.level(3).size(), pyramid.level(0).data() + pyramid.bytes() + 1);
+
+    // about 4/3 of the base, plus alignment
+    ASSERT_EQ(pyramid.size(), 15000u + 3750u + 950u + 247u);
+    ASSERT_LE(pyramid.bytes(), pyramid.size() + 4 * 64);
+    ASSERT_LE(pyramid.size(), base.size() * 4 / 3 + 4 * 64);
+
+    // rebuilding the same shape reuses the buffer
+    const uchar* data = pyramid.level(0).data();
+    pyramid.build(createRandomImage(100, 150, 5), 4);
+    ASSERT_EQ(pyramid.level(0).data(), data);
+}
+
+TEST(ImagePyramid, StopsAtOnePixel) {
+    ImagePyramid pyramid(createRandomImage(5, 3, 6), 10);
+    ASSERT_EQ(pyramid.levels(), 4); // 5x3, 3x2, 2x1, 1x1
+    ASSERT_EQ(pyramid.level(3).size(), 1u);
+
+    ImagePyramid empty(FlatImage(), 3);
+    ASSERT_EQ(empty.levels(), 0);
+    EXPECT_THROW(ImagePyramid(createRandomImage(4, 4), 0), std::invalid_argument);
+}
+
+TEST(ImagePyramid, FilterMatchesPerLevelPipeline) {
+    ImagePyramid pyramid(createRandomImage(120, 90, 7), 5);
+    FilterPipeline pipeline = FilterPipeline().addBlur().addSobelOperator();
+
+    ImagePyramid filtered;
+    pyramid.filter(pipeline, filtered);
+    ASSERT_EQ(filtered.levels(), pyramid.levels());
+    for (int i = 0; i < pyramid.levels(); ++i) {
+        FlatImage expected;
+        pipeline.apply(pyramid.level(i), expected);
+        expectImagesEqual(filtered.level(i), expected);
+    }
+
+    // filtering again reuses the output buffer
+    const uchar* data = filtered.level(0).data();
+    pyramid.filter(FilterPipeline().addGaussianBlur(), filtered, BatchOptions{BatchParallelism::AcrossImages});
+    ASSERT_EQ(filtered.level(0).data(), data);
+    FlatImage expected;
+    FilterPipeline().addGaussianBlur().apply(pyramid.level(2), expected);
+    expectImagesEqual(filtered.level(2), expected);
+}
+
+TEST(ImagePyramid, CopiesOwnTheirPixels) {
+    ImagePyramid pyramid(createRandomImage(40, 40, 8), 3);
+    ImagePyramid copy = pyramid;
+    ASSERT_NE(copy.level(1).data(), pyramid.level(1).data());
+    expectImagesEqual(copy.level(1), pyramid.level(1));
+
+    copy.level(1)(0, 0) ^= 1;
+    ASSERT_NE(copy.level(1)(0, 0), pyramid.level(1)(0, 0));
+
+    ImagePyramid moved = std::move(copy);
+    ASSERT_EQ(moved.levels(), 3);
+    expectImagesEqual(moved.level(2), pyramid.level(2));
+}
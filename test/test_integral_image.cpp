@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include "integral_image.hpp"
+#include "parallel_utils.hpp"
+#include "test_utils.hpp"
+
+
+// Sum over the replicated-border window, summed pixel by pixel
+static uint64_t referenceSum(const FlatImage& image, int top, int left, int rows, int cols, bool squares = false) {
+    uint64_t sum = 0;
+    for (int i = top; i < top + rows; ++i) {
+        for (int j = left; j < left + cols; ++j) {
+            const uint64_t px = image(std::clamp(i, 0, image.rows() - 1), std::clamp(j, 0, image.cols() - 1));
+            sum += squares ? px * px : px;
+        }
+    }
+    return sum;
+}
+
+TEST(IntegralImage, TablesMatchBruteForceSums) {
+    FlatImage input = createRandomImage(23, 31);
+    IntegralImage integral;
+    integral.build(input, 4);
+
+    ASSERT_EQ(integral.sums().rows(), 23 + 8 + 1);
+    ASSERT_EQ(integral.sums().cols(), 31 + 8 + 1);
+    for (int i = -4; i <= 23 + 4; ++i) {
+        for (int j = -4; j <= 31 + 4; ++j) {
+            ASSERT_EQ(integral.sumsRow(i)[j], referenceSum(input, -4, -4, i + 4, j + 4)) << "at (" << i << ", " << j << ")";
+            ASSERT_EQ(integral.squaredSumsRow(i)[j], referenceSum(input, -4, -4, i + 4, j + 4, true)) << "at (" << i << ", " << j << ")";
+        }
+    }
+}
+
+TEST(IntegralImage, ChunkedBuildMatchesSerial) {
+    FlatImage input = createRandomImage(301, 157, 3);
+    IntegralImage serial, chunked;
+    {
+        ExecutionPolicyScope scope(ExecutionPolicy::serial());
+        serial.build(input, 7);
+    }
+    {
+        ExecutionPolicy policy;
+        policy.parallelMinPixels = 0;
+        policy.chunksPerWorker = 16;
+        ExecutionPolicyScope scope(policy);
+        chunked.build(input, 7);
+    }
+    ASSERT_TRUE(std::equal(serial.sums().begin(), serial.sums().end(), chunked.sums().begin()));
+    ASSERT_TRUE(std::equal(serial.squaredSums().begin(), serial.squaredSums().end(), chunked.squaredSums().begin()));
+}
+
+TEST(IntegralImage, BoxQueries) {
+    FlatImage input = createRandomImage(40, 50, 5);
+    IntegralImage integral;
+    integral.build(input, 3);
+
+    for (auto [i, j] : {std::pair{0, 0}, {39, 49}, {20, 1}, {17, 33}}) {
+        const uint64_t sum = referenceSum(input, i - 3, j - 2, 7, 5);
+        const uint64_t squaredSum = referenceSum(input, i - 3, j - 2, 7, 5, true);
+        ASSERT_EQ(integral.boxSum(i, j, 3, 2), sum);
+        ASSERT_DOUBLE_EQ(integral.boxMean(i, j, 3, 2), sum / 35.0);
+        ASSERT_NEAR(integral.boxVariance(i, j, 3, 2), squaredSum / 35.0 - (sum / 35.0) * (sum / 35.0), 1e-9);
+    }
+
+    IntegralImage sumsOnly;
+    sumsOnly.build(input, 3, false);
+    ASSERT_FALSE(sumsOnly.hasSquares());
+    ASSERT_EQ(sumsOnly.boxSum(5, 5, 1, 1), integral.boxSum(5, 5, 1, 1));
+    ASSERT_THROW(sumsOnly.boxVariance(5, 5, 1, 1), std::runtime_error);
+}
+
+TEST(IntegralImage, WindowSumsStayExactPastTheTableRange) {
+    // the total of 4200 x 4200 saturated pixels exceeds 2^32, yet window sums stay exact
+    FlatImage input(4200, 4200);
+    std::fill(input.begin(), input.end(), 255);
+    IntegralImage integral;
+    integral.build(input, 1, false);
+
+    ASSERT_GT(uint64_t(255) * input.size(), uint64_t(UINT32_MAX));
+    ASSERT_EQ(integral.boxSum(4199, 4199, 1, 1), 9u * 255);
+    ASSERT_EQ(integral.sum(4000, 0, 200, 4200), 200u * 4200 * 255);
+}
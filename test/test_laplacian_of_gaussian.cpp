@@ -0,0 +1,30 @@
+#include <opencv2/opencv.hpp>
+#include <gtest/gtest.h>
+
+#include "laplacian_of_gaussian.hpp"
+#include "test_utils.hpp"
+
+
+TEST(LaplacianOfGaussian, TestLaplacianOfGaussianUniform) {
+    FlatImage input = createTestImage(5, 5, 120);
+    FlatImage output;
+
+    LaplacianOfGaussian().apply(input, output);
+
+    ASSERT_EQ(output.rows(), input.rows());
+    ASSERT_EQ(output.cols(), input.cols());
+    expectImagesEqual(output, createTestImage(5, 5, 0));
+}
+
+TEST(LaplacianOfGaussian, TestLaplacianOfGaussianImpulse) {
+    FlatImage input(7, 7);
+    input(3, 3) = 10;
+    FlatImage output;
+
+    LaplacianOfGaussian().apply(input, output);
+
+    ASSERT_EQ(output(3, 3), 160);
+    ASSERT_EQ(output(3, 2), 20);
+    ASSERT_EQ(output(2, 2), 10);
+    ASSERT_EQ(output(0, 0), 0);
+}
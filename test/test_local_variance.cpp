@@ -0,0 +1,55 @@
+#include <opencv2/opencv.hpp>
+#include <gtest/gtest.h>
+
+#include "local_variance.hpp"
+#include "test_utils.hpp"
+
+
+// Standard deviation of the window with replicated borders, rounded to nearest
+static FlatImage referenceDeviation(const FlatImage& input, int ksize) {
+    const int radius = ksize / 2;
+    const double area = ksize * ksize;
+    FlatImage output(input.rows(), input.cols());
+    for (int i = 0; i < input.rows(); ++i) {
+        for (int j = 0; j < input.cols(); ++j) {
+            double sum = 0, squaredSum = 0;
+            for (int r = -radius; r <= radius; ++r) {
+                for (int c = -radius; c <= radius; ++c) {
+                    const double px = input(std::clamp(i + r, 0, input.rows() - 1), std::clamp(j + c, 0, input.cols() - 1));
+                    sum += px;
+                    squaredSum += px * px;
+                }
+            }
+            output(i, j) = static_cast<uchar>(std::nearbyint(std::sqrt(area * squaredSum - sum * sum) / area));
+        }
+    }
+    return output;
+}
+
+TEST(LocalVariance, ConstantImageHasNoDeviation) {
+    FlatImage input = createTestImage(5, 5, 77);
+    FlatImage output;
+
+    LocalVariance(3).apply(input, output);
+
+    ASSERT_EQ(output.rows(), input.rows());
+    ASSERT_EQ(output.cols(), input.cols());
+    for (uchar px : output) {
+        ASSERT_EQ(px, 0);
+    }
+}
+
+TEST(LocalVariance, MatchesBruteForce) {
+    for (int ksize : {1, 3, 15, 31}) {
+        FlatImage input = createRandomImage(45, 60, ksize);
+        FlatImage output;
+        LocalVariance(ksize).apply(input, output);
+        expectImagesEqual(output, referenceDeviation(input, ksize));
+    }
+}
+
+TEST(LocalVariance, RejectsInvalidSizes) {
+    ASSERT_THROW(LocalVariance(0), std::invalid_argument);
+    ASSERT_THROW(LocalVariance(4), std::invalid_argument);
+    ASSERT_THROW(LocalVariance(4097), std::invalid_argument);
+}
@@ -0,0 +1,111 @@
+#include <opencv2/opencv.hpp>
+#include <gtest/gtest.h>
+
+#include "blur.hpp"
+#include "filter_pipeline.hpp"
+#include "gaussian_blur.hpp"
+#include "separable_smoothing.hpp"
+#include "sobel.hpp"
+#include "test_utils.hpp"
+
+
+TEST(PipelinePlan, DropsNoOps) {
+    FlatImage input = createRandomImage(40, 33, 1);
+    auto pipeline = FilterPipeline().addBlur(1).addSobelOperator().addBlur(1).addGaussianBlur();
+
+    const PipelinePlan& plan = pipeline.plan();
+    ASSERT_EQ(plan.steps().size(), 2);
+    ASSERT_EQ(plan.droppedStages(), (std::vector<size_t>{0, 2}));
+    ASSERT_EQ(plan.steps()[1].stages, std::vector<size_t>{3});
+    ASSERT_EQ(plan.bufferCount(), 1);
+    ASSERT_EQ(plan.guard(), 2);
+
+    FlatImage expected, output;
+    FilterPipeline().addSobelOperator().addGaussianBlur().apply(input, expected);
+    pipeline.apply(input, output);
+    expectImagesEqual(output, expected);
+
+    // a pipeline of no-ops copies its input
+    auto identity = FilterPipeline().addBlur(1);
+    ASSERT_TRUE(identity.plan().steps().empty());
+    identity.apply(input, output);
+    expectImagesEqual(output, input);
+}
+
+TEST(PipelinePlan, FoldsSmoothingWhenEnabled) {
+    FlatImage input = createRandomImage(50, 61, 2);
+    auto pipeline = FilterPipeline().addBlur(3).addGaussianBlur(5).addSobelOperator();
+
+    // folding is opt-in: the default plan runs every stage
+    ASSERT_EQ(pipeline.plan().steps().size(), 3);
+
+    pipeline.setPlanOptions(PlanOptions{.foldSmoothing = true});
+    const PipelinePlan& plan = pipeline.plan();
+    ASSERT_EQ(plan.steps().size(), 2);
+    ASSERT_TRUE(plan.steps()[0].folded);
+    ASSERT_EQ(plan.steps()[0].stages, (std::vector<size_t>{0, 1}));
+    ASSERT_EQ(plan.steps()[0].smoothingTaps, (std::vector<int>{1, 5, 11, 14, 11, 5, 1}));
+    ASSERT_NE(plan.describe().find("stages 0+1: folded smoothing"), std::string::npos);
+
+    // the chain rounds after every stage and the folded kernel only once, so interior pixels
+    // stay within a grey level of it; the edge bands run the chain and match it exactly
+    FlatImage smoothed, once, chained;
+    FilterPipeline().addBlur(3).addGaussianBlur(5).apply(input, chained);
+    SeparableSmoothing({1, 5, 11, 14, 11, 5, 1}).apply(input, smoothed);
+    plan.steps()[0].filter->apply(input, once);
+    for (int i = 0; i < input.rows(); ++i) {
+        for (int j = 0; j < input.cols(); ++j) {
+            const bool edge = std::min({i, j, input.rows() - 1 - i, input.cols() - 1 - j}) < 2;
+            ASSERT_EQ(once(i, j), edge ? chained(i, j) : smoothed(i, j)) << "at (" << i << ", " << j << ")";
+            ASSERT_LE(std::abs(once(i, j) - chained(i, j)), 1) << "at (" << i << ", " << j << ")";
+        }
+    }
+
+    FlatImage expected, folded;
+    SobelOperator().apply(once, expected);
+    pipeline.apply(input, folded);
+    expectImagesEqual(folded, expected);
+
+    FlatImage tiled;
+    pipeline.applyTiled(input, tiled, TileOptions{16, 16});
+    expectImagesEqual(tiled, folded);
+}
+
+TEST(PipelinePlan, KeepsStagesFoldingWouldSlowDown) {
+    PlanOptions options{.foldSmoothing = true};
+
+    // wide boxes slide their sums; their 29-tap product would not
+    FilterPipeline boxes = FilterPipeline().addBlur(15).addBlur(15);
+    boxes.setPlanOptions(options);
+    ASSERT_EQ(boxes.plan().steps().size(), 2);
+
+    // only adjacent smoothing stages fold
+    FilterPipeline split = FilterPipeline().addGaussianBlur(3).addScharrOperator().addGaussianBlur(3);
+    split.setPlanOptions(options);
+    ASSERT_EQ(split.plan().steps().size(), 3);
+    ASSERT_EQ(split.plan().bufferCount(), 2);
+
+    // runs fold left to right into one step
+    FilterPipeline gaussians = FilterPipeline().addGaussianBlur(3).addGaussianBlur(3).addGaussianBlur(3);
+    gaussians.setPlanOptions(options);
+    ASSERT_EQ(gaussians.plan().steps().size(), 1);
+    ASSERT_EQ(gaussians.plan().steps()[0].smoothingTaps, (std::vector<int>{1, 6, 15, 20, 15, 6, 1}));
+    ASSERT_EQ(gaussians.plan().bufferCount(), 0);
+}
+
+TEST(SeparableSmoothing, MatchesGaussianBlur) {
+    FlatImage input = createRandomImage(37, 45, 3);
+    FlatImage expected, output;
+    GaussianBlur(5).apply(input, expected);
+    SeparableSmoothing({1, 4, 6, 4, 1}).apply(input, output);
+    expectImagesEqual(output, expected);
+}
+
+TEST(SeparableSmoothing, RejectsUnsupportedTaps) {
+    ASSERT_TRUE(SeparableSmoothing::supports({1, 2, 1}));
+    ASSERT_FALSE(SeparableSmoothing::supports({1, 1}));
+    ASSERT_FALSE(SeparableSmoothing::supports({1, -2, 1}));
+    ASSERT_FALSE(SeparableSmoothing::supports({0, 0, 0}));
+    ASSERT_FALSE(SeparableSmoothing::supports({2000, 2000, 2000}));
+    ASSERT_THROW(SeparableSmoothing({1, 1}), std::invalid_argument);
+}
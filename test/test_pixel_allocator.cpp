@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include <thread>
+
+#include "filter_pipeline.hpp"
+#include "pixel_allocator.hpp"
+#include "types.hpp"
+#include "test_utils.hpp"
+
+
+TEST(PixelAllocator, AlignedAndZeroFilled) {
+    for (int cols : {1, 7, 64, 333}) {
+        FlatImage image(3, cols);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(image.data()) % PixelAllocator::ALIGNMENT, 0u);
+        for (uchar pixel : image) {
+            ASSERT_EQ(pixel, 0);
+        }
+    }
+
+    FlatArray<int16_t> wide(5, 9);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(wide.data()) % PixelAllocator::ALIGNMENT, 0u);
+}
+
+TEST(ScratchArena, RecyclesBuffers) {
+    ScratchArena arena;
+    const uchar* first;
+    {
+        FlatImage scratch(20, 30, arena);
+        first = scratch.data();
+        ASSERT_EQ(arena.pooledBytes(), 0u);
+    }
+    ASSERT_GE(arena.pooledBytes(), 600u);
+
+    const size_t allocations = pixelAllocationCount();
+    FlatImage reused(30, 20, arena);
+    ASSERT_EQ(reused.data(), first);
+    ASSERT_EQ(pixelAllocationCount(), allocations);
+    ASSERT_EQ(arena.pooledBytes(), 0u);
+
+    // copies do not inherit the arena
+    FlatImage copy = reused;
+    ASSERT_EQ(pixelAllocationCount(), allocations + 1);
+}
+
+TEST(ScratchArena, CapsAndTrimsThePool) {
+    ScratchArena arena(defaultPixelAllocator(), 4096);
+    {
+        FlatImage a(32, 64, arena), b(32, 64, arena), c(32, 64, arena);
+    }
+    // the third buffer would exceed the cap and goes back to the heap
+    ASSERT_EQ(arena.pooledBytes(), 4096u);
+
+    arena.trim(2048);
+    ASSERT_LE(arena.pooledBytes(), 2048u);
+
+    arena.setMaxPooledBytes(0);
+    ASSERT_EQ(arena.pooledBytes(), 0u);
+    {
+        FlatImage d(8, 8, arena);
+    }
+    ASSERT_EQ(arena.pooledBytes(), 0u);
+}
+
+TEST(ScratchArena, ArraysOutliveTheirThread) {
+    // an image drawn from a worker's arena and handed out keeps that arena alive
+    FlatImage escaped;
+    std::thread([&] {
+        FlatImage scratch(ScratchArena::local());
+        scratch.resize(12, 34);
+        scratch(5, 6) = 7;
+        escaped = std::move(scratch);
+    }).join();
+
+    ASSERT_EQ(escaped.rows(), 12);
+    ASSERT_EQ(escaped(5, 6), 7);
+    escaped.resize(40, 40);
+    escaped = FlatImage();
+}
+
+TEST(ScratchArena, SteadyStateDoesNotAllocate) {
+    FlatImage input = createRandomImage(64, 80, 4);
+
+    std::vector<FilterPipeline> pipelines;
+    pipelines.push_back(FilterPipeline().addBlur().addSobelOperator().addScharrOperator());
+    pipelines.push_back(FilterPipeline().addGaussianBlur(7).addLaplacianOfGaussian());
+
+    for (auto& pipeline : pipelines) {
+        FlatImage output(input.rows(), input.cols());
+        pipeline.apply(input, output);
+        FlatImage expected = output;
+
+        const size_t allocations = pixelAllocationCount();
+        for (int frame = 0; frame < 3; ++frame) {
+            pipeline.apply(input, output);
+        }
+        ASSERT_EQ(pixelAllocationCount(), allocations);
+        expectImagesEqual(output, expected);
+    }
+}
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include "prof_utils.hpp"
+
+static void busyWait(std::chrono::microseconds duration) {
+    auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end) {
+    }
+}
+
+static void innerScope() {
+    PROF_EXEC_TIME_CUSTOM("inner");
+    busyWait(std::chrono::microseconds(200));
+}
+
+static void outerScope() {
+    PROF_EXEC_TIME_CUSTOM("outer");
+    innerScope();
+    innerScope();
+}
+
+static const ProfileStats* findStats(const std::vector<ProfileStats>& stats, const std::string& name) {
+    for (const auto& entry : stats) {
+        if (entry.name == name) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+class ProfilerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+#if !IMAGE_FILTERS_PROFILING
+        GTEST_SKIP() << "profiling scopes are compiled out";
+#endif
+        Profiler::reset();
+        Profiler::setEnabled(true);
+        Profiler::setTracing(false);
+    }
+
+    void TearDown() override {
+        Profiler::setEnabled(false);
+        Profiler::setTracing(false);
+        Profiler::reset();
+    }
+};
+
+TEST_F(ProfilerTest, CountsCallsAndNesting) {
+    for (int i = 0; i < 3; ++i) {
+        outerScope();
+    }
+
+    const auto stats = Profiler::snapshot();
+    const ProfileStats* outer = findStats(stats, "outer");
+    const ProfileStats* inner = findStats(stats, "inner");
+    ASSERT_NE(outer, nullptr);
+    ASSERT_NE(inner, nullptr);
+
+    EXPECT_EQ(outer->calls, 3u);
+    EXPECT_EQ(inner->calls, 6u);
+    EXPECT_GE(inner->minUs, 200);
+    EXPECT_LE(inner->minUs, inner->meanUs);
+    EXPECT_LE(inner->meanUs, inner->maxUs);
+    EXPECT_GE(inner->p99Us, inner->minUs);
+    EXPECT_LE(inner->p99Us, inner->maxUs);
+
+    // the outer scope's own time excludes its nested scopes
+    EXPECT_GE(outer->totalUs, inner->totalUs);
+    EXPECT_NEAR(outer->selfUs, outer->totalUs - inner->totalUs, 1);
+    EXPECT_DOUBLE_EQ(inner->selfUs, inner->totalUs);
+    // sorted by total time
+    EXPECT_EQ(stats.front().name, "outer");
+}
+
+TEST_F(ProfilerTest, RuntimeSwitch) {
+    Profiler::setEnabled(false);
+    outerScope();
+    EXPECT_TRUE(Profiler::snapshot().empty());
+
+    Profiler::setEnabled(true);
+    outerScope();
+    const auto stats = Profiler::snapshot();
+    ASSERT_NE(findStats(stats, "outer"), nullptr);
+
+    Profiler::reset();
+    EXPECT_TRUE(Profiler::snapshot().empty());
+}
+
+TEST_F(ProfilerTest, MergesThreads) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([] { innerScope(); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    innerScope();
+
+    const auto stats = Profiler::snapshot();
+    const ProfileStats* inner = findStats(stats, "inner");
+    ASSERT_NE(inner, nullptr);
+    EXPECT_EQ(inner->calls, 5u);
+}
+
+TEST_F(ProfilerTest, WritesSummaryAndChromeTrace) {
+    Profiler::setTracing(true);
+    outerScope();
+
+    std::ostringstream summary;
+    Profiler::writeSummary(summary);
+    EXPECT_NE(summary.str().find("outer"), std::string::npos);
+    EXPECT_NE(summary.str().find("p99 us"), std::string::npos);
+
+    const std::string path = ::testing::TempDir() + "prof_utils_trace.json";
+    Profiler::writeChromeTrace(path);
+    std::ifstream file(path);
+    std::stringstream trace;
+    trace << file.rdbuf();
+    std::remove(path.c_str());
+
+    const std::string json = trace.str();
+    EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0), 0u);
+    EXPECT_NE(json.find("{\"name\":\"outer\",\"ph\":\"X\""), std::string::npos);
+    size_t innerEvents = 0;
+    for (size_t at = json.find("\"name\":\"inner\""); at != std::string::npos; at = json.find("\"name\":\"inner\"", at + 1)) {
+        ++innerEvents;
+    }
+    EXPECT_EQ(innerEvents, 2u);
+}
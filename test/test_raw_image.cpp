@@ -0,0 +1,88 @@
+#include <fstream>
+#include <gtest/gtest.h>
+
+#include "filter_pipeline.hpp"
+#include "raw_image.hpp"
+#include "test_utils.hpp"
+
+
+TEST(RawImage, RoundTrip) {
+    const std::string path = testing::TempDir() + "round_trip.raw";
+    FlatImage input = createRandomImage(37, 70, 1);
+    writeRawImage(path, input);
+
+    const FlatImage mapped = mapRawImage(path);
+    ASSERT_TRUE(mapped.isView());
+    ASSERT_EQ(mapped.stride() % PixelAllocator::ALIGNMENT, 0);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(mapped.data()) % PixelAllocator::ALIGNMENT, 0u);
+    expectImagesEqual(mapped, input);
+
+    std::remove(path.c_str());
+}
+
+TEST(RawImage, PipelineWritesIntoMapping) {
+    const std::string inputPath = testing::TempDir() + "pipeline_input.raw";
+    const std::string outputPath = testing::TempDir() + "pipeline_output.raw";
+    FlatImage input = createRandomImage(50, 41, 2);
+    writeRawImage(inputPath, input);
+
+    auto pipeline = FilterPipeline().addGaussianBlur().addScharrOperator();
+    {
+        FlatImage output = createRawImage(outputPath, input.rows(), input.cols());
+        const uchar* pixels = output.data();
+        pipeline.apply(mapRawImage(inputPath), output);
+        ASSERT_EQ(output.data(), pixels);
+    }
+
+    FlatImage expected;
+    pipeline.apply(input, expected);
+    expectImagesEqual(mapRawImage(outputPath), expected);
+
+    // edits through a writable mapping reach the file
+    {
+        FlatImage writable = mapRawImageWritable(outputPath);
+        writable(3, 4) = expected(3, 4) + 1;
+    }
+    ASSERT_EQ(mapRawImage(outputPath)(3, 4), static_cast<uchar>(expected(3, 4) + 1));
+
+    // read-only mappings are copy-on-write, so writing through a copy leaves the file alone
+    {
+        FlatImage copy = mapRawImage(outputPath);
+        copy(3, 4) = expected(3, 4);
+        ASSERT_EQ(copy(3, 4), expected(3, 4));
+    }
+    ASSERT_EQ(mapRawImage(outputPath)(3, 4), static_cast<uchar>(expected(3, 4) + 1));
+
+    std::remove(inputPath.c_str());
+    std::remove(outputPath.c_str());
+}
+
+TEST(RawImage, RejectsInvalidFiles) {
+    const std::string path = testing::TempDir() + "invalid.raw";
+    std::ofstream(path) << "P5\n2 2\n255\n";
+    ASSERT_THROW(mapRawImage(path), std::runtime_error);
+    ASSERT_THROW(mapRawImage(testing::TempDir() + "missing.raw"), std::runtime_error);
+
+    // headers whose rows, pitch or offset reach past the end of the file
+    auto corrupt = [&](auto edit) {
+        writeRawImage(path, createRandomImage(4, 10, 3));
+        RawImageHeader header;
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        edit(header);
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    };
+    corrupt([](RawImageHeader& header) { header.rows = 5; });
+    ASSERT_THROW(mapRawImage(path), std::runtime_error);
+    corrupt([](RawImageHeader& header) { header.pitch = 0x80000000u; });
+    ASSERT_THROW(mapRawImage(path), std::runtime_error);
+    corrupt([](RawImageHeader& header) { header.dataOffset = ~uint64_t(0) & ~uint64_t(63); });
+    ASSERT_THROW(mapRawImage(path), std::runtime_error);
+    corrupt([](RawImageHeader& header) { header.cols = 65; });
+    ASSERT_THROW(mapRawImage(path), std::runtime_error);
+    corrupt([](RawImageHeader&) {});
+    ASSERT_NO_THROW(mapRawImage(path));
+
+    std::remove(path.c_str());
+}
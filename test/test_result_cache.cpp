@@ -0,0 +1,194 @@
+#include <atomic>
+
+#include <opencv2/opencv.hpp>
+#include <gtest/gtest.h>
+
+#include "blur.hpp"
+#include "canny.hpp"
+#include "content_hash.hpp"
+#include "filter_pipeline.hpp"
+#include "result_cache.hpp"
+#include "test_utils.hpp"
+
+
+// Inverts the image and counts how often it ran
+class CountingFilter : public ImageFilter
+{
+public:
+    explicit CountingFilter(std::string name) : name(std::move(name)) {}
+
+    void apply(const FlatImage& input, FlatImage& output) const override {
+        ++calls;
+        output.resize(input.rows(), input.cols());
+        for (int i = 0; i < input.rows(); ++i) {
+            for (int j = 0; j < input.cols(); ++j) {
+                output(i, j) = 255 - input(i, j);
+            }
+        }
+    }
+    void applyBenchmark(const cv::Mat&, cv::Mat&) const override {}
+    int radius() const override { return 0; }
+    std::string signature() const override { return name; }
+
+    mutable std::atomic<int> calls = 0;
+
+private:
+    std::string name;
+};
+
+static ResultKey keyFor(const FlatImage& image, uint64_t pipeline = 1) {
+    return ResultKey{contentHash(image), pipeline, image.rows(), image.cols()};
+}
+
+TEST(ContentHash, ViewsAndCopiesHashAlike) {
+    FlatImage image = createRandomImage(40, 70, 1);
+    FlatImage copy = image;
+    FlatImage guarded(40, 70, 3);
+    for (int i = 0; i < 40; ++i) {
+        std::copy_n(image.row(i), 70, guarded.row(i));
+    }
+    FlatImage wide = createRandomImage(50, 90, 2);
+    for (int i = 0; i < 40; ++i) {
+        std::copy_n(image.row(i), 70, wide.row(i + 5) + 10);
+    }
+
+    ASSERT_EQ(contentHash(copy), contentHash(image));
+    ASSERT_EQ(contentHash(guarded), contentHash(image));
+    ASSERT_EQ(contentHash(wide.subView(5, 10, 40, 70)), contentHash(image));
+}
+
+TEST(ContentHash, SensitiveToPixelsAndShape) {
+    FlatImage image = createRandomImage(64, 200, 3);
+    const uint64_t hash = contentHash(image);
+
+    // every position of a block, the buffered row tails and the final partial stripe
+    for (auto [i, j] : {std::pair{0, 0}, std::pair{0, 63}, std::pair{5, 199}, std::pair{33, 100}, std::pair{63, 199}}) {
+        FlatImage changed = image;
+        changed(i, j) ^= 1;
+        ASSERT_NE(contentHash(changed), hash) << i << ", " << j;
+    }
+
+    // same bytes, different dimensions
+    FlatImage reshaped(128, 100);
+    std::copy(image.begin(), image.end(), reshaped.begin());
+    ASSERT_NE(contentHash(reshaped), hash);
+
+    // stripes swapped within a row
+    FlatImage swapped = image;
+    std::swap_ranges(swapped.row(7), swapped.row(7) + 64, swapped.row(7) + 64);
+    ASSERT_NE(contentHash(swapped), hash);
+
+    ASSERT_NE(contentHash(FlatImage(0, 0)), contentHash(FlatImage(0, 5)));
+    ASSERT_EQ(contentHash("Blur(3)", 7), contentHash("Blur(3)", 7));
+    ASSERT_NE(contentHash("Blur(3)", 7), contentHash("Blur(5)", 7));
+}
+
+TEST(ResultCache, EvictsLeastRecentlyUsed) {
+    FlatImage a = createRandomImage(10, 10, 1), b = createRandomImage(10, 10, 2), c = createRandomImage(10, 10, 3);
+    ResultCache cache(250);
+
+    cache.insert(keyFor(a), a);
+    cache.insert(keyFor(b), b);
+    FlatImage output;
+    ASSERT_TRUE(cache.lookup(keyFor(a), output)); // b is now least recently used
+    expectImagesEqual(output, a);
+
+    cache.insert(keyFor(c), c);
+    ASSERT_FALSE(cache.lookup(keyFor(b), output));
+    ASSERT_TRUE(cache.lookup(keyFor(a), output));
+    ASSERT_TRUE(cache.lookup(keyFor(c), output));
+    expectImagesEqual(output, c);
+    ASSERT_FALSE(cache.lookup(keyFor(c, 2), output));
+
+    ResultCacheStats stats = cache.stats();
+    ASSERT_EQ(stats.hits, 3u);
+    ASSERT_EQ(stats.misses, 2u);
+    ASSERT_EQ(stats.insertions, 3u);
+    ASSERT_EQ(stats.evictions, 1u);
+    ASSERT_EQ(stats.entries, 2u);
+    ASSERT_EQ(stats.bytes, 200u);
+    ASSERT_DOUBLE_EQ(stats.hitRate(), 0.6);
+
+    // too large to ever fit, and re-inserting a key replaces its entry
+    cache.insert(keyFor(FlatImage(20, 20)), FlatImage(20, 20));
+    cache.insert(keyFor(a), a);
+    ASSERT_EQ(cache.stats().entries, 2u);
+    ASSERT_EQ(cache.stats().bytes, 200u);
+
+    cache.clear();
+    ASSERT_EQ(cache.stats().entries, 0u);
+    ASSERT_FALSE(cache.lookup(keyFor(a), output));
+}
+
+TEST(ResultCache, PipelineHitsRepeatedFrames) {
+    auto filter = std::make_shared<CountingFilter>("Invert");
+    FilterPipeline pipeline = FilterPipeline().addBlur().add(filter);
+    ASSERT_EQ(pipeline.signature(), "Blur(3)|Invert");
+    auto cache = std::make_shared<ResultCache>(1 << 20);
+    pipeline.setResultCache(cache);
+
+    FlatImage frame = createRandomImage(60, 80, 4), other = createRandomImage(60, 80, 5);
+    FlatImage expected, first, second, third;
+    FilterPipeline().addBlur().add(filter).apply(frame, expected);
+    filter->calls = 0;
+
+    pipeline.apply(frame, first);
+    pipeline.apply(frame, second);
+    ASSERT_EQ(filter->calls, 1);
+    expectImagesEqual(first, expected);
+    expectImagesEqual(second, expected);
+
+    pipeline.apply(other, third);
+    ASSERT_EQ(filter->calls, 2);
+
+    std::vector<FlatImage> outputs;
+    pipeline.applyBatch({frame, other, frame}, outputs);
+    ASSERT_EQ(filter->calls, 2);
+    expectImagesEqual(outputs[2], expected);
+
+    ResultCacheStats stats = cache->stats();
+    ASSERT_EQ(stats.hits, 4u);
+    ASSERT_EQ(stats.misses, 2u);
+}
+
+TEST(ResultCache, KeysOnPipelineSignature) {
+    auto cache = std::make_shared<ResultCache>(1 << 20);
+    FlatImage frame = createRandomImage(50, 50, 6);
+
+    FilterPipeline blur3 = FilterPipeline().addBlur(3);
+    FilterPipeline blur5 = FilterPipeline().addBlur(5);
+    blur3.setResultCache(cache);
+    blur5.setResultCache(cache);
+    ASSERT_NE(blur3.signature(), blur5.signature());
+
+    FlatImage out3, out5, expected;
+    blur3.apply(frame, out3);
+    blur5.apply(frame, out5);
+    FilterPipeline().addBlur(5).apply(frame, expected);
+    expectImagesEqual(out5, expected);
+    ASSERT_EQ(cache->stats().misses, 2u);
+
+    // folding may change pixels, so it changes the signature too
+    const std::string unfolded = blur3.signature();
+    blur3.setPlanOptions(PlanOptions{true, true});
+    ASSERT_NE(blur3.signature(), unfolded);
+
+    ASSERT_NE(FilterPipeline().addCannyEdgeDetector(50, 150).signature(), FilterPipeline().addCannyEdgeDetector(50, 151).signature());
+    ASSERT_NE(FilterPipeline().addCannyEdgeDetector().signature(),
+              FilterPipeline().addCannyEdgeDetector(50, 150, GradientNorm::L2).signature());
+}
+
+TEST(ResultCache, SkipsPipelinesWithoutSignature) {
+    auto filter = std::make_shared<CountingFilter>("");
+    FilterPipeline pipeline = FilterPipeline().add(filter).addBlur();
+    ASSERT_TRUE(pipeline.signature().empty());
+    auto cache = std::make_shared<ResultCache>(1 << 20);
+    pipeline.setResultCache(cache);
+
+    FlatImage frame = createRandomImage(20, 20, 7), output;
+    pipeline.apply(frame, output);
+    pipeline.apply(frame, output);
+    ASSERT_EQ(filter->calls, 2);
+    ASSERT_EQ(cache->stats().misses, 0u);
+    ASSERT_EQ(cache->stats().entries, 0u);
+}
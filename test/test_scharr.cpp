@@ -30,3 +30,12 @@ TEST(Scharr, TestSCharr) {
         }
     }
 }
+
+TEST(Scharr, SeparableKernelsMatchDense) {
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            ASSERT_EQ(ScharrOperator::SEPARABLE_KERNELX.column[r] * ScharrOperator::SEPARABLE_KERNELX.row[c], ScharrOperator::KERNELX[r][c]);
+            ASSERT_EQ(ScharrOperator::SEPARABLE_KERNELY.column[r] * ScharrOperator::SEPARABLE_KERNELY.row[c], ScharrOperator::KERNELY[r][c]);
+        }
+    }
+}
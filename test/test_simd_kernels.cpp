@@ -0,0 +1,285 @@
+#include <cstring>
+
+#include <opencv2/opencv.hpp>
+#include <gtest/gtest.h>
+
+#include "scharr.hpp"
+#include "simd_kernels.hpp"
+#include "sobel.hpp"
+#include "test_utils.hpp"
+
+
+static std::vector<int16_t> flatten(const int kernel[3][3]) {
+    return {
+        static_cast<int16_t>(kernel[0][0]), static_cast<int16_t>(kernel[0][1]), static_cast<int16_t>(kernel[0][2]),
+        static_cast<int16_t>(kernel[1][0]), static_cast<int16_t>(kernel[1][1]), static_cast<int16_t>(kernel[1][2]),
+        static_cast<int16_t>(kernel[2][0]), static_cast<int16_t>(kernel[2][1]), static_cast<int16_t>(kernel[2][2])
+    };
+}
+
+static int referenceGradient(const FlatImage& image, int j, const std::vector<int16_t>& kernel) {
+    int gradient = 0;
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            gradient += image(r, j + c - 1) * kernel[r * 3 + c];
+        }
+    }
+    return std::min(std::abs(gradient), 255);
+}
+
+TEST(SimdKernels, ScalarIsAlwaysSupported) {
+    auto supported = supportedSimdKernels();
+
+    ASSERT_FALSE(supported.empty());
+    ASSERT_STREQ(supported.back()->name, "scalar");
+    ASSERT_NE(std::find(supported.begin(), supported.end(), &activeSimdKernels()), supported.end());
+}
+
+TEST(SimdKernels, XYGradientRowMatchesScalar) {
+    const auto kernelX = flatten(ScharrOperator::KERNELX);
+    const auto kernelY = flatten(ScharrOperator::KERNELY);
+
+    for (const SimdKernelSet* kernels : supportedSimdKernels()) {
+        for (int cols : {1, 2, 17, 18, 33, 34, 100}) {
+            FlatImage rows = createRandomImage(3, cols, cols);
+            for (uchar threshold : {0, 50, 255}) {
+                FlatImage out(1, cols);
+                int end = kernels->xyGradientRow(&rows(0, 0), &rows(1, 0), &rows(2, 0), &out(0, 0), cols, kernelX.data(), kernelY.data(), threshold);
+
+                ASSERT_GE(end, 1) << kernels->name;
+                ASSERT_LE(end, std::max(cols - 1, 1)) << kernels->name;
+                for (int j = 1; j < end; ++j) {
+                    int gradient = (referenceGradient(rows, j, kernelX) + referenceGradient(rows, j, kernelY)) / 2;
+                    ASSERT_EQ(out(0, j), gradient < threshold ? 0 : gradient) << kernels->name << " column " << j;
+                }
+            }
+        }
+    }
+}
+
+TEST(SimdKernels, SingleGradientRowMatchesScalar) {
+    const int kernel[3][3] = {
+        {1, -2, 3},
+        {-4, 5, -6},
+        {7, -8, 9}
+    };
+    const auto taps = flatten(kernel);
+
+    for (const SimdKernelSet* kernels : supportedSimdKernels()) {
+        for (int cols : {3, 17, 18, 33, 64, 100}) {
+            FlatImage rows = createRandomImage(3, cols, cols + 1);
+            for (uchar threshold : {0, 50}) {
+                FlatImage out(1, cols);
+                int end = kernels->singleGradientRow(&rows(0, 0), &rows(1, 0), &rows(2, 0), &out(0, 0), cols, taps.data(), threshold);
+
+                for (int j = 1; j < end; ++j) {
+                    int gradient = referenceGradient(rows, j, taps);
+                    ASSERT_EQ(out(0, j), gradient < threshold ? 0 : gradient) << kernels->name << " column " << j;
+                }
+            }
+        }
+    }
+}
+
+TEST(SimdKernels, SeparableRowsMatchScalar) {
+    const int16_t row[3] = {3, 10, 3};
+    const int16_t column[3] = {-1, 0, 1};
+
+    for (const SimdKernelSet* kernels : supportedSimdKernels()) {
+        for (int cols : {1, 17, 18, 33, 34, 100}) {
+            FlatImage src = createRandomImage(3, cols, cols + 2);
+
+            std::vector<int16_t> horizontal[3];
+            for (int r = 0; r < 3; ++r) {
+                horizontal[r].assign(cols, 0);
+                int end = kernels->horizontalRow(&src(r, 0), horizontal[r].data(), cols, row);
+                for (int j = 1; j < end; ++j) {
+                    ASSERT_EQ(horizontal[r][j], src(r, j - 1) * row[0] + src(r, j) * row[1] + src(r, j + 1) * row[2]) << kernels->name;
+                }
+                // fill the columns the SIMD pass left over so the vertical pass sees full rows
+                for (int j = std::max(end, 0); j < cols; ++j) {
+                    horizontal[r][j] = static_cast<int16_t>(src(r, j) * 16);
+                }
+                if (end > 1) {
+                    horizontal[r][0] = static_cast<int16_t>(src(r, 0) * 16);
+                }
+            }
+
+            const int16_t* const window[3] = {horizontal[0].data(), horizontal[1].data(), horizontal[2].data()};
+            FlatImage single(1, cols), xy(1, cols);
+            int singleEnd = kernels->verticalSingleRow(window, &single(0, 0), cols, column, 50);
+            int xyEnd = kernels->verticalXYRow(window, window, &xy(0, 0), cols, column, column, 50);
+
+            for (int j = 0; j < singleEnd; ++j) {
+                int gradient = std::min(std::abs(window[0][j] * column[0] + window[1][j] * column[1] + window[2][j] * column[2]), 255);
+                ASSERT_EQ(single(0, j), gradient < 50 ? 0 : gradient) << kernels->name << " column " << j;
+            }
+            for (int j = 0; j < xyEnd; ++j) {
+                int gradient = std::min(std::abs(window[0][j] * column[0] + window[1][j] * column[1] + window[2][j] * column[2]), 255);
+                ASSERT_EQ(xy(0, j), gradient < 50 ? 0 : gradient) << kernels->name << " column " << j;
+            }
+        }
+    }
+}
+
+TEST(SimdKernels, FixedPointRowsMatchScalar) {
+    const FixedPointDivisor divide(25, 255 * 25);
+
+    for (const SimdKernelSet* kernels : supportedSimdKernels()) {
+        for (int cols : {1, 7, 8, 33, 100}) {
+            FlatImage src = createRandomImage(2, cols, cols);
+            std::vector<uint32_t> sums(cols, 1000), rowSums(cols, 7);
+
+            kernels->accumulateRow(sums.data(), &src(0, 0), 3, cols);
+            for (int j = 0; j < cols; ++j) {
+                ASSERT_EQ(sums[j], 1000u + 3 * src(0, j)) << kernels->name;
+            }
+
+            kernels->slideRow(sums.data(), &src(1, 0), &src(0, 0), cols);
+            for (int j = 0; j < cols; ++j) {
+                ASSERT_EQ(sums[j], 1000u + 2 * src(0, j) + src(1, j)) << kernels->name;
+            }
+
+            kernels->accumulateSumsRow(rowSums.data(), sums.data(), 2, cols);
+            for (int j = 0; j < cols; ++j) {
+                ASSERT_EQ(rowSums[j], 7 + 2 * sums[j]) << kernels->name;
+            }
+
+            FlatImage out(1, cols);
+            kernels->divideRow(sums.data(), &out(0, 0), cols, divide);
+            for (int j = 0; j < cols; ++j) {
+                ASSERT_EQ(out(0, j), (sums[j] + 12) / 25) << kernels->name;
+            }
+        }
+    }
+}
+
+TEST(SimdKernels, HashStripesMatchReference) {
+    FlatImage data = createRandomImage(1, 64 * 5, 11);
+    FlatImage secret = createRandomImage(1, 64 + 8 * 4, 12);
+
+    auto load = [](const uchar* src) {
+        uint64_t word;
+        std::memcpy(&word, src, sizeof(word));
+        return word;
+    };
+    uint64_t expected[8] = {1, 2, 3, 4, 5, 6, 7, UINT64_MAX};
+    for (int s = 0; s < 5; ++s) {
+        for (int lane = 0; lane < 8; ++lane) {
+            const uint64_t value = load(&data(0, 64 * s + 8 * lane));
+            const uint64_t keyed = value ^ load(&secret(0, 8 * s + 8 * lane));
+            expected[lane ^ 1] += value;
+            expected[lane] += (keyed & 0xFFFFFFFF) * (keyed >> 32);
+        }
+    }
+
+    for (const SimdKernelSet* kernels : supportedSimdKernels()) {
+        uint64_t lanes[8] = {1, 2, 3, 4, 5, 6, 7, UINT64_MAX};
+        kernels->hashStripes(lanes, &data(0, 0), 5, &secret(0, 0));
+        for (int lane = 0; lane < 8; ++lane) {
+            ASSERT_EQ(lanes[lane], expected[lane]) << kernels->name << " lane " << lane;
+        }
+    }
+}
+
+TEST(SimdKernels, PyramidDownRowMatchesScalar) {
+    const SimdKernelSet& scalar = *supportedSimdKernels().back();
+    for (int cols : {1, 2, 3, 4, 5, 33, 100}) {
+        FlatImage src = createRandomImage(5, cols, cols);
+        const uchar* window[5] = {&src(0, 0), &src(1, 0), &src(2, 0), &src(3, 0), &src(4, 0)};
+        std::vector<uint16_t> sums(cols + 4);
+        FlatImage expected(1, (cols + 1) / 2);
+        scalar.pyramidDownRow(window, &expected(0, 0), cols, sums.data());
+
+        for (const SimdKernelSet* kernels : supportedSimdKernels()) {
+            FlatImage out(1, (cols + 1) / 2);
+            kernels->pyramidDownRow(window, &out(0, 0), cols, sums.data());
+            expectImagesEqual(out, expected);
+        }
+    }
+}
+
+TEST(SimdKernels, GradientFieldRowMatchesScalar) {
+    // the heaviest weights int16 accumulation allows, so the extreme derivatives are covered too
+    const int heavyX[3][3] = {{-16, 0, 16}, {-32, 0, 32}, {-16, 0, 16}};
+    const int heavyY[3][3] = {{16, 32, 16}, {0, 0, 0}, {-16, -32, -16}};
+
+    for (auto [kernelX, kernelY] : {std::pair{flatten(ScharrOperator::KERNELX), flatten(ScharrOperator::KERNELY)},
+                                    std::pair{flatten(heavyX), flatten(heavyY)}}) {
+        for (const SimdKernelSet* kernels : supportedSimdKernels()) {
+            for (int cols : {1, 2, 17, 18, 33, 34, 100}) {
+                FlatImage rows = createRandomImage(3, cols, cols);
+                for (int r = 0; r < 3; ++r) {
+                    rows(r, cols / 2) = 255 * (r % 2); // saturated stripes for the extremes
+                }
+                for (GradientNorm norm : {GradientNorm::L1, GradientNorm::L2}) {
+                    GradientField field;
+                    field.norm = norm;
+                    field.resize(1, cols);
+                    int end = kernels->gradientFieldRow(&rows(0, 0), &rows(1, 0), &rows(2, 0), GradientRow(field, 0), cols, kernelX.data(), kernelY.data(), norm);
+
+                    ASSERT_GE(end, 1) << kernels->name;
+                    ASSERT_LE(end, std::max(cols - 1, 1)) << kernels->name;
+                    for (int j = 1; j < end; ++j) {
+                        int gx = 0, gy = 0;
+                        for (int r = 0; r < 3; ++r) {
+                            for (int c = 0; c < 3; ++c) {
+                                gx += rows(r, j + c - 1) * kernelX[r * 3 + c];
+                                gy += rows(r, j + c - 1) * kernelY[r * 3 + c];
+                            }
+                        }
+                        ASSERT_EQ(field.gx(0, j), gx) << kernels->name << " column " << j;
+                        ASSERT_EQ(field.gy(0, j), gy) << kernels->name << " column " << j;
+                        ASSERT_EQ(field.magnitude(0, j), gradientMagnitude(gx, gy, norm)) << kernels->name << " column " << j;
+                        ASSERT_EQ(field.orientation(0, j), static_cast<uchar>(quantizeDirection(gx, gy))) << kernels->name << " column " << j;
+                    }
+
+                    // outputs that were not requested are skipped
+                    GradientField orientationOnly;
+                    orientationOnly.outputs = GradientOrientation;
+                    orientationOnly.resize(1, cols);
+                    kernels->gradientFieldRow(&rows(0, 0), &rows(1, 0), &rows(2, 0), GradientRow(orientationOnly, 0), cols, kernelX.data(), kernelY.data(), norm);
+                    for (int j = 1; j < end; ++j) {
+                        ASSERT_EQ(orientationOnly.orientation(0, j), field.orientation(0, j)) << kernels->name;
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(SimdKernels, SuppressNonMaximaRowMatchesScalar) {
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> level(0, 6);
+    for (const SimdKernelSet* kernels : supportedSimdKernels()) {
+        for (int cols : {1, 2, 9, 10, 17, 18, 100}) {
+            // few distinct magnitudes, so ties with both neighbours are common
+            FlatArray<float> magnitude(3, cols);
+            FlatImage direction(1, cols);
+            for (float& m : magnitude) {
+                m = 20.0f * level(rng);
+            }
+            for (uchar& d : direction) {
+                d = static_cast<uchar>(level(rng) % 4);
+            }
+
+            FlatImage out(1, cols);
+            int end = kernels->suppressNonMaximaRow(magnitude.row(0), magnitude.row(1), magnitude.row(2), direction.row(0), out.row(0), cols, 30.0f, 70.0f);
+
+            ASSERT_GE(end, 1) << kernels->name;
+            ASSERT_LE(end, std::max(cols - 1, 1)) << kernels->name;
+            for (int j = 1; j < end; ++j) {
+                const float m = magnitude(1, j);
+                bool peak = false;
+                switch (static_cast<GradientDirection>(direction(0, j))) {
+                case GradientDirection::Horizontal: peak = m > magnitude(1, j - 1) && m >= magnitude(1, j + 1); break;
+                case GradientDirection::Vertical: peak = m > magnitude(0, j) && m >= magnitude(2, j); break;
+                case GradientDirection::Diagonal: peak = m > magnitude(0, j + 1) && m > magnitude(2, j - 1); break;
+                case GradientDirection::AntiDiagonal: peak = m > magnitude(0, j - 1) && m > magnitude(2, j + 1); break;
+                }
+                const int expected = peak && m > 30.0f ? (m > 70.0f ? 2 : 1) : 0;
+                ASSERT_EQ(out(0, j), expected) << kernels->name << " column " << j;
+            }
+        }
+    }
+}
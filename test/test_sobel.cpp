@@ -30,3 +30,27 @@ TEST(Sobel, TestSobel) {
         }
     }
 }
+
+TEST(Sobel, SeparableKernelsMatchDense) {
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            ASSERT_EQ(SobelOperator::SEPARABLE_KERNELX.column[r] * SobelOperator::SEPARABLE_KERNELX.row[c], SobelOperator::KERNELX[r][c]);
+            ASSERT_EQ(SobelOperator::SEPARABLE_KERNELY.column[r] * SobelOperator::SEPARABLE_KERNELY.row[c], SobelOperator::KERNELY[r][c]);
+        }
+    }
+}
+
+TEST(Sobel, TestLargerKernels) {
+    FlatImage input = createTestImage(5, 5, 1);
+
+    for (int ksize : {5, 7}) {
+        FlatImage output;
+        SobelOperator(ksize).apply(input, output);
+
+        ASSERT_EQ(output.rows(), input.rows());
+        ASSERT_EQ(output.cols(), input.cols());
+        expectImagesEqual(output, createTestImage(5, 5, 0));
+    }
+
+    ASSERT_THROW(SobelOperator(4), std::invalid_argument);
+}
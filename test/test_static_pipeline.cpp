@@ -0,0 +1,113 @@
+#include <opencv2/opencv.hpp>
+#include <gtest/gtest.h>
+
+#include "blur.hpp"
+#include "filter_pipeline.hpp"
+#include "gaussian_blur.hpp"
+#include "laplacian_of_gaussian.hpp"
+#include "scharr.hpp"
+#include "sobel.hpp"
+#include "static_pipeline.hpp"
+#include "test_utils.hpp"
+
+
+// Runs the static chain and the runtime chain over the same image
+template <typename Pipeline>
+void expectMatchesRuntime(const Pipeline& pipeline, FilterPipeline runtime, const FlatImage& input) {
+    FlatImage expected, actual;
+    runtime.apply(input, expected);
+    pipeline.apply(input, actual);
+    expectImagesEqual(actual, expected);
+}
+
+TEST(StaticPipeline, HaloRadius) {
+    ASSERT_EQ((StaticPipeline<Blur, SobelOperator>().haloRadius()), 2);
+    ASSERT_EQ(StaticPipeline(GaussianBlur(7), SobelOperator(5), ScharrOperator()).haloRadius(), 6);
+    ASSERT_EQ(StaticPipeline(Blur(15), Blur()).radius(), 8);
+}
+
+TEST(StaticPipeline, MatchesFilterPipeline) {
+    ExecutionPolicyScope scope(ExecutionPolicy::serial());
+    for (auto [rows, cols] : {std::pair{100, 77}, std::pair{31, 64}, std::pair{3, 5}, std::pair{1, 1}, std::pair{2, 40}}) {
+        FlatImage input = createRandomImage(rows, cols, rows * cols);
+
+        expectMatchesRuntime(StaticPipeline<Blur, SobelOperator>(), FilterPipeline().addBlur().addSobelOperator(), input);
+        expectMatchesRuntime(StaticPipeline(GaussianBlur(7), Blur(9), SobelOperator(5), LaplacianOfGaussian()),
+                             FilterPipeline().addGaussianBlur(7).addBlur(9).addSobelOperator(5).addLaplacianOfGaussian(), input);
+        expectMatchesRuntime(StaticPipeline(ScharrOperator(), GaussianBlur(3), SobelOperator(7)),
+                             FilterPipeline().addScharrOperator().addGaussianBlur(3).addSobelOperator(7), input);
+        expectMatchesRuntime(StaticPipeline<Blur>(Blur(1)), FilterPipeline().addBlur(1), input);
+        // box blurs sliding their column sums over rings of the stage before
+        expectMatchesRuntime(StaticPipeline(Blur(5), Blur(3), Blur(11)), FilterPipeline().addBlur(5).addBlur(3).addBlur(11), input);
+    }
+}
+
+TEST(StaticPipeline, EmptyImage) {
+    FlatImage input, output(4, 4);
+    StaticPipeline<Blur, SobelOperator>().apply(input, output);
+    ASSERT_TRUE(output.empty());
+}
+
+TEST(StaticPipeline, ChunkedMatchesSerial) {
+    FlatImage input = createRandomImage(203, 61, 4);
+    const StaticPipeline pipeline(GaussianBlur(5), Blur(7), ScharrOperator());
+
+    FlatImage serial;
+    {
+        ExecutionPolicyScope scope(ExecutionPolicy::serial());
+        pipeline.apply(input, serial);
+    }
+
+    ExecutionPolicy chunked;
+    chunked.parallelMinPixels = 0;
+    chunked.chunksPerWorker = 64;
+    ExecutionPolicyScope scope(chunked);
+    FlatImage output;
+    pipeline.apply(input, output);
+    expectImagesEqual(output, serial);
+}
+
+TEST(StaticPipeline, ApplyInPlace) {
+    FlatImage input = createRandomImage(64, 57, 8);
+    const StaticPipeline<Blur, SobelOperator> pipeline;
+    FlatImage expected;
+    pipeline.apply(input, expected);
+
+    ExecutionPolicy chunked;
+    chunked.parallelMinPixels = 0;
+    chunked.chunksPerWorker = 16;
+    ExecutionPolicyScope scope(chunked);
+    FlatImage image = input;
+    pipeline.apply(image, image);
+    expectImagesEqual(image, expected);
+
+    // output two rows above the input in the same buffer
+    FlatImage buffer(66, 57);
+    for (int i = 0; i < 64; ++i) {
+        std::copy(input.row(i), input.row(i) + 57, buffer.row(i + 2));
+    }
+    FlatImage shifted = buffer.subView(0, 0, 64, 57);
+    pipeline.apply(buffer.subView(2, 0, 64, 57), shifted);
+    expectImagesEqual(shifted, expected);
+}
+
+TEST(StaticPipeline, StageOfFilterPipeline) {
+    FlatImage input = createRandomImage(90, 70, 5);
+    auto fused = std::make_shared<StaticPipeline<GaussianBlur, SobelOperator>>();
+    FilterPipeline pipeline = FilterPipeline().addBlur().add(fused);
+    ASSERT_EQ(pipeline.haloRadius(), 4);
+
+    FlatImage expected;
+    FilterPipeline().addBlur().addGaussianBlur().addSobelOperator().apply(input, expected);
+
+    FlatImage output, tiled;
+    pipeline.apply(input, output);
+    pipeline.applyTiled(input, tiled, TileOptions{16, 16});
+    expectImagesEqual(output, expected);
+    expectImagesEqual(tiled, expected);
+
+    cv::Mat benchmark;
+    fused->applyBenchmark(FlatImageFactory::toMat(input), benchmark);
+    ASSERT_EQ(benchmark.rows, input.rows());
+    ASSERT_EQ(benchmark.cols, input.cols());
+}
@@ -0,0 +1,153 @@
+#include <opencv2/opencv.hpp>
+#include <gtest/gtest.h>
+
+#include "filter_pipeline.hpp"
+#include "types.hpp"
+#include "test_utils.hpp"
+
+
+TEST(FlatArray, CopyOwningIsDeep) {
+    FlatImage image = createRandomImage(6, 9, 1);
+    FlatImage copy = image;
+    ASSERT_NE(copy.data(), image.data());
+    expectImagesEqual(copy, image);
+
+    copy(0, 0) = image(0, 0) + 1;
+    ASSERT_NE(copy(0, 0), image(0, 0));
+}
+
+TEST(FlatArray, BorrowUsesStride) {
+    std::vector<uchar> buffer(4 * 8);
+    std::iota(buffer.begin(), buffer.end(), 0);
+
+    FlatImage view = FlatImage::borrow(buffer.data(), 4, 5, 8);
+    ASSERT_TRUE(view.isView());
+    ASSERT_FALSE(view.isContinuous());
+    ASSERT_EQ(view.stride(), 8);
+    ASSERT_EQ(view(2, 3), 19);
+
+    // copies of a view alias the same pixels
+    FlatImage alias = view;
+    alias(1, 1) = 200;
+    ASSERT_EQ(buffer[9], 200);
+
+    ASSERT_THROW(FlatImage::borrow(buffer.data(), 4, 9, 8), std::invalid_argument);
+}
+
+TEST(FlatArray, ResizeView) {
+    std::vector<uchar> buffer(3 * 4, 7);
+    FlatImage view = FlatImage::borrow(buffer.data(), 3, 4);
+
+    view.resize(3, 4);
+    ASSERT_TRUE(view.isView());
+    ASSERT_EQ(view.data(), buffer.data());
+
+    // a different shape detaches into owned storage and leaves the buffer alone
+    view.resize(2, 2);
+    ASSERT_FALSE(view.isView());
+    ASSERT_NE(view.data(), buffer.data());
+    view(0, 0) = 1;
+    ASSERT_EQ(buffer[0], 7);
+}
+
+TEST(FlatArray, GuardBandLayout) {
+    FlatImage image(5, 70, 2);
+    ASSERT_EQ(image.guard(), 2);
+    ASSERT_EQ(image.border(), 0);
+    ASSERT_EQ(image.stride() % 64, 0);
+    ASSERT_GE(image.stride(), image.cols() + 2 * image.guard());
+    for (int i = -2; i < image.rows() + 2; ++i) {
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(image.row(i)) % PixelAllocator::ALIGNMENT, 0u);
+    }
+
+    FlatArray<int16_t> wide(3, 10, 1);
+    ASSERT_EQ(wide.stride() * sizeof(int16_t) % 64, 0u);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(wide.row(1)) % PixelAllocator::ALIGNMENT, 0u);
+}
+
+TEST(FlatArray, FillBorderReplicatesEdges) {
+    FlatImage input = createRandomImage(4, 6, 5);
+    FlatImage image(4, 6, 3);
+    for (int i = 0; i < 4; ++i) {
+        std::copy(input.row(i), input.row(i) + 6, image.row(i));
+    }
+
+    image.fillBorder(3);
+    ASSERT_EQ(image.border(), 3);
+    for (int i = -3; i < 7; ++i) {
+        for (int j = -3; j < 9; ++j) {
+            ASSERT_EQ(image(i, j), input(std::clamp(i, 0, 3), std::clamp(j, 0, 5))) << "at (" << i << ", " << j << ")";
+        }
+    }
+
+    // resizing hands the pixels back to a writer, so the border is stale again
+    image.resize(4, 6);
+    ASSERT_EQ(image.border(), 0);
+    ASSERT_EQ(image.guard(), 3);
+
+    ASSERT_THROW(image.fillBorder(4), std::invalid_argument);
+}
+
+TEST(FlatArray, SubViewSharesPixels) {
+    FlatImage image = createRandomImage(10, 12, 6);
+    FlatImage view = image.subView(2, 3, 4, 5);
+    ASSERT_TRUE(view.isView());
+    ASSERT_EQ(view.stride(), image.stride());
+    ASSERT_EQ(view(1, 2), image(3, 5));
+
+    view(0, 0) = image(2, 3) + 1;
+    ASSERT_EQ(view(0, 0), image(2, 3));
+
+    ASSERT_THROW(image.subView(8, 0, 3, 1), std::invalid_argument);
+}
+
+TEST(FlatImageFactory, WrapIsZeroCopy) {
+    cv::Mat mat(10, 12, CV_8UC1);
+    for (int i = 0; i < mat.rows; ++i) {
+        for (int j = 0; j < mat.cols; ++j) {
+            mat.at<uchar>(i, j) = static_cast<uchar>(i * mat.cols + j);
+        }
+    }
+
+    cv::Mat roi = mat(cv::Rect(2, 3, 5, 4));
+    FlatImage view = FlatImageFactory::wrap(roi);
+    ASSERT_EQ(view.data(), roi.data);
+    ASSERT_EQ(view.rows(), 4);
+    ASSERT_EQ(view.cols(), 5);
+    ASSERT_EQ(view.stride(), 12);
+    ASSERT_EQ(view(1, 2), mat.at<uchar>(4, 4));
+
+    FlatImage copy = FlatImageFactory::from(roi);
+    ASSERT_TRUE(copy.isContinuous());
+    expectImagesEqual(copy, view);
+
+    ASSERT_THROW(FlatImageFactory::wrap(cv::Mat(2, 2, CV_32FC1)), std::invalid_argument);
+}
+
+TEST(FlatImageFactory, ToMatSharesPixels) {
+    FlatImage image = createRandomImage(5, 7, 2);
+    cv::Mat mat = FlatImageFactory::toMat(image);
+    ASSERT_EQ(mat.data, image.data());
+    ASSERT_EQ(mat.step[0], static_cast<size_t>(image.stride()));
+
+    mat.at<uchar>(3, 4) = 42;
+    ASSERT_EQ(image(3, 4), 42);
+}
+
+TEST(FlatImageFactory, PipelineWritesIntoMat) {
+    FlatImage input = createRandomImage(30, 40, 3);
+    auto pipeline = FilterPipeline().addBlur().addSobelOperator();
+
+    FlatImage expected;
+    pipeline.apply(input, expected);
+
+    // filter into the interior of a larger Mat, which must be written in place
+    cv::Mat canvas = cv::Mat::zeros(34, 48, CV_8UC1);
+    cv::Mat roi = canvas(cv::Rect(4, 2, 40, 30));
+    FlatImage output = FlatImageFactory::wrap(roi);
+    pipeline.apply(FlatImageFactory::wrap(FlatImageFactory::toMat(input)), output);
+
+    ASSERT_EQ(output.data(), roi.data);
+    expectImagesEqual(output, expected);
+    ASSERT_EQ(canvas.at<uchar>(0, 0), 0);
+}
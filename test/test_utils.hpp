@@ -1,3 +1,5 @@
+#include <gtest/gtest.h>
+#include <random>
 #include <vector>
 #include "types.hpp"
 
@@ -10,3 +12,25 @@ FlatImage createTestImage(int rows, int cols, std::optional<uchar> value = std::
     }
     return image;
 }
+
+FlatImage createRandomImage(int rows, int cols, unsigned int seed = 0) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> dist(0, 255);
+    FlatImage image(rows, cols);
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            image(i, j) = static_cast<uchar>(dist(rng));
+        }
+    }
+    return image;
+}
+
+void expectImagesEqual(const FlatImage& actual, const FlatImage& expected) {
+    ASSERT_EQ(actual.rows(), expected.rows());
+    ASSERT_EQ(actual.cols(), expected.cols());
+    for (int i = 0; i < actual.rows(); ++i) {
+        for (int j = 0; j < actual.cols(); ++j) {
+            ASSERT_EQ(actual(i, j), expected(i, j)) << "at (" << i << ", " << j << ")";
+        }
+    }
+}
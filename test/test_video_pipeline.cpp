@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <thread>
+#include "filter_pipeline.hpp"
+#include "spsc_queue.hpp"
+#include "test_utils.hpp"
+#include "video_pipeline.hpp"
+
+// Keeps a copy of every frame it is handed
+class CollectingFrameSink : public FrameSink {
+public:
+    void write(const FlatImage& frame) override {
+        frames.push_back(frame);
+    }
+
+    std::vector<FlatImage> frames;
+};
+
+// Counts frames without copying them
+class CountingFrameSink : public FrameSink {
+public:
+    explicit CountingFrameSink(int failAt = -1) : failAt(failAt) {}
+
+    void write(const FlatImage&) override {
+        if (frames == failAt) {
+            throw std::runtime_error("sink failed");
+        }
+        ++frames;
+    }
+
+    int failAt;
+    int frames = 0;
+};
+
+TEST(SpscQueue, BoundedCapacity) {
+    SpscQueue<int> queue(3);
+    ASSERT_EQ(queue.capacity(), 4u);
+
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.tryPush(i));
+    }
+    EXPECT_FALSE(queue.tryPush(4));
+
+    int value;
+    ASSERT_TRUE(queue.tryPop(value));
+    EXPECT_EQ(value, 0);
+    EXPECT_TRUE(queue.tryPush(4));
+    for (int i = 1; i <= 4; ++i) {
+        ASSERT_TRUE(queue.tryPop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(queue.tryPop(value));
+}
+
+TEST(SpscQueue, PreservesOrderAcrossThreads) {
+    constexpr int count = 100000;
+    SpscQueue<int> queue(8);
+
+    std::thread producer([&] {
+        for (int i = 0; i < count; ++i) {
+            while (!queue.tryPush(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    int expected = 0;
+    while (expected < count) {
+        int value;
+        if (queue.tryPop(value)) {
+            ASSERT_EQ(value, expected);
+            ++expected;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+}
+
+TEST(VideoPipeline, MatchesPerFrameApply) {
+    constexpr int frames = 12;
+    auto pipeline = FilterPipeline().addGaussianBlur().addSobelOperator();
+
+    std::vector<FlatImage> expected;
+    SyntheticFrameSource reference(48, 70, frames);
+    FlatImage frame;
+    while (reference.read(frame)) {
+        FlatImage output;
+        pipeline.apply(frame, output);
+        expected.push_back(output);
+    }
+    ASSERT_EQ(expected.size(), static_cast<size_t>(frames));
+
+    for (size_t ringFrames : {1, 2, 4}) {
+        SCOPED_TRACE(ringFrames);
+        SyntheticFrameSource source(48, 70, frames);
+        CollectingFrameSink sink;
+        VideoReport report = VideoPipeline(pipeline, {ringFrames}).run(source, sink);
+
+        EXPECT_EQ(report.frames, static_cast<size_t>(frames));
+        EXPECT_GE(report.maxLatencyMs, report.meanLatencyMs);
+        ASSERT_EQ(sink.frames.size(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            expectImagesEqual(sink.frames[i], expected[i]);
+        }
+    }
+}
+
+TEST(VideoPipeline, ReusesFrameBuffers) {
+    VideoPipeline video(FilterPipeline().addBlur().addSobelOperator(), {3});
+    CountingFrameSink warmUpSink;
+    SyntheticFrameSource warmUp(64, 64, 5);
+    video.run(warmUp, warmUpSink);
+
+    const size_t allocations = pixelAllocationCount();
+    CountingFrameSink sink;
+    SyntheticFrameSource source(64, 64, 20);
+    VideoReport report = video.run(source, sink);
+
+    EXPECT_EQ(report.frames, 20u);
+    EXPECT_EQ(sink.frames, 20);
+    EXPECT_EQ(pixelAllocationCount(), allocations);
+}
+
+TEST(VideoPipeline, EmptySource) {
+    SyntheticFrameSource source(16, 16, 0);
+    CountingFrameSink sink;
+    VideoReport report = VideoPipeline(FilterPipeline().addBlur()).run(source, sink);
+    EXPECT_EQ(report.frames, 0u);
+    EXPECT_EQ(sink.frames, 0);
+}
+
+TEST(VideoPipeline, PropagatesStageErrors) {
+    SyntheticFrameSource source(32, 32, 50);
+    CountingFrameSink sink(7);
+    VideoPipeline video(FilterPipeline().addBlur(), {2});
+    EXPECT_THROW(video.run(source, sink), std::runtime_error);
+    EXPECT_EQ(sink.frames, 7);
+
+    EXPECT_THROW(VideoPipeline(FilterPipeline(), {0}), std::invalid_argument);
+}